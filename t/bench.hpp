@@ -0,0 +1,54 @@
+//////////////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Trivial Template Library Test Framework: benchmark helpers
+//
+// The benchmarks are built with "make benches" and run with "make bench";
+// they take the problem size as the first argument.
+//
+// This work is PUBLIC DOMAIN
+//
+#ifndef _TTL_T_BENCH_HPP_
+#define _TTL_T_BENCH_HPP_
+
+#include <time.h>
+#include "t.hpp"
+
+namespace t
+{
+   inline double now()
+   {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   inline unsigned long arg(int i, unsigned long def)
+   {
+      return i < argc ? strtoul(argv[i], NULL, 0): def;
+   }
+
+   // deterministic, so every container sees the same sequence
+   struct xorshift
+   {
+      uint64_t s;
+      xorshift(uint64_t seed = 88172645463325252ull): s(seed) {}
+      uint64_t operator()()
+      {
+         s ^= s << 13;
+         s ^= s >> 7;
+         s ^= s << 17;
+         return s;
+      }
+   };
+
+   // keeps the results of the measured code alive
+   extern volatile unsigned long sink;
+
+   inline void report(const char *what, unsigned long ops, double seconds)
+   {
+      printf("%-44s %10lu ops %10.3f ms %8.2f ns/op\n",
+             what, ops, seconds * 1e3, ops ? seconds * 1e9 / ops: 0.);
+   }
+}
+
+#endif // _TTL_T_BENCH_HPP_
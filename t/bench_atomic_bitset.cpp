@@ -0,0 +1,122 @@
+// vim: sw=3 ts=8 et
+#include <pthread.h>
+#include "ttl/bitset.hpp"
+#include "ttl/atomic_bitset.hpp"
+#include "bench.hpp"
+
+// slot allocation from a shared bitmap: each thread keeps held slots and
+// frees the oldest one for each one it allocates
+static const ttl::size_t bits = 1 << 16;
+static const unsigned held = 256;
+static const unsigned max_threads = 64;
+
+static unsigned long per_thread;
+static unsigned nthreads;
+
+struct atomic_pool
+{
+   ttl::dynamic_atomic_bitset<> b;
+   bool hinted;
+   atomic_pool(bool h): b(bits), hinted(h) {}
+   ttl::size_t hint(unsigned t) { return hinted ? b.hint(t, nthreads): 0; }
+   ttl::size_t allocate(ttl::size_t &hint)
+   {
+      if (!hinted)
+         hint = 0;
+      return b.find_first_zero_and_set(hint);
+   }
+   void free(ttl::size_t pos) { b.reset(pos); }
+};
+
+// the alternative: a lock around a plain bitset
+struct locked_pool
+{
+   ttl::bitset<bits> b;
+   pthread_mutex_t lock;
+   locked_pool() { pthread_mutex_init(&lock, 0); }
+   ~locked_pool() { pthread_mutex_destroy(&lock); }
+   ttl::size_t hint(unsigned) { return 0; }
+   ttl::size_t allocate(ttl::size_t &)
+   {
+      ttl::size_t pos = bits;
+      pthread_mutex_lock(&lock);
+      for (ttl::size_t s = 0; s < bits / ttl::bitset_slots::slot_bits; ++s)
+         if (~b.slot(s))
+         {
+            pos = s * ttl::bitset_slots::slot_bits + ttl::bitset_slots::lowest(~b.slot(s));
+            b.set(pos);
+            break;
+         }
+      pthread_mutex_unlock(&lock);
+      return pos;
+   }
+   void free(ttl::size_t pos)
+   {
+      pthread_mutex_lock(&lock);
+      b.reset(pos);
+      pthread_mutex_unlock(&lock);
+   }
+};
+
+template<class Pool>
+struct worker
+{
+   Pool *pool;
+   unsigned index;
+
+   static void *run(void *arg)
+   {
+      worker *w = static_cast<worker *>(arg);
+      ttl::size_t slots[held];
+      ttl::size_t hint = w->pool->hint(w->index);
+      unsigned long sum = 0;
+      for (unsigned i = 0; i < held; ++i)
+         slots[i] = w->pool->allocate(hint);
+      for (unsigned long i = 0; i < per_thread; ++i)
+      {
+         ttl::size_t &s = slots[i % held];
+         w->pool->free(s);
+         s = w->pool->allocate(hint);
+         sum += s;
+      }
+      for (unsigned i = 0; i < held; ++i)
+         w->pool->free(slots[i]);
+      t::sink = sum;
+      return 0;
+   }
+};
+
+template<class Pool>
+static void bench(const char *name, Pool &pool)
+{
+   char title[64];
+   pthread_t th[max_threads];
+   worker<Pool> w[max_threads];
+   double t0 = t::now();
+   for (unsigned i = 0; i < nthreads; ++i)
+   {
+      w[i].pool = &pool;
+      w[i].index = i;
+      pthread_create(&th[i], 0, &worker<Pool>::run, &w[i]);
+   }
+   for (unsigned i = 0; i < nthreads; ++i)
+      pthread_join(th[i], 0);
+   snprintf(title, sizeof(title), "%s, %u threads", name, nthreads);
+   t::report(title, per_thread * nthreads, t::now() - t0);
+}
+
+// the arguments are the allocations per thread and the number of threads
+void test()
+{
+   per_thread = t::arg(1, 1000000);
+   const unsigned most = t::arg(2, 8);
+   for (nthreads = 1; nthreads <= most && nthreads <= max_threads; nthreads *= 2)
+   {
+      atomic_pool hinted(true);
+      bench("atomic_bitset, per-thread hints", hinted);
+      atomic_pool shared(false);
+      bench("atomic_bitset, scan from 0", shared);
+      locked_pool locked;
+      bench("mutex + bitset", locked);
+   }
+}
@@ -0,0 +1,194 @@
+// vim: sw=3 ts=8 et
+#include "ttl/bitset.hpp"
+#include "bench.hpp"
+
+struct sum_positions
+{
+   unsigned long sum;
+   sum_positions(): sum(0) {}
+   void operator()(ttl::size_t i) { sum += i; }
+};
+
+// scans a bitset with one bit in density set, bit by bit and a slot at a time
+template<ttl::size_t N>
+static void bench_scan(unsigned long rounds, unsigned density)
+{
+   char title[64];
+   ttl::bitset<N> *bs = new ttl::bitset<N>;
+   t::xorshift rnd;
+   for (ttl::size_t i = 0; i < N; ++i)
+      if (rnd() % density == 0)
+         bs->set(i);
+   const unsigned long ops = rounds * N;
+   unsigned long sum = 0;
+
+   double t0 = t::now();
+   for (unsigned long r = 0; r < rounds; ++r)
+      for (ttl::size_t i = 0; i < N; ++i)
+         if (bs->test(i))
+            sum += i;
+   double t1 = t::now();
+   snprintf(title, sizeof(title), "<%lu> 1/%u test() loop", (unsigned long)N, density);
+   t::report(title, ops, t1 - t0);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+      for (ttl::size_t i = bs->find_first(); i < N; i = bs->find_next(i))
+         sum += i;
+   double t2 = t::now();
+   snprintf(title, sizeof(title), "<%lu> 1/%u find_first/find_next", (unsigned long)N, density);
+   t::report(title, ops, t2 - t1);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+      sum += bs->for_each_set_bit(sum_positions()).sum;
+   double t3 = t::now();
+   snprintf(title, sizeof(title), "<%lu> 1/%u for_each_set_bit", (unsigned long)N, density);
+   t::report(title, ops, t3 - t2);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+      sum += bs->count();
+   double t4 = t::now();
+   snprintf(title, sizeof(title), "<%lu> 1/%u count", (unsigned long)N, density);
+   t::report(title, ops, t4 - t3);
+
+   t::sink = sum;
+   delete bs;
+}
+
+// the shift as it was done before, a bit at a time
+template<ttl::size_t N>
+static void shift_bitwise(ttl::bitset<N> &bs, ttl::size_t pos)
+{
+   ttl::bitset<N> other;
+   for (ttl::size_t i = 0; pos < N; ++i, ++pos)
+      if (bs.test(i))
+         other.set(pos);
+   bs = other;
+}
+
+template<ttl::size_t N>
+static void bench_shift(unsigned long rounds)
+{
+   char title[64];
+   ttl::bitset<N> *bs = new ttl::bitset<N>;
+   t::xorshift rnd;
+   for (ttl::size_t i = 0; i < N; ++i)
+      if (rnd() & 1)
+         bs->set(i);
+   const unsigned long ops = rounds * N;
+   unsigned long sum = 0;
+
+   double t0 = t::now();
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      shift_bitwise(*bs, 1 + r % 100);
+      bs->set(r % N);
+      sum += bs->test(N / 2);
+   }
+   double t1 = t::now();
+   snprintf(title, sizeof(title), "<%lu> <<= bit by bit", (unsigned long)N);
+   t::report(title, ops, t1 - t0);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      *bs <<= 1 + r % 100;
+      bs->set(r % N);
+      sum += bs->test(N / 2);
+   }
+   double t2 = t::now();
+   snprintf(title, sizeof(title), "<%lu> <<=", (unsigned long)N);
+   t::report(title, ops, t2 - t1);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      *bs >>= 1 + r % 100;
+      bs->set(N - 1 - r % N);
+      sum += bs->test(N / 2);
+   }
+   double t3 = t::now();
+   snprintf(title, sizeof(title), "<%lu> >>=", (unsigned long)N);
+   t::report(title, ops, t3 - t2);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      bs->rotate_left(1 + r % 100);
+      sum += bs->test(N / 2);
+   }
+   double t4 = t::now();
+   snprintf(title, sizeof(title), "<%lu> rotate_left", (unsigned long)N);
+   t::report(title, ops, t4 - t3);
+
+   t::sink = sum;
+   delete bs;
+}
+
+// the text form, against a character at a time
+template<ttl::size_t N>
+static void bench_chars(unsigned long rounds)
+{
+   char title[64];
+   char *text = new char[N + 1];
+   t::xorshift rnd;
+   for (ttl::size_t i = 0; i < N; ++i)
+      text[i] = "01"[rnd() & 1];
+   text[N] = 0;
+   const unsigned long ops = rounds * N;
+   unsigned long sum = 0;
+   ttl::bitset<N> *bs = new ttl::bitset<N>;
+
+   double t0 = t::now();
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      bs->reset();
+      for (ttl::size_t i = 0; i < N; ++i)
+         if (text[i] == '1')
+            bs->set(N - 1 - i);
+      sum += bs->test(r % N);
+   }
+   double t1 = t::now();
+   snprintf(title, sizeof(title), "<%lu> parse a character at a time", (unsigned long)N);
+   t::report(title, ops, t1 - t0);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      *bs = ttl::bitset<N>(text, N);
+      sum += bs->test(r % N);
+   }
+   double t2 = t::now();
+   snprintf(title, sizeof(title), "<%lu> const char * constructor", (unsigned long)N);
+   t::report(title, ops, t2 - t1);
+
+   for (unsigned long r = 0; r < rounds; ++r)
+   {
+      bs->to_chars(text, text + N);
+      sum += text[r % N];
+   }
+   double t3 = t::now();
+   snprintf(title, sizeof(title), "<%lu> to_chars", (unsigned long)N);
+   t::report(title, ops, t3 - t2);
+
+   t::sink = sum;
+   delete bs;
+   delete[] text;
+}
+
+template<ttl::size_t N>
+static void bench_size(unsigned long bits)
+{
+   const unsigned long rounds = bits / N + 1;
+   bench_scan<N>(rounds, 2);
+   bench_scan<N>(rounds, 64);
+   bench_shift<N>(rounds / 10 + 1);
+   bench_chars<N>(rounds / 10 + 1);
+}
+
+// the argument is the number of bits scanned per measurement, in total,
+// the shifts and the text conversions go over a tenth of that
+void test()
+{
+   const unsigned long bits = t::arg(1, 100000000);
+
+   bench_size<64>(bits);
+   bench_size<1024>(bits);
+   bench_size<65536>(bits);
+   bench_size<1048576>(bits);
+}
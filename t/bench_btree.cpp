@@ -0,0 +1,125 @@
+// vim: sw=3 ts=8 et
+#include "ttl/map.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/btree_map.hpp"
+#include "ttl/vector.hpp"
+#include "bench.hpp"
+
+// the ordered maps of int to int: random insertion, lookups, iteration
+// and erasure; the maps of N values are built from the same random keys
+
+template<class Map>
+static void bench_insert(const char *name, Map &m, const ttl::vector<int> &keys)
+{
+   char title[64];
+   double t0 = t::now();
+   for (ttl::size_t i = 0; i < keys.size(); ++i)
+      m[keys[i]] = (int)i;
+   snprintf(title, sizeof(title), "%s insert random", name);
+   t::report(title, keys.size(), t::now() - t0);
+}
+
+template<class Map>
+static void bench_lookup(const char *name, Map &m, const ttl::vector<int> &keys, unsigned long lookups)
+{
+   char title[64];
+   t::xorshift rnd(7);
+   unsigned long sum = 0;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < lookups; ++i)
+   {
+      typename Map::iterator f = m.find(keys[rnd() % keys.size()]);
+      sum += f->second;
+   }
+   double t1 = t::now();
+   snprintf(title, sizeof(title), "%s find", name);
+   t::report(title, lookups, t1 - t0);
+
+   // half of them miss
+   for (unsigned long i = 0; i < lookups; ++i)
+   {
+      typename Map::iterator f = m.lower_bound((int)rnd());
+      if (f != m.end())
+         sum += f->first;
+   }
+   double t2 = t::now();
+   snprintf(title, sizeof(title), "%s lower_bound", name);
+   t::report(title, lookups, t2 - t1);
+
+   unsigned long n = 0;
+   for (typename Map::const_iterator i = m.begin(); i != m.end(); ++i, ++n)
+      sum += i->second;
+   snprintf(title, sizeof(title), "%s iterate", name);
+   t::report(title, n, t::now() - t2);
+   t::sink = sum;
+}
+
+template<class Map>
+static void bench_erase(const char *name, Map &m, const ttl::vector<int> &keys)
+{
+   char title[64];
+   double t0 = t::now();
+   for (ttl::size_t i = 0; i < keys.size(); ++i)
+      m.erase(keys[i]);
+   snprintf(title, sizeof(title), "%s erase random", name);
+   t::report(title, keys.size(), t::now() - t0);
+}
+
+static void bench_size(unsigned long n, unsigned long lookups)
+{
+   ttl::vector<int> keys;
+   keys.reserve(n);
+   t::xorshift rnd;
+   for (unsigned long i = 0; i < n; ++i)
+      keys.push_back((int)rnd());
+   printf("--- %lu values\n", n);
+
+   {
+      const char *name = "map<int,int>";
+      ttl::map<int, int> m;
+      bench_insert(name, m, keys);
+      bench_lookup(name, m, keys, lookups);
+      bench_erase(name, m, keys);
+   }
+   {
+      const char *name = "sorted_vector_map<int,int>";
+      ttl::sorted_vector_map<int, int> m;
+      // random insertion moves half of the map, build in order instead
+      if (n <= 100000)
+         bench_insert(name, m, keys);
+      else
+      {
+         ttl::map<int, int> order;
+         for (ttl::size_t i = 0; i < keys.size(); ++i)
+            order[keys[i]] = (int)i;
+         double t0 = t::now();
+         for (ttl::map<int, int>::const_iterator i = order.begin(); i != order.end(); ++i)
+            m.insert(ttl::pair<int, int>(i->first, i->second));
+         t::report("sorted_vector_map<int,int> insert in order", n, t::now() - t0);
+      }
+      bench_lookup(name, m, keys, lookups);
+   }
+   {
+      const char *name = "btree_map<int,int>";
+      ttl::btree_map<int, int> m;
+      bench_insert(name, m, keys);
+      bench_lookup(name, m, keys, lookups);
+
+      ttl::btree_map<int, int> c;
+      double t0 = t::now();
+      c.assign_sorted(m.begin(), m.end());
+      t::report("btree_map<int,int> assign_sorted", m.size(), t::now() - t0);
+      bench_lookup("btree_map<int,int> (bulk loaded)", c, keys, lookups);
+      bench_erase(name, m, keys);
+   }
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 1000000);
+   const unsigned long lookups = t::arg(2, 1000000);
+
+   bench_size(1000, lookups);
+   bench_size(n / 10, lookups);
+   bench_size(n, lookups);
+}
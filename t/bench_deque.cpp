@@ -0,0 +1,46 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/lazy_queue.hpp"
+#include "ttl/circular_buffer.hpp"
+#include "ttl/deque.hpp"
+#include "bench.hpp"
+
+// FIFO traffic: a queue of a steady depth, one push_back and one
+// pop_front per message, as in a sliding window or a packet queue
+
+template<class Q>
+static void bench_fifo(const char *name, unsigned long depth, unsigned long n)
+{
+   char title[64];
+   Q q;
+   unsigned long sum = 0;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < depth; ++i)
+      q.push_back(i);
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      sum += q.front();
+      q.pop_front();
+      q.push_back(i);
+   }
+   while (!q.empty())
+   {
+      sum += q.front();
+      q.pop_front();
+   }
+   snprintf(title, sizeof(title), "%s, depth %lu", name, depth);
+   t::report(title, n, t::now() - t0);
+   t::sink = sum;
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 10000000);
+   const unsigned long depths[] = { 16, 1024, 65536 };
+   for (unsigned i = 0; i < 3; ++i)
+   {
+      bench_fifo<ttl::lazy_queue<unsigned long> >("lazy_queue", depths[i], n);
+      bench_fifo<ttl::circular_buffer<unsigned long> >("circular_buffer", depths[i], n);
+      bench_fifo<ttl::deque<unsigned long> >("deque", depths[i], n);
+   }
+}
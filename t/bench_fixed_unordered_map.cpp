@@ -0,0 +1,70 @@
+// vim: sw=3 ts=8 et
+#include "ttl/fixed_unordered_map.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/vector_map.hpp"
+#include "ttl/algorithm.hpp"
+#include "bench.hpp"
+
+// a classification table of K flow keys: random lookups, half of them
+// hits, in the fixed hash map against the sorted_vector_map and the
+// linear scan of a vector_map; then the churn of erases and inserts
+
+template<unsigned long K>
+static void bench_table(unsigned long lookups)
+{
+   typedef ttl::fixed_unordered_map<unsigned, unsigned, K> table_type;
+   static table_type table;
+   ttl::sorted_vector_map<unsigned, unsigned> sorted;
+   ttl::vector_map<unsigned, unsigned> linear;
+   static unsigned keys[K];
+   t::xorshift rnd;
+   for (unsigned long i = 0; i < K; ++i)
+   {
+      keys[i] = (unsigned)rnd() & ~1u;
+      table[keys[i]] = (unsigned)i;
+      sorted[keys[i]] = (unsigned)i;
+      linear.push_back(ttl::make_pair(keys[i], (unsigned)i));
+   }
+   printf("--- %lu keys, %lu slots\n", K, (unsigned long)table.bucket_count());
+
+   unsigned long sum = 0;
+   t::xorshift r1(3);
+   double t0 = t::now();
+   for (unsigned long i = 0; i < lookups; ++i)
+      sum += table.count(keys[r1() % K] | (unsigned)(i & 1));
+   t::report("fixed_unordered_map count", lookups, t::now() - t0);
+
+   t::xorshift r2(3);
+   t0 = t::now();
+   for (unsigned long i = 0; i < lookups; ++i)
+      sum += sorted.count(keys[r2() % K] | (unsigned)(i & 1));
+   t::report("sorted_vector_map count", lookups, t::now() - t0);
+
+   // the scan is slow on the large tables, fewer lookups
+   const unsigned long scans = lookups / (K / 16 + 1);
+   t::xorshift r3(3);
+   t0 = t::now();
+   for (unsigned long i = 0; i < scans; ++i)
+      sum += linear.find(keys[r3() % K] | (unsigned)(i & 1)) != linear.end();
+   t::report("vector_map find (linear scan)", scans, t::now() - t0);
+
+   t::xorshift r4(5);
+   t0 = t::now();
+   for (unsigned long i = 0; i < lookups; ++i)
+   {
+      const unsigned long k = r4() % K;
+      table.erase(keys[k]);
+      keys[k] = (unsigned)r4() & ~1u;
+      table.insert(ttl::make_pair(keys[k], (unsigned)i));
+   }
+   t::report("fixed_unordered_map erase + insert", lookups, t::now() - t0);
+   t::sink = sum + table.size();
+}
+
+void test()
+{
+   const unsigned long lookups = t::arg(1, 1000000);
+   bench_table<64>(lookups);
+   bench_table<1024>(lookups);
+   bench_table<16384>(lookups);
+}
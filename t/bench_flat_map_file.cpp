@@ -0,0 +1,82 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/flat_map_file.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/vector.hpp"
+#include "bench.hpp"
+#include <stdlib.h>
+#include <unistd.h>
+
+// a table of N int keys to int values: loaded into a sorted_vector_map
+// from the view of its file, against opening the view; then the random
+// lookups in both, the view without and with the Eytzinger index
+
+typedef ttl::sorted_vector_map<int, int> map_type;
+typedef ttl::flat_map_view<int, int> view_type;
+
+template<class Map>
+static void bench_find(const char *name, const Map &m, const ttl::vector<int> &keys, unsigned long lookups)
+{
+   char title[96];
+   t::xorshift rnd(7);
+   unsigned long sum = 0;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < lookups; ++i)
+      sum += m.count(keys[rnd() % keys.size()] + (int)(i & 1));
+   snprintf(title, sizeof(title), "%s count", name);
+   t::report(title, lookups, t::now() - t0);
+   t::sink = sum;
+}
+
+static void bench_size(const char *path, unsigned long n, unsigned long lookups)
+{
+   ttl::vector<int> keys;
+   keys.reserve(n);
+   t::xorshift rnd;
+   ttl::vector<ttl::pair<int, int> > pairs;
+   pairs.reserve(n);
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      keys.push_back((int)(rnd() & 0x7ffffffe));
+      pairs.push_back(ttl::make_pair(keys.back(), (int)i));
+   }
+   map_type m(pairs.begin(), pairs.end());
+   printf("--- %lu values\n", n);
+
+   static const unsigned long strides[] = { 0, 1, 16, 64 };
+   for (unsigned s = 0; s < countof(strides); ++s)
+   {
+      assert(ttl::write_flat_map(path, m, strides[s]));
+      char title[64];
+      view_type v;
+      double t0 = t::now();
+      assert(v.open(path));
+      snprintf(title, sizeof(title), "open, index stride %lu", strides[s]);
+      t::report(title, 1, t::now() - t0);
+      if (!s)
+      {
+         map_type copy;
+         t0 = t::now();
+         for (view_type::const_iterator i = v.begin(); i != v.end(); ++i)
+            copy[i.key()] = i.value();
+         t::report("load into sorted_vector_map", n, t::now() - t0);
+         bench_find("sorted_vector_map", copy, keys, lookups);
+      }
+      snprintf(title, sizeof(title), "flat_map_view, stride %lu", strides[s]);
+      bench_find(title, v, keys, lookups);
+   }
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 1000000);
+   const unsigned long lookups = t::arg(2, 1000000);
+   char path[] = "/tmp/bench_flat_map_file.XXXXXX";
+   int fd = mkstemp(path);
+   assert(fd >= 0);
+   close(fd);
+   bench_size(path, 1000, lookups);
+   bench_size(path, n, lookups);
+   bench_size(path, n * 10, lookups);
+   unlink(path);
+}
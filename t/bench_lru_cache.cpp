@@ -0,0 +1,77 @@
+// vim: sw=3 ts=8 et
+#include "ttl/lru_cache.hpp"
+#include "ttl/list.hpp"
+#include "ttl/map.hpp"
+#include "bench.hpp"
+
+// a cache of C entries under skewed lookups, a miss puts the key: the
+// caches against the hand-built list with a map of its iterators
+
+struct list_map_cache
+{
+   typedef ttl::list<ttl::pair<unsigned, unsigned> > list_type;
+   list_type lru;
+   ttl::map<unsigned, list_type::iterator> index;
+   unsigned long size, capacity;
+
+   list_map_cache(unsigned long c): size(0), capacity(c) {}
+   unsigned *get(unsigned key)
+   {
+      ttl::map<unsigned, list_type::iterator>::iterator i = index.find(key);
+      if (i == index.end())
+         return 0;
+      lru.splice(lru.begin(), lru, i->second);
+      return &i->second->second;
+   }
+   void put(unsigned key, unsigned value)
+   {
+      if (size == capacity)
+      {
+         index.erase(lru.back().first);
+         lru.pop_back();
+         --size;
+      }
+      lru.push_front(ttl::make_pair(key, value));
+      index[key] = lru.begin();
+      ++size;
+   }
+};
+
+// the keys of a random walk over K keys, mostly near each other
+template<class Cache>
+static void bench_cache(const char *name, unsigned long capacity, unsigned long n)
+{
+   char title[64];
+   Cache c(capacity);
+   t::xorshift rnd;
+   unsigned long sum = 0, hits = 0;
+   unsigned key = 0;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      const uint64_t r = rnd();
+      key = (r & 15) ? key + (unsigned)(r >> 60) - 8: (unsigned)(r >> 32) % (unsigned)(capacity * 4);
+      if (unsigned *v = c.get(key))
+      {
+         sum += *v;
+         ++hits;
+      }
+      else
+         c.put(key, (unsigned)i);
+   }
+   snprintf(title, sizeof(title), "%s, %lu entries, %lu%% hits", name, capacity, hits * 100 / n);
+   t::report(title, n, t::now() - t0);
+   t::sink = sum;
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 2000000);
+   const unsigned long capacities[] = { 64, 4096, 262144 };
+   for (unsigned i = 0; i < 3; ++i)
+   {
+      bench_cache<list_map_cache>("list + map", capacities[i], n);
+      bench_cache<ttl::lru_cache<unsigned, unsigned> >("lru_cache", capacities[i], n);
+      bench_cache<ttl::clock_cache<unsigned, unsigned> >("clock_cache", capacities[i], n);
+   }
+}
@@ -0,0 +1,86 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/functional.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/priority_queue.hpp"
+#include "ttl/set.hpp"
+#include "bench.hpp"
+
+typedef unsigned long long key_type;
+
+template<class Q>
+static void bench_queue(const char *name, unsigned long n)
+{
+   char title[64];
+   Q q;
+   t::xorshift rnd;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < n; ++i)
+      q.push(rnd());
+   double t1 = t::now();
+   snprintf(title, sizeof(title), "%s push", name);
+   t::report(title, n, t1 - t0);
+
+   // hold model: the queue size is constant, as in a scheduler
+   unsigned long sum = 0;
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      key_type k = q.top();
+      sum += k;
+      q.pop();
+      q.push(k + (rnd() >> 8));
+   }
+   double t2 = t::now();
+   snprintf(title, sizeof(title), "%s pop+push", name);
+   t::report(title, n, t2 - t1);
+
+   while (!q.empty())
+   {
+      sum += q.top();
+      q.pop();
+   }
+   double t3 = t::now();
+   snprintf(title, sizeof(title), "%s pop", name);
+   t::report(title, n, t3 - t2);
+   t::sink = sum;
+}
+
+// ttl::set as a priority queue, the way it was used before
+struct set_queue
+{
+   ttl::set<key_type> s;
+   bool empty() const { return s.empty(); }
+   key_type top() const { return *s.begin(); }
+   void push(key_type k) { s.insert(k); }
+   void pop() { key_type k = *s.begin(); s.erase(k); }
+};
+
+void test()
+{
+   const unsigned long n = t::arg(1, 1000000);
+
+   bench_queue< ttl::priority_queue<key_type, ttl::greater<key_type>, 2> >("priority_queue<2>", n);
+   bench_queue< ttl::priority_queue<key_type, ttl::greater<key_type>, 4> >("priority_queue<4>", n);
+   bench_queue< ttl::priority_queue<key_type, ttl::greater<key_type>, 8> >("priority_queue<8>", n);
+   bench_queue<set_queue>("set", n);
+
+   ttl::vector<key_type> batch;
+   batch.reserve(n);
+   t::xorshift rnd;
+   for (unsigned long i = 0; i < n; ++i)
+      batch.push_back(rnd());
+   {
+      ttl::priority_queue<key_type, ttl::greater<key_type> > q;
+      double t0 = t::now();
+      q.push_range(batch.begin(), batch.end());
+      t::report("priority_queue<4> push_range (Floyd)", n, t::now() - t0);
+      t::sink = q.top();
+   }
+   {
+      set_queue q;
+      double t0 = t::now();
+      q.s.insert(batch.begin(), batch.end());
+      t::report("set insert(first, last)", n, t::now() - t0);
+      t::sink = q.top();
+   }
+}
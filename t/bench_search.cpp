@@ -0,0 +1,98 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/vector.hpp"
+#include "bench.hpp"
+
+// a pattern searched in a buffer of N bytes, where it is only found at the
+// end: the naive search, Horspool with the SSE2 filter and with the skip
+// table, and two-way. Typical cases are random letters, worst cases are
+// periodic text with patterns that almost match everywhere.
+
+// bytes which are not a byte pointer, so Horspool uses its skip table
+struct byte_iterator
+{
+   const char *p;
+   byte_iterator(const char *q): p(q) {}
+   char operator[](ttl::size_t i) const { return p[i]; }
+   char operator*() const { return *p; }
+   byte_iterator operator+(ttl::size_t i) const { return byte_iterator(p + i); }
+   ttl::ptrdiff_t operator-(const byte_iterator &o) const { return p - o.p; }
+};
+
+template<class Searcher, class It>
+static void bench_searcher(const char *what, const char *name, const Searcher &s,
+                           It first, It last, ttl::size_t expected, unsigned long reps)
+{
+   char title[64];
+   unsigned long found = 0;
+   double t0 = t::now();
+   for (unsigned long r = 0; r < reps; ++r)
+      found += s(first, last).first - first;
+   snprintf(title, sizeof(title), "%s, %s", name, what);
+   t::report(title, reps * (last - first), t::now() - t0);
+   assert(found == expected * reps);
+   t::sink = found;
+}
+
+static void bench_case(const char *what, const ttl::vector<char> &text, const ttl::vector<char> &pattern)
+{
+   const char *s = text.begin(), *s_end = text.end();
+   const char *p = pattern.begin(), *p_end = pattern.end();
+   // about 20 MB searched by each
+   const unsigned long reps = 20000000 / text.size() + 1;
+   const ttl::size_t at = ttl::search(s, s_end, p, p_end) - s;
+   printf("--- %s, a pattern of %lu in %lu bytes\n", what, (unsigned long)pattern.size(),
+          (unsigned long)text.size());
+
+   bench_searcher(what, "search", ttl::default_searcher<const char *>(p, p_end), s, s_end, at, reps);
+   bench_searcher(what, "horspool sse2", ttl::boyer_moore_horspool_searcher<const char *>(p, p_end),
+                  s, s_end, at, reps);
+   bench_searcher(what, "horspool skip", ttl::boyer_moore_horspool_searcher<const char *>(p, p_end),
+                  byte_iterator(s), byte_iterator(s_end), at, reps);
+   bench_searcher(what, "two-way", ttl::two_way_searcher<const char *>(p, p_end), s, s_end, at, reps);
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 65536);
+   t::xorshift rnd;
+   ttl::vector<char> text, pattern;
+
+   // random letters, the pattern appended to the end
+   static const unsigned lengths[] = { 8, 32, 256 };
+   for (unsigned l = 0; l < countof(lengths); ++l)
+   {
+      const unsigned m = lengths[l];
+      pattern.clear();
+      for (unsigned i = 0; i < m; ++i)
+         pattern.push_back((char)('a' + rnd() % 26));
+      text.clear();
+      for (unsigned long i = 0; i < n; ++i)
+         text.push_back((char)('a' + rnd() % 26));
+      text.insert(text.end(), pattern.begin(), pattern.end());
+      bench_case("random letters", text, pattern);
+   }
+
+   // a...a with a...ab: every window matches but the last byte
+   const unsigned m = 32;
+   text.assign(n, 'a');
+   pattern.assign(m - 1, 'a');
+   pattern.push_back('b');
+   text.insert(text.end(), pattern.begin(), pattern.end());
+   bench_case("aaa...ab", text, pattern);
+
+   // a...a with ba...a: every window matches but the first byte
+   pattern.assign(m - 1, 'a');
+   pattern.insert(pattern.begin(), 'b');
+   text.assign(n, 'a');
+   text.insert(text.end(), pattern.begin(), pattern.end());
+   bench_case("baa...a", text, pattern);
+
+   // a...a with a...aba: the first and the last bytes match everywhere
+   pattern.assign(m, 'a');
+   pattern[m - 2] = 'b';
+   text.assign(n, 'a');
+   text.insert(text.end(), pattern.begin(), pattern.end());
+   bench_case("aaa...aba", text, pattern);
+}
@@ -0,0 +1,81 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/vector.hpp"
+#include "bench.hpp"
+
+// the intersection of two posting lists of strictly increasing 32 bit
+// integers, from equal sizes to one list 1000 times the other: a merge,
+// set_intersection (galloping past a size ratio) and
+// set_intersection_unique (SSE2 blocks)
+
+static void posting_list(ttl::vector<unsigned> &v, unsigned long n, unsigned long range, t::xorshift &rnd)
+{
+   // every value in range with the probability n / range
+   v.clear();
+   v.reserve(n * 2 + 16);
+   for (unsigned long x = 0; x < range; ++x)
+      if (rnd() % range < n)
+         v.push_back((unsigned)x);
+}
+
+static unsigned *merge_intersection(const unsigned *a, const unsigned *a_end,
+                                    const unsigned *b, const unsigned *b_end, unsigned *o)
+{
+   while (a != a_end && b != b_end)
+      if (*a < *b)
+         ++a;
+      else if (*b < *a)
+         ++b;
+      else
+         *o++ = *a++, ++b;
+   return o;
+}
+
+static void bench_ratio(unsigned long n, unsigned long ratio)
+{
+   t::xorshift rnd;
+   ttl::vector<unsigned> large, small, out;
+   const unsigned long range = n * 4;
+   posting_list(large, n, range, rnd);
+   posting_list(small, n / ratio, range, rnd);
+   out.resize(small.size() + 1);
+   const unsigned *a = small.begin(), *a_end = small.end(), *b = large.begin(), *b_end = large.end();
+   const unsigned long reps = 20000000 / (large.size() + small.size()) + 1;
+   const unsigned long ops = reps * (large.size() + small.size());
+   char title[64];
+   printf("--- %lu and %lu values\n", (unsigned long)small.size(), (unsigned long)large.size());
+
+   unsigned long found = 0, check;
+   double t0 = t::now();
+   for (unsigned long r = 0; r < reps; ++r)
+      found += merge_intersection(a, a_end, b, b_end, out.begin()) - out.begin();
+   snprintf(title, sizeof(title), "merge 1:%lu", ratio);
+   t::report(title, ops, t::now() - t0);
+   check = found;
+
+   found = 0;
+   t0 = t::now();
+   for (unsigned long r = 0; r < reps; ++r)
+      found += ttl::set_intersection(a, a_end, b, b_end, out.begin()) - out.begin();
+   snprintf(title, sizeof(title), "set_intersection 1:%lu", ratio);
+   t::report(title, ops, t::now() - t0);
+   assert(found == check);
+
+   found = 0;
+   t0 = t::now();
+   for (unsigned long r = 0; r < reps; ++r)
+      found += ttl::set_intersection_unique(a, a_end, b, b_end, out.begin()) - out.begin();
+   snprintf(title, sizeof(title), "set_intersection_unique 1:%lu", ratio);
+   t::report(title, ops, t::now() - t0);
+   assert(found == check);
+   t::sink = found;
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 1000000);
+   static const unsigned long ratios[] = { 1, 4, 16, 64, 256, 1000 };
+   for (unsigned i = 0; i < countof(ratios); ++i)
+      bench_ratio(n, ratios[i]);
+}
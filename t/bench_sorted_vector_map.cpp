@@ -0,0 +1,98 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/vector.hpp"
+#include "bench.hpp"
+
+// refreshes of a sorted_vector_map of N values with batches of K new
+// random keys: one insert per value, against one batch insert; and
+// random inserts mixed with finds, without and with the side buffer
+
+typedef ttl::sorted_vector_map<int, int> map_type;
+
+static void random_batch(ttl::vector<ttl::pair<int, int> > &batch, unsigned long k, t::xorshift &rnd)
+{
+   batch.clear();
+   batch.reserve(k);
+   for (unsigned long i = 0; i < k; ++i)
+      batch.push_back(ttl::make_pair((int)rnd(), (int)i));
+}
+
+static void bench_refresh(unsigned long n, unsigned long k)
+{
+   t::xorshift rnd;
+   ttl::vector<ttl::pair<int, int> > batch;
+   random_batch(batch, n, rnd);
+   map_type base;
+   base.insert(batch.begin(), batch.end());
+   const unsigned long batches = 10;
+   char title[64];
+   printf("--- %lu values, batches of %lu\n", n, k);
+
+   // one by one moves N / 2 pointers per insert, it is too slow for the
+   // large batches
+   map_type m = base;
+   double secs = 0;
+   if (k <= 1000)
+   {
+      t::xorshift r1(3);
+      for (unsigned long b = 0; b < batches; ++b)
+      {
+         random_batch(batch, k, r1);
+         double t0 = t::now();
+         for (ttl::size_t i = 0; i < batch.size(); ++i)
+            m.insert(batch[i]);
+         secs += t::now() - t0;
+      }
+      snprintf(title, sizeof(title), "insert one by one, K = %lu", k);
+      t::report(title, batches * k, secs);
+   }
+   const ttl::size_t size = m.size();
+
+   m = base;
+   t::xorshift r2(3);
+   secs = 0;
+   for (unsigned long b = 0; b < batches; ++b)
+   {
+      random_batch(batch, k, r2);
+      double t0 = t::now();
+      m.insert(batch.begin(), batch.end());
+      secs += t::now() - t0;
+   }
+   snprintf(title, sizeof(title), "insert(first, last), K = %lu", k);
+   t::report(title, batches * k, secs);
+   assert(k > 1000 || m.size() == size);
+   t::sink = m.size();
+}
+
+static void bench_buffered(unsigned long n, unsigned long limit)
+{
+   t::xorshift rnd(5);
+   map_type m;
+   m.set_buffer_limit(limit);
+   unsigned long sum = 0;
+   char title[64];
+   double t0 = t::now();
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      m[(int)rnd()] = (int)i;
+      sum += m.find((int)rnd()) != m.end();
+   }
+   snprintf(title, sizeof(title), "operator[] + find, buffer of %lu", limit);
+   t::report(title, n, t::now() - t0);
+   assert(m.stats().merges == (limit ? m.size() / limit: 0));
+   t::sink = sum + m.size();
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 200000);
+   bench_refresh(n, 100);
+   bench_refresh(n, 1000);
+   bench_refresh(n, n / 10);
+
+   printf("--- %lu random inserts\n", n);
+   static const unsigned long limits[] = { 0, 64, 512, 2048 };
+   for (unsigned i = 0; i < countof(limits); ++i)
+      bench_buffered(n, limits[i]);
+}
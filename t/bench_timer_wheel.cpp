@@ -0,0 +1,117 @@
+// vim: sw=3 ts=8 et
+#include "ttl/timer_wheel.hpp"
+#include "ttl/map.hpp"
+#include "bench.hpp"
+
+// Every tick a few timers fire and are rearmed and many more are refreshed
+// before they expire, as with per-entry expirations.
+
+static const unsigned long span = 60000;   // deadlines up to a minute of ms
+static const unsigned long ticks = 1000;
+static const unsigned long id_bits = 24;
+
+struct entry: ttl::timer_node
+{
+   unsigned long id;
+};
+
+struct rearm
+{
+   ttl::timer_wheel<> *w;
+   t::xorshift *rnd;
+   void operator()(ttl::timer_node &t) const
+   {
+      w->schedule(t, w->now() + 1 + (*rnd)() % span);
+   }
+};
+
+static void bench_wheel(unsigned long n, unsigned long refresh)
+{
+   ttl::timer_wheel<> w;
+   entry *e = new entry[n];
+   t::xorshift rnd;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      e[i].id = i;
+      w.schedule(e[i], 1 + rnd() % span);
+   }
+   double t1 = t::now();
+   t::report("timer_wheel schedule", n, t1 - t0);
+
+   unsigned long expired = 0;
+   rearm r = { &w, &rnd };
+   for (unsigned long tick = 1; tick <= ticks; ++tick)
+   {
+      for (unsigned long i = 0; i < refresh; ++i)
+         w.schedule(e[rnd() % n], tick + rnd() % span);
+      expired += w.advance(tick, r);
+   }
+   double t2 = t::now();
+   t::report("timer_wheel refresh+advance", ticks * refresh + expired, t2 - t1);
+   printf("%lu expired\n", expired);
+
+   for (unsigned long i = 0; i < n; ++i)
+      w.cancel(e[i]);
+   t::report("timer_wheel cancel", n, t::now() - t2);
+   delete [] e;
+}
+
+// the map keyed by (deadline, id), erased and reinserted on each refresh
+static void bench_map(unsigned long n, unsigned long refresh)
+{
+   typedef ttl::map<unsigned long long, unsigned long> map_type;
+   map_type m;
+   unsigned long long *deadline = new unsigned long long[n];
+   t::xorshift rnd;
+   double t0 = t::now();
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      deadline[i] = 1 + rnd() % span;
+      m[deadline[i] << id_bits | i] = i;
+   }
+   double t1 = t::now();
+   t::report("map insert", n, t1 - t0);
+
+   unsigned long expired = 0;
+   for (unsigned long tick = 1; tick <= ticks; ++tick)
+   {
+      for (unsigned long i = 0; i < refresh; ++i)
+      {
+         unsigned long id = rnd() % n;
+         unsigned long long when = tick + rnd() % span;
+         m.erase(deadline[id] << id_bits | id);
+         deadline[id] = when > tick ? when: tick + 1;
+         m[deadline[id] << id_bits | id] = id;
+      }
+      while (!m.empty() && m.begin()->first >> id_bits <= tick)
+      {
+         unsigned long id = m.begin()->second;
+         m.erase(m.begin()->first);
+         deadline[id] = tick + 1 + rnd() % span;
+         m[deadline[id] << id_bits | id] = id;
+         ++expired;
+      }
+   }
+   double t2 = t::now();
+   t::report("map refresh+advance", ticks * refresh + expired, t2 - t1);
+   printf("%lu expired\n", expired);
+
+   m.clear();
+   t::report("map clear", n, t::now() - t2);
+   delete [] deadline;
+}
+
+void test()
+{
+   const unsigned long n = t::arg(1, 10000000);
+   const unsigned long refresh = n / ticks + 1;   // each timer once, on average
+
+   if (n >> id_bits)
+   {
+      printf("at most %lu timers\n", (1ul << id_bits) - 1);
+      return;
+   }
+   bench_wheel(n, refresh);
+   bench_map(n, refresh);
+}
@@ -64,6 +64,8 @@ namespace t
    extern int argc;
    extern char **argv;
 
+   volatile unsigned long sink;
+
    static char def_argv0[] = "t";
    static char *def_argv[] = {def_argv0, NULL};
    int argc = 1;
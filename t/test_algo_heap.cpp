@@ -0,0 +1,50 @@
+#include "t.hpp"
+#include "ttl/utility.hpp"
+#include "ttl/functional.hpp"
+#include "ttl/algorithm.hpp"
+
+static void print_ints(const char *title, const int *first, const int *last)
+{
+   fputs(title, stdout);
+   while (first != last)
+      printf(" %d", *first++);
+   fputs(".\n", stdout);
+}
+
+void test()
+{
+   int a[] = {3,1,4,1,5,9,2,6,5,3,5,8,9,7,9};
+   int *end = a + countof(a);
+
+   assert(!ttl::is_heap(a, end));
+   ttl::make_heap(a, end);
+   print_ints("make_heap:", a, end);
+   assert(ttl::is_heap(a, end));
+   assert(*ttl::max_element(a, end) == a[0]);
+
+   ttl::pop_heap(a, end);
+   assert(end[-1] == 9);
+   assert(ttl::is_heap(a, end - 1));
+   end[-1] = 10;
+   ttl::push_heap(a, end);
+   assert(ttl::is_heap(a, end));
+   assert(a[0] == 10);
+
+   ttl::sort_heap(a, end);
+   print_ints("sort_heap:", a, end);
+   assert(ttl::is_sorted(a, end));
+
+   // min-heap
+   ttl::make_heap(a, end, ttl::greater<int>());
+   assert(ttl::is_heap(a, end, ttl::greater<int>()));
+   assert(a[0] == 1);
+   ttl::sort_heap(a, end, ttl::greater<int>());
+   print_ints("sort_heap(greater):", a, end);
+   assert(a[0] == 10 && end[-1] == 1);
+
+   int b[1] = {42};
+   ttl::make_heap(b, b + 1);
+   ttl::pop_heap(b, b + 1);
+   ttl::push_heap(b, b + 1);
+   assert(b[0] == 42 && ttl::is_heap(b, b));
+}
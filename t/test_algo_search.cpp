@@ -0,0 +1,71 @@
+#include "t.hpp"
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+
+template<class Searcher, class It>
+static It search_all(const char *title, It first, It last, It pfirst, It plast)
+{
+   Searcher searcher(pfirst, plast);
+   It found = ttl::search(first, last, searcher);
+   assert(found == ttl::search(first, last, pfirst, plast));
+   ttl::pair<It, It> r = searcher(first, last);
+   assert(r.first == found);
+   assert(r.second == (found == last ? last: found + (plast - pfirst)));
+   printf("%s: %ld\n", title, (long)(found - first));
+   return found;
+}
+
+template<class It>
+static void check(It first, It last, It pfirst, It plast)
+{
+   It r = search_all< ttl::default_searcher<It> >("default", first, last, pfirst, plast);
+   assert(r == search_all< ttl::boyer_moore_horspool_searcher<It> >("bmh", first, last, pfirst, plast));
+   assert(r == search_all< ttl::two_way_searcher<It> >("two-way", first, last, pfirst, plast));
+}
+
+static void check(const char *s, const char *p)
+{
+   check(s, s + strlen(s), p, p + strlen(p));
+}
+
+void test()
+{
+   check("", "");
+   check("abc", "");
+   check("", "a");
+   check("a", "a");
+   check("abc", "c");
+   check("abc", "abcd");
+   check("hello, world", "world");
+   check("hello, world", "word");
+   check("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "aaaab");
+   check("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "aaaab");
+   check("abababababababababababababababababababababc", "ababc");
+   check("GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\nbody", "\r\n\r\n");
+   check("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxyz", "yz");
+   check("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxyz", "zz");
+
+   // exhaustive check of short patterns over a binary alphabet
+   char text[64 + 1];
+   for (unsigned i = 0; i < 64; ++i)
+      text[i] = "ab"[(i * 7 + i / 5) % 3 == 0];
+   text[64] = '\0';
+   for (unsigned len = 1; len <= 8; ++len)
+      for (unsigned bits = 0; bits < (1u << len); ++bits)
+      {
+         char pat[8 + 1];
+         for (unsigned i = 0; i < len; ++i)
+            pat[i] = "ab"[(bits >> i) & 1];
+         pat[len] = '\0';
+         check(text, pat);
+      }
+
+   // non-byte elements
+   static const int a[] = {1,2,3,1,2,3,4,1,2,3,4,5};
+   static const int p0[] = {1,2,3,4,5};
+   static const int p1[] = {3,4,1};
+   static const int p2[] = {257,2};
+   check(a, a + countof(a), p0, p0 + countof(p0));
+   check(a, a + countof(a), p1, p1 + countof(p1));
+   check(a, a + countof(a), p2, p2 + countof(p2));
+}
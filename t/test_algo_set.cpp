@@ -3,6 +3,11 @@
 #include "ttl/functional.hpp"
 #include "ttl/array.hpp"
 #include "ttl/algorithm.hpp"
+#include "ttl/vector.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include <algorithm>
+#include <vector>
+#include <map>
 
 struct less_than
 {
@@ -26,6 +31,183 @@ static void print_ints(const char *title, const int *first, const int *last)
    fputs(".\n", stdout);
 }
 
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// sorted, with duplicates unless unique
+static void random_sorted(std::vector<int> &v, unsigned n, unsigned range, bool unique)
+{
+   v.clear();
+   for (unsigned i = 0; i < n; ++i)
+      v.push_back(rnd() % range);
+   std::sort(v.begin(), v.end());
+   if (unique)
+      v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+// the set operations against the standard ones, merging and galloping
+static void test_random()
+{
+   static const unsigned sizes[][2] = {
+      { 0, 0 }, { 0, 10 }, { 10, 0 }, { 1, 1 }, { 20, 20 }, { 100, 120 },
+      { 3, 1000 }, { 1000, 3 }, { 10, 5000 }, { 5000, 10 }, { 1, 40000 }, { 300, 3000 },
+   };
+   const int *a, *b;
+   for (unsigned round = 0; round < 40; ++round)
+      for (unsigned t = 0; t < countof(sizes); ++t)
+      {
+         std::vector<int> v1, v2, ref, out;
+         const unsigned range = 1 + rnd() % (round % 2 ? 100: 100000);
+         random_sorted(v1, sizes[t][0], range, round % 4 == 0);
+         random_sorted(v2, sizes[t][1], range, round % 4 == 0);
+         out.resize(v1.size() + v2.size() + 1);
+         a = v1.empty() ? 0: &v1[0];
+         b = v2.empty() ? 0: &v2[0];
+         const int *a_end = a + v1.size(), *b_end = b + v2.size();
+         int *o = &out[0];
+
+         std::set_union(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         assert(ttl::set_union(a, a_end, b, b_end, o) == o + ref.size());
+         assert(std::equal(ref.begin(), ref.end(), o));
+         ref.clear();
+         std::set_intersection(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         assert(ttl::set_intersection(a, a_end, b, b_end, o) == o + ref.size());
+         assert(std::equal(ref.begin(), ref.end(), o));
+         ref.clear();
+         std::set_difference(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         assert(ttl::set_difference(a, a_end, b, b_end, o) == o + ref.size());
+         assert(std::equal(ref.begin(), ref.end(), o));
+         ref.clear();
+         std::set_difference(v2.begin(), v2.end(), v1.begin(), v1.end(), std::back_inserter(ref));
+         assert(ttl::set_difference(b, b_end, a, a_end, o) == o + ref.size());
+         assert(std::equal(ref.begin(), ref.end(), o));
+         ref.clear();
+         std::set_symmetric_difference(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         assert(ttl::set_symmetric_difference(a, a_end, b, b_end, o) == o + ref.size());
+         assert(std::equal(ref.begin(), ref.end(), o));
+         ref.clear();
+         assert(ttl::includes(a, a_end, b, b_end) == std::includes(v1.begin(), v1.end(), v2.begin(), v2.end()));
+         assert(ttl::includes(b, b_end, a, a_end) == std::includes(v2.begin(), v2.end(), v1.begin(), v1.end()));
+         // a subset of a larger set, for the galloping includes
+         std::vector<int> sub;
+         for (unsigned i = 0; i < v1.size(); i += 1 + rnd() % 40)
+            sub.push_back(v1[i]);
+         assert(ttl::includes(v1.begin(), v1.end(), sub.begin(), sub.end()));
+         if (!sub.empty())
+         {
+            sub.back() += 1;
+            assert(ttl::includes(a, a_end, &sub[0], &sub[0] + sub.size()) ==
+                   std::includes(v1.begin(), v1.end(), sub.begin(), sub.end()));
+         }
+
+         // strictly increasing 32 bit integers, block by block
+         if (round % 4 == 0)
+         {
+            std::vector<unsigned> u1(v1.begin(), v1.end()), u2(v2.begin(), v2.end()), uout(out.size());
+            std::vector<unsigned> uref;
+            std::set_intersection(u1.begin(), u1.end(), u2.begin(), u2.end(), std::back_inserter(uref));
+            const unsigned *ua = u1.empty() ? 0: &u1[0], *ub = u2.empty() ? 0: &u2[0];
+            unsigned *uo = ttl::set_intersection_unique(ua, ua + u1.size(), ub, ub + u2.size(), &uout[0]);
+            assert(uo == &uout[0] + uref.size() && std::equal(uref.begin(), uref.end(), &uout[0]));
+         }
+
+         // in place, on a vector
+         ttl::vector<int> tv;
+         tv.reserve(v1.size() + v2.size());
+         for (unsigned i = 0; i < v1.size(); ++i)
+            tv.push_back(v1[i]);
+         std::set_union(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         ttl::inplace_set_union(tv, b, b_end);
+         assert(tv.size() == ref.size() && std::equal(ref.begin(), ref.end(), tv.begin()));
+         ref.clear();
+         std::vector<int> u(tv.begin(), tv.end());
+         std::set_difference(u.begin(), u.end(), v2.begin(), v2.end(), std::back_inserter(ref));
+         ttl::inplace_set_difference(tv, v2.begin(), v2.end());
+         assert(tv.size() == ref.size() && std::equal(ref.begin(), ref.end(), tv.begin()));
+         ttl::inplace_set_union(tv, b, b_end);
+         u.clear();
+         std::set_union(ref.begin(), ref.end(), v2.begin(), v2.end(), std::back_inserter(u));
+         assert(tv.size() == u.size() && std::equal(u.begin(), u.end(), tv.begin()));
+         ttl::inplace_set_intersection(tv, a, a_end);
+         ref.clear();
+         std::set_intersection(u.begin(), u.end(), v1.begin(), v1.end(), std::back_inserter(ref));
+         assert(tv.size() == ref.size() && std::equal(ref.begin(), ref.end(), tv.begin()));
+      }
+}
+
+static void test_sorted_vector_map()
+{
+   typedef ttl::sorted_vector_map<int, int> map_type;
+   for (unsigned round = 0; round < 200; ++round)
+   {
+      map_type m1, m2;
+      std::map<int, int> r1, r2;
+      const unsigned n1 = rnd() % (round % 2 ? 50: 2000), n2 = rnd() % (round % 3 ? 50: 2000);
+      for (unsigned i = 0; i < n1; ++i)
+      {
+         int k = rnd() % 3000;
+         m1[k] = i;
+         r1[k] = i;
+      }
+      for (unsigned i = 0; i < n2; ++i)
+      {
+         int k = rnd() % 3000;
+         m2[k] = -(int)i;
+         r2[k] = -(int)i;
+      }
+      map_type c = m1;
+      std::map<int, int> rc = r1;
+      for (std::map<int, int>::const_iterator i = r2.begin(); i != r2.end(); ++i)
+         rc.insert(*i);
+      c.unite(m2);
+      assert(c.size() == rc.size());
+      std::map<int, int>::const_iterator j = rc.begin();
+      for (map_type::const_iterator i = c.begin(); i != c.end(); ++i, ++j)
+         assert(i->first == j->first && i->second == j->second);
+
+      c = m1;
+      c.subtract(m2);
+      rc = r1;
+      for (std::map<int, int>::const_iterator i = r2.begin(); i != r2.end(); ++i)
+         rc.erase(i->first);
+      assert(c.size() == rc.size());
+      j = rc.begin();
+      for (map_type::const_iterator i = c.begin(); i != c.end(); ++i, ++j)
+         assert(i->first == j->first && i->second == j->second);
+
+      m1.intersect(m2);
+      unsigned n = 0;
+      for (std::map<int, int>::const_iterator i = r1.begin(); i != r1.end(); ++i)
+         if (r2.count(i->first))
+            assert(m1.at(i->first) == i->second && ++n);
+      assert(m1.size() == n);
+      m2.intersect(m2);
+      assert(m2.size() == r2.size());
+      m2.subtract(m2);
+      assert(m2.empty());
+   }
+
+   // a copy or a union of one element reserves a single slot, which
+   // must still grow on the next insert
+   map_type a;
+   a[1] = 1;
+   map_type b;
+   b = a;
+   b.insert(ttl::make_pair(2, 2));
+   assert(b.size() == 2 && b.at(1) == 1 && b.at(2) == 2);
+   map_type c;
+   c.unite(a);
+   c.insert(ttl::make_pair(0, 0));
+   c[3] = 3;
+   assert(c.size() == 3 && c.at(0) == 0 && c.at(1) == 1 && c.at(3) == 3);
+}
+
 void test()
 {
    int *p;
@@ -47,4 +229,7 @@ void test()
    static const ttl::array<int, countof(a0)> a3 = {{1,2,3,4}};
    p = ttl::merge(a3.cbegin(), a3.cend(), a2.cbegin(), a2.cend(), result);
    assert(ttl::is_sorted(result, result + countof(result)));
+
+   test_random();
+   test_sorted_vector_map();
 }
@@ -0,0 +1,96 @@
+// vim: sw=3 ts=8 et
+#include <pthread.h>
+#include "ttl/atomic_bitset.hpp"
+#include "t.hpp"
+
+template<class Bits>
+static void test_single(Bits &b)
+{
+   const ttl::size_t n = b.size();
+   assert(b.count() == 0 && !b.test(0));
+   assert(!b.test_and_set(5) && b.test_and_set(5) && b[5]);
+   assert(b.test_and_reset(5) && !b.test_and_reset(5));
+   assert(b.find_first_zero_and_set() == 0 && b.find_first_zero_and_set() == 1);
+
+   // from a hint, wrapping around
+   ttl::size_t hint = n - 2;
+   assert(b.find_first_zero_and_set(hint) == n - 2 && hint == n - 1);
+   assert(b.find_first_zero_and_set(hint) == n - 1 && hint == 0);
+   assert(b.find_first_zero_and_set(hint) == 2 && hint == 3);
+   hint = n - 1;
+   assert(b.find_first_zero_and_set(hint) == 3);
+   for (ttl::size_t i = 4; i < n - 2; ++i)
+      assert(b.find_first_zero_and_set(hint) == i);
+   assert(b.count() == n);
+   assert(b.find_first_zero_and_set(hint) == n && b.find_first_zero_and_set() == n);
+   b.reset(n / 2);
+   hint = n + 100;
+   assert(b.find_first_zero_and_set(hint) == n / 2 && b.count() == n);
+   b.reset();
+   assert(b.count() == 0);
+
+   // the hints of the threads are in different cache lines
+   ttl::size_t h0 = b.hint(0, 4), h1 = b.hint(1, 4);
+   assert(h0 == 0 && h1 < n && (n < 4 * 512 || h1 / 512 != h0 / 512));
+}
+
+static const ttl::size_t bits = 10000;
+static const int threads = 4;
+static ttl::dynamic_atomic_bitset<> *shared;
+static ttl::size_t got[threads][bits];
+static ttl::size_t ngot[threads];
+
+static void *allocate_all(void *arg)
+{
+   const int t = (int)(ttl::size_t)arg;
+   ttl::size_t hint = shared->hint(t, threads);
+   unsigned churn = 0;
+   for (;;)
+   {
+      const ttl::size_t pos = shared->find_first_zero_and_set(hint);
+      if (pos == shared->size())
+         break;
+      got[t][ngot[t]++] = pos;
+      // give some back to churn
+      if (pos % 3 == 0 && churn++ < bits / 10)
+      {
+         shared->reset(pos);
+         --ngot[t];
+      }
+   }
+   return 0;
+}
+
+void test()
+{
+   ttl::atomic_bitset<1000> a;
+   printf("sizeof atomic_bitset<1000> %lu\n", (unsigned long)sizeof(a));
+   assert((ttl::size_t)&a % ttl::cache_line_size == 0 || __alignof__(a) == ttl::cache_line_size);
+   test_single(a);
+   ttl::atomic_bitset<64> a64;
+   test_single(a64);
+   ttl::dynamic_atomic_bitset<> d(5000);
+   test_single(d);
+   ttl::dynamic_atomic_bitset<> d3(70);
+   test_single(d3);
+
+   // each bit is allocated once
+   ttl::dynamic_atomic_bitset<> s(bits);
+   shared = &s;
+   pthread_t th[threads];
+   for (int t = 0; t < threads; ++t)
+      pthread_create(&th[t], 0, allocate_all, (void *)(ttl::size_t)t);
+   for (int t = 0; t < threads; ++t)
+      pthread_join(th[t], 0);
+   assert(s.count() == bits);
+   static char seen[bits];
+   ttl::size_t total = 0;
+   for (int t = 0; t < threads; ++t)
+      for (ttl::size_t i = 0; i < ngot[t]; ++i)
+      {
+         assert(!seen[got[t][i]]);
+         seen[got[t][i]] = 1;
+         ++total;
+      }
+   assert(total == bits);
+}
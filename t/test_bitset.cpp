@@ -17,6 +17,119 @@ template<typename T> void print_bitset(const char *s, const T &bs)
    fputs(".\n", stdout);
 }
 
+// counts the positions visited by for_each_set_bit, keeps the first 64
+struct collect
+{
+   unsigned *pos;
+   unsigned n;
+   collect(unsigned *p): pos(p), n(0) {}
+   void operator()(ttl::size_t i)
+   {
+      if (pos && n < 64)
+         pos[n] = i;
+      ++n;
+   }
+};
+
+template<ttl::size_t N> static void test_find(const unsigned *pos, unsigned n)
+{
+   ttl::bitset<N> bs;
+   assert(bs.find_first() == N);
+   for (unsigned i = 0; i < n; ++i)
+      bs.set(pos[i]);
+   assert(bs.count() == n);
+
+   unsigned k = 0;
+   for (ttl::size_t i = bs.find_first(); i < bs.size(); i = bs.find_next(i))
+      assert(i == pos[k++]);
+   assert(k == n);
+
+   unsigned visited[64];
+   collect c = bs.for_each_set_bit(collect(visited));
+   assert(c.n == n);
+   for (unsigned i = 0; i < n; ++i)
+      assert(visited[i] == pos[i]);
+
+   // nothing is found past the end, even if the unused bits are set
+   bs.flip();
+   assert(bs.count() == N - n);
+   assert(bs.find_next(N - 1) == N && bs.find_next(N + 10) == N);
+   c = bs.for_each_set_bit(collect(visited));
+   assert(c.n == N - n);
+}
+
+// shifts and rotations against test()
+template<ttl::size_t N> static void test_shift(unsigned long long seed)
+{
+   ttl::bitset<N> bs;
+   for (ttl::size_t i = 0; i < N; ++i)
+   {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      if ((seed >> 40) & 1)
+         bs.set(i);
+   }
+   const ttl::size_t shifts[] = { 0, 1, 7, 31, 63, 64, 65, 100, N - 1, N, N + 1 };
+   for (unsigned k = 0; k < sizeof(shifts)/sizeof(*shifts); ++k)
+   {
+      const ttl::size_t sh = shifts[k];
+      const ttl::bitset<N> l = bs << sh, r = bs >> sh;
+      ttl::bitset<N> rl(bs), rr(bs);
+      rl.rotate_left(sh);
+      rr.rotate_right(sh);
+      for (ttl::size_t i = 0; i < N; ++i)
+      {
+         assert(l.test(i) == (i >= sh && bs.test(i - sh)));
+         assert(r.test(i) == (i + sh < N && bs.test(i + sh)));
+         assert(rl.test(i) == bs.test((i + N - sh % N) % N));
+         assert(rr.test(i) == bs.test((i + sh) % N));
+      }
+      assert(rl.count() == bs.count() && rr.count() == bs.count());
+   }
+}
+
+// the text and word forms against std::bitset
+template<ttl::size_t N> static void test_chars(unsigned long long seed)
+{
+   char text[N + 40], out[N + 1];
+   for (ttl::size_t len = N > 20 ? N - 20: 0; len <= N + 20; ++len)
+   {
+      for (ttl::size_t i = 0; i < len; ++i)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         text[i] = "01"[(seed >> 40) & 1];
+      }
+      text[len] = 0;
+      const ttl::bitset<N> bs(text);
+      const std::bitset<N> ref(text);
+      for (ttl::size_t i = 0; i < N; ++i)
+         assert(bs.test(i) == ref.test(i));
+      assert(bs.to_chars(out, out + N) == out + N);
+      out[N] = 0;
+      assert(ref.to_string() == out);
+      assert(bs.to_chars(out, out + N - 1) == 0 || N == 0);
+
+      // the custom characters and a length
+      for (ttl::size_t i = 0; i < len; ++i)
+         text[i] = text[i] == '1' ? 'x': '.';
+      const ttl::bitset<N> xs(text, len / 2, '.', 'x');
+      const std::bitset<N> xref(text, len / 2, '.', 'x');
+      for (ttl::size_t i = 0; i < N; ++i)
+         assert(xs.test(i) == xref.test(i));
+      xs.to_chars(out, out + N, '.', 'x');
+      out[N] = 0;
+      assert(xref.to_string('.', 'x') == out);
+
+      unsigned long long words[N / 64 + 2];
+      words[bs.word_count()] = 12345;
+      bs.to_words(words);
+      assert(words[bs.word_count()] == 12345);
+      ttl::bitset<N> back;
+      back.flip();
+      back.from_words(words, bs.word_count());
+      assert(back == bs);
+   }
+}
+
 ttl::bitset<16> &negate(ttl::bitset<16> &bs)
 {
    return bs = ~bs;
@@ -235,4 +348,54 @@ void test()
       assert(b16.any() == false);
       assert(b16.none() == true);
    }
+
+   {
+      const unsigned pos[] = { 0, 1, 31, 32, 63, 64, 65, 127, 128, 190, 199 };
+      test_find<200>(pos, 11);
+      test_find<256>(pos, 9);
+      test_find<64>(pos, 5);
+      const unsigned pos66[] = { 63, 65 };
+      test_find<66>(pos66, 2);
+      const unsigned none[] = { 0 };
+      test_find<5>(none, 0);
+      assert(ttl::bitset<5>(0x10ul).find_first() == 4);
+      assert(ttl::bitset<5>(0x10ul).find_next(4) == 5);
+      assert(ttl::bitset<0>().find_first() == 0);
+      assert(bs3.for_each_set_bit(collect(0)).n == 0);
+   }
+
+   test_shift<1>(1);
+   test_shift<64>(2);
+   test_shift<66>(3);
+   test_shift<200>(4);
+   test_shift<1024>(5);
+   {
+      // the unused bits are not shifted in
+      ttl::bitset<10> b10;
+      b10.flip();
+      assert((b10 >> 5).count() == 5);
+      b10.rotate_left(3);
+      assert(b10.count() == 10);
+      assert(ttl::bitset<8>(0x81ul).rotate_left(1).to_ulong() == 0x03);
+      assert(ttl::bitset<8>(0x81ul).rotate_right(1).to_ulong() == 0xc0);
+      bs3.rotate_left(1);
+   }
+
+   test_chars<1>(1);
+   test_chars<16>(2);
+   test_chars<64>(3);
+   test_chars<100>(4);
+   test_chars<1000>(5);
+   {
+      // parsing stops at the first other character
+      ttl::bitset<32> b("110x1111");
+      assert(b.to_ulong() == 6);
+      const unsigned long long w[] = { 0xffffffffffffffffull, 0xffull };
+      ttl::bitset<70> b70;
+      b70.from_words(w, 2);
+      assert(b70.count() == 70);
+      b70.from_words(w + 1, 1);
+      assert(b70.count() == 8);
+      assert(ttl::bitset<0>::word_count() == 0 && ttl::bitset<70>::word_count() == 2);
+   }
 }
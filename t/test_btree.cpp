@@ -0,0 +1,303 @@
+// vim: sw=3 ts=8 et
+#include "ttl/btree_map.hpp"
+#include "ttl/btree_set.hpp"
+#include "ttl/algorithm.hpp"
+#include "t.hpp"
+#include <map>
+#include <set>
+
+template class ttl::btree_map<int, int>;
+template class ttl::btree_set<unsigned>;
+
+// counts the live objects, so that the moves inside the nodes leak nothing
+struct counted
+{
+   static long live;
+   long key;
+   counted(long k = 0): key(k) { ++live; }
+   counted(const counted &other): key(other.key) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &other) { key = other.key; return *this; }
+   bool operator<(const counted &other) const { return key < other.key; }
+   bool operator==(const counted &other) const { return key == other.key; }
+};
+long counted::live = 0;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+template<class Map, class Ref>
+static void check_map(const Map &m, const Ref &ref)
+{
+   assert(m.size() == ref.size());
+   assert(m.empty() == ref.empty());
+   typename Map::const_iterator i = m.begin();
+   for (typename Ref::const_iterator j = ref.begin(); j != ref.end(); ++j, ++i)
+      assert(i != m.end() && i->first == j->first && i->second == j->second);
+   assert(i == m.end());
+   // and backwards
+   for (typename Ref::const_iterator j = ref.end(); j != ref.begin();)
+   {
+      --j;
+      --i;
+      assert(i->first == j->first);
+   }
+   assert(i == m.begin());
+}
+
+template<typename K>
+static void test_map(unsigned long n, unsigned long range)
+{
+   typedef ttl::btree_map<K, long> map_type;
+   map_type m;
+   std::map<K, long> ref;
+   for (unsigned long i = 0; i < n; ++i)
+   {
+      K k = (K)(rnd() % range);
+      switch (rnd() % 4)
+      {
+      case 0:
+      case 1:
+         {
+            bool inserted = m.insert(ttl::make_pair(k, (long)i)).second;
+            assert(inserted == ref.insert(std::make_pair(k, (long)i)).second);
+            break;
+         }
+      case 2:
+         m[k] = i;
+         ref[k] = i;
+         break;
+      case 3:
+         assert(m.erase(k) == ref.erase(k));
+         break;
+      }
+      if (i % 997 == 0)
+         check_map(m, ref);
+   }
+   check_map(m, ref);
+
+   for (unsigned long i = 0; i < 2000; ++i)
+   {
+      K k = (K)(rnd() % (range + 2));
+      typename map_type::iterator lo = m.lower_bound(k), up = m.upper_bound(k);
+      typename std::map<K, long>::iterator rlo = ref.lower_bound(k), rup = ref.upper_bound(k);
+      assert((lo == m.end()) == (rlo == ref.end()));
+      assert((up == m.end()) == (rup == ref.end()));
+      if (rlo != ref.end())
+         assert(lo->first == rlo->first);
+      if (rup != ref.end())
+         assert(up->first == rup->first);
+      assert(m.count(k) == ref.count(k));
+      assert((m.find(k) == m.end()) == (ref.find(k) == ref.end()));
+   }
+
+   // copies are rebuilt bottom up
+   map_type c(m);
+   check_map(c, ref);
+   assert(c == m);
+   map_type d;
+   d[1] = 1;
+   d = m;
+   assert(d == m);
+   d.swap(c);
+   assert(d == m && c == m);
+
+   // erasing by iterators
+   unsigned long erased = 0;
+   for (typename map_type::iterator i = m.begin(); i != m.end();)
+      if (i->second % 3 == 0)
+      {
+         ref.erase(i->first);
+         i = m.erase(i);
+         ++erased;
+      }
+      else
+         ++i;
+   check_map(m, ref);
+   if (m.size() > 10)
+   {
+      typename map_type::iterator first = m.begin(), last;
+      ++first;
+      last = first;
+      for (int i = 0; i < 7; ++i)
+         ++last;
+      typename std::map<K, long>::iterator rfirst = ref.begin(), rlast;
+      ++rfirst;
+      rlast = rfirst;
+      for (int i = 0; i < 7; ++i)
+         ++rlast;
+      typename map_type::iterator next = m.erase(first, last);
+      ref.erase(rfirst, rlast);
+      assert(next->first == rlast->first);
+      check_map(m, ref);
+   }
+   m.erase(m.begin(), m.end());
+   assert(m.empty() && m.begin() == m.end());
+   m.clear();
+   printf("btree_map<%lu byte key> %lu ops, %lu erased by iterator\n",
+          (unsigned long)sizeof(K), n, erased);
+}
+
+static void test_set()
+{
+   typedef ttl::btree_set<int> set_type;
+   typedef set_type::const_iterator const_iterator;
+   set_type s;
+   std::set<int> ref;
+   for (int i = 0; i < 20000; ++i)
+   {
+      int k = (int)(rnd() % 5000) - 2500;
+      if (rnd() % 3)
+         assert(s.insert(k).second == ref.insert(k).second);
+      else
+         assert(s.erase(k) == ref.erase(k));
+   }
+   assert(s.size() == ref.size());
+   assert(ttl::equal(s.begin(), s.end(), ref.begin()));
+   for (int k = -2600; k < 2600; ++k)
+   {
+      const_iterator lo = s.lower_bound(k), up = s.upper_bound(k);
+      std::set<int>::const_iterator rlo = ref.lower_bound(k), rup = ref.upper_bound(k);
+      assert(rlo == ref.end() ? lo == s.end(): *lo == *rlo);
+      assert(rup == ref.end() ? up == s.end(): *up == *rup);
+      assert(s.count(k) == ref.count(k));
+   }
+   // the extremes of the SSE2 compares
+   ttl::btree_set<unsigned> u;
+   ttl::btree_set<int> i;
+   for (unsigned k = 0; k < 100; ++k)
+   {
+      u.insert(k);
+      u.insert(0u - k - 1);
+      i.insert((int)(k + 0x7fffff00));
+      i.insert((int)(k + 0x80000000));
+   }
+   assert(u.size() == 200 && *u.begin() == 0 && *--u.end() == ~0u);
+   assert(*u.lower_bound(0x80000000u) == 0u - 100);
+   assert(*u.upper_bound(99) == 0u - 100);
+   assert(i.size() == 200 && *i.begin() == (int)0x80000000 && *--i.end() == 0x7fffff63);
+   assert(*i.lower_bound(0) == 0x7fffff00 && *i.upper_bound((int)0x80000063) == 0x7fffff00);
+}
+
+static void test_sorted()
+{
+   typedef ttl::btree_set<int> set_type;
+   const unsigned leaf = ttl::btree<int, int, ttl::select_same<int>, ttl::less<int>,
+                                    ttl::new_delete_resource>::leaf_max;
+   int sizes[] = { 0, 1, 2, (int)leaf - 1, (int)leaf, (int)leaf + 1, (int)leaf * 2 + 1, 1000, 100000 };
+   for (unsigned t = 0; t < countof(sizes); ++t)
+   {
+      ttl::vector<int> v;
+      v.reserve(sizes[t] * 2);
+      for (int i = 0; i < sizes[t]; ++i)
+      {
+         v.push_back(i * 2);
+         if (i % 5 == 0)
+            v.push_back(i * 2); // repeated keys are skipped
+      }
+      set_type s;
+      s.insert(-1);
+      s.assign_sorted(v.begin(), v.end());
+      assert(s.size() == (ttl::size_t)sizes[t]);
+      int expect = 0;
+      for (set_type::const_iterator i = s.begin(); i != s.end(); ++i, expect += 2)
+         assert(*i == expect);
+      // the tree stays valid for the updates
+      for (int i = 0; i < sizes[t]; ++i)
+         assert(s.insert(i * 2 + 1).second);
+      for (int i = 0; i < sizes[t]; i += 2)
+         assert(s.erase(i * 2) == 1);
+      assert(s.size() == (ttl::size_t)(sizes[t] + sizes[t] / 2));
+      // all of [0, 2 * size) but the multiples of 4
+      set_type::const_iterator i = s.begin();
+      for (expect = 0; expect < 2 * sizes[t]; ++expect)
+         if (expect % 4)
+            assert(*i++ == expect);
+      assert(i == s.end());
+   }
+
+   printf("btree_set<int>: %u values per leaf, %u keys per inner node\n", leaf,
+          (unsigned)ttl::btree<int, int, ttl::select_same<int>, ttl::less<int>,
+                               ttl::new_delete_resource>::inner_max);
+}
+
+static void test_counted()
+{
+   {
+      ttl::btree_map<counted, counted> m;
+      std::map<long, long> ref;
+      for (int i = 0; i < 30000; ++i)
+      {
+         long k = rnd() % 3000;
+         if (rnd() % 2)
+         {
+            m[counted(k)] = counted(i);
+            ref[k] = i;
+         }
+         else
+            assert(m.erase(counted(k)) == ref.erase(k));
+      }
+      assert(m.size() == ref.size());
+      ttl::btree_map<counted, counted> c(m);
+      assert(c == m);
+      std::map<long, long>::const_iterator j = ref.begin();
+      for (ttl::btree_map<counted, counted>::const_iterator i = c.begin(); i != c.end(); ++i, ++j)
+         assert(i->first.key == j->first && i->second.key == j->second);
+      // and the separators in the inner nodes
+      assert(counted::live >= 4 * (long)ref.size());
+   }
+   assert(counted::live == 0);
+}
+
+// counts the outstanding allocations
+struct counting_resource
+{
+   long *blocks;
+   counting_resource(long *n): blocks(n) {}
+   void *allocate(ttl::size_t size) { ++*blocks; return ::operator new(size); }
+   void deallocate(void *p, ttl::size_t)
+   {
+      if (!p)
+         return;
+      --*blocks;
+      ::operator delete(p);
+   }
+};
+
+void test()
+{
+   test_map<int>(200000, 20000);
+   test_map<unsigned>(100000, 1000);
+   test_map<long long>(100000, 50000);
+   test_map<short>(50000, 300);
+   test_set();
+   test_sorted();
+   test_counted();
+
+   // the references of the iterators are references to the values
+   ttl::btree_map<int, int> rm;
+   rm[1] = 1;
+   ttl::btree_map<int, int>::iterator::reference r = *rm.begin();
+   r.second = 2;
+   ttl::btree_map<int, int>::const_iterator::reference cr = *rm.cbegin();
+   assert(&cr == &r && rm[1] == 2 && rm.size() == 1);
+
+   long blocks = 0;
+   {
+      ttl::btree_map<int, int, ttl::less<int>, counting_resource> m((counting_resource(&blocks)));
+      for (int i = 0; i < 10000; ++i)
+         m[i * 7 % 10007] = i;
+      assert(blocks > 0);
+      for (int i = 0; i < 10000; i += 2)
+         m.erase(i * 7 % 10007);
+      ttl::btree_map<int, int, ttl::less<int>, counting_resource> c(m);
+      assert(c.get_resource().blocks == &blocks);
+   }
+   assert(blocks == 0);
+}
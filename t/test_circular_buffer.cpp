@@ -0,0 +1,151 @@
+// vim: sw=3 ts=8 et
+#include "ttl/circular_buffer.hpp"
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+#include "t.hpp"
+#include <deque>
+
+template class ttl::circular_buffer<int>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// a value which counts its instances, the buffer must destroy all
+struct counted
+{
+   static int live;
+   int value;
+   counted(): value(0) { ++live; }
+   counted(int v): value(v) { ++live; }
+   counted(const counted &o): value(o.value) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &o) { value = o.value; return *this; }
+   bool operator==(const counted &o) const { return value == o.value; }
+};
+int counted::live = 0;
+
+typedef ttl::circular_buffer<counted> buffer_type;
+
+static void check(const buffer_type &b, const std::deque<int> &ref)
+{
+   assert(b.size() == ref.size() && b.empty() == ref.empty());
+   assert(!b.capacity() || (b.capacity() & (b.capacity() - 1)) == 0);
+   assert(b.size() <= b.capacity() && (!b.limit() || b.size() <= b.limit()));
+   for (ttl::size_t i = 0; i < ref.size(); ++i)
+      assert(b[i].value == ref[i]);
+   buffer_type::const_iterator j = b.begin();
+   for (std::deque<int>::const_iterator i = ref.begin(); i != ref.end(); ++i, ++j)
+      assert(j->value == *i);
+   assert(j == b.end() && b.end() - b.begin() == (long)ref.size());
+   if (!ref.empty())
+      assert(b.front().value == ref.front() && b.back().value == ref.back());
+}
+
+static void test_random(ttl::size_t limit)
+{
+   buffer_type b;
+   std::deque<int> ref;
+   b.set_limit(limit);
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const int value = (int)(rnd() % 1000);
+      switch (rnd() % 8)
+      {
+      case 0:
+      case 1:
+         if (!ref.empty())
+         {
+            b.pop_front();
+            ref.pop_front();
+         }
+         break;
+      case 2:
+         if (!ref.empty())
+         {
+            b.pop_back();
+            ref.pop_back();
+         }
+         break;
+      case 3:
+         b.push_front(value);
+         ref.push_front(value);
+         if (limit && ref.size() > limit)
+            ref.pop_back();
+         break;
+      case 4:
+         if (!ref.empty())
+         {
+            // pushes one of its own elements
+            const ttl::size_t i = rnd() % ref.size();
+            b.push_back(b[i]);
+            ref.push_back(ref[i]);
+            if (limit && ref.size() > limit)
+               ref.pop_front();
+         }
+         break;
+      default:
+         b.push_back(value);
+         ref.push_back(value);
+         if (limit && ref.size() > limit)
+            ref.pop_front();
+      }
+      if (step % 64 == 0)
+         check(b, ref);
+   }
+   check(b, ref);
+
+   buffer_type c(b), d;
+   assert(c == b && (d != b || b.empty()) && c.limit() == limit);
+   check(c, ref);
+   d.push_back(-1);
+   d.swap(c);
+   check(d, ref);
+   assert(c.size() == 1 && c.front().value == -1);
+   c = d;
+   assert(c == b);
+   c.clear();
+   assert(c.empty() && c.begin() == c.end());
+}
+
+void test()
+{
+   test_random(0);
+   test_random(1);
+   test_random(10);
+   test_random(16);
+   test_random(300);
+   assert(counted::live == 0);
+
+   // a sliding window of the 4 last values
+   ttl::circular_buffer<int> w;
+   w.set_limit(4);
+   assert(w.capacity() == 4);
+   for (int i = 0; i < 10; ++i)
+      w.push_back(i);
+   assert(w.full() && w.size() == 4 && w.front() == 6 && w.back() == 9 && w.capacity() == 4);
+   w.set_limit(2);
+   assert(w.size() == 2 && w.front() == 8 && w[1] == 9);
+   w.set_limit(0);
+   for (int i = 0; i < 10; ++i)
+      w.push_front(i);
+   assert(!w.full() && w.size() == 12 && w.front() == 9 && w.back() == 9 && w.capacity() == 16);
+
+   // random access, a heap
+   const int a[] = { 5, 3, 9, 1, 7 };
+   ttl::circular_buffer<int> s(a, a + 5);
+   s.push_front(0);
+   s.pop_back();
+   ttl::make_heap(s.begin(), s.end());
+   assert(s[0] == 9 && s.size() == 5);
+   ttl::pop_heap(s.begin(), s.end());
+   assert(s[0] == 5 && s[4] == 9);
+   ttl::circular_buffer<int> n((ttl::size_t)3, 7);
+   assert(n.size() == 3 && n[2] == 7);
+   printf("sizeof circular_buffer<int>: %lu\n", (unsigned long)sizeof(ttl::circular_buffer<int>));
+}
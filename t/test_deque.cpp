@@ -0,0 +1,144 @@
+// vim: sw=3 ts=8 et
+#include "ttl/deque.hpp"
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+#include "t.hpp"
+#include <deque>
+
+template class ttl::deque<int>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// a value which counts its instances, the deque must destroy all
+struct counted
+{
+   static int live;
+   int value;
+   counted(): value(0) { ++live; }
+   counted(int v): value(v) { ++live; }
+   counted(const counted &o): value(o.value) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &o) { value = o.value; return *this; }
+   bool operator==(const counted &o) const { return value == o.value; }
+};
+int counted::live = 0;
+
+template<class Deque>
+static void check(const Deque &d, const std::deque<int> &ref)
+{
+   assert(d.size() == ref.size() && d.empty() == ref.empty());
+   for (ttl::size_t i = 0; i < ref.size(); ++i)
+      assert(d[i].value == ref[i]);
+   typename Deque::const_iterator j = d.begin();
+   for (std::deque<int>::const_iterator i = ref.begin(); i != ref.end(); ++i, ++j)
+      assert(j->value == *i);
+   assert(j == d.end() && d.end() - d.begin() == (long)ref.size());
+   if (!ref.empty())
+      assert(d.front().value == ref.front() && d.back().value == ref.back());
+}
+
+// the biased pushes and pops grow and shrink it by many blocks
+template<class Deque>
+static void test_random(unsigned bias)
+{
+   Deque d;
+   std::deque<int> ref;
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const int value = (int)(rnd() % 1000);
+      const unsigned op = (unsigned)(rnd() % 8);
+      if (op < bias && !ref.empty())
+      {
+         if (op & 1)
+         {
+            d.pop_front();
+            ref.pop_front();
+         }
+         else
+         {
+            d.pop_back();
+            ref.pop_back();
+         }
+      }
+      else if (op & 1)
+      {
+         d.push_front(value);
+         ref.push_front(value);
+      }
+      else
+      {
+         d.push_back(value);
+         ref.push_back(value);
+      }
+      if (step % 256 == 0)
+         check(d, ref);
+      if (step % 10000 == 0)
+         bias = 8 - bias;
+   }
+   check(d, ref);
+
+   Deque c(d), e;
+   assert(c == d && (e != d || d.empty()));
+   check(c, ref);
+   e.push_back(-1);
+   e.swap(c);
+   check(e, ref);
+   assert(c.size() == 1 && c.front().value == -1);
+   c = e;
+   assert(c == d);
+   c.clear();
+   assert(c.empty() && c.begin() == c.end());
+}
+
+struct big
+{
+   counted c;
+   char pad[200];
+   big(int v): c(v) {}
+};
+
+void test()
+{
+   test_random<ttl::deque<counted> >(3);
+   test_random<ttl::deque<counted> >(4);
+   test_random<ttl::deque<counted> >(5);
+   assert(counted::live == 0);
+
+   // the elements do not move when it grows at either end
+   ttl::deque<int> d;
+   d.push_back(1);
+   const int *p = &d.front();
+   for (int i = 0; i < 10000; ++i)
+   {
+      d.push_back(i);
+      d.push_front(i);
+   }
+   assert(p == &d[10000] && *p == 1 && d.size() == 20001);
+
+   // a FIFO
+   for (int i = 0; i < 100000; ++i)
+   {
+      d.push_back(i);
+      d.pop_front();
+   }
+   assert(d.size() == 20001 && d.back() == 99999);
+
+   // random access, a heap
+   ttl::make_heap(d.begin(), d.end());
+   assert(d[0] == 99999);
+   ttl::pop_heap(d.begin(), d.end());
+   assert(d.back() == 99999 && d[0] == 99998);
+
+   ttl::deque<int> n((ttl::size_t)1000, 7);
+   assert(n.size() == 1000 && n[999] == 7);
+   printf("deque<int>: %lu bytes, blocks of %lu\n",
+          (unsigned long)sizeof(ttl::deque<int>), (unsigned long)ttl::deque<int>::block_size);
+   printf("deque<big>: blocks of %lu\n", (unsigned long)ttl::deque<big>::block_size);
+}
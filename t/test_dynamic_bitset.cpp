@@ -0,0 +1,158 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/memory_resource.hpp"
+#include "ttl/vector.hpp"
+#include "ttl/dynamic_bitset.hpp"
+#include "t.hpp"
+
+typedef ttl::dynamic_bitset<> bits;
+
+template class ttl::dynamic_bitset<>;
+
+// checks the set against a vector of bools
+static void check(const bits &b, const ttl::vector<bool> &v)
+{
+   assert(b.size() == v.size());
+   ttl::size_t n = 0;
+   for (ttl::size_t i = 0; i < v.size(); ++i)
+   {
+      assert(b.test(i) == v[i]);
+      n += v[i];
+   }
+   assert(b.count() == n);
+   assert(b.any() == (n != 0) && b.none() == (n == 0));
+   assert(b.all() == (n == v.size()));
+   ttl::size_t k = 0;
+   for (ttl::size_t i = b.find_first(); i < b.size(); i = b.find_next(i), ++k)
+      assert(v[i]);
+   assert(k == n);
+   // the unused bits are kept 0
+   if (b.size() % (sizeof(bits::slot_type) * CHAR_BIT))
+      assert(!(b.slot(b.num_slots() - 1) >> b.size() % (sizeof(bits::slot_type) * CHAR_BIT)));
+}
+
+static void random_bits(bits &b, ttl::vector<bool> &v, ttl::size_t n, unsigned long long &seed)
+{
+   b.resize(0);
+   v.clear();
+   for (ttl::size_t i = 0; i < n; ++i)
+   {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      bool x = (seed >> 40) % 3 == 0;
+      b.push_back(x);
+      v.push_back(x);
+   }
+}
+
+struct counter
+{
+   ttl::size_t n, last;
+   counter(): n(0), last(0) {}
+   void operator()(ttl::size_t i) { ++n; last = i; }
+};
+
+void test()
+{
+   bits e;
+   assert(e.empty() && e.size() == 0 && e.count() == 0 && e.find_first() == 0);
+   assert(e.none() && e.all());
+
+   bits b(100);
+   assert(b.size() == 100 && b.none() && b.capacity() >= 100);
+   b.set(3).set(64).set(99);
+   assert(b.count() == 3 && b.find_first() == 3 && b.find_next(3) == 64 && b.find_next(64) == 99);
+   assert(b.find_next(99) == 100);
+   b[64] = false;
+   b[65].flip();
+   assert(!b[64] && b[65] && b.count() == 3);
+   counter c = b.for_each_set_bit(counter());
+   assert(c.n == 3 && c.last == 99);
+
+   bits f(70, true);
+   assert(f.all() && f.count() == 70);
+   f.resize(130, true);
+   assert(f.all() && f.count() == 130);
+   f.resize(65);
+   assert(f.count() == 65);
+   f.resize(200);
+   assert(f.count() == 65 && !f.test(65) && !f.test(199));
+   f.flip();
+   assert(f.count() == 135 && f.find_first() == 65);
+   assert((~f).count() == 65 && (~f).find_first() == 0);
+
+   // word appends at any bit offset
+   bits w;
+   w.append(0x5ul);
+   assert(w.size() == sizeof(bits::slot_type) * CHAR_BIT && w.count() == 2);
+   w.push_back(true);
+   w.append(0x3ul);
+   assert(w.count() == 5 && w.test(sizeof(bits::slot_type) * CHAR_BIT + 2));
+   const bits::slot_type words[] = { (bits::slot_type)-1, 1ul };
+   w.append(words, 2);
+   assert(w.count() == 5 + sizeof(bits::slot_type) * CHAR_BIT + 1);
+
+   unsigned long long seed = 7;
+   const ttl::size_t sizes[] = { 1, 63, 64, 65, 127, 128, 129, 300, 1000 };
+   for (unsigned s = 0; s < sizeof(sizes)/sizeof(*sizes); ++s)
+   {
+      const ttl::size_t n = sizes[s];
+      bits x, y;
+      ttl::vector<bool> vx, vy;
+      random_bits(x, vx, n, seed);
+      random_bits(y, vy, n, seed);
+      check(x, vx);
+      check(y, vy);
+
+      ttl::vector<bool> r(vx);
+      for (ttl::size_t i = 0; i < n; ++i) r[i] = vx[i] && vy[i];
+      check(x & y, r);
+      for (ttl::size_t i = 0; i < n; ++i) r[i] = vx[i] || vy[i];
+      check(x | y, r);
+      for (ttl::size_t i = 0; i < n; ++i) r[i] = vx[i] != vy[i];
+      check(x ^ y, r);
+      for (ttl::size_t i = 0; i < n; ++i) r[i] = vx[i] && !vy[i];
+      check(x - y, r);
+      for (ttl::size_t i = 0; i < n; ++i) r[i] = !vx[i];
+      check(~x, r);
+
+      const ttl::size_t shifts[] = { 0, 1, 13, 63, 64, 65, 128, 200, n - 1, n, n + 5 };
+      for (unsigned k = 0; k < sizeof(shifts)/sizeof(*shifts); ++k)
+      {
+         const ttl::size_t sh = shifts[k];
+         for (ttl::size_t i = 0; i < n; ++i)
+            r[i] = i >= sh && vx[i - sh];
+         check(x << sh, r);
+         for (ttl::size_t i = 0; i < n; ++i)
+            r[i] = i + sh < n && vx[i + sh];
+         check(x >> sh, r);
+      }
+
+      bits z(x);
+      assert(z == x && !(z != x));
+      z.flip(n - 1);
+      assert(z != x);
+      z = y;
+      assert(z == y);
+      z.swap(x);
+      assert(x == y);
+      check(x, vy);
+      check(z, vx);
+   }
+
+   {
+      // the slots from an arena
+      ttl::monotonic_arena arena;
+      typedef ttl::dynamic_bitset<ttl::resource_ref<ttl::monotonic_arena> > arena_bits;
+      arena_bits a(1000, false, arena);
+      a.set(999);
+      assert(arena.allocated() >= 1000 / CHAR_BIT);
+      arena_bits a2(a);
+      assert(a2 == a && a2.find_first() == 999);
+      a2.reset();
+      assert(a2.none() && a.count() == 1);
+      arena_bits a3(arena);
+      for (int i = 0; i < 500; ++i)
+         a3.push_back(i % 2);
+      assert(a3.count() == 250 && a3.find_first() == 1);
+   }
+}
@@ -0,0 +1,442 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/fixed_list.hpp"
+#include "ttl/fixed_forward_list.hpp"
+#include "ttl/fixed_backward_list.hpp"
+#include "t.hpp"
+#include <list>
+
+template class ttl::fixed_list<int, 10>;
+template class ttl::fixed_forward_list<int, 10>;
+template class ttl::fixed_backward_list<int, 10>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// a value which counts its instances, the lists must destroy all
+struct counted
+{
+   static int live;
+   int value;
+   counted(): value(0) { ++live; }
+   counted(int v): value(v) { ++live; }
+   counted(const counted &o): value(o.value) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &o) { value = o.value; return *this; }
+   bool operator==(const counted &o) const { return value == o.value; }
+   bool operator<(const counted &o) const { return value < o.value; }
+};
+int counted::live = 0;
+
+static bool is_odd(const counted &c) { return c.value & 1; }
+
+template<class List>
+static void check(const List &l, const std::list<int> &ref, ttl::size_t n)
+{
+   std::list<int>::const_iterator j = ref.begin();
+   for (typename List::const_iterator i = l.begin(); i != l.end(); ++i, ++j)
+      assert(j != ref.end() && i->value == *j);
+   assert(j == ref.end() && l.size() == ref.size() && l.empty() == ref.empty());
+   assert(l.full() == (ref.size() == n));
+}
+
+template<class List>
+static void sorted(List &l, std::list<int> &ref, unsigned k)
+{
+   ref.clear();
+   for (int v = (int)(rnd() % 4); k--; v += (int)(rnd() % 4))
+      ref.push_back(v);
+   l.assign(ref.begin(), ref.end());
+}
+
+static void test_list()
+{
+   const ttl::size_t n = 16;
+   typedef ttl::fixed_list<counted, n> list_type;
+   list_type l, o;
+   std::list<int> ref, oref;
+   for (unsigned step = 0; step < 20000; ++step)
+   {
+      const int v = (int)(rnd() % 8);
+      const ttl::size_t pos = ref.empty() ? 0: rnd() % ref.size();
+      list_type::iterator i = l.begin();
+      std::list<int>::iterator j = ref.begin();
+      for (ttl::size_t k = 0; k < pos; ++k)
+         ++i, ++j;
+      switch (rnd() % 16)
+      {
+      case 0:
+         if (ref.size() < n)
+         {
+            assert(l.insert(i, counted(v))->value == v);
+            ref.insert(j, v);
+         }
+         else
+            assert(l.insert(i, counted(v)) == l.end());
+         break;
+      case 1:
+         if (!ref.empty())
+         {
+            l.erase(i);
+            ref.erase(j);
+         }
+         break;
+      case 2:
+      {
+         list_type::iterator last = i;
+         std::list<int>::iterator rlast = j;
+         for (unsigned k = rnd() % 4; k && last != l.end(); --k)
+            ++last, ++rlast;
+         assert(l.erase(i, last) == last);
+         ref.erase(j, rlast);
+         break;
+      }
+      case 3:
+         if (ref.size() < n)
+            ref.push_front(v);
+         l.push_front(counted(v));
+         break;
+      case 4:
+         if (!ref.empty())
+         {
+            l.pop_front();
+            ref.pop_front();
+         }
+         break;
+      case 5:
+         if (!ref.empty())
+         {
+            l.pop_back();
+            ref.pop_back();
+         }
+         break;
+      case 6:
+      {
+         const ttl::size_t k = rnd() % (n + 4);
+         l.resize(k, counted(v));
+         ref.resize(k < n ? k: n, v);
+         break;
+      }
+      case 7:
+         l.remove(counted(v));
+         ref.remove(v);
+         break;
+      case 8:
+         l.remove_if(is_odd);
+         for (j = ref.begin(); j != ref.end();)
+            j = *j & 1 ? ref.erase(j): ++j;
+         break;
+      case 9:
+         l.unique();
+         ref.unique();
+         break;
+      case 10:
+         l.reverse();
+         ref.reverse();
+         break;
+      case 11:
+         // the same list: relinks
+         if (!ref.empty())
+         {
+            l.splice(l.begin(), l, i);
+            ref.splice(ref.begin(), ref, j);
+            l.splice(l.end(), l, l.begin(), ++l.begin());
+            ref.splice(ref.end(), ref, ref.begin(), ++ref.begin());
+         }
+         break;
+      case 12:
+         // another list: copies what fits
+         for (unsigned k = rnd() % 6; k--;)
+         {
+            o.push_back(counted(v + (int)k));
+            if (oref.size() < n)
+               oref.push_back(v + (int)k);
+         }
+         if (!oref.empty())
+         {
+            l.splice(i, o, o.begin());
+            if (ref.size() < n)
+               ref.splice(j, oref, oref.begin());
+         }
+         l.splice(l.end(), o);
+         while (ref.size() < n && !oref.empty())
+            ref.splice(ref.end(), oref, oref.begin());
+         break;
+      case 13:
+         sorted(o, oref, (unsigned)(rnd() % 10));
+         if (ref.size() + oref.size() <= n)
+         {
+            sorted(l, ref, (unsigned)(rnd() % (n - oref.size() + 1)));
+            l.merge(o);
+            ref.merge(oref);
+            assert(o.empty());
+         }
+         break;
+      case 14:
+         l.swap(o);
+         ref.swap(oref);
+         break;
+      default:
+         if (ref.size() < n)
+            ref.push_back(v);
+         l.push_back(counted(v));
+      }
+      check(l, ref, n);
+      check(o, oref, n);
+   }
+   list_type c(l);
+   assert(c == l && counted::live == (int)(l.size() + o.size() + c.size()));
+   c = o;
+   assert(c == o && (c != l) == (o != l));
+   c.assign(3, counted(7));
+   assert(c.size() == 3 && c.front().value == 7 && c.back().value == 7);
+   const int a[] = { 1, 2, 3 };
+   list_type r(a, a + countof(a));
+   assert(r.size() == 3 && r.back().value == 3 && (--r.end())->value == 3);
+   c.assign(r.begin(), r.end());
+   assert(c == r);
+
+   // a merge into a full list stops, the rest stays in the other one
+   const int b[] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18 }, d[] = { 1, 3, 5, 7, 9, 11, 13, 15 };
+   list_type even(b, b + countof(b)), odd(d, d + countof(d));
+   even.merge(odd);
+   assert(even.full() && odd.size() == 2 && odd.front().value == 13);
+   for (int k = 0; k < 12; ++k)
+      assert(ttl::find(even.begin(), even.end(), counted(k)) != even.end());
+}
+
+static void test_forward_list()
+{
+   const ttl::size_t n = 12;
+   typedef ttl::fixed_forward_list<counted, n> list_type;
+   list_type l, o;
+   std::list<int> ref, oref;
+   for (unsigned step = 0; step < 20000; ++step)
+   {
+      const int v = (int)(rnd() % 8);
+      const ttl::size_t pos = rnd() % (ref.size() + 1);
+      list_type::iterator i = l.before_begin();
+      std::list<int>::iterator j = ref.begin();
+      for (ttl::size_t k = 0; k < pos; ++k)
+         ++i, ++j;
+      switch (rnd() % 14)
+      {
+      case 0:
+         if (ref.size() < n)
+         {
+            assert(l.insert_after(i, counted(v))->value == v);
+            ref.insert(j, v);
+         }
+         else
+            assert(l.insert_after(i, counted(v)) == l.end());
+         break;
+      case 1:
+         if (j != ref.end())
+         {
+            l.erase_after(i);
+            ref.erase(j);
+         }
+         break;
+      case 2:
+      {
+         // erases (i, last), the values between
+         list_type::iterator last = i;
+         unsigned steps = 0;
+         for (unsigned k = rnd() % 4; k && last != l.end(); --k, ++steps)
+            ++last;
+         std::list<int>::iterator rlast = j;
+         for (unsigned k = 1; k < steps; ++k)
+            ++rlast;
+         if (steps)
+         {
+            assert(l.erase_after(i, last) == last);
+            ref.erase(j, rlast);
+         }
+         break;
+      }
+      case 3:
+         if (ref.size() < n)
+            ref.push_front(v);
+         l.push_front(counted(v));
+         break;
+      case 4:
+         if (!ref.empty())
+         {
+            l.pop_front();
+            ref.pop_front();
+         }
+         break;
+      case 5:
+      {
+         const ttl::size_t k = rnd() % (n + 4);
+         if (rnd() % 2)
+         {
+            l.resize(k, counted(v));
+            ref.resize(k < n ? k: n, v);
+         }
+         else
+         {
+            l.resize(k);
+            ref.resize(k < n ? k: n, 0);
+         }
+         break;
+      }
+      case 6:
+         l.remove(counted(v));
+         ref.remove(v);
+         break;
+      case 7:
+         l.remove_if(is_odd);
+         for (j = ref.begin(); j != ref.end();)
+            j = *j & 1 ? ref.erase(j): ++j;
+         break;
+      case 8:
+         l.unique();
+         ref.unique();
+         break;
+      case 9:
+         l.reverse();
+         ref.reverse();
+         break;
+      case 10:
+         // the same list: moves the value after i to the front
+         if (j != ref.end())
+         {
+            l.splice_after(l.before_begin(), l, i);
+            ref.splice(ref.begin(), ref, j);
+         }
+         break;
+      case 11:
+         // another list: copies what fits
+         for (unsigned k = rnd() % 6; k--;)
+         {
+            o.push_front(counted(v + (int)k));
+            if (oref.size() < n)
+               oref.push_front(v + (int)k);
+         }
+         l.splice_after(i, o);
+         while (ref.size() < n && !oref.empty())
+            ref.splice(j, oref, oref.begin());
+         break;
+      case 12:
+         sorted(o, oref, (unsigned)(rnd() % 8));
+         if (ref.size() + oref.size() <= n)
+         {
+            sorted(l, ref, (unsigned)(rnd() % (n - oref.size() + 1)));
+            l.merge(o);
+            ref.merge(oref);
+            assert(o.empty());
+         }
+         break;
+      default:
+         l.swap(o);
+         ref.swap(oref);
+      }
+      check(l, ref, n);
+      check(o, oref, n);
+   }
+   list_type c(l);
+   assert(c == l && counted::live == (int)(l.size() + o.size() + c.size()));
+   c = o;
+   assert(c == o);
+}
+
+static void test_backward_list()
+{
+   const ttl::size_t n = 8;
+   typedef ttl::fixed_backward_list<counted, n> list_type;
+   list_type l, o;
+   std::list<int> ref, oref;
+   for (unsigned step = 0; step < 20000; ++step)
+   {
+      const int v = (int)(rnd() % 100);
+      const ttl::size_t pos = rnd() % (ref.size() + 1);
+      list_type::iterator i = l.before_begin();
+      std::list<int>::iterator j = ref.begin();
+      for (ttl::size_t k = 0; k < pos; ++k)
+         ++i, ++j;
+      switch (rnd() % 8)
+      {
+      case 0:
+         if (ref.size() < n)
+         {
+            assert(l.insert_after(i, counted(v))->value == v);
+            ref.insert(j, v);
+         }
+         else
+            assert(l.insert_after(i, counted(v)) == l.end());
+         break;
+      case 1:
+         if (j != ref.end())
+         {
+            l.erase_after(i);
+            ref.erase(j);
+         }
+         break;
+      case 2:
+         // to the end
+         l.erase_after(i, l.end());
+         ref.erase(j, ref.end());
+         break;
+      case 3:
+         if (ref.size() < n)
+            ref.push_front(v);
+         l.push_front(counted(v));
+         break;
+      case 4:
+         if (!ref.empty())
+         {
+            l.pop_front();
+            ref.pop_front();
+         }
+         break;
+      case 5:
+         l.reverse();
+         ref.reverse();
+         break;
+      case 6:
+         l.swap(o);
+         ref.swap(oref);
+         break;
+      default:
+         if (ref.size() < n)
+            ref.push_back(v);
+         l.push_back(counted(v));
+      }
+      check(l, ref, n);
+      check(o, oref, n);
+      assert(ref.empty() ? l.before_end() == l.before_begin(): l.back().value == ref.back());
+   }
+   const int a[] = { 1, 2, 3 };
+   list_type c(a, a + countof(a));
+   c.insert_after(c.before_end(), 2, counted(4));
+   c.push_back(counted(5));
+   assert(c.size() == 6 && c.back().value == 5);
+}
+
+void test()
+{
+   test_list();
+   test_forward_list();
+   test_backward_list();
+   assert(counted::live == 0);
+
+   // a queue in a pool: the freed nodes are reused
+   ttl::fixed_backward_list<int, 4> q;
+   for (int i = 0; i < 1000; ++i)
+   {
+      q.push_back(i);
+      if (q.full())
+         q.pop_front();
+   }
+   assert(q.size() == 3 && q.front() == 997 && q.back() == 999);
+   printf("sizeof fixed_list<int, 16>: %lu, of fixed_forward_list<int, 16>: %lu\n",
+          (unsigned long)sizeof(ttl::fixed_list<int, 16>), (unsigned long)sizeof(ttl::fixed_forward_list<int, 16>));
+}
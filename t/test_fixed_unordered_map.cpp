@@ -0,0 +1,151 @@
+// vim: sw=3 ts=8 et
+#include "ttl/fixed_unordered_map.hpp"
+#include "t.hpp"
+#include <map>
+#include <set>
+
+template class ttl::fixed_unordered_map<int, int, 100>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// a few home slots for all the keys: long runs, which wrap round the table
+struct bad_hash
+{
+   ttl::size_t operator()(int key) const { return (ttl::size_t)(key % 3) * 5 + 55; }
+};
+
+// a value which counts its instances, the map must destroy all
+struct counted
+{
+   static int live;
+   int value;
+   counted(): value(0) { ++live; }
+   counted(int v): value(v) { ++live; }
+   counted(const counted &o): value(o.value) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &o) { value = o.value; return *this; }
+   bool operator==(const counted &o) const { return value == o.value; }
+};
+int counted::live = 0;
+
+template<class Map>
+static void check(const Map &m, const std::map<int, int> &ref)
+{
+   assert(m.size() == ref.size() && m.empty() == ref.empty() && m.full() == (ref.size() == m.max_size()));
+   std::set<int> seen;
+   for (typename Map::const_iterator i = m.begin(); i != m.end(); ++i)
+   {
+      std::map<int, int>::const_iterator j = ref.find(i->first);
+      assert(j != ref.end() && j->second == i->second.value && seen.insert(i->first).second);
+   }
+   assert(seen.size() == ref.size());
+}
+
+template<class Map>
+static void test_random(int range)
+{
+   Map m;
+   std::map<int, int> ref;
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const int key = (int)(rnd() % range);
+      const int value = (int)(rnd() % 1000);
+      switch (rnd() % 8)
+      {
+      case 0:
+      case 1:
+         assert(m.erase(key) == ref.erase(key));
+         break;
+      case 2:
+         if (ref.count(key) || ref.size() < m.max_size())
+         {
+            m[key] = counted(value);
+            ref[key] = value;
+         }
+         break;
+      case 3:
+      {
+         // erases some while iterating, visits each value once
+         std::set<int> seen;
+         for (typename Map::iterator i = m.begin(); i != m.end();)
+         {
+            assert(seen.insert(i->first).second);
+            if (i->first % 5 == key % 5)
+            {
+               ref.erase(i->first);
+               i = m.erase(i);
+            }
+            else
+               ++i;
+         }
+         break;
+      }
+      default:
+      {
+         ttl::pair<typename Map::iterator, bool> r = m.insert(ttl::make_pair(key, counted(value)));
+         if (ref.count(key))
+            assert(!r.second && r.first->first == key && r.first->second.value == ref[key]);
+         else if (ref.size() == m.max_size())
+            assert(!r.second && r.first == m.end());
+         else
+         {
+            assert(r.second && r.first->first == key && r.first->second.value == value);
+            ref[key] = value;
+         }
+      }
+      }
+      const int probe = (int)(rnd() % range);
+      assert(m.count(probe) == ref.count(probe));
+      assert(ref.count(probe) ? m.find(probe)->second.value == ref[probe]: m.find(probe) == m.end());
+      if (step % 64 == 0)
+         check(m, ref);
+   }
+   check(m, ref);
+
+   Map c(m), d;
+   assert(c == m && d != m);
+   check(c, ref);
+   d[-1] = counted(1);
+   d.swap(c);
+   check(d, ref);
+   assert(c.size() == 1 && c.find(-1)->second.value == 1);
+   c = d;
+   assert(c == m);
+   c.clear();
+   assert(c.empty() && c.begin() == c.end());
+}
+
+void test()
+{
+   test_random<ttl::fixed_unordered_map<int, counted, 64> >(100);
+   test_random<ttl::fixed_unordered_map<int, counted, 64> >(1000);
+   test_random<ttl::fixed_unordered_map<int, counted, 40, bad_hash> >(100);
+   test_random<ttl::fixed_unordered_map<int, counted, 1000> >(1200);
+   assert(counted::live == 0);
+
+   // full() as in fixed_vector: the inserts of new keys do nothing
+   ttl::fixed_unordered_map<unsigned, int, 5> m;
+   for (unsigned k = 0; k < 10; ++k)
+      m.insert(ttl::make_pair(k << 20, (int)k));
+   assert(m.full() && m.size() == 5 && m.count(4u << 20) && !m.count(5u << 20));
+   assert(m.insert(ttl::make_pair(3u << 20, 0)).first->second == 3);
+   m.erase(0u);
+   assert(!m.full() && m.insert(ttl::make_pair(9u << 20, 9)).second && m[9u << 20] == 9);
+
+   // a map from ranges
+   const ttl::pair<const char *, int> a[] = {
+      ttl::make_pair("a", 1), ttl::make_pair("b", 2), ttl::make_pair("c", 3)
+   };
+   ttl::fixed_unordered_map<const char *, int, 8> p(a, a + 3);
+   assert(p.size() == 3 && p[a[1].first] == 2);
+   printf("sizeof fixed_unordered_map<int, int, 100>: %lu, %lu slots\n",
+          (unsigned long)sizeof(ttl::fixed_unordered_map<int, int, 100>),
+          (unsigned long)ttl::fixed_unordered_map<int, int, 100>().bucket_count());
+}
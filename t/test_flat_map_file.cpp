@@ -0,0 +1,106 @@
+// vim: sw=3 ts=8 et
+#include "ttl/flat_map_file.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/map.hpp"
+#include "t.hpp"
+#include <stdlib.h>
+#include <unistd.h>
+#include <map>
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+struct point
+{
+   short x, y;
+};
+
+// the lookups of every key and of the keys around, against std::map
+template<class View>
+static void check(const View &v, const std::map<int, point> &ref)
+{
+   assert(v.is_open() && v.size() == ref.size() && v.empty() == ref.empty());
+   std::map<int, point>::const_iterator j = ref.begin();
+   for (typename View::const_iterator i = v.begin(); i != v.end(); ++i, ++j)
+      assert(i.key() == j->first && i.value().x == j->second.x && (*i).second.y == j->second.y);
+   assert(j == ref.end());
+   for (j = ref.begin(); j != ref.end(); ++j)
+      for (int key = j->first - 1; key <= j->first + 1; ++key)
+      {
+         std::map<int, point>::const_iterator lo = ref.lower_bound(key), up = ref.upper_bound(key);
+         typename View::const_iterator f = v.find(key);
+         assert(ref.count(key) ? f != v.end() && f.key() == key: f == v.end());
+         assert(v.count(key) == ref.count(key));
+         assert(lo == ref.end() ? v.lower_bound(key) == v.end(): v.lower_bound(key).key() == lo->first);
+         assert(up == ref.end() ? v.upper_bound(key) == v.end(): v.upper_bound(key).key() == up->first);
+      }
+   assert(v.lower_bound(-1000000) == v.begin() && v.find(1000000) == v.end());
+}
+
+static void test_strides(const char *path)
+{
+   static const ttl::size_t sizes[] = { 0, 1, 2, 15, 16, 17, 100, 1000, 4097 };
+   static const ttl::size_t strides[] = { 0, 1, 3, 16, 64 };
+   for (unsigned s = 0; s < countof(sizes); ++s)
+   {
+      ttl::sorted_vector_map<int, point> m;
+      std::map<int, point> ref;
+      while (ref.size() < sizes[s])
+      {
+         int key = (int)(rnd() % (sizes[s] * 4)) - (int)sizes[s];
+         point p = { (short)key, (short)rnd() };
+         m[key] = p;
+         ref[key] = p;
+      }
+      for (unsigned k = 0; k < countof(strides); ++k)
+      {
+         assert(ttl::write_flat_map(path, m, strides[k]));
+         ttl::flat_map_view<int, point> v;
+         assert(v.open(path));
+         check(v, ref);
+      }
+   }
+}
+
+void test()
+{
+   char path[] = "/tmp/test_flat_map_file.XXXXXX";
+   int fd = mkstemp(path);
+   assert(fd >= 0);
+   close(fd);
+   test_strides(path);
+
+   // from a map with a reverse order
+   ttl::map<int, int, ttl::greater<int> > g;
+   for (int i = 0; i < 100; ++i)
+      g[i * 3] = i;
+   assert(ttl::write_flat_map(path, g, 4));
+   ttl::flat_map_view<int, int, ttl::greater<int> > v;
+   assert(v.open(path));
+   assert(v.begin().key() == 297 && v.find(30).value() == 10 && v.lower_bound(31).key() == 30);
+   printf("%lu elements from %d to %d\n", (unsigned long)v.size(), v.begin().key(), (--v.end()).key());
+
+   // only the files of the same key and value types
+   ttl::flat_map_view<int, long long> wrong;
+   assert(!wrong.open(path) && !wrong.is_open());
+   assert(!v.open("/nonexistent/test_flat_map_file") && !v.is_open());
+
+   // a copy in memory, and the damaged copies
+   ttl::flat_map_view<int, int, ttl::greater<int> > mem;
+   FILE *f = fopen(path, "rb");
+   assert(f);
+   static unsigned long long data[1024];
+   const ttl::size_t size = fread(data, 1, sizeof(data), f);
+   fclose(f);
+   assert(mem.attach(data, size) && mem.size() == 100 && mem.find(297).value() == 99);
+   assert(!mem.attach(data, size - 1) && !mem.attach(data, 16));
+   reinterpret_cast<char *>(data)[0] ^= 1;
+   assert(!mem.attach(data, size));
+   unlink(path);
+}
@@ -0,0 +1,199 @@
+// vim: sw=3 ts=8 et
+#include "ttl/intrusive_list.hpp"
+#include "ttl/intrusive_slist.hpp"
+#include "ttl/intrusive_rbtree.hpp"
+#include "t.hpp"
+
+// one object in four containers at once
+struct conn
+{
+   int fd;
+   ttl::list_node by_age;
+   ttl::list_node by_owner;
+   ttl::slist_node free;
+   ttl::rbnode by_fd;
+
+   bool operator<(const conn &o) const { return fd < o.fd; }
+   bool operator==(const conn &o) const { return fd == o.fd; }
+};
+
+struct fd_of
+{
+   const int &operator()(const conn &c) const { return c.fd; }
+};
+
+typedef ttl::intrusive_list<conn, &conn::by_age> age_list;
+typedef ttl::intrusive_list<conn, &conn::by_owner> owner_list;
+typedef ttl::intrusive_slist<conn, &conn::free> free_list;
+typedef ttl::intrusive_rbtree<int, conn, &conn::by_fd, fd_of> fd_tree;
+typedef ttl::intrusive_set<conn, &conn::by_fd> conn_set;
+
+template class ttl::intrusive_list<conn, &conn::by_age>;
+template class ttl::intrusive_slist<conn, &conn::free>;
+template class ttl::intrusive_rbtree<int, conn, &conn::by_fd, fd_of>;
+
+static void test_list(conn *c, int n)
+{
+   age_list ages;
+   owner_list owners;
+   assert(ages.empty() && ages.size() == 0);
+   for (int i = 0; i < n; ++i)
+   {
+      c[i].by_age.init();
+      ages.push_back(c[i]);
+      owners.push_front(c[i]);
+   }
+   assert(ages.size() == (unsigned)n && owners.size() == (unsigned)n);
+   assert(&ages.front() == &c[0] && &ages.back() == &c[n - 1]);
+   assert(&owners.front() == &c[n - 1] && &owners.back() == &c[0]);
+
+   // erasing from one list leaves the object in the other
+   age_list::erase(c[3]);
+   assert(!age_list::is_linked(c[3]) && age_list::is_linked(c[4]));
+   assert(ages.size() == (unsigned)n - 1 && owners.size() == (unsigned)n);
+   int expected = 0;
+   for (age_list::const_iterator i = ages.cbegin(); i != ages.cend(); ++i, ++expected)
+   {
+      if (expected == 3)
+         ++expected;
+      assert(i->fd == expected);
+   }
+
+   // touch: move to the back in O(1)
+   ages.splice(ages.end(), c[0]);
+   assert(&ages.back() == &c[0] && &ages.front() == &c[1]);
+   ages.insert(age_list::iterator_to(c[2]), c[3]);
+   age_list::iterator i = ages.begin();
+   assert(i->fd == 1 && (++i)->fd == 3 && (++i)->fd == 2);
+   i = ages.erase(i);
+   assert(i->fd == 4 && !age_list::is_linked(c[2]));
+   assert((--i)->fd == 3);
+
+   ages.pop_front();
+   ages.pop_back();
+   assert(&ages.front() == &c[3] && &ages.back() == &c[n - 1]);
+
+   age_list other;
+   other.swap(ages);
+   assert(ages.empty() && other.size() == (unsigned)n - 3);
+   ages.push_back(c[0]);
+   ages.splice(ages.begin(), other);
+   assert(other.empty() && ages.size() == (unsigned)n - 2 && &ages.back() == &c[0]);
+   ages.reverse();
+   assert(&ages.front() == &c[0]);
+   ages.clear();
+   assert(ages.empty() && !age_list::is_linked(c[5]));
+   assert(owners.size() == (unsigned)n);
+   owners.clear();
+}
+
+static void test_slist(conn *c, int n)
+{
+   free_list fl;
+   assert(fl.empty());
+   for (int i = 0; i < n; ++i)
+      fl.push_front(c[i]);
+   assert(fl.size() == (unsigned)n && fl.front().fd == n - 1);
+   fl.reverse();
+   int expected = 0;
+   for (free_list::iterator i = fl.begin(); i != fl.end(); ++i)
+      assert(i->fd == expected++);
+   fl.pop_front();
+   assert(fl.front().fd == 1);
+   free_list::iterator i = fl.erase_after(fl.begin());
+   assert(i->fd == 3 && fl.size() == (unsigned)n - 2);
+   fl.insert_after(fl.before_begin(), c[0]);
+   fl.insert_after(free_list::iterator_to(c[1]), c[2]);
+   expected = 0;
+   for (free_list::const_iterator j = fl.cbegin(); j != fl.cend(); ++j)
+      assert(j->fd == expected++);
+
+   free_list other;
+   other.splice_after(other.before_begin(), fl);
+   assert(fl.empty() && other.size() == (unsigned)n);
+   other.erase_after(free_list::iterator_to(c[1]), other.end());
+   assert(other.size() == 2);
+   other.clear();
+   assert(other.empty());
+}
+
+static void test_rbtree(conn *c, int n)
+{
+   fd_tree t;
+   assert(t.empty() && t.begin() == t.end());
+   // insert in a scrambled order
+   for (int i = 0; i < n; ++i)
+   {
+      conn &x = c[(i * 7) % n];
+      ttl::pair<fd_tree::iterator, bool> r = t.insert(x);
+      assert(r.second && &*r.first == &x);
+   }
+   assert(t.size() == (unsigned)n);
+
+   conn dup;
+   dup.fd = 5;
+   ttl::pair<fd_tree::iterator, bool> r = t.insert(dup);
+   assert(!r.second && &*r.first == &c[5]);
+
+   int expected = 0;
+   for (fd_tree::const_iterator i = t.cbegin(); i != t.cend(); ++i)
+      assert(i->fd == expected++);
+   expected = n;
+   for (fd_tree::iterator i = t.end(); i != t.begin(); )
+      assert((--i)->fd == --expected);
+
+   assert(&*t.find(7) == &c[7] && t.find(n) == t.end() && t.count(3) == 1);
+   assert(t.lower_bound(4)->fd == 4 && t.upper_bound(4)->fd == 5);
+
+   assert(t.erase(4) == &c[4] && t.erase(4) == 0);
+   t.erase(c[6]);
+   assert(t.size() == (unsigned)n - 2 && t.find(6) == t.end());
+   assert(t.lower_bound(4)->fd == 5 && t.upper_bound(5)->fd == 7);
+   for (int i = 0; i < n; ++i)
+      if (i != 4 && i != 6)
+         assert(t.erase(i) == &c[i]);
+   assert(t.empty());
+
+   conn_set s;
+   for (int i = n; i--;)
+      assert(s.insert(c[i]).second);
+   assert(s.begin()->fd == 0 && s.find(dup) != s.end());
+   s.clear();
+   assert(s.empty());
+}
+
+void test()
+{
+   printf("sizeof conn %lu\n", (unsigned long)sizeof(conn));
+
+   const int n = 20;
+   conn c[n];
+   for (int i = 0; i < n; ++i)
+      c[i].fd = i;
+
+   test_list(c, n);
+   test_slist(c, n);
+   test_rbtree(c, n);
+
+   // all at once
+   age_list ages;
+   free_list fl;
+   fd_tree t;
+   for (int i = 0; i < n; ++i)
+   {
+      ages.push_back(c[i]);
+      fl.push_front(c[i]);
+      t.insert(c[i]);
+   }
+   assert(ages.size() == (unsigned)n && fl.size() == (unsigned)n && t.size() == (unsigned)n);
+   for (int i = 0; i < n; i += 2)
+   {
+      age_list::erase(c[i]);
+      t.erase(c[i]);
+   }
+   assert(ages.size() == (unsigned)n / 2 && t.size() == (unsigned)n / 2 && fl.size() == (unsigned)n);
+   assert(ages.front().fd == 1 && t.begin()->fd == 1 && fl.front().fd == n - 1);
+   ages.clear();
+   t.clear();
+   fl.clear();
+}
@@ -0,0 +1,242 @@
+// vim: sw=3 ts=8 et
+#include "ttl/lru_cache.hpp"
+#include "ttl/string.hpp"
+#include "t.hpp"
+#include <pthread.h>
+#include <list>
+#include <map>
+
+template class ttl::lru_cache<int, int>;
+template class ttl::clock_cache<int, int>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+// a few home slots for all the keys: long runs, which wrap round the index
+struct bad_hash
+{
+   ttl::size_t operator()(int key) const { return (ttl::size_t)(key % 3) * 5 + 55; }
+};
+
+// a value which counts its instances, the caches must destroy all
+struct counted
+{
+   static int live;
+   int value;
+   counted(): value(0) { ++live; }
+   counted(int v): value(v) { ++live; }
+   counted(const counted &o): value(o.value) { ++live; }
+   ~counted() { --live; }
+   counted &operator=(const counted &o) { value = o.value; return *this; }
+};
+int counted::live = 0;
+
+// the exact order of eviction, against a list from the most recently used
+template<class Cache>
+static void test_lru(ttl::size_t capacity, int range)
+{
+   Cache c(capacity);
+   std::list<std::pair<int, int> > ref;
+   unsigned long hits = 0, misses = 0;
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const int key = (int)(rnd() % range), value = (int)(rnd() % 1000);
+      std::list<std::pair<int, int> >::iterator i = ref.begin();
+      while (i != ref.end() && i->first != key)
+         ++i;
+      switch (rnd() % 6)
+      {
+      case 0:
+         assert(c.erase(key) == (i != ref.end()));
+         if (i != ref.end())
+            ref.erase(i);
+         break;
+      case 1:
+         assert(c.touch(key) == (i != ref.end()));
+         if (i != ref.end())
+            ref.splice(ref.begin(), ref, i);
+         break;
+      case 2:
+      {
+         const counted *p = c.peek(key);
+         assert(i == ref.end() ? !p: p->value == i->second);
+         break;
+      }
+      case 3:
+      {
+         counted *p = c.get(key);
+         assert(i == ref.end() ? !p: p->value == i->second);
+         if (i != ref.end())
+         {
+            ++hits;
+            ref.splice(ref.begin(), ref, i);
+         }
+         else
+            ++misses;
+         break;
+      }
+      default:
+         assert(c.put(key, counted(value)).value == value);
+         if (i != ref.end())
+            ref.erase(i);
+         else if (ref.size() == c.capacity())
+            ref.pop_back();
+         ref.push_front(std::make_pair(key, value));
+      }
+      assert(c.size() == ref.size() && c.full() == (ref.size() == c.capacity()));
+      assert(c.hits() == hits && c.misses() == misses);
+      if (step % 64 == 0)
+      {
+         typename Cache::const_iterator j = c.begin();
+         for (i = ref.begin(); i != ref.end(); ++i, ++j)
+            assert(j->first == i->first && j->second.value == i->second && c.contains(i->first));
+         assert(j == c.end());
+      }
+   }
+   c.clear();
+   assert(c.empty() && c.begin() == c.end() && !c.contains(0));
+   c.reset_stats();
+   assert(!c.hits() && !c.misses());
+}
+
+// the values, against a map of the last ones put; a key just put or got
+// stays until capacity other keys are put
+template<class Cache>
+static void test_clock(ttl::size_t capacity, int range)
+{
+   Cache c(capacity);
+   std::map<int, int> last;
+   unsigned long hits = 0, misses = 0;
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const int key = (int)(rnd() % range), value = (int)(rnd() % 1000);
+      const ttl::size_t size = c.size();
+      const bool cached = c.contains(key);
+      switch (rnd() % 6)
+      {
+      case 0:
+         assert(c.erase(key) == cached && c.size() == size - cached && !c.contains(key));
+         break;
+      case 1:
+         assert(c.touch(key) == cached);
+         break;
+      case 2:
+      case 3:
+      {
+         counted *p = c.get(key);
+         assert(cached ? p && p->value == last[key]: !p);
+         ++(cached ? hits: misses);
+         break;
+      }
+      default:
+         assert(c.put(key, counted(value)).value == value);
+         last[key] = value;
+         assert(c.contains(key) && c.size() == (cached || size == c.capacity() ? size: size + 1));
+      }
+      assert(c.size() <= c.capacity() && c.full() == (c.size() == c.capacity()));
+      assert(c.hits() == hits && c.misses() == misses);
+      const int probe = (int)(rnd() % range);
+      const counted *p = c.peek(probe);
+      assert(!p || p->value == last[probe]);
+   }
+   c.clear();
+   assert(c.empty() && !c.contains(0));
+   c.reset_stats();
+   assert(!c.hits() && !c.misses());
+}
+
+// readers of a clock_cache which nothing writes to, as under a shared
+// lock: each gets every key, half of them cached
+static const int readers = 4;
+static const int reads = 20000;
+static ttl::clock_cache<int, int> *shared;
+
+static void *read_all(void *arg)
+{
+   const int t = (int)(ttl::size_t)arg;
+   for (int i = 0; i < reads; ++i)
+   {
+      const int key = (i * 7 + t) % 200;
+      const int *v = shared->get(key);
+      assert(key < 100 ? v && *v == key * 2: !v);
+   }
+   return 0;
+}
+
+static void test_readers()
+{
+   ttl::clock_cache<int, int> c(100);
+   for (int i = 0; i < 100; ++i)
+      c.put(i, i * 2);
+   shared = &c;
+   pthread_t th[readers];
+   for (int t = 0; t < readers; ++t)
+      pthread_create(&th[t], 0, read_all, (void *)(ttl::size_t)t);
+   for (int t = 0; t < readers; ++t)
+      pthread_join(th[t], 0);
+   assert(c.hits() == readers * reads / 2 && c.misses() == readers * reads / 2);
+   assert(c.size() == 100);
+}
+
+void test()
+{
+   test_lru<ttl::lru_cache<int, counted> >(1, 4);
+   test_lru<ttl::lru_cache<int, counted> >(16, 30);
+   test_lru<ttl::lru_cache<int, counted, bad_hash> >(40, 60);
+   test_lru<ttl::lru_cache<int, counted> >(100, 1000);
+   test_clock<ttl::clock_cache<int, counted> >(1, 4);
+   test_clock<ttl::clock_cache<int, counted> >(16, 30);
+   test_clock<ttl::clock_cache<int, counted, bad_hash> >(40, 60);
+   test_clock<ttl::clock_cache<int, counted> >(100, 1000);
+   assert(counted::live == 0);
+   test_readers();
+
+   // the second chance: the referenced entries are passed once
+   ttl::clock_cache<int, int> k(3);
+   k.put(1, 1);
+   k.put(2, 2);
+   k.put(3, 3);
+   k.put(4, 4); // all referenced, the sweep comes back to 1
+   assert(!k.contains(1) && k.contains(2) && k.contains(3) && k.contains(4));
+   assert(*k.get(2) == 2);
+   k.put(5, 5); // 2 was referenced again
+   assert(k.contains(2) && !k.contains(3) && k.contains(4) && k.contains(5));
+   assert(k.hits() == 1 && !k.misses() && !k.get(3) && k.misses() == 1);
+
+   // the value put is the value evicted
+   ttl::lru_cache<int, int> l(2);
+   l.put(1, 10);
+   l.put(2, 20);
+   l.put(3, *l.peek(1));
+   assert(!l.contains(1) && *l.get(3) == 10 && l.begin()->first == 3);
+   k.put(6, *k.peek(4));
+   assert(*k.peek(6) == 4);
+
+   // string keys
+   ttl::lru_cache<ttl::string, int> s(2);
+   s.put("a key too long to be kept inline", 1);
+   s.put("short", 2);
+   assert(*s.get("a key too long to be kept inline") == 1);
+   s.put("third", 3);
+   assert(!s.contains("short") && s.contains("third"));
+
+   // from an arena, one allocation per entry and the index
+   ttl::monotonic_arena arena;
+   {
+      typedef ttl::resource_ref<ttl::monotonic_arena> ref;
+      ttl::lru_cache<int, int, ttl::hash<int>, ttl::equal_to<int>, ref> a(10, ref(arena));
+      for (int i = 0; i < 100; ++i)
+         a.put(i, i);
+      assert(a.size() == 10 && a.contains(99) && !a.contains(89));
+      const ttl::size_t n = arena.allocated();
+      for (int i = 0; i < 100; ++i)
+         a.put(i, i);
+      assert(arena.allocated() == n);
+   }
+}
@@ -0,0 +1,221 @@
+// vim: sw=3 ts=8 et
+#include "ttl/memory_resource.hpp"
+#include "ttl/utility.hpp"
+#include "ttl/functional.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/vector.hpp"
+#include "ttl/list.hpp"
+#include "ttl/forward_list.hpp"
+#include "ttl/backward_list.hpp"
+#include "ttl/lazy_queue.hpp"
+#include "ttl/map.hpp"
+#include "ttl/set.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "t.hpp"
+
+// counts the outstanding allocations and bytes
+struct counting_resource
+{
+   long *blocks, *bytes;
+   counting_resource(long *n, long *b): blocks(n), bytes(b) {}
+   void *allocate(ttl::size_t size)
+   {
+      ++*blocks;
+      *bytes += size;
+      return ::operator new(size);
+   }
+   void deallocate(void *p, ttl::size_t size)
+   {
+      if (!p)
+         return;
+      --*blocks;
+      *bytes -= size;
+      ::operator delete(p);
+   }
+};
+
+typedef ttl::resource_ref<ttl::monotonic_arena> arena_ref;
+typedef ttl::resource_ref<ttl::fixed_pool> pool_ref;
+
+template<class Resource>
+static void exercise(const Resource &r)
+{
+   {
+      ttl::vector<int, Resource> v(r);
+      for (int i = 0; i < 100; ++i)
+         v.push_back(i);
+      v.insert(v.begin(), (ttl::size_t)3, -1);
+      v.erase(v.begin() + 10, v.begin() + 20);
+      assert(v.size() == 93 && v[0] == -1 && v[10] == 17);
+      ttl::vector<int, Resource> w(v);
+      assert(w == v);
+      ttl::vector<int, Resource> x(r);
+      x.swap(w);
+      assert(x == v && w.empty());
+   }
+   {
+      ttl::list<int, Resource> l(r);
+      for (int i = 0; i < 50; ++i)
+         l.push_back(i);
+      l.resize(20);
+      l.pop_front();
+      assert(l.size() == 19 && l.front() == 1 && l.back() == 19);
+      ttl::list<int, Resource> m(l);
+      assert(m.size() == 19);
+   }
+   {
+      ttl::forward_list<int, Resource> fl(r);
+      for (int i = 0; i < 50; ++i)
+         fl.push_front(i);
+      fl.erase_after(fl.begin());
+      fl.pop_front();
+      assert(fl.front() == 47);
+   }
+   {
+      ttl::backward_list<int, Resource> bl(r);
+      for (int i = 0; i < 50; ++i)
+         bl.push_back(i);
+      bl.pop_front();
+      assert(bl.front() == 1 && bl.back() == 49);
+   }
+   {
+      ttl::lazy_queue<int, Resource> q(r);
+      for (int i = 0; i < 50; ++i)
+         q.push_back(i);
+      for (int i = 0; i < 25; ++i)
+         q.pop_front();
+      for (int i = 0; i < 25; ++i)
+         q.push_back(i);
+      q.clear();
+      q.cleanup();
+      q.push_back(1);
+      assert(q.front() == 1);
+   }
+   {
+      ttl::map<int, int, ttl::less<int>, Resource> m(r);
+      for (int i = 0; i < 100; ++i)
+         m[i] = i * i;
+      for (int i = 0; i < 100; i += 2)
+         assert(m.erase(i) == 1);
+      assert(m.erase(0) == 0 && m.at(9) == 81);
+      ttl::map<int, int, ttl::less<int>, Resource> n(m);
+      assert(n.at(99) == 99 * 99 && n.count(98) == 0);
+   }
+   {
+      ttl::set<int, ttl::less<int>, Resource> s(r);
+      for (int i = 0; i < 100; ++i)
+         s.insert(i % 37);
+      assert(s.erase(5) == 1 && s.count(5) == 0 && s.count(6) == 1);
+   }
+   {
+      ttl::sorted_vector_map<int, int, ttl::less<int>, Resource> m(r);
+      for (int i = 100; i--;)
+         m[i] = -i;
+      assert(m.size() == 100 && m.begin()->second == 0 && m.at(42) == -42);
+      ttl::sorted_vector_map<int, int, ttl::less<int>, Resource> n(m);
+      assert(n.size() == 100 && n.at(99) == -99);
+      ttl::sorted_vector_map<int, int, ttl::less<int>, Resource> p(16, r);
+      p[1] = 1;
+      assert(p.size() == 1);
+   }
+   {
+      // the count and the range constructors take the resource too
+      static const int a[] = {5, 3, 8, 1, 3};
+      ttl::vector<int, Resource> v((ttl::size_t)4, r), w((ttl::size_t)3, 7, r), x(a, a + 5, r);
+      assert(v.size() == 4 && !v[3] && w.size() == 3 && w[2] == 7 && x.size() == 5 && x[2] == 8);
+      ttl::list<int, Resource> l((ttl::size_t)3, 7, r), m(a, a + 5, r);
+      assert(l.size() == 3 && l.back() == 7 && m.size() == 5 && m.back() == 3);
+      ttl::forward_list<int, Resource> fl((ttl::size_t)3, 7, r), fm(a, a + 5, r);
+      assert(fl.front() == 7 && fm.front() == 5);
+      ttl::backward_list<int, Resource> bl((ttl::size_t)3, 7, r), bm(a, a + 5, r);
+      assert(bl.back() == 7 && bm.front() == 5 && bm.back() == 3);
+      ttl::lazy_queue<int, Resource> q((ttl::size_t)3, 7, r);
+      assert(q.front() == 7);
+      ttl::set<int, ttl::less<int>, Resource> s(a, a + 5, r);
+      assert(s.count(8) == 1 && s.count(3) == 1 && !s.count(2));
+      const ttl::pair<int, int> kv[] = {ttl::make_pair(2, 4), ttl::make_pair(1, 1), ttl::make_pair(3, 9)};
+      ttl::map<int, int, ttl::less<int>, Resource> mp(kv, kv + 3, r);
+      assert(mp.at(1) == 1 && mp.at(3) == 9 && !mp.count(4));
+      ttl::sorted_vector_map<int, int, ttl::less<int>, Resource> sv(kv, kv + 3, r);
+      assert(sv.size() == 3 && sv.begin()->first == 1);
+      // a copy is another container on the same resource
+      ttl::sorted_vector_map<int, int, ttl::less<int>, Resource> sw(sv);
+      sw[0] = 0;
+      assert(sw.size() == 4 && sv.size() == 3);
+   }
+}
+
+void test()
+{
+   printf("sizeof vector<int> %lu, list<int> %lu, map<int,int> %lu\n",
+          (unsigned long)sizeof(ttl::vector<int>),
+          (unsigned long)sizeof(ttl::list<int>),
+          (unsigned long)sizeof(ttl::map<int, int>));
+   // the default resource takes no space
+   assert(sizeof(ttl::vector<int>) == 3 * sizeof(int *));
+   assert(sizeof(ttl::list<int>) == sizeof(ttl::list_node));
+   assert(sizeof(ttl::vector<int, arena_ref>) == 4 * sizeof(int *));
+
+   {
+      long blocks = 0, bytes = 0;
+      exercise(counting_resource(&blocks, &bytes));
+      assert(blocks == 0 && bytes == 0);
+      ttl::vector<int, counting_resource> v(counting_resource(&blocks, &bytes));
+      v.reserve(10);
+      assert(blocks == 1 && bytes == 10 * sizeof(int));
+      assert(v.get_resource().blocks == &blocks);
+   }
+
+   {
+      char buffer[256];
+      ttl::monotonic_arena arena(buffer, sizeof(buffer), 1024);
+      void *a = arena.allocate(3);
+      void *b = arena.allocate(8);
+      assert(a == buffer && (char *)b == buffer + ttl::max_align);
+      // only the latest allocation is taken back
+      arena.deallocate(a, 3);
+      arena.deallocate(b, 8);
+      assert(arena.allocate(8) == b && arena.allocated() == 11);
+      void *c = arena.allocate(300);
+      assert((char *)c < buffer || (char *)c >= buffer + sizeof(buffer));
+      arena.release();
+      assert(arena.allocated() == 0 && arena.allocate(1) == buffer);
+      arena.release();
+
+      exercise(arena_ref(arena));
+      assert(arena.allocated() > 0);
+      arena.release();
+   }
+
+   {
+      ttl::fixed_pool pool(24, 4);
+      assert(pool.block_size() == 32);
+      void *p[10];
+      for (int i = 0; i < 10; ++i)
+         p[i] = pool.allocate(24);
+      for (int i = 0; i < 10; ++i)
+         for (int j = 0; j < i; ++j)
+            assert(p[i] != p[j]);
+      pool.deallocate(p[3], 24);
+      assert(pool.allocate(20) == p[3]);
+      void *big = pool.allocate(100);
+      pool.deallocate(big, 100);
+      for (int i = 0; i < 10; ++i)
+         pool.deallocate(p[i], 24);
+   }
+
+   {
+      // the block size of the first allocation: the nodes of the map
+      ttl::fixed_pool pool;
+      ttl::map<int, int, ttl::less<int>, pool_ref> m(pool);
+      m[1] = 1;
+      ttl::size_t node = pool.block_size();
+      assert(node >= sizeof(ttl::rbnode) + 2 * sizeof(int));
+      for (int i = 0; i < 1000; ++i)
+         m[i] = i;
+      for (int i = 0; i < 1000; ++i)
+         m.erase(i);
+      exercise(pool_ref(pool));
+      assert(pool.block_size() == node);
+   }
+}
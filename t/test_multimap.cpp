@@ -0,0 +1,155 @@
+// vim: sw=3 ts=8 et
+#include "ttl/map.hpp"
+#include "ttl/set.hpp"
+#include "ttl/algorithm.hpp"
+#include "t.hpp"
+#include <map>
+#include <set>
+
+template class ttl::multimap<int, int>;
+template class ttl::multiset<int>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+typedef ttl::multimap<int, int> multimap_type;
+typedef std::multimap<int, int> ref_type;
+
+// the same values in the same order: the equal keys in their insertion
+// order, as in std::multimap
+static void check(const multimap_type &m, const ref_type &ref)
+{
+   ref_type::const_iterator j = ref.begin();
+   for (multimap_type::const_iterator i = m.begin(); i != m.end(); ++i, ++j)
+      assert(j != ref.end() && i->first == j->first && i->second == j->second);
+   assert(j == ref.end() && m.empty() == ref.empty());
+}
+
+static void test_multimap()
+{
+   for (unsigned round = 0; round < 20; ++round)
+   {
+      multimap_type m;
+      ref_type ref;
+      const int range = round % 2 ? 5: 100;
+      int serial = 0;
+      for (unsigned step = 0; step < 2000; ++step)
+      {
+         const int key = (int)(rnd() % range);
+         switch (rnd() % 8)
+         {
+         case 0:
+            assert(m.erase(key) == ref.erase(key));
+            break;
+         case 1:
+            // one of the values of the key
+            if (ref.count(key))
+            {
+               const unsigned k = rnd() % ref.count(key);
+               multimap_type::iterator i = m.find(key);
+               ref_type::iterator j = ref.find(key);
+               for (unsigned n = 0; n < k; ++n)
+                  ++i, ++j;
+               assert(i->second == j->second);
+               multimap_type::iterator next = m.erase(i);
+               ref.erase(j++);
+               assert(next == m.end() ? j == ref.end(): next->second == j->second);
+            }
+            break;
+         case 2:
+         {
+            // a range, which may split the values of the keys
+            multimap_type::iterator first = m.lower_bound(key);
+            ref_type::iterator rfirst = ref.lower_bound(key);
+            unsigned k = rnd() % 4;
+            for (; k && first != m.end(); --k)
+               ++first, ++rfirst;
+            multimap_type::iterator last = first;
+            ref_type::iterator rlast = rfirst;
+            for (k = rnd() % 50; k && last != m.end(); --k)
+               ++last, ++rlast;
+            assert(m.erase(first, last) == last);
+            ref.erase(rfirst, rlast);
+            break;
+         }
+         default:
+         {
+            multimap_type::iterator i = m.insert(ttl::make_pair(key, serial));
+            ref.insert(std::make_pair(key, serial++));
+            assert(i->first == key && i->second == serial - 1);
+         }
+         }
+         const int probe = (int)(rnd() % (range + 2)) - 1;
+         assert(m.count(probe) == ref.count(probe));
+         ttl::pair<multimap_type::iterator, multimap_type::iterator> r = m.equal_range(probe);
+         std::pair<ref_type::iterator, ref_type::iterator> rr = ref.equal_range(probe);
+         for (; rr.first != rr.second; ++r.first, ++rr.first)
+            assert(r.first->second == rr.first->second);
+         assert(r.first == r.second);
+         assert(ref.count(probe) ? m.find(probe)->second == ref.find(probe)->second: m.find(probe) == m.end());
+      }
+      check(m, ref);
+      multimap_type c(m);
+      assert(c == m);
+      check(c, ref);
+      c.insert(ttl::make_pair(0, 0));
+      assert(c != m);
+   }
+
+   multimap_type m;
+   for (int i = 0; i < 100; ++i)
+      m.insert(ttl::make_pair(i / 10, i));
+   assert(m.erase_range(2, 5) == 30 && !m.count(4) && m.count(5) == 10);
+   assert(m.upper_bound(1)->second == 50 && m.lower_bound(2)->second == 50);
+   const multimap_type &cm = m;
+   assert(cm.equal_range(9).first->second == 90 && cm.equal_range(9).second == cm.end());
+   assert(m.erase(m.find(5), m.end()) == m.end() && m.count(1) == 10 && !m.count(5));
+}
+
+static void test_multiset()
+{
+   ttl::multiset<int> s;
+   std::multiset<int> ref;
+   for (unsigned step = 0; step < 5000; ++step)
+   {
+      const int key = (int)(rnd() % 30);
+      if (rnd() % 5 == 0)
+         assert(s.erase(key) == ref.erase(key));
+      else if (rnd() % 5 == 0 && s.count(key))
+      {
+         s.erase(s.find(key));
+         ref.erase(ref.find(key));
+      }
+      else
+      {
+         s.insert(key);
+         ref.insert(key);
+      }
+      assert(s.count(key) == ref.count(key));
+   }
+   assert(ttl::equal(s.begin(), s.end(), ref.begin(), ref.end()));
+   ttl::pair<ttl::multiset<int>::iterator, ttl::multiset<int>::iterator> r = s.equal_range(10);
+   assert(s.erase(r.first, r.second) == r.second && !s.count(10));
+   ref.erase(10);
+   ttl::multiset<int> c(ref.begin(), ref.end());
+   assert(c == s);
+   printf("multiset of %lu keys\n", (unsigned long)ref.size());
+}
+
+void test()
+{
+   test_multimap();
+   test_multiset();
+
+   // transparent lookups
+   ttl::multimap<long, int, ttl::less<> > t;
+   t.insert(ttl::make_pair(1L, 1));
+   t.insert(ttl::make_pair(1L, 2));
+   assert(t.count(1) == 2 && t.find(1)->second == 1 && t.erase(1) == 2 && t.empty());
+}
@@ -0,0 +1,64 @@
+// vim: sw=3 ts=8 et
+#include "ttl/utility.hpp"
+#include "ttl/functional.hpp"
+#include "ttl/algorithm.hpp"
+#include "ttl/priority_queue.hpp"
+#include "t.hpp"
+
+template class ttl::priority_queue<int>;
+template class ttl::priority_queue<int, ttl::greater<int>, 2>;
+
+template<class Q>
+static void drain(const char *title, Q &q, bool ascending)
+{
+   fputs(title, stdout);
+   int prev = 0;
+   for (bool first = true; !q.empty(); first = false)
+   {
+      int v = q.top();
+      printf(" %d", v);
+      assert(first || (ascending ? prev <= v: v <= prev));
+      prev = v;
+      q.pop();
+   }
+   fputs(".\n", stdout);
+}
+
+void test()
+{
+   static const int a[] = {3,1,4,1,5,9,2,6,5,3,5,8,9,7,9,3,2,3,8,4,6,2,6,4,3,3,8,3,2,7,9,5};
+
+   ttl::priority_queue<int> q;
+   assert(q.empty() && q.size() == 0);
+   for (unsigned i = 0; i < countof(a); ++i)
+   {
+      q.push(a[i]);
+      assert(q.top() == *ttl::max_element(a, a + i + 1));
+   }
+   assert(q.size() == countof(a));
+   drain("push/pop:", q, false);
+
+   // Floyd heapify of the whole batch
+   q.push_range(a, a + countof(a));
+   assert(q.size() == countof(a));
+   drain("push_range:", q, false);
+
+   // small batch on top of a bigger heap: sift-up one by one
+   q.push_range(a, a + countof(a));
+   q.push_range(a, a + 3);
+   assert(q.size() == countof(a) + 3);
+   drain("push_range(small):", q, false);
+
+   ttl::priority_queue<int, ttl::greater<int>, 2> minq(a, a + countof(a));
+   assert(minq.top() == 1);
+   drain("min binary heap:", minq, true);
+
+   ttl::priority_queue<int, ttl::less<int>, 8> q8(a, a + countof(a));
+   ttl::priority_queue<int, ttl::less<int>, 8> e8;
+   e8.swap(q8);
+   assert(q8.empty() && e8.size() == countof(a));
+   drain("8-ary:", e8, false);
+   e8.push(1);
+   e8.clear();
+   assert(e8.empty());
+}
@@ -0,0 +1,65 @@
+// vim: sw=3 ts=8 et
+#include "ttl/dynamic_bitset.hpp"
+#include "ttl/rank_select.hpp"
+#include "t.hpp"
+
+template<class Bits>
+static void check(const Bits &bits)
+{
+   ttl::rank_select<Bits> index(bits);
+   ttl::size_t r = 0;
+   for (ttl::size_t i = 0; i < bits.size(); ++i)
+   {
+      assert(index.rank(i) == r);
+      assert(index.rank0(i) == i - r);
+      if (bits.test(i))
+      {
+         assert(index.select(r) == i);
+         ++r;
+      }
+   }
+   assert(index.rank(bits.size()) == r && index.count() == r && r == bits.count());
+   assert(index.select(r) == bits.size() && index.select(r + 100) == bits.size());
+}
+
+static unsigned long long seed = 3;
+
+static bool random_bit(unsigned one_in)
+{
+   seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+   return (seed >> 33) % one_in == 0;
+}
+
+void test()
+{
+   const ttl::size_t sizes[] = { 0, 1, 63, 64, 511, 512, 513, 4096, 4097, 20000, 100000 };
+   const unsigned densities[] = { 1, 2, 7, 100, 5000 };
+   for (unsigned i = 0; i < sizeof(sizes)/sizeof(*sizes); ++i)
+      for (unsigned d = 0; d < sizeof(densities)/sizeof(*densities); ++d)
+      {
+         ttl::dynamic_bitset<> bits(sizes[i]);
+         for (ttl::size_t k = 0; k < sizes[i]; ++k)
+            if (random_bit(densities[d]))
+               bits.set(k);
+         check(bits);
+      }
+
+   // the unused bits of bitset<N> are not counted
+   ttl::bitset<1000> b;
+   for (ttl::size_t k = 0; k < b.size(); k += 3)
+      b.set(k);
+   b.set(1010);
+   check(b);
+
+   // the index is rebuilt after a change
+   ttl::dynamic_bitset<> big(1 << 20);
+   for (ttl::size_t k = 0; k < big.size(); k += 5)
+      big.set(k);
+   ttl::rank_select<ttl::dynamic_bitset<> > index(big);
+   printf("index of %lu bits: %lu bytes\n", (unsigned long)big.size(), (unsigned long)index.size_in_bytes());
+   assert(index.size_in_bytes() * 8 < big.size() / 16);
+   assert(index.select(100000) == 500000 && index.rank(500001) == 100001);
+   big.reset(0);
+   index.build();
+   assert(index.select(100000) == 500005 && index.rank(500001) == 100000);
+}
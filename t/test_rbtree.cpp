@@ -3,6 +3,10 @@
 #include "ttl/functional.hpp"
 #include "ttl/utility.hpp"
 #include "ttl/rbtree.hpp"
+#include "ttl/set.hpp"
+#include "ttl/map.hpp"
+#include <set>
+#include <vector>
 
 typedef ttl::rbtree<int,
         ttl::pair<int,char>,
@@ -26,6 +30,169 @@ static void inorder(const ttl::rbnode *n, bool print_pointer = false, int depth
       inorder<Container>(n->right, print_pointer, depth + 1);
 }
 
+// the black height, after checking the order, the parents and the
+// left-leaning red-black rules
+static int check(const ttl::rbnode *n, const ttl::rbnode *parent, const int *lo, const int *hi)
+{
+   if (!n)
+      return 0;
+   const int k = static_cast<const rbtree_set::node *>(n)->data;
+   assert(n->parent == parent);
+   assert(!lo || *lo <= k);
+   assert(!hi || k <= *hi);
+   assert(!n->right || n->right->color == ttl::rbnode::BLACK);
+   if (n->color == ttl::rbnode::RED)
+      assert(!n->left || n->left->color == ttl::rbnode::BLACK);
+   const int lh = check(n->left, n, lo, &k), rh = check(n->right, n, &k, hi);
+   assert(lh == rh);
+   return lh + (n->color == ttl::rbnode::BLACK);
+}
+
+static void check(const rbtree_set &t, const std::set<int> &ref)
+{
+   const ttl::rbnode *root = t.get_croot();
+   assert(!root || (root->color == ttl::rbnode::BLACK && root->parent == t.end()));
+   check(root, t.end(), 0, 0);
+   std::set<int>::const_iterator j = ref.begin();
+   for (const ttl::rbnode *i = root ? ttl::rbtree_base::min_node(root): t.end(); i != t.end();
+        i = ttl::rbtree_base::next_node(i), ++j)
+      assert(j != ref.end() && static_cast<const rbtree_set::node *>(i)->data == *j);
+   assert(j == ref.end());
+}
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+static void test_join_split()
+{
+   printf("split, join, erase_range, unite and subtract\n");
+   for (int round = 0; round < 300; ++round)
+   {
+      rbtree_set a, b;
+      std::set<int> ra, rb;
+      const int n = rnd() % (round < 100 ? 40: 3000), m = rnd() % (round % 3 ? 100: 3000);
+      const int range = 1 + rnd() % 10000;
+      for (int i = 0; i < n; ++i)
+      {
+         int k = rnd() % range;
+         a.insert_unique(k);
+         ra.insert(k);
+      }
+      for (int i = 0; i < m; ++i)
+      {
+         int k = rnd() % range;
+         b.insert_unique(k);
+         rb.insert(k);
+      }
+
+      // split and join back
+      int key = rnd() % (range + 2) - 1;
+      rbtree_set hi;
+      hi.insert_unique(-5);
+      a.split(key, hi);
+      std::set<int> rlo(ra.begin(), ra.lower_bound(key)), rhi(ra.lower_bound(key), ra.end());
+      check(a, rlo);
+      check(hi, rhi);
+      a.join(hi);
+      assert(!hi.get_croot());
+      check(a, ra);
+
+      // the range erase keeps the other nodes
+      int lo = rnd() % range, up = lo + rnd() % (range / 4 + 1);
+      const rbtree_set::node *keep = a.lower_bound(up);
+      size_t erased = a.erase_range(lo, up);
+      assert(erased == (size_t)std::distance(ra.lower_bound(lo), ra.lower_bound(up)));
+      ra.erase(ra.lower_bound(lo), ra.lower_bound(up));
+      check(a, ra);
+      assert(a.lower_bound(lo) == keep);
+
+      rbtree_set c;
+      c.assign(b);
+      a.subtract(c);
+      for (std::set<int>::const_iterator i = rb.begin(); i != rb.end(); ++i)
+         ra.erase(*i);
+      check(a, ra);
+      check(c, rb);
+
+      a.unite(b);
+      assert(!b.get_croot());
+      ra.insert(rb.begin(), rb.end());
+      check(a, ra);
+      a.unite(c);
+      check(a, ra);
+
+      a.erase_from(lo);
+      ra.erase(ra.lower_bound(lo), ra.end());
+      check(a, ra);
+   }
+
+   ttl::set<int> s;
+   ttl::map<int, int> m;
+   for (int i = 0; i < 100; ++i)
+   {
+      s.insert(i);
+      m[i] = -i;
+   }
+   ttl::set<int>::iterator first = s.find(10), last = s.find(20);
+   assert(s.erase(first, last) == last && *last == 20);
+   assert(s.count(9) && !s.count(10) && !s.count(19) && s.count(20));
+   assert(*s.erase(s.find(20)) == 21 && !s.count(20));
+   assert(s.erase_range(50, 60) == 10 && s.erase_range(60, 50) == 0);
+   assert(s.erase(s.find(90), s.end()) == s.end() && s.count(89) && !s.count(90));
+   ttl::map<int, int>::iterator mi = m.erase(m.find(30), m.find(40));
+   assert(mi->first == 40 && !m.count(39) && m.count(29));
+   ttl::map<int, int> other;
+   for (int i = 35; i < 50; ++i)
+      other[i] = i;
+   m.unite(other);
+   assert(m.at(35) == 35 && m.at(40) == -40 && m.at(29) == -29);
+   ttl::map<int, int> drop;
+   for (int i = 0; i < 100; i += 2)
+      drop[i] = 0;
+   m.subtract(drop);
+   assert(!m.count(0) && m.count(11) && !m.count(36) && m.at(37) == 37 && m.count(99));
+}
+
+// the removal of given nodes among many equal keys
+static void test_remove_node()
+{
+   rbtree_set t;
+   std::multiset<int> ref;
+   std::vector<rbtree_set::node *> nodes;
+   for (int i = 0; i < 2000; ++i)
+   {
+      const int key = (int)(rnd() % 20);
+      nodes.push_back(t.insert_equal(key));
+      ref.insert(key);
+   }
+   while (!nodes.empty())
+   {
+      const size_t i = rnd() % nodes.size();
+      rbtree_set::node *n = nodes[i];
+      // the node and not another with its key
+      const ttl::rbnode *prev = n == static_cast<const ttl::rbnode *>(ttl::rbtree_base::min_node(t.get_root())) ?
+         0: ttl::rbtree_base::prev_node(n);
+      const ttl::rbnode *next = ttl::rbtree_base::next_node(n);
+      assert(t.remove(n) == n);
+      assert(!prev || ttl::rbtree_base::next_node(prev) == next);
+      ref.erase(ref.find(n->data));
+      assert(t.count(n->data) == ref.count(n->data));
+      t.destroy_node(n);
+      nodes[i] = nodes.back();
+      nodes.pop_back();
+      const ttl::rbnode *root = t.get_croot();
+      assert(!root || root->color == ttl::rbnode::BLACK);
+      check(root, t.end(), 0, 0);
+   }
+   assert(!t.get_croot());
+}
+
 void test()
 {
    printf("sizeof rbnode %lu, rbtree_map::node %lu, rbtree_set::node %lu\n",
@@ -178,4 +345,7 @@ void test()
    delete s.remove(1);
    printf("set of two elements\n");
    inorder<rbtree_set>(s.get_croot());
+
+   test_join_split();
+   test_remove_node();
 }
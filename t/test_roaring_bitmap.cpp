@@ -0,0 +1,166 @@
+// vim: sw=3 ts=8 et
+#include <set>
+#include "ttl/roaring_bitmap.hpp"
+#include "t.hpp"
+
+typedef std::set<unsigned> ref_set;
+
+struct to_set
+{
+   ref_set *s;
+   to_set(ref_set *p): s(p) {}
+   void operator()(unsigned x) { s->insert(x); }
+};
+
+template<class Bitmap>
+static void check(const Bitmap &b, const ref_set &s)
+{
+   assert(b.cardinality() == s.size() && b.empty() == s.empty());
+   ref_set::const_iterator j = s.begin();
+   for (typename Bitmap::const_iterator i = b.begin(); i != b.end(); ++i, ++j)
+   {
+      assert(j != s.end());
+      assert(*i == *j);
+   }
+   assert(j == s.end());
+   ref_set v;
+   b.for_each(to_set(&v));
+   assert(v == s);
+   for (j = s.begin(); j != s.end(); ++j)
+   {
+      assert(b.contains(*j));
+      assert(s.count(*j + 1) == b.contains(*j + 1));
+   }
+}
+
+// a mix of sparse ids, a dense chunk and runs
+template<class Bitmap>
+static void fill(Bitmap &b, ref_set &s, unsigned long long &seed, unsigned base)
+{
+   for (int i = 0; i < 3000; ++i)
+   {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      unsigned x = (unsigned)(seed >> 32);
+      switch (i % 3)
+      {
+      case 0: break;                                  // anywhere
+      case 1: x = base << 16 | (x & 0xffff); break;   // a dense chunk
+      case 2: x = (base + 1) << 16 | (x & 0x3fff); break;
+      }
+      assert(b.add(x) == s.insert(x).second);
+   }
+   for (unsigned x = (base + 2) << 16; x < ((base + 2) << 16) + 20000; ++x)
+      if (x % 1000 < 700)
+      {
+         b.add(x);
+         s.insert(x);
+      }
+}
+
+void test()
+{
+   ttl::roaring_bitmap<> b;
+   assert(b.empty() && b.cardinality() == 0 && b.begin() == b.end());
+   assert(b.add(7) && !b.add(7) && b.contains(7) && !b.contains(8));
+   assert(b.add(0xffffffffu) && b.add(0x10000) && b.cardinality() == 3);
+   assert(*b.begin() == 7);
+   assert(b.remove(7) && !b.remove(7) && b.cardinality() == 2);
+   b.clear();
+   assert(b.empty());
+
+   // array to bitmap and back
+   ref_set s;
+   for (unsigned x = 0; x < 10000; ++x)
+   {
+      b.add(x * 3);
+      s.insert(x * 3);
+   }
+   check(b, s);
+   printf("dense chunk: %lu bytes\n", (unsigned long)b.size_in_bytes());
+   assert(b.size_in_bytes() < 3 * 10000);
+   for (unsigned x = 0; x < 9000; ++x)
+   {
+      assert(b.remove(x * 3));
+      s.erase(x * 3);
+   }
+   check(b, s);
+
+   // runs
+   b.clear();
+   s.clear();
+   for (unsigned x = 100000; x < 200000; ++x)
+   {
+      b.add(x);
+      s.insert(x);
+   }
+   const unsigned long before = b.size_in_bytes();
+   assert(b.run_optimize() && !b.run_optimize());
+   printf("100000 ids: %lu bytes, %lu as runs\n", before, (unsigned long)b.size_in_bytes());
+   assert(b.size_in_bytes() < before / 10);
+   check(b, s);
+   assert(b.contains(100000) && b.contains(199999) && !b.contains(99999) && !b.contains(200000));
+   ttl::roaring_bitmap<> r(b);
+   assert(r == b);
+   assert(r.remove(150000) && !r.contains(150000) && r.contains(150001));
+   s.erase(150000);
+   check(r, s);
+   assert(r != b);
+   s.insert(150000);
+
+   unsigned long long seed = 1;
+   for (int round = 0; round < 4; ++round)
+   {
+      ttl::roaring_bitmap<> x, y;
+      ref_set sx, sy;
+      fill(x, sx, seed, 1);
+      fill(y, sy, seed, 2);
+      if (round & 1)
+         x.run_optimize();
+      if (round & 2)
+         y.run_optimize();
+      check(x, sx);
+      check(y, sy);
+
+      ref_set e;
+      for (ref_set::iterator i = sx.begin(); i != sx.end(); ++i)
+         if (sy.count(*i))
+            e.insert(*i);
+      check(x & y, e);
+      check(y & x, e);
+
+      e = sx;
+      e.insert(sy.begin(), sy.end());
+      check(x | y, e);
+      check(y | x, e);
+
+      e.clear();
+      for (ref_set::iterator i = sx.begin(); i != sx.end(); ++i)
+         if (!sy.count(*i))
+            e.insert(*i);
+      check(x - y, e);
+      assert((x - y) == ((x | y) - y));
+      assert((x - x).empty() && (x & x) == x && (x | x) == x);
+
+      ttl::roaring_bitmap<> z;
+      z.swap(x);
+      assert(x.empty());
+      check(z, sx);
+   }
+   {
+      // the chunks, their arrays and bitmaps from an arena
+      ttl::monotonic_arena arena;
+      typedef ttl::roaring_bitmap<ttl::resource_ref<ttl::monotonic_arena> > arena_bitmap;
+      arena_bitmap a(arena);
+      ref_set sa;
+      fill(a, sa, seed, 3);
+      assert(arena.allocated() >= sizeof(ttl::bitset<0x10000>));
+      ttl::size_t used = arena.allocated();
+      arena_bitmap c(a);
+      assert(c == a && arena.allocated() > used);
+      used = arena.allocated();
+      c.run_optimize();
+      c &= a;
+      assert(c == a && arena.allocated() > used);
+      check(c, sa);
+   }
+}
@@ -1,6 +1,8 @@
 // vim: sw=3 ts=8 et
 #include "ttl/sorted_vector_map.hpp"
+#include "ttl/map.hpp"
 #include "t.hpp"
+#include <map>
 
 template class ttl::sorted_vector_map<char, int>;
 
@@ -18,6 +20,173 @@ static void print_map(const char *s,
    fputs(".\n", stdout);
 }
 
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+template<class Map>
+static void check(const Map &m, const std::map<int, int> &ref)
+{
+   assert(m.size() == ref.size());
+   std::map<int, int>::const_iterator j = ref.begin();
+   for (typename Map::const_iterator i = m.begin(); i != m.end(); ++i, ++j)
+      assert(i->first == j->first && i->second == j->second);
+}
+
+// batches merged into the map, against inserting one by one
+static void test_batch()
+{
+   typedef ttl::sorted_vector_map<int, int> map_type;
+   for (unsigned round = 0; round < 100; ++round)
+   {
+      map_type m;
+      std::map<int, int> ref;
+      const int range = 1 + rnd() % (round % 2 ? 100: 10000);
+      for (unsigned b = 0; b < 10; ++b)
+      {
+         ttl::vector<ttl::pair<int, int> > batch;
+         const unsigned k = rnd() % (b % 3 ? 50: 1000);
+         batch.reserve(k);
+         for (unsigned i = 0; i < k; ++i)
+            batch.push_back(ttl::make_pair((int)(rnd() % range), (int)i));
+         // sorted with repeated keys of other values: the first one of
+         // them is inserted, as by the inserts one by one
+         ttl::map<int, int> once;
+         for (unsigned i = 0; i < k; ++i)
+            once.insert(batch[i]);
+         batch.clear();
+         for (ttl::map<int, int>::const_iterator i = once.begin(); i != once.end(); ++i)
+         {
+            batch.push_back(ttl::make_pair(i->first, i->second));
+            if (i->second % 4 == 0)
+               batch.push_back(ttl::make_pair(i->first, -i->second - 1));
+         }
+         if (b % 2 == 0)
+            for (unsigned i = 0; i + 1 < batch.size(); ++i)
+               ttl::swap(batch[i], batch[i + rnd() % (batch.size() - i)]);
+         for (unsigned i = 0; i < batch.size(); ++i)
+            ref.insert(std::make_pair(batch[i].first, batch[i].second));
+         if (b % 2)
+            m.insert_sorted(batch.begin(), batch.end());
+         else
+            m.insert(batch.begin(), batch.end());
+         check(m, ref);
+      }
+   }
+
+   // from a map, and into an empty one
+   ttl::map<int, int> src;
+   std::map<int, int> ref;
+   for (int i = 0; i < 1000; ++i)
+   {
+      src[i * 7 % 1009] = i;
+      ref[i * 7 % 1009] = i;
+   }
+   map_type m(src.begin(), src.end());
+   check(m, ref);
+   map_type e;
+   e.insert_sorted(m.begin(), m.end());
+   check(e, ref);
+
+   // a batch of one into an empty map reserves a single slot
+   ttl::pair<int, int> one = ttl::make_pair(5, 5);
+   map_type s1;
+   s1.insert(&one, &one + 1);
+   s1.insert(ttl::make_pair(6, 6));
+   s1[4] = 4;
+   assert(s1.size() == 3 && s1.at(4) == 4 && s1.at(5) == 5 && s1.at(6) == 6);
+   map_type s2;
+   s2.insert_sorted(&one, &one + 1);
+   s2[6] = 6;
+   assert(s2.size() == 2 && s2.at(5) == 5 && s2.at(6) == 6);
+}
+
+// the side buffer: the lookups and the iterators see it in place
+static void test_buffer()
+{
+   typedef ttl::sorted_vector_map<int, int> map_type;
+   map_type m;
+   std::map<int, int> ref;
+   m.set_buffer_limit(16);
+   for (int i = 0; i < 1000; ++i)
+   {
+      const int key = (int)(rnd() % 2000);
+      if (i % 3)
+         m[key] = i;
+      else if (m.insert_buffered(ttl::make_pair(key, i)))
+         assert(!ref.count(key));
+      ref[key] = m.at(key);
+      assert(m.count(key) && m.size() == ref.size());
+      assert(m.buffered() < 16);
+      if (i % 50 == 0)
+      {
+         const int gone = (int)(rnd() % 2000);
+         assert(m.erase(gone) == ref.erase(gone));
+      }
+   }
+   // the values do not move when the buffer is merged
+   m[-1] = -1;
+   ref[-1] = -1;
+   int &v = m[-1];
+   const map_type::buffer_stats &st = m.stats();
+   const ttl::size_t merges = st.merges, flushes = st.flushes;
+   assert(merges > 20 && !flushes && m.buffered());
+   check(m, ref);
+   std::map<int, int>::const_reverse_iterator r = ref.rbegin();
+   for (map_type::const_iterator i = m.end(); i != m.begin(); ++r)
+      assert((--i)->first == r->first);
+   assert(&m.find(-1)->second == &v && m.find(-2) == m.end());
+   assert(!st.flushes && m.buffered());
+   m.flush();
+   assert(st.flushes == 1 && !m.buffered() && st.merged >= m.size());
+   assert(v == -1 && &m.find(-1)->second == &v);
+
+   // the copies keep the buffer, the source is not merged
+   m[5000] = 1;
+   map_type c = m;
+   ref[5000] = 1;
+   assert(c.buffer_limit() == 16 && c.buffered() == 1 && m.buffered() == 1);
+   check(c, ref);
+   m[5001] = 2;
+   assert(m.lower_bound(5001)->second == 2 && m.upper_bound(5000)->first == 5001);
+   assert(m.equal_range(5000).first->second == 1 && st.flushes == 1);
+   map_type u;
+   u.unite(m);
+   assert(m.buffered() == 2 && u.size() == m.size() && u.find(5001)->second == 2);
+   u.intersect(m);
+   assert(u.size() == m.size());
+
+   // a range of the map is one of the array and one of the buffer
+   for (int key = 100; key < 1000; key += 7)
+      c[key] = key;
+   assert(c.buffered());
+   std::map<int, int> cref(ref);
+   for (int key = 100; key < 1000; key += 7)
+      cref[key] = c[key];
+   map_type::iterator e = c.erase(c.lower_bound(300), c.lower_bound(700));
+   cref.erase(cref.lower_bound(300), cref.lower_bound(700));
+   assert(e == c.lower_bound(700));
+   check(c, cref);
+   c.subtract(m);
+   for (std::map<int, int>::iterator i = cref.begin(); i != cref.end();)
+      if (m.count(i->first))
+         cref.erase(i++);
+      else
+         ++i;
+   check(c, cref);
+
+   m[5002] = 3;
+   m.set_buffer_limit(0);
+   assert(!m.buffered() && st.flushes == 2);
+   m[5003] = 4;
+   assert(!m.buffered() && m.size() == ref.size() + 3 && m.at(5003) == 4);
+}
+
 void test()
 {
    ttl::sorted_vector_map<char, int> m;
@@ -45,4 +214,6 @@ void test()
    //print_map("insert(iterator)\n", m1);
    m1.clear();
    print_map("clear: ", m1);
+   test_batch();
+   test_buffer();
 }
@@ -0,0 +1,187 @@
+// vim: sw=3 ts=8 et
+#include "ttl/string.hpp"
+#include "ttl/map.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/fixed_unordered_map.hpp"
+#include "t.hpp"
+#include <string>
+
+template class ttl::sso_string<>;
+
+static unsigned long rnd()
+{
+   static unsigned long s = 88172645463325252ul;
+   s ^= s << 13;
+   s ^= s >> 7;
+   s ^= s << 17;
+   return s;
+}
+
+static ttl::size_t pos(ttl::size_t n)
+{
+   return n == std::string::npos ? ttl::string_view::npos: n;
+}
+
+// a few letters, so the searches find something
+static std::string random_string(ttl::size_t max)
+{
+   std::string s(rnd() % (max + 1), 'a');
+   for (ttl::size_t i = 0; i < s.size(); ++i)
+      s[i] = (char)('a' + rnd() % 4 + (rnd() % 64 == 0 ? 0x70: 0));
+   return s;
+}
+
+static void check(const ttl::string &s, const std::string &ref)
+{
+   assert(s.size() == ref.size() && s.empty() == ref.empty());
+   assert(!memcmp(s.data(), ref.data(), ref.size()) && !s.c_str()[s.size()]);
+   assert(s.capacity() >= s.size() && s.capacity() >= s.inline_capacity);
+   assert(s == ttl::string_view(ref.data(), ref.size()));
+}
+
+static void test_view()
+{
+   for (unsigned step = 0; step < 20000; ++step)
+   {
+      const std::string a = random_string(70), b = random_string(step % 8 == 0 ? 40: 3);
+      const ttl::string_view va(a.data(), a.size()), vb(b.data(), b.size());
+      const ttl::size_t p = rnd() % (a.size() + 2);
+      const char c = (char)('a' + rnd() % 5);
+      assert(va.find(vb, p) == pos(a.find(b, p)));
+      assert(va.find(c, p) == pos(a.find(c, p)));
+      assert(va.rfind(vb, p) == pos(a.rfind(b, p)));
+      assert(va.rfind(c, p) == pos(a.rfind(c, p)));
+      assert(va.find_first_of(vb, p) == pos(a.find_first_of(b, p)));
+      assert(va.find_last_of(vb, p) == pos(a.find_last_of(b, p)));
+      assert(va.find_first_not_of(vb, p) == pos(a.find_first_not_of(b, p)));
+      assert(va.find_last_not_of(vb, p) == pos(a.find_last_not_of(b, p)));
+      const int r = a.compare(b);
+      assert((va.compare(vb) < 0) == (r < 0) && (va.compare(vb) > 0) == (r > 0));
+      assert((va < vb) == (a < b) && (va == vb) == (a == b) && (va >= vb) == (a >= b));
+      assert(va.starts_with(vb) == (a.compare(0, b.size(), b) == 0 && a.size() >= b.size()));
+      assert(va.substr(p, 7) == ttl::string_view(a.substr(p < a.size() ? p: a.size(), 7).c_str()));
+      if (va == vb)
+         assert(ttl::hash<ttl::string_view>()(va) == ttl::hash<ttl::string_view>()(vb));
+   }
+
+   // a set of more than 16 characters, the high bytes
+   const ttl::string_view v("hello, world\xff");
+   assert(v.find_first_of("0123456789ABCDEFGHIJKLMNOPw") == 7);
+   assert(v.find_first_of("\xff") == 12 && v.find('\xff') == 12 && v.find("") == 0);
+   assert(ttl::string_view("\xff") > ttl::string_view("a"));
+   assert(v.find("world") == 7 && v.find("worlds") == v.npos && v.ends_with("world\xff"));
+}
+
+static void test_random()
+{
+   ttl::string s;
+   std::string ref;
+   for (unsigned step = 0; step < 50000; ++step)
+   {
+      const std::string a = random_string(step % 16 == 0 ? 60: 8);
+      const ttl::size_t p = rnd() % (ref.size() + 1), n = rnd() % 10;
+      switch (rnd() % 10)
+      {
+      case 0:
+         s.clear();
+         ref.clear();
+         break;
+      case 1:
+         s.erase(p, n);
+         ref.erase(p, n);
+         break;
+      case 2:
+         s.insert(p, a.c_str());
+         ref.insert(p, a);
+         break;
+      case 3:
+         // the string itself, or a part of it
+         s.insert(p, ttl::string_view(s).substr(n));
+         ref.insert(p, ref.substr(n < ref.size() ? n: ref.size()));
+         break;
+      case 4:
+         s.append(s.data() + p, ref.size() - p);
+         ref.append(ref, p, std::string::npos);
+         break;
+      case 5:
+         s.resize(n * 5, 'x');
+         ref.resize(n * 5, 'x');
+         break;
+      case 6:
+         s = a.c_str();
+         ref = a;
+         break;
+      case 7:
+         s.push_back('y');
+         ref.push_back('y');
+         break;
+      case 8:
+         if (!ref.empty())
+         {
+            s.pop_back();
+            ref.erase(ref.size() - 1);
+            s.shrink_to_fit();
+         }
+         break;
+      default:
+         s += a.c_str();
+         ref += a;
+      }
+      check(s, ref);
+   }
+
+   ttl::string c(s), d("short");
+   assert(c == s && d != s);
+   c.swap(d);
+   check(d, ref);
+   assert(c == "short" && c.size() == 5);
+   c = d;
+   check(c, ref);
+   c = c.substr(3, 30);
+   check(c, ref.substr(3 < ref.size() ? 3: ref.size(), 30));
+   assert(ttl::string("abc") + "def" + 'g' == "abcdefg");
+}
+
+void test()
+{
+   test_view();
+   test_random();
+
+   // 23 characters inline
+   ttl::string s(23, 'a');
+   assert(s.capacity() == 23 && s.size() == 23 && !s.c_str()[23]);
+   s += 'b';
+   assert(s.capacity() == 31 && s.size() == 24 && s[23] == 'b');
+   s.resize(23);
+   s.shrink_to_fit();
+   assert(s.capacity() == 23 && s == ttl::string(23, 'a'));
+
+   // the keys of maps, and the transparent lookups
+   const char *const words[] = { "pear", "apple", "a rather long key, allocated", "fig", "" };
+   ttl::map<ttl::string, int> m;
+   ttl::sorted_vector_map<ttl::string, int, ttl::less<> > v;
+   ttl::fixed_unordered_map<ttl::string, int, 8> h;
+   for (int i = 0; i < 5; ++i)
+   {
+      m[words[i]] = i;
+      v[words[i]] = i;
+      h[words[i]] = i;
+   }
+   assert(m.count("pear") && m.begin()->first == "" && m["fig"] == 3);
+   assert(v.find(ttl::string_view("apple"))->second == 1 && v.find("plum") == v.end());
+   assert((++v.begin())->first == "a rather long key, allocated");
+   assert(h.size() == 5 && h.find("a rather long key, allocated")->second == 2 && !h.count("plum"));
+
+   // from a memory resource
+   ttl::monotonic_arena arena;
+   typedef ttl::sso_string<ttl::resource_ref<ttl::monotonic_arena> > arena_string;
+   arena_string a(arena);
+   a.assign("in the arena, a string too long for the inline characters");
+   a += a;
+   assert(a.size() == 114 && a.substr(57, 6) == "in the" && arena.allocated() > 114);
+   arena_string b(a);
+   assert(ttl::string_view(b) == a && b.substr(3, 9) == "the arena");
+
+   printf("sizeof string: %lu, %lu characters inline\n",
+          (unsigned long)sizeof(ttl::string), (unsigned long)ttl::string::inline_capacity);
+}
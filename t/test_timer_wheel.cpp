@@ -0,0 +1,152 @@
+// vim: sw=3 ts=8 et
+#include "ttl/timer_wheel.hpp"
+#include "t.hpp"
+
+template class ttl::timer_wheel<>;
+template class ttl::timer_wheel<2>;
+
+struct job: ttl::timer_node
+{
+   int id;
+   unsigned long long fired;
+};
+
+struct record
+{
+   unsigned long long *last;
+   unsigned long long now;
+   int *count;
+   void operator()(ttl::timer_node &t) const
+   {
+      job &j = static_cast<job &>(t);
+      assert(!j.scheduled());
+      assert(j.expires <= now);
+      *last = j.expires;
+      j.fired = now;
+      ++*count;
+   }
+};
+
+template<class Wheel>
+static int advance(Wheel &w, unsigned long long now)
+{
+   unsigned long long last = 0;
+   int count = 0;
+   record r = { &last, now, &count };
+   assert((int)w.advance(now, r) == count);
+   assert(w.now() == now);
+   return count;
+}
+
+// the wheel against a straightforward scan of all timers
+template<class Wheel>
+static void random_test(unsigned long long span, unsigned n, unsigned steps)
+{
+   Wheel w(12345);
+   job *jobs = new job[n];
+   unsigned long long seed = 1;
+   for (unsigned i = 0; i < n; ++i)
+   {
+      jobs[i].id = i;
+      jobs[i].fired = 0;
+   }
+   unsigned long long now = w.now();
+   for (unsigned step = 0; step < steps; ++step)
+   {
+      for (unsigned k = 0; k < n / 4; ++k)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         job &j = jobs[(seed >> 33) % n];
+         unsigned long long delta = (seed >> 13) % span;
+         if ((seed >> 7) % 16 == 0)
+            w.cancel(j);
+         else
+            w.schedule(j, now + delta - span / 64);
+      }
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      now += 1 + (seed >> 40) % (span / 8);
+      unsigned expected = 0, scheduled = 0;
+      for (unsigned i = 0; i < n; ++i)
+         if (jobs[i].scheduled())
+         {
+            ++scheduled;
+            if (jobs[i].expires <= now)
+               ++expected;
+         }
+      assert(w.size() == scheduled);
+      int fired = advance(w, now);
+      assert((unsigned)fired == expected);
+      for (unsigned i = 0; i < n; ++i)
+         assert(!jobs[i].scheduled() || jobs[i].expires > now);
+   }
+   delete [] jobs;
+}
+
+void test()
+{
+   printf("sizeof timer_node %lu, timer_wheel<> %lu\n",
+          (unsigned long)sizeof(ttl::timer_node),
+          (unsigned long)sizeof(ttl::timer_wheel<>));
+
+   ttl::timer_wheel<> w;
+   job a, b, c, d;
+   assert(w.empty() && !a.scheduled());
+
+   w.schedule(a, 10);
+   w.schedule(b, 100);
+   w.schedule(c, 5000);
+   w.schedule(d, 1ull << 40);
+   assert(w.size() == 4 && a.scheduled());
+
+   assert(advance(w, 9) == 0);
+   assert(advance(w, 10) == 1 && !a.scheduled() && a.fired == 10);
+
+   // refresh b twice, it fires once, at the last deadline
+   w.schedule(b, 150);
+   w.schedule(b, 200);
+   assert(w.size() == 3);
+   assert(advance(w, 199) == 0);
+   assert(advance(w, 4999) == 1 && b.fired == 4999);
+
+   w.cancel(c);
+   w.cancel(c);
+   assert(w.size() == 1 && !c.scheduled());
+   assert(advance(w, 1ull << 39) == 0);
+
+   // in the past: expires on the next advance
+   w.schedule(a, 3);
+   assert(advance(w, (1ull << 39) + 1) == 1);
+
+   assert(advance(w, 1ull << 40) == 1 && !d.scheduled());
+   assert(w.empty());
+
+   // expiry order
+   w.schedule(c, w.now() + 64 * 64 * 64 - 1);
+   w.schedule(b, w.now() + 64 * 64);
+   w.schedule(a, w.now() + 64);
+   {
+      unsigned long long last = 0;
+      int count = 0;
+      record r = { &last, w.now() + 64 * 64 * 64, &count };
+      assert(w.advance(r.now, r) == 3);
+      assert(a.fired == r.now && last == c.expires);
+   }
+
+   // beyond the span of a two level wheel (4096 ticks)
+   ttl::timer_wheel<2> w2;
+   w2.schedule(a, 1000000);
+   w2.schedule(b, 4096);
+   w2.schedule(c, 4095);
+   assert(advance(w2, 4095) == 1 && c.fired == 4095);
+   assert(advance(w2, 999999) == 1 && b.fired == 999999);
+   assert(advance(w2, 1000000) == 1 && a.fired == 1000000);
+   w2.schedule(a, 1);
+   w2.schedule(b, 1);
+   w2.schedule(c, 1);
+   w2.cancel(b);
+
+   random_test< ttl::timer_wheel<> >(1000, 200, 200);
+   random_test< ttl::timer_wheel<> >(1000000, 200, 200);
+   random_test< ttl::timer_wheel<2> >(100000, 200, 200);
+   random_test< ttl::timer_wheel<3> >(64, 100, 500);
+}
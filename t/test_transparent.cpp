@@ -0,0 +1,123 @@
+// vim: sw=3 ts=8 et
+#include "ttl/map.hpp"
+#include "ttl/set.hpp"
+#include "ttl/btree_map.hpp"
+#include "ttl/btree_set.hpp"
+#include "ttl/sorted_vector_map.hpp"
+#include "ttl/vector_map.hpp"
+#include "t.hpp"
+
+// a key owning a copy of its string, counting the copies made
+struct name
+{
+   static int made;
+   char *s;
+   name(const char *str): s(strdup(str)) { ++made; }
+   name(const name &other): s(strdup(other.s)) { ++made; }
+   ~name() { free(s); }
+   name &operator=(const name &other)
+   {
+      char *c = strdup(other.s);
+      free(s);
+      s = c;
+      return *this;
+   }
+};
+int name::made = 0;
+
+bool operator<(const name &a, const name &b) { return strcmp(a.s, b.s) < 0; }
+bool operator<(const name &a, const char *b) { return strcmp(a.s, b) < 0; }
+bool operator<(const char *a, const name &b) { return strcmp(a, b.s) < 0; }
+bool operator==(const name &a, const name &b) { return !strcmp(a.s, b.s); }
+bool operator==(const name &a, const char *b) { return !strcmp(a.s, b); }
+bool operator==(const char *a, const name &b) { return !strcmp(a, b.s); }
+
+static const char *const words[] = { "kiwi", "apple", "fig", "lime", "date", "pear", "cherry" };
+
+template<class Map>
+static void test_lookups(Map &m, const char *title)
+{
+   typedef typename Map::iterator iterator;
+   typedef typename Map::const_iterator const_iterator;
+   for (unsigned i = 0; i < countof(words); ++i)
+      m[name(words[i])] = (int)i;
+
+   const int made = name::made;
+   const Map &cm = m;
+   for (unsigned i = 0; i < countof(words); ++i)
+   {
+      assert(m.find(words[i])->second == (int)i);
+      assert(cm.find(words[i])->second == (int)i);
+      assert(m.count(words[i]) == 1);
+      assert(m.lower_bound(words[i]) == m.find(words[i]));
+   }
+   assert(m.find("banana") == m.end() && cm.find("zzz") == cm.end() && !m.count("grape"));
+   // the bounds of a key not in the map
+   iterator lo = m.lower_bound("grape");
+   assert(lo == m.upper_bound("grape") && lo->first == "kiwi");
+   const_iterator up = cm.upper_bound("fig");
+   assert(up->first == "kiwi");
+   ttl::pair<iterator, iterator> r = m.equal_range("lime");
+   assert(r.first->first == "lime" && r.second->first == "pear");
+   ttl::pair<const_iterator, const_iterator> cr = cm.equal_range("banana");
+   assert(cr.first == cr.second && cr.first->first == "cherry");
+   assert(name::made == made);
+   // a btree relocates the values after the one erased by copies
+   assert(m.erase("lime") == 1 && m.erase("lime") == 0 && !m.count("lime"));
+   printf("%s: no key built by the lookups\n", title);
+}
+
+template<class Set>
+static void test_set()
+{
+   Set s;
+   for (unsigned i = 0; i < countof(words); ++i)
+      s.insert(name(words[i]));
+   const int made = name::made;
+   assert(*s.find("fig") == "fig" && s.count("pear") && !s.count("plum"));
+   assert(*s.lower_bound("e") == "fig" && *s.upper_bound("fig") == "kiwi");
+   assert(s.equal_range("cherry").first == s.find("cherry"));
+   assert(name::made == made);
+   assert(s.erase("apple") == 1 && *s.begin() == "cherry");
+}
+
+static void test_vector_map()
+{
+   ttl::vector_map<name, int, ttl::equal_to<> > m;
+   for (unsigned i = 0; i < countof(words); ++i)
+      m[name(words[i])] = (int)i;
+   const int made = name::made;
+   assert(m.find("date")->second == 4 && m.find("plum") == m.end());
+   assert(m.count("pear") == 1 && !m.count("plum"));
+   assert(name::made == made);
+}
+
+void test()
+{
+   {
+      ttl::map<name, int, ttl::less<> > m;
+      test_lookups(m, "map<name, int, less<> >");
+   }
+   {
+      ttl::sorted_vector_map<name, int, ttl::less<> > m;
+      test_lookups(m, "sorted_vector_map<name, int, less<> >");
+   }
+   {
+      ttl::btree_map<name, int, ttl::less<> > m;
+      test_lookups(m, "btree_map<name, int, less<> >");
+   }
+   test_set<ttl::set<name, ttl::less<> > >();
+   test_set<ttl::btree_set<name, ttl::less<> > >();
+   test_vector_map();
+
+   // without a transparent Compare the lookups still build a key
+   ttl::map<name, int> m;
+   m[name("a")] = 1;
+   const int made = name::made;
+   assert(m.find("a")->second == 1);
+   assert(name::made == made + 1);
+   ttl::map<int, int, ttl::greater<> > g;
+   for (int i = 0; i < 10; ++i)
+      g[i] = i;
+   assert(g.begin()->first == 9 && g.lower_bound(4.5)->first == 4 && g.count(3L));
+}
@@ -7,6 +7,11 @@
 #ifndef _TINY_TEMPLATE_LIBRARY_ALGORITHM_HPP_
 #define _TINY_TEMPLATE_LIBRARY_ALGORITHM_HPP_
 
+#include <limits.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <string.h>
+#include <emmintrin.h>
+#endif
 #include "types.hpp"
 #include "type_traits.hpp"
 
@@ -152,6 +157,274 @@ namespace ttl
       return last;
    }
 
+   //
+   // Searchers, to be used with search(first, last, searcher)
+   //
+
+   template<class ForwardIt1, class Searcher>
+   inline ForwardIt1 search(ForwardIt1 first, ForwardIt1 last, const Searcher &searcher)
+   {
+      return searcher(first, last).first;
+   }
+
+   // The naive O(N*M) search, the same as search(first, last, subfirst, sublast)
+   template<class ForwardIt1>
+   class default_searcher
+   {
+   public:
+      default_searcher(ForwardIt1 pat_first, ForwardIt1 pat_last):
+         pat_first_(pat_first), pat_last_(pat_last) {}
+
+      template<class ForwardIt2>
+      pair<ForwardIt2, ForwardIt2> operator()(ForwardIt2 first, ForwardIt2 last) const
+      {
+         first = ttl::search(first, last, pat_first_, pat_last_);
+         ForwardIt2 i = first;
+         for (ForwardIt1 p = pat_first_; p != pat_last_ && i != last; ++p)
+            ++i;
+         return pair<ForwardIt2, ForwardIt2>(first, i);
+      }
+
+   private:
+      ForwardIt1 pat_first_, pat_last_;
+   };
+
+   template<class T> struct _is_byte_pointer: false_type {};
+   template<> struct _is_byte_pointer<char *>: true_type {};
+   template<> struct _is_byte_pointer<const char *>: true_type {};
+   template<> struct _is_byte_pointer<signed char *>: true_type {};
+   template<> struct _is_byte_pointer<const signed char *>: true_type {};
+   template<> struct _is_byte_pointer<unsigned char *>: true_type {};
+   template<> struct _is_byte_pointer<const unsigned char *>: true_type {};
+
+#if defined(__SSE2__) && defined(__GNUC__)
+   // First-and-last byte filter: compare 16 candidate positions at once
+   // against the first and the last byte of the pattern, and check the
+   // middle of the pattern only where both match. Requires m >= 2.
+   inline const char *_search_bytes(const char *s, ttl::size_t n, const char *p, ttl::size_t m)
+   {
+      const __m128i first = _mm_set1_epi8(p[0]);
+      const __m128i last = _mm_set1_epi8(p[m - 1]);
+      ttl::size_t i = 0;
+      for (; i + m - 1 + 16 <= n; i += 16)
+      {
+         const __m128i bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+         const __m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + m - 1));
+         unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first),
+                                                         _mm_cmpeq_epi8(bl, last)));
+         for (; mask; mask &= mask - 1)
+         {
+            const ttl::size_t pos = i + __builtin_ctz(mask);
+            if (!memcmp(s + pos + 1, p + 1, m - 2))
+               return s + pos;
+         }
+      }
+      for (; i + m <= n; ++i)
+         if (s[i] == p[0] && s[i + m - 1] == p[m - 1] && !memcmp(s + i + 1, p + 1, m - 2))
+            return s + i;
+      return s + n;
+   }
+#endif
+
+   // Boyer-Moore-Horspool search: on a mismatch the window is shifted by the
+   // distance of the window's last element from its last occurrence in the
+   // pattern. The skip table is indexed by the low byte of the element, which
+   // is exact for byte-sized elements and conservative for wider integers.
+   //
+   // Byte ranges are searched with the SIMD first-and-last byte filter,
+   // where it is available.
+   //
+   // O(N/M) typical, O(N*M) worst case.
+   template<class RandomIt1>
+   class boyer_moore_horspool_searcher
+   {
+   public:
+      boyer_moore_horspool_searcher(RandomIt1 pat_first, RandomIt1 pat_last);
+
+      template<class RandomIt2>
+      pair<RandomIt2, RandomIt2> operator()(RandomIt2 first, RandomIt2 last) const
+      {
+         return search_(first, last,
+                        integral_constant<bool, _is_byte_pointer<RandomIt1>::value &&
+                                                _is_byte_pointer<RandomIt2>::value>());
+      }
+
+   private:
+      RandomIt1 pat_first_;
+      ttl::size_t m_;
+      ttl::size_t skip_[1 << CHAR_BIT];
+
+      template<class RandomIt2>
+      pair<RandomIt2, RandomIt2> search_(RandomIt2 first, RandomIt2 last, integral_constant<bool, false>) const;
+#if defined(__SSE2__) && defined(__GNUC__)
+      template<class RandomIt2>
+      pair<RandomIt2, RandomIt2> search_(RandomIt2 first, RandomIt2 last, integral_constant<bool, true>) const
+      {
+         if (m_ < 2 || (ttl::size_t)(last - first) < m_)
+            return search_(first, last, integral_constant<bool, false>());
+         const char *s = reinterpret_cast<const char *>(first);
+         const char *r = _search_bytes(s, last - first, reinterpret_cast<const char *>(pat_first_), m_);
+         if (r == s + (last - first))
+            return pair<RandomIt2, RandomIt2>(last, last);
+         return pair<RandomIt2, RandomIt2>(first + (r - s), first + (r - s) + m_);
+      }
+#else
+      template<class RandomIt2>
+      pair<RandomIt2, RandomIt2> search_(RandomIt2 first, RandomIt2 last, integral_constant<bool, true>) const
+      {
+         return search_(first, last, integral_constant<bool, false>());
+      }
+#endif
+   };
+
+   template<class RandomIt1>
+   boyer_moore_horspool_searcher<RandomIt1>::boyer_moore_horspool_searcher(RandomIt1 pat_first, RandomIt1 pat_last):
+      pat_first_(pat_first), m_(pat_last - pat_first)
+   {
+      for (unsigned c = 0; c < sizeof(skip_)/sizeof(*skip_); ++c)
+         skip_[c] = m_;
+      for (ttl::size_t i = 0; i + 1 < m_; ++i)
+         skip_[static_cast<unsigned char>(pat_first_[i])] = m_ - 1 - i;
+   }
+
+   template<class RandomIt1>
+   template<class RandomIt2>
+   pair<RandomIt2, RandomIt2>
+   boyer_moore_horspool_searcher<RandomIt1>::search_(RandomIt2 first, RandomIt2 last, integral_constant<bool, false>) const
+   {
+      const ttl::size_t n = last - first;
+      if (!m_)
+         return pair<RandomIt2, RandomIt2>(first, first);
+      for (ttl::size_t j = 0; m_ <= n && j <= n - m_; )
+      {
+         ttl::size_t i = m_ - 1;
+         while (first[j + i] == pat_first_[i])
+         {
+            if (!i)
+               return pair<RandomIt2, RandomIt2>(first + j, first + j + m_);
+            --i;
+         }
+         j += skip_[static_cast<unsigned char>(first[j + m_ - 1])];
+      }
+      return pair<RandomIt2, RandomIt2>(last, last);
+   }
+
+   // Two-way string matching: Crochemore, Perrin, "Two-way string-matching",
+   // Journal of the ACM 38(3), 1991.
+   //
+   // The pattern is split at a critical factorization; the right part is
+   // matched left to right, then the left part right to left, and the shift
+   // after a mismatch never rescans text known to match, so the search is
+   // O(N + M) in the worst case using O(1) extra memory. Elements need
+   // operator< and operator==.
+   template<class RandomIt1>
+   class two_way_searcher
+   {
+   public:
+      two_way_searcher(RandomIt1 pat_first, RandomIt1 pat_last);
+
+      template<class RandomIt2>
+      pair<RandomIt2, RandomIt2> operator()(RandomIt2 first, RandomIt2 last) const;
+
+   private:
+      RandomIt1 pat_;
+      ttl::size_t m_, suffix_, period_;
+      bool periodic_;
+
+      ttl::size_t maximal_suffix(bool reversed, ttl::size_t &period) const;
+   };
+
+   template<class RandomIt1>
+   ttl::size_t two_way_searcher<RandomIt1>::maximal_suffix(bool reversed, ttl::size_t &period) const
+   {
+      // ms starts at -1, the unsigned arithmetic is intended to wrap around
+      ttl::size_t ms = (ttl::size_t)-1, j = 0, k = 1;
+      period = 1;
+      while (j + k < m_)
+      {
+         const bool a_lt_b = pat_[j + k] < pat_[ms + k];
+         const bool b_lt_a = pat_[ms + k] < pat_[j + k];
+         if (reversed ? b_lt_a: a_lt_b)
+         {
+            j += k;
+            k = 1;
+            period = j - ms;
+         }
+         else if (!a_lt_b && !b_lt_a)
+         {
+            if (k != period)
+               ++k;
+            else
+            {
+               j += period;
+               k = 1;
+            }
+         }
+         else
+         {
+            ms = j++;
+            k = period = 1;
+         }
+      }
+      return ms + 1;
+   }
+
+   template<class RandomIt1>
+   two_way_searcher<RandomIt1>::two_way_searcher(RandomIt1 pat_first, RandomIt1 pat_last):
+      pat_(pat_first), m_(pat_last - pat_first), suffix_(0), period_(1), periodic_(false)
+   {
+      if (m_ < 2)
+         return;
+      ttl::size_t p, rp;
+      const ttl::size_t s = maximal_suffix(false, p);
+      const ttl::size_t rs = maximal_suffix(true, rp);
+      if (s < rs)
+         suffix_ = rs, period_ = rp;
+      else
+         suffix_ = s, period_ = p;
+      periodic_ = suffix_ + period_ <= m_;
+      for (ttl::size_t i = 0; periodic_ && i < suffix_; ++i)
+         if (!(pat_[i] == pat_[i + period_]))
+            periodic_ = false;
+      if (!periodic_)
+         period_ = (suffix_ > m_ - suffix_ ? suffix_: m_ - suffix_) + 1;
+   }
+
+   template<class RandomIt1>
+   template<class RandomIt2>
+   pair<RandomIt2, RandomIt2> two_way_searcher<RandomIt1>::operator()(RandomIt2 first, RandomIt2 last) const
+   {
+      const ttl::size_t n = last - first;
+      if (!m_)
+         return pair<RandomIt2, RandomIt2>(first, first);
+      if (n < m_)
+         return pair<RandomIt2, RandomIt2>(last, last);
+
+      // memory is the length of the pattern prefix known to match after a
+      // shift by a period, it is always 0 for non-periodic patterns
+      ttl::size_t memory = 0;
+      for (ttl::size_t j = 0; j <= n - m_; )
+      {
+         ttl::size_t i = suffix_ > memory ? suffix_: memory;
+         while (i < m_ && pat_[i] == first[i + j])
+            ++i;
+         if (i < m_)
+         {
+            j += i - suffix_ + 1;
+            memory = 0;
+            continue;
+         }
+         for (i = suffix_; i > memory && pat_[i - 1] == first[i - 1 + j]; --i)
+            ;
+         if (i <= memory)
+            return pair<RandomIt2, RandomIt2>(first + j, first + j + m_);
+         j += period_;
+         if (periodic_)
+            memory = m_ - period_;
+      }
+      return pair<RandomIt2, RandomIt2>(last, last);
+   }
+
    template<class InputIt, class T>
    /* InputIt::difference_type */ int count(InputIt first, InputIt last, const T &value)
    {
@@ -629,6 +902,130 @@ namespace ttl
       return is_sorted_until(first, last) == last;
    }
 
+   //
+   // Heap operations
+   //
+
+   struct _less_op
+   {
+      template<class A, class B> bool operator()(const A &a, const B &b) const { return a < b; }
+   };
+
+   // The value is passed by value, so it is safe to overwrite its origin.
+   template<class RandomIt, class T, class Compare>
+   void _heap_sift_up(RandomIt first, ttl::ptrdiff_t hole, T value, Compare comp)
+   {
+      for (ttl::ptrdiff_t parent; hole > 0 && comp(first[parent = (hole - 1) / 2], value); hole = parent)
+         first[hole] = first[parent];
+      first[hole] = value;
+   }
+
+   template<class RandomIt, class T, class Compare>
+   void _heap_sift_down(RandomIt first, ttl::ptrdiff_t hole, ttl::ptrdiff_t len, T value, Compare comp)
+   {
+      for (ttl::ptrdiff_t child; (child = 2 * hole + 1) < len; hole = child)
+      {
+         if (child + 1 < len && comp(first[child], first[child + 1]))
+            ++child;
+         if (!comp(value, first[child]))
+            break;
+         first[hole] = first[child];
+      }
+      first[hole] = value;
+   }
+
+   template<class RandomIt, class T, class Compare>
+   inline void _pop_heap(RandomIt first, RandomIt last, T value, Compare comp)
+   {
+      *last = *first;
+      _heap_sift_down(first, 0, last - first, value, comp);
+   }
+
+   template<class RandomIt, class Compare>
+   inline void push_heap(RandomIt first, RandomIt last, Compare comp)
+   {
+      if (last - first > 1)
+         _heap_sift_up(first, last - first - 1, *(last - 1), comp);
+   }
+
+   template<class RandomIt>
+   inline void push_heap(RandomIt first, RandomIt last)
+   {
+      push_heap(first, last, _less_op());
+   }
+
+   template<class RandomIt, class Compare>
+   inline void pop_heap(RandomIt first, RandomIt last, Compare comp)
+   {
+      if (last - first > 1)
+      {
+         --last;
+         _pop_heap(first, last, *last, comp);
+      }
+   }
+
+   template<class RandomIt>
+   inline void pop_heap(RandomIt first, RandomIt last)
+   {
+      pop_heap(first, last, _less_op());
+   }
+
+   // Floyd's bottom-up heap construction, O(N)
+   template<class RandomIt, class Compare>
+   void make_heap(RandomIt first, RandomIt last, Compare comp)
+   {
+      const ttl::ptrdiff_t len = last - first;
+      for (ttl::ptrdiff_t i = len / 2; i-- > 0; )
+         _heap_sift_down(first, i, len, first[i], comp);
+   }
+
+   template<class RandomIt>
+   inline void make_heap(RandomIt first, RandomIt last)
+   {
+      make_heap(first, last, _less_op());
+   }
+
+   template<class RandomIt, class Compare>
+   void sort_heap(RandomIt first, RandomIt last, Compare comp)
+   {
+      for (; last - first > 1; --last)
+         pop_heap(first, last, comp);
+   }
+
+   template<class RandomIt>
+   inline void sort_heap(RandomIt first, RandomIt last)
+   {
+      sort_heap(first, last, _less_op());
+   }
+
+   template<class RandomIt, class Compare>
+   RandomIt is_heap_until(RandomIt first, RandomIt last, Compare comp)
+   {
+      const ttl::ptrdiff_t len = last - first;
+      for (ttl::ptrdiff_t i = 1; i < len; ++i)
+         if (comp(first[(i - 1) / 2], first[i]))
+            return first + i;
+      return last;
+   }
+
+   template<class RandomIt>
+   inline RandomIt is_heap_until(RandomIt first, RandomIt last)
+   {
+      return is_heap_until(first, last, _less_op());
+   }
+
+   template<class RandomIt, class Compare>
+   inline bool is_heap(RandomIt first, RandomIt last, Compare comp)
+   {
+      return is_heap_until(first, last, comp) == last;
+   }
+
+   template<class RandomIt>
+   inline bool is_heap(RandomIt first, RandomIt last)
+   {
+      return is_heap_until(first, last) == last;
+   }
+
    //
    // Set operations on sorted ranges
    //
@@ -654,6 +1051,451 @@ namespace ttl
       return ttl::copy(first2, last2, output);
    }
 
+   //
+   // The set operations keep the duplicates as the standard ones do: an
+   // element found m times in the first range and n times in the second is
+   // in the union max(m, n) times, in the intersection min(m, n) times and
+   // in the difference max(m - n, 0) times.
+   //
+   // When both ranges are arrays (pointers) and one is more than
+   // _gallop_ratio times the other, the intersection, the difference and
+   // includes walk the smaller one and search the larger one by galloping:
+   // doubling steps from the last position and then a binary search, for
+   // O(M log(N / M + 1)) comparisons instead of O(N + M). The union and the
+   // symmetric difference copy all of both ranges anyway and are merges.
+   //
+   enum { _gallop_ratio = 64 };
+
+   // The first position in [first, last) not less than the value, in
+   // O(log D) for a distance D from first
+   template<class RandomIt, class T, class Compare>
+   RandomIt _gallop_lower(RandomIt first, RandomIt last, const T &value, Compare comp)
+   {
+      const ttl::ptrdiff_t n = last - first;
+      if (!n || !comp(*first, value))
+         return first;
+      ttl::ptrdiff_t lo = 0, step = 1, hi = 1;
+      while (hi < n && comp(first[hi], value))
+      {
+         lo = hi;
+         step *= 2;
+         hi = lo + step;
+      }
+      return ttl::lower_bound(first + lo + 1, hi < n ? first + hi: last, value, comp);
+   }
+
+   template<class InputIt1, class InputIt2, class Compare>
+   bool _includes(InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, Compare comp,
+                  integral_constant<bool, false>)
+   {
+      for (; first2 != last2; ++first1)
+      {
+         if (first1 == last1 || comp(*first2, *first1))
+            return false;
+         if (!comp(*first1, *first2))
+            ++first2;
+      }
+      return true;
+   }
+
+   template<class InputIt1, class InputIt2, class Compare>
+   bool _includes(InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, Compare comp,
+                  integral_constant<bool, true>)
+   {
+      const ttl::ptrdiff_t n1 = last1 - first1, n2 = last2 - first2;
+      if (n2 > n1)
+         return false;
+      if (n1 / _gallop_ratio <= n2)
+         return _includes(first1, last1, first2, last2, comp, integral_constant<bool, false>());
+      for (; first2 != last2; ++first2, ++first1)
+      {
+         first1 = _gallop_lower(first1, last1, *first2, comp);
+         if (first1 == last1 || comp(*first2, *first1))
+            return false;
+      }
+      return true;
+   }
+
+   // Whether the sorted range 2 is a subsequence of the sorted range 1
+   template<class InputIt1, class InputIt2, class Compare>
+   inline bool includes(InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, Compare comp)
+   {
+      return _includes(first1, last1, first2, last2, comp,
+                       integral_constant<bool, is_pointer<InputIt1>::value && is_pointer<InputIt2>::value>());
+   }
+
+   template<class InputIt1, class InputIt2>
+   inline bool includes(InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2)
+   {
+      return ttl::includes(first1, last1, first2, last2, _less_op());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt set_union(InputIt1 first1, InputIt1 last1,
+                      InputIt2 first2, InputIt2 last2,
+                      OutputIt output, Compare comp)
+   {
+      for (; first1 != last1; ++output)
+      {
+         if (first2 == last2)
+            return ttl::copy(first1, last1, output);
+         if (comp(*first2, *first1))
+         {
+            *output = *first2;
+            ++first2;
+         }
+         else
+         {
+            *output = *first1;
+            if (!comp(*first1, *first2))
+               ++first2;
+            ++first1;
+         }
+      }
+      return ttl::copy(first2, last2, output);
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt>
+   inline OutputIt set_union(InputIt1 first1, InputIt1 last1,
+                             InputIt2 first2, InputIt2 last2,
+                             OutputIt output)
+   {
+      return ttl::set_union(first1, last1, first2, last2, output, _less_op());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt _set_intersection(InputIt1 first1, InputIt1 last1,
+                              InputIt2 first2, InputIt2 last2,
+                              OutputIt output, Compare comp, integral_constant<bool, false>)
+   {
+      while (first1 != last1 && first2 != last2)
+      {
+         if (comp(*first1, *first2))
+            ++first1;
+         else
+         {
+            if (!comp(*first2, *first1))
+            {
+               *output = *first1;
+               ++output;
+               ++first1;
+            }
+            ++first2;
+         }
+      }
+      return output;
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt _set_intersection(InputIt1 first1, InputIt1 last1,
+                              InputIt2 first2, InputIt2 last2,
+                              OutputIt output, Compare comp, integral_constant<bool, true>)
+   {
+      const ttl::ptrdiff_t n1 = last1 - first1, n2 = last2 - first2;
+      if (n2 / _gallop_ratio > n1)
+      {
+         for (; first1 != last1 && first2 != last2; ++first1)
+         {
+            first2 = _gallop_lower(first2, last2, *first1, comp);
+            if (first2 != last2 && !comp(*first1, *first2))
+            {
+               *output = *first1;
+               ++output;
+               ++first2;
+            }
+         }
+         return output;
+      }
+      if (n1 / _gallop_ratio > n2)
+      {
+         for (; first2 != last2 && first1 != last1; ++first2)
+         {
+            first1 = _gallop_lower(first1, last1, *first2, comp);
+            if (first1 != last1 && !comp(*first2, *first1))
+            {
+               *output = *first1;
+               ++output;
+               ++first1;
+            }
+         }
+         return output;
+      }
+      return _set_intersection(first1, last1, first2, last2, output, comp, integral_constant<bool, false>());
+   }
+
+   // The output may be the start of range 1, it never overtakes its input.
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   inline OutputIt set_intersection(InputIt1 first1, InputIt1 last1,
+                                    InputIt2 first2, InputIt2 last2,
+                                    OutputIt output, Compare comp)
+   {
+      return _set_intersection(first1, last1, first2, last2, output, comp,
+                               integral_constant<bool, is_pointer<InputIt1>::value &&
+                                                       is_pointer<InputIt2>::value>());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt>
+   inline OutputIt set_intersection(InputIt1 first1, InputIt1 last1,
+                                    InputIt2 first2, InputIt2 last2,
+                                    OutputIt output)
+   {
+      return ttl::set_intersection(first1, last1, first2, last2, output, _less_op());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt _set_difference(InputIt1 first1, InputIt1 last1,
+                            InputIt2 first2, InputIt2 last2,
+                            OutputIt output, Compare comp, integral_constant<bool, false>)
+   {
+      while (first1 != last1)
+      {
+         if (first2 == last2)
+            return ttl::copy(first1, last1, output);
+         if (comp(*first1, *first2))
+         {
+            *output = *first1;
+            ++output;
+            ++first1;
+         }
+         else
+         {
+            if (!comp(*first2, *first1))
+               ++first1;
+            ++first2;
+         }
+      }
+      return output;
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt _set_difference(InputIt1 first1, InputIt1 last1,
+                            InputIt2 first2, InputIt2 last2,
+                            OutputIt output, Compare comp, integral_constant<bool, true>)
+   {
+      const ttl::ptrdiff_t n1 = last1 - first1, n2 = last2 - first2;
+      if (n2 / _gallop_ratio > n1)
+      {
+         for (; first1 != last1; ++first1)
+         {
+            first2 = _gallop_lower(first2, last2, *first1, comp);
+            if (first2 != last2 && !comp(*first1, *first2))
+               ++first2;
+            else
+            {
+               *output = *first1;
+               ++output;
+            }
+         }
+         return output;
+      }
+      if (n1 / _gallop_ratio > n2)
+      {
+         for (; first2 != last2; ++first2)
+         {
+            InputIt1 lower = _gallop_lower(first1, last1, *first2, comp);
+            output = ttl::copy(first1, lower, output);
+            first1 = lower;
+            if (first1 != last1 && !comp(*first2, *first1))
+               ++first1;
+         }
+         return ttl::copy(first1, last1, output);
+      }
+      return _set_difference(first1, last1, first2, last2, output, comp, integral_constant<bool, false>());
+   }
+
+   // The elements of range 1 not in range 2. The output may be the start of
+   // range 1, it never overtakes its input.
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   inline OutputIt set_difference(InputIt1 first1, InputIt1 last1,
+                                  InputIt2 first2, InputIt2 last2,
+                                  OutputIt output, Compare comp)
+   {
+      return _set_difference(first1, last1, first2, last2, output, comp,
+                             integral_constant<bool, is_pointer<InputIt1>::value &&
+                                                     is_pointer<InputIt2>::value>());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt>
+   inline OutputIt set_difference(InputIt1 first1, InputIt1 last1,
+                                  InputIt2 first2, InputIt2 last2,
+                                  OutputIt output)
+   {
+      return ttl::set_difference(first1, last1, first2, last2, output, _less_op());
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+   OutputIt set_symmetric_difference(InputIt1 first1, InputIt1 last1,
+                                     InputIt2 first2, InputIt2 last2,
+                                     OutputIt output, Compare comp)
+   {
+      while (first1 != last1)
+      {
+         if (first2 == last2)
+            return ttl::copy(first1, last1, output);
+         if (comp(*first1, *first2))
+         {
+            *output = *first1;
+            ++output;
+            ++first1;
+         }
+         else
+         {
+            if (comp(*first2, *first1))
+            {
+               *output = *first2;
+               ++output;
+            }
+            else
+               ++first1;
+            ++first2;
+         }
+      }
+      return ttl::copy(first2, last2, output);
+   }
+
+   template<class InputIt1, class InputIt2, class OutputIt>
+   inline OutputIt set_symmetric_difference(InputIt1 first1, InputIt1 last1,
+                                            InputIt2 first2, InputIt2 last2,
+                                            OutputIt output)
+   {
+      return ttl::set_symmetric_difference(first1, last1, first2, last2, output, _less_op());
+   }
+
+#if defined(__SSE2__) && defined(__GNUC__)
+   // Block intersection, after Schlegel, Willhalm and Lehner, "Fast
+   // Sorted-Set Intersection using SIMD Instructions", 2011: each block of 4
+   // of range 1 is compared with the 4 rotations of a block of range 2, and
+   // the block with the smaller last element is passed.
+   template<class T>
+   T *_set_intersection_unique(const T *first1, const T *last1, const T *first2, const T *last2,
+                               T *output, integral_constant<bool, true>)
+   {
+      // the blocks pass the larger array faster than a merge, they are
+      // still faster than galloping at twice its ratio
+      const ttl::ptrdiff_t n1 = last1 - first1, n2 = last2 - first2;
+      if (n1 / (2 * _gallop_ratio) > n2 || n2 / (2 * _gallop_ratio) > n1)
+         return ttl::set_intersection(first1, last1, first2, last2, output);
+      while (last1 - first1 >= 4 && last2 - first2 >= 4)
+      {
+         const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first1));
+         const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first2));
+         const __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(a, b),
+                         _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)))));
+         const T max1 = first1[3], max2 = first2[3];
+         for (unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(eq)); mask; mask &= mask - 1)
+            *output++ = first1[__builtin_ctz(mask)];
+         if (!(max2 < max1))
+            first1 += 4;
+         if (!(max1 < max2))
+            first2 += 4;
+      }
+      return ttl::set_intersection(first1, last1, first2, last2, output);
+   }
+#endif
+
+   template<class T, bool Block>
+   T *_set_intersection_unique(const T *first1, const T *last1, const T *first2, const T *last2,
+                               T *output, integral_constant<bool, Block>)
+   {
+      return ttl::set_intersection(first1, last1, first2, last2, output);
+   }
+
+   // The intersection of two strictly increasing arrays, compared with
+   // operator<. The 32 bit integers are intersected 4 by 4 with SSE2 where
+   // it is available, and galloped when one array is much smaller.
+   template<class T>
+   inline T *set_intersection_unique(const T *first1, const T *last1,
+                                     const T *first2, const T *last2, T *output)
+   {
+#if defined(__SSE2__) && defined(__GNUC__)
+      return _set_intersection_unique(first1, last1, first2, last2, output,
+                                      integral_constant<bool, is_integral<T>::value && sizeof(T) == 4>());
+#else
+      return _set_intersection_unique(first1, last1, first2, last2, output,
+                                      integral_constant<bool, false>());
+#endif
+   }
+
+   //
+   // The in-place set operations replace the sorted contents of a vector
+   // (a container with random access iterators, erase(first, last) and
+   // resize(n), such as vector and fixed_vector) with the result, without
+   // an output buffer.
+   //
+
+   // counts what a set operation writes
+   struct _count_output
+   {
+      ttl::size_t n;
+      _count_output(): n(0) {}
+      _count_output &operator*() { return *this; }
+      _count_output &operator++() { return *this; }
+      template<class T> _count_output &operator=(const T &) { ++n; return *this; }
+   };
+
+   template<class Vector, class InputIt, class Compare>
+   void inplace_set_intersection(Vector &v, InputIt first2, InputIt last2, Compare comp)
+   {
+      v.erase(ttl::set_intersection(v.begin(), v.end(), first2, last2, v.begin(), comp), v.end());
+   }
+
+   template<class Vector, class InputIt>
+   inline void inplace_set_intersection(Vector &v, InputIt first2, InputIt last2)
+   {
+      inplace_set_intersection(v, first2, last2, _less_op());
+   }
+
+   template<class Vector, class InputIt, class Compare>
+   void inplace_set_difference(Vector &v, InputIt first2, InputIt last2, Compare comp)
+   {
+      v.erase(ttl::set_difference(v.begin(), v.end(), first2, last2, v.begin(), comp), v.end());
+   }
+
+   template<class Vector, class InputIt>
+   inline void inplace_set_difference(Vector &v, InputIt first2, InputIt last2)
+   {
+      inplace_set_difference(v, first2, last2, _less_op());
+   }
+
+   // The elements of range 2 not in the vector are counted first, then the
+   // vector is grown by as many and merged from the back, where the output
+   // never overtakes the input.
+   template<class Vector, class BidirIt, class Compare>
+   void inplace_set_union(Vector &v, BidirIt first2, BidirIt last2, Compare comp)
+   {
+      const ttl::size_t n1 = v.size();
+      const ttl::size_t added = ttl::set_difference(first2, last2, v.begin(), v.end(), _count_output(), comp).n;
+      if (!added)
+         return;
+      v.resize(n1 + added);
+      typename Vector::iterator i1 = v.begin() + n1, o = v.end();
+      while (first2 != last2)
+      {
+         BidirIt j = last2;
+         --j;
+         if (i1 != v.begin() && !comp(i1[-1], *j))
+         {
+            if (!comp(*j, i1[-1]))
+               last2 = j;
+            *--o = *--i1;
+         }
+         else
+         {
+            *--o = *j;
+            last2 = j;
+         }
+      }
+   }
+
+   template<class Vector, class BidirIt>
+   inline void inplace_set_union(Vector &v, BidirIt first2, BidirIt last2)
+   {
+      inplace_set_union(v, first2, last2, _less_op());
+   }
+
    //
    // Minimum/maximum operations
    //
@@ -0,0 +1,232 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a bitset with atomic operations
+//
+// For allocating slots from a shared bitmap without a lock:
+//
+//    ttl::atomic_bitset<4096> used;
+//
+//    // in each thread
+//    ttl::size_t hint = used.hint(thread_index, thread_count);
+//    ttl::size_t slot = used.find_first_zero_and_set(hint);
+//    if (slot == used.size())
+//       ... // full
+//    ...
+//    used.reset(slot);
+//
+// Every operation on a bit is one atomic read-modify-write of its slot. The
+// scan for a zero bit starts at the caller's hint and wraps around; the
+// hints of different threads start in different cache lines and move on
+// past the slots they allocate, so the threads mostly modify different
+// lines. The slots are aligned to a cache line.
+//
+// The operations are sequentially consistent. count() and the other
+// whole-set reads are a snapshot of each slot, not of the set.
+//
+// This needs the __atomic builtins of GCC or clang.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_ATOMIC_BITSET_HPP_
+#define _TINY_TEMPLATE_LIBRARY_ATOMIC_BITSET_HPP_ 1
+
+#include "types.hpp"
+#include "memory_resource.hpp"
+#include "bitset.hpp"
+
+namespace ttl
+{
+   //
+   // The atomic operations on the slots, shared by atomic_bitset and
+   // dynamic_atomic_bitset
+   //
+   struct atomic_bitset_slots
+   {
+      typedef bitset_slots::slot_type slot_type;
+      static const ttl::size_t slot_bits = bitset_slots::slot_bits;
+      static const ttl::size_t line_bits = cache_line_size * CHAR_BIT;
+
+      static slot_type mask(ttl::size_t pos) { return (slot_type)1 << pos % slot_bits; }
+      static slot_type load(const slot_type *bits, ttl::size_t s)
+      {
+         return __atomic_load_n(bits + s, __ATOMIC_SEQ_CST);
+      }
+
+      static bool test(const slot_type *bits, ttl::size_t pos)
+      {
+         return load(bits, pos / slot_bits) & mask(pos);
+      }
+      // the previous value
+      static bool test_and_set(slot_type *bits, ttl::size_t pos)
+      {
+         return __atomic_fetch_or(bits + pos / slot_bits, mask(pos), __ATOMIC_SEQ_CST) & mask(pos);
+      }
+      static bool test_and_reset(slot_type *bits, ttl::size_t pos)
+      {
+         return __atomic_fetch_and(bits + pos / slot_bits, ~mask(pos), __ATOMIC_SEQ_CST) & mask(pos);
+      }
+
+      static ttl::size_t count(const slot_type *bits, ttl::size_t size)
+      {
+         ttl::size_t c = 0;
+         for (ttl::size_t s = 0; s < size / slot_bits; ++s)
+            c += bitset_slots::popcount(load(bits, s));
+         if (size % slot_bits)
+            c += bitset_slots::popcount(load(bits, size / slot_bits) & (mask(size) - 1));
+         return c;
+      }
+
+      // sets the first clear bit at or after hint, wrapping around, and
+      // moves hint past it; size if all are set
+      static ttl::size_t find_first_zero_and_set(slot_type *bits, ttl::size_t size, ttl::size_t &hint)
+      {
+         const ttl::size_t n = (size + slot_bits - 1) / slot_bits;
+         if (!n)
+            return size;
+         ttl::size_t s = hint < size ? hint / slot_bits: 0;
+         // the first slot is looked at twice: from the hint, then whole
+         slot_type from = hint < size ? (slot_type)-1 << hint % slot_bits: (slot_type)-1;
+         for (ttl::size_t i = 0; i <= n; ++i, from = (slot_type)-1)
+         {
+            const slot_type valid = s == n - 1 && size % slot_bits ? mask(size) - 1: (slot_type)-1;
+            slot_type w = load(bits, s);
+            for (slot_type zeros; (zeros = ~w & valid & from);)
+            {
+               const slot_type bit = zeros & -zeros;
+               w = __atomic_fetch_or(bits + s, bit, __ATOMIC_SEQ_CST);
+               if (!(w & bit))
+               {
+                  const ttl::size_t pos = s * slot_bits + bitset_slots::lowest(bit);
+                  hint = pos + 1 < size ? pos + 1: 0;
+                  return pos;
+               }
+            }
+            if (++s == n)
+               s = 0;
+         }
+         return size;
+      }
+
+      // the first bit of the part of the set for thread i of n, cache line
+      // aligned
+      static ttl::size_t hint(ttl::size_t size, ttl::size_t i, ttl::size_t n)
+      {
+         const ttl::size_t lines = (size + line_bits - 1) / line_bits;
+         return n ? (lines * (i % n) / n) * line_bits % (size ? size: 1): 0;
+      }
+   };
+
+   template<ttl::size_t N>
+   class atomic_bitset
+   {
+   public:
+      typedef atomic_bitset_slots::slot_type slot_type;
+      typedef ttl::size_t size_type;
+
+   private:
+      static const size_type slot_bits = atomic_bitset_slots::slot_bits;
+      slot_type bits_[(N + slot_bits - 1) / slot_bits] __attribute__((aligned(64)));
+
+      atomic_bitset(const atomic_bitset &);
+      atomic_bitset &operator=(const atomic_bitset &);
+
+   public:
+      atomic_bitset() { reset(); }
+
+      size_type size() const { return N; }
+      bool test(size_type pos) const { return atomic_bitset_slots::test(bits_, pos); }
+      bool operator[](size_type pos) const { return test(pos); }
+      // these return the previous value of the bit
+      bool test_and_set(size_type pos) { return atomic_bitset_slots::test_and_set(bits_, pos); }
+      bool test_and_reset(size_type pos) { return atomic_bitset_slots::test_and_reset(bits_, pos); }
+      void set(size_type pos) { test_and_set(pos); }
+      void reset(size_type pos) { test_and_reset(pos); }
+      // not atomic as a whole
+      void reset()
+      {
+         for (size_type s = 0; s < sizeof(bits_)/sizeof(*bits_); ++s)
+            __atomic_store_n(bits_ + s, 0, __ATOMIC_SEQ_CST);
+      }
+
+      size_type count() const { return atomic_bitset_slots::count(bits_, N); }
+
+      // a good starting hint for thread i of n
+      size_type hint(size_type i, size_type n) const { return atomic_bitset_slots::hint(N, i, n); }
+      // sets and returns the first clear bit from hint on, or size()
+      size_type find_first_zero_and_set(size_type &hint)
+      {
+         return atomic_bitset_slots::find_first_zero_and_set(bits_, N, hint);
+      }
+      size_type find_first_zero_and_set()
+      {
+         size_type hint = 0;
+         return find_first_zero_and_set(hint);
+      }
+   };
+
+   //
+   // The same sized at construction, the slots are taken from the memory
+   // resource and aligned to a cache line
+   //
+   template<typename Resource = new_delete_resource>
+   class dynamic_atomic_bitset: private Resource
+   {
+   public:
+      typedef atomic_bitset_slots::slot_type slot_type;
+      typedef ttl::size_t size_type;
+
+   private:
+      static const size_type slot_bits = atomic_bitset_slots::slot_bits;
+
+      void *memory_;
+      slot_type *bits_;
+      size_type size_;
+
+      size_type bytes() const { return (size_ + slot_bits - 1) / slot_bits * sizeof(slot_type) + cache_line_size; }
+      void allocate()
+      {
+         memory_ = Resource::allocate(bytes());
+         const ttl::size_t p = (ttl::size_t)memory_;
+         bits_ = reinterpret_cast<slot_type *>((p + cache_line_size - 1) & ~(cache_line_size - 1));
+         reset();
+      }
+
+      dynamic_atomic_bitset(const dynamic_atomic_bitset &);
+      dynamic_atomic_bitset &operator=(const dynamic_atomic_bitset &);
+
+   public:
+      explicit dynamic_atomic_bitset(size_type n): size_(n) { allocate(); }
+      dynamic_atomic_bitset(size_type n, const Resource &r): Resource(r), size_(n) { allocate(); }
+      ~dynamic_atomic_bitset() { Resource::deallocate(memory_, bytes()); }
+
+      const Resource &get_resource() const { return *this; }
+
+      size_type size() const { return size_; }
+      bool test(size_type pos) const { return atomic_bitset_slots::test(bits_, pos); }
+      bool operator[](size_type pos) const { return test(pos); }
+      bool test_and_set(size_type pos) { return atomic_bitset_slots::test_and_set(bits_, pos); }
+      bool test_and_reset(size_type pos) { return atomic_bitset_slots::test_and_reset(bits_, pos); }
+      void set(size_type pos) { test_and_set(pos); }
+      void reset(size_type pos) { test_and_reset(pos); }
+      void reset()
+      {
+         for (size_type s = 0; s < (size_ + slot_bits - 1) / slot_bits; ++s)
+            __atomic_store_n(bits_ + s, 0, __ATOMIC_SEQ_CST);
+      }
+
+      size_type count() const { return atomic_bitset_slots::count(bits_, size_); }
+
+      size_type hint(size_type i, size_type n) const { return atomic_bitset_slots::hint(size_, i, n); }
+      size_type find_first_zero_and_set(size_type &hint)
+      {
+         return atomic_bitset_slots::find_first_zero_and_set(bits_, size_, hint);
+      }
+      size_type find_first_zero_and_set()
+      {
+         size_type hint = 0;
+         return find_first_zero_and_set(hint);
+      }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_ATOMIC_BITSET_HPP_
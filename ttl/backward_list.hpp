@@ -9,15 +9,17 @@
 #ifndef _TINY_TEMPLATE_LIBRARY_BACKWARD_LIST_HPP_
 #define _TINY_TEMPLATE_LIBRARY_BACKWARD_LIST_HPP_ 1
 
+#include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 #include "slist_node.hpp"
 
 namespace ttl
 {
    template<typename T> void swap(T &, T &);
 
-   template<typename T>
-   class backward_list
+   template<typename T, typename Resource = new_delete_resource>
+   class backward_list: private Resource
    {
    public:
       typedef T value_type;
@@ -34,6 +36,13 @@ namespace ttl
          T value;
          node(const T &v): value(v) {}
       };
+
+      node *create_node(const T &v) { return ::new(Resource::allocate(sizeof(node))) node(v); }
+      void destroy_node(slist_node *n)
+      {
+         static_cast<node *>(n)->~node();
+         Resource::deallocate(n, sizeof(node));
+      }
       slist_node head_;
       slist_node *tail_;
 
@@ -52,8 +61,8 @@ namespace ttl
          ~iterator() {}
          iterator &operator++() { head_ = head_->next; return *this; }
          iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<backward_list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<backward_list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<backward_list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<backward_list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const iterator &other) const { return head_ == other.head_; }
          bool operator!=(const iterator &other) const { return head_ != other.head_; }
@@ -62,13 +71,13 @@ namespace ttl
 
       private:
          slist_node *head_;
-         friend class backward_list<T>;
+         friend class backward_list<T,Resource>;
          iterator(slist_node *head): head_(head) {}
       };
       class const_iterator
       {
       public:
-         typedef backward_list<T>::iterator iterator;
+         typedef backward_list<T,Resource>::iterator iterator;
          typedef T value_type;
          typedef const T *pointer;
          typedef const T &reference;
@@ -79,15 +88,15 @@ namespace ttl
          ~const_iterator() {}
          const_iterator &operator++() { head_ = head_->next; return *this; }
          const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<const backward_list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<const backward_list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<const backward_list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const backward_list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const const_iterator &other) const { return head_ == other.head_; }
          bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
 
       private:
-         friend class backward_list<T>;
-         friend class backward_list<T>::iterator;
+         friend class backward_list<T,Resource>;
+         friend class backward_list<T,Resource>::iterator;
          const slist_node *head_;
          const_iterator(const slist_node *head): head_(head) {}
       };
@@ -97,20 +106,29 @@ namespace ttl
          head_.next = 0;
          tail_ = &head_;
       }
-      backward_list(const backward_list &other)
+      explicit backward_list(const Resource &r):
+         Resource(r)
+      {
+         head_.next = 0;
+         tail_ = &head_;
+      }
+      backward_list(const backward_list &other):
+         Resource(other)
       {
          head_.next = 0;
          tail_ = &head_;
          insert_after(cbefore_begin(), other.cbegin(), other.cend());
       }
-      backward_list(size_type n, const T &value)
+      backward_list(size_type n, const T &value, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.next = 0;
          tail_ = &head_;
          insert_after(cbefore_begin(), n, value);
       }
       template<typename InputIterator>
-      backward_list(InputIterator first, InputIterator last)
+      backward_list(InputIterator first, InputIterator last, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.next = 0;
          tail_ = &head_;
@@ -161,18 +179,18 @@ namespace ttl
 
       void push_front(const T &value)
       {
-         slist_node *n = head_.insert_after(new node(value));
+         slist_node *n = head_.insert_after(create_node(value));
          if (tail_ == &head_)
             tail_ = n;
       }
       void push_back(const T &value)
       {
-         tail_ = tail_->insert_after(new node(value));
+         tail_ = tail_->insert_after(create_node(value));
       }
 
       void pop_front()
       {
-         delete static_cast<node *>(head_.unlink_next());
+         destroy_node(head_.unlink_next());
          if (empty())
             tail_ = &head_;
       }
@@ -195,7 +213,7 @@ namespace ttl
       iterator insert_after(const_iterator pos, const T &value)
       {
          slist_node *pn = const_cast<slist_node *>(pos.head_);
-         slist_node *n = pn->insert_after(new node(value));
+         slist_node *n = pn->insert_after(create_node(value));
          if (pn == tail_)
             tail_ = n;
          return iterator(n);
@@ -210,13 +228,14 @@ namespace ttl
          slist_node *p = pn->unlink_next();
          if (p == tail_)
             tail_ = pn;
-         delete static_cast<node *>(p);
+         destroy_node(p);
          return iterator(pn->next);
       }
       iterator erase_after(const_iterator pos, const_iterator last);
 
       void swap(backward_list &other)
       {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
          ttl::swap(head_.next, other.head_.next);
          ttl::swap(tail_, other.tail_);
       }
@@ -246,54 +265,56 @@ namespace ttl
 
 #endif
       void reverse();
+
+      const Resource &get_resource() const { return *this; }
    };
-   template<typename T>
-   void backward_list<T>::insert_after(const_iterator pos, size_type n, const T &value)
+   template<typename T, typename Resource>
+   void backward_list<T,Resource>::insert_after(const_iterator pos, size_type n, const T &value)
    {
       slist_node *pn = const_cast<slist_node *>(pos.head_);
       slist_node *p = pn;
       while (n--)
-         p = p->insert_after(new node(value));
+         p = p->insert_after(create_node(value));
       if (pn == tail_)
          tail_ = p;
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename InputIterator>
-   void backward_list<T>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
+   void backward_list<T,Resource>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
    {
       slist_node *pn = const_cast<slist_node *>(pos.head_);
       slist_node *p = pn;
       for ( ; first != last; ++first)
-         p = p->insert_after(new node(*first));
+         p = p->insert_after(create_node(*first));
       if (pn == tail_)
-         tail_ = pn;
+         tail_ = p;
    }
-   template<typename T>
-   void backward_list<T>::clear()
+   template<typename T, typename Resource>
+   void backward_list<T,Resource>::clear()
    {
       tail_ = &head_;
       while (head_.next)
-         delete static_cast<node *>(head_.unlink_next());
+         destroy_node(head_.unlink_next());
    }
-   template<typename T>
-   typename backward_list<T>::iterator backward_list<T>::erase_after(const_iterator pos, const_iterator last)
+   template<typename T, typename Resource>
+   typename backward_list<T,Resource>::iterator backward_list<T,Resource>::erase_after(const_iterator pos, const_iterator last)
    {
       slist_node *p = const_cast<slist_node *>(pos.head_);
       while (p->next != last.head_)
-         delete static_cast<node *>(p->unlink_next());
+         destroy_node(p->unlink_next());
       if (last == cend())
          tail_ = p;
       return iterator(p->next);
    }
-   template<typename T>
-   void backward_list<T>::reverse()
+   template<typename T, typename Resource>
+   void backward_list<T,Resource>::reverse()
    {
       tail_ = head_.next;
       head_.reverse();
    }
 #if TODO
-   template<typename T>
-   void backward_list<T>::splice_after(const_iterator pos, backward_list &, const_iterator first, const_iterator last)
+   template<typename T, typename Resource>
+   void backward_list<T,Resource>::splice_after(const_iterator pos, backward_list &, const_iterator first, const_iterator last)
    {
       slist_node *f = const_cast<slist_node *>(first.head_);
 
@@ -306,13 +327,13 @@ namespace ttl
    template<class InputIt1, class InputIt2>
    bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
 
-   template <typename T>
-   bool operator==(const backward_list<T> &a, const backward_list<T> &b)
+   template <typename T, typename Resource>
+   bool operator==(const backward_list<T,Resource> &a, const backward_list<T,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template <typename T>
-   bool operator!=(const backward_list<T> &a, const backward_list<T> &b)
+   template <typename T, typename Resource>
+   bool operator!=(const backward_list<T,Resource> &a, const backward_list<T,Resource> &b)
    {
       return !(a == b);
    }
@@ -2,20 +2,282 @@
 //
 // Tiny Template Library: the implementation of STL bitset
 //
+// Besides the STL interface, the set bits can be scanned a slot at a time:
+//
+//    for (ttl::size_t i = bs.find_first(); i < bs.size(); i = bs.find_next(i))
+//       ...
+//    bs.for_each_set_bit(visit); // calls visit(i) for each set bit i
+//
+// The text form is parsed and written 16 characters at a time with SSE2,
+// where it is available.
+//
 // This code is Public Domain
 //
 #ifndef _TINY_TEMPLATE_LIBRARY_BITSET_HPP_
 #define _TINY_TEMPLATE_LIBRARY_BITSET_HPP_ 1
 
 #include <limits.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
 #include "types.hpp"
 
 namespace ttl
 {
+   //
+   // The operations on the slots (words) of the bits, shared with
+   // dynamic_bitset. They use the population count and count trailing zeros
+   // instructions where the compiler has them, and combine the slots two at
+   // a time with SSE2 where it is available.
+   //
+   struct bitset_slots
+   {
+      typedef unsigned long slot_type;
+      static const ttl::size_t slot_bits = sizeof(slot_type) * CHAR_BIT;
+
+      static unsigned popcount(slot_type b)
+      {
+#ifdef __GNUC__
+         return __builtin_popcountl(b);
+#else
+         unsigned c = 0;
+         for (; b; b &= b - 1)
+            ++c;
+         return c;
+#endif
+      }
+      // the index of the lowest set bit, b must not be 0
+      static unsigned lowest(slot_type b)
+      {
+#ifdef __GNUC__
+         return __builtin_ctzl(b);
+#else
+         unsigned c = 0;
+         for (; !(b & 1); b >>= 1)
+            ++c;
+         return c;
+#endif
+      }
+
+      // the set bits of n slots, the last one masked with last
+      static ttl::size_t count(const slot_type *bits, ttl::size_t n, slot_type last)
+      {
+         if (!n)
+            return 0;
+         ttl::size_t c = 0;
+         for (ttl::size_t i = 0; i < n - 1; ++i)
+            c += popcount(bits[i]);
+         return c + popcount(bits[n - 1] & last);
+      }
+
+      // the first set bit at or after pos, or size if none
+      static ttl::size_t find_from(const slot_type *bits, ttl::size_t size, ttl::size_t pos)
+      {
+         if (pos >= size)
+            return size;
+         const ttl::size_t n = (size + slot_bits - 1) / slot_bits;
+         ttl::size_t s = pos / slot_bits;
+         slot_type b = bits[s] & ((slot_type)-1 << pos % slot_bits);
+         while (!b)
+         {
+            if (++s == n)
+               return size;
+            b = bits[s];
+         }
+         pos = s * slot_bits + lowest(b);
+         return pos < size ? pos: size;
+      }
+
+      // the combining operations, a = a op b
+      struct and_op
+      {
+         slot_type operator()(slot_type a, slot_type b) const { return a & b; }
+#if defined(__SSE2__) && defined(__GNUC__)
+         __m128i operator()(__m128i a, __m128i b) const { return _mm_and_si128(a, b); }
+#endif
+      };
+      struct or_op
+      {
+         slot_type operator()(slot_type a, slot_type b) const { return a | b; }
+#if defined(__SSE2__) && defined(__GNUC__)
+         __m128i operator()(__m128i a, __m128i b) const { return _mm_or_si128(a, b); }
+#endif
+      };
+      struct xor_op
+      {
+         slot_type operator()(slot_type a, slot_type b) const { return a ^ b; }
+#if defined(__SSE2__) && defined(__GNUC__)
+         __m128i operator()(__m128i a, __m128i b) const { return _mm_xor_si128(a, b); }
+#endif
+      };
+      struct and_not_op
+      {
+         slot_type operator()(slot_type a, slot_type b) const { return a & ~b; }
+#if defined(__SSE2__) && defined(__GNUC__)
+         __m128i operator()(__m128i a, __m128i b) const { return _mm_andnot_si128(b, a); }
+#endif
+      };
+
+      template<typename Op>
+      static void combine(slot_type *a, const slot_type *b, ttl::size_t n, Op op)
+      {
+         ttl::size_t i = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+         const ttl::size_t per = sizeof(__m128i) / sizeof(slot_type);
+         for (; i + per <= n; i += per)
+         {
+            __m128i *pa = reinterpret_cast<__m128i *>(a + i);
+            const __m128i va = _mm_loadu_si128(pa);
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            _mm_storeu_si128(pa, op(va, vb));
+         }
+#endif
+         for (; i < n; ++i)
+            a[i] = op(a[i], b[i]);
+      }
+
+      // operator<< and operator>> of n slots: whole slots are moved and
+      // each is combined with its neighbour in one funnel shift, the
+      // vacated bits are 0. The unused bits of the last slot are shifted
+      // down as well, so they must be 0 for shift_right()
+      static void shift_left(slot_type *bits, ttl::size_t n, ttl::size_t pos)
+      {
+         const ttl::size_t ws = pos / slot_bits, bs = pos % slot_bits;
+         ttl::size_t i;
+         if (ws >= n)
+            zero(bits, 0, n);
+         else if (!bs)
+         {
+            for (i = n; i-- > ws;)
+               bits[i] = bits[i - ws];
+            zero(bits, 0, ws);
+         }
+         else
+         {
+            for (i = n - 1; i > ws; --i)
+               bits[i] = bits[i - ws] << bs | bits[i - ws - 1] >> (slot_bits - bs);
+            bits[ws] = bits[0] << bs;
+            zero(bits, 0, ws);
+         }
+      }
+      static void shift_right(slot_type *bits, ttl::size_t n, ttl::size_t pos)
+      {
+         const ttl::size_t ws = pos / slot_bits, bs = pos % slot_bits;
+         ttl::size_t i;
+         if (ws >= n)
+            zero(bits, 0, n);
+         else if (!bs)
+         {
+            for (i = 0; i + ws < n; ++i)
+               bits[i] = bits[i + ws];
+            zero(bits, n - ws, n);
+         }
+         else
+         {
+            for (i = 0; i + ws + 1 < n; ++i)
+               bits[i] = bits[i + ws] >> bs | bits[i + ws + 1] << (slot_bits - bs);
+            bits[i] = bits[n - 1] >> bs;
+            zero(bits, n - ws, n);
+         }
+      }
+      static void zero(slot_type *bits, ttl::size_t from, ttl::size_t to)
+      {
+         for (; from < to; ++from)
+            bits[from] = 0;
+      }
+
+      // the number of the first n, at most max, characters at s that are
+      // zero or one; n is (ttl::size_t)-1 for a NUL terminated string, which
+      // is then read a character at a time so as not to read past its end
+      static ttl::size_t span(const char *s, ttl::size_t n, ttl::size_t max, char zero, char one)
+      {
+         ttl::size_t i = 0;
+         const bool counted = n != (ttl::size_t)-1;
+         if (n > max)
+            n = max;
+#if defined(__SSE2__) && defined(__GNUC__)
+         const __m128i zeros = _mm_set1_epi8(zero), ones = _mm_set1_epi8(one);
+         for (; counted && i + 16 <= n; i += 16)
+         {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            const unsigned m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, zeros), _mm_cmpeq_epi8(v, ones)));
+            if (m != 0xffff)
+               return i + __builtin_ctz(~m);
+         }
+#endif
+         for (; i < n; ++i)
+            if (!(s[i] == zero || s[i] == one))
+               break;
+         return i;
+      }
+
+      // sets the bits of the len characters at s, the first is the highest
+      // bit, to the characters equal to one; the bits must be 0
+      static void parse(slot_type *bits, const char *s, ttl::size_t len, char one)
+      {
+         ttl::size_t j = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+         // 16 characters to 16 bits: reverse them, compare, take the mask
+         const __m128i ones = _mm_set1_epi8(one);
+         for (; j + 16 <= len; j += 16)
+         {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + len - j - 16));
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            const slot_type m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones));
+            bits[j / slot_bits] |= m << j % slot_bits;
+         }
+#endif
+         for (; j < len; ++j)
+            if (s[len - 1 - j] == one)
+               bits[j / slot_bits] |= (slot_type)1 << j % slot_bits;
+      }
+
+      // writes the size characters of the bits, the highest first
+      static void format(const slot_type *bits, ttl::size_t size, char *out, char zero, char one)
+      {
+         ttl::size_t j = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+         // 16 bits to 16 characters: spread the high byte over the first 8
+         // characters and the low one over the last 8, test a bit in each
+         const __m128i select = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+         const __m128i zeros = _mm_set1_epi8(zero);
+         const __m128i diff = _mm_set1_epi8(zero ^ one);
+         for (; j + 16 <= size; j += 16)
+         {
+            const unsigned b = (unsigned)(bits[j / slot_bits] >> j % slot_bits);
+            const __m128i v = _mm_unpacklo_epi64(_mm_set1_epi8((char)(b >> 8)), _mm_set1_epi8((char)b));
+            const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(v, select), select);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + size - j - 16),
+                             _mm_xor_si128(zeros, _mm_and_si128(set, diff)));
+         }
+#endif
+         for (; j < size; ++j)
+            out[size - 1 - j] = bits[j / slot_bits] >> j % slot_bits & 1 ? one: zero;
+      }
+
+      template<typename Visitor>
+      static Visitor for_each(const slot_type *bits, ttl::size_t size, Visitor visit)
+      {
+         const ttl::size_t n = (size + slot_bits - 1) / slot_bits;
+         for (ttl::size_t s = 0; s < n; ++s)
+         {
+            slot_type b = bits[s];
+            if (s == n - 1 && size % slot_bits)
+               b &= ((slot_type)1 << size % slot_bits) - 1;
+            for (; b; b &= b - 1)
+               visit(s * slot_bits + lowest(b));
+         }
+         return visit;
+      }
+   };
+
    template<ttl::size_t N> class bitset
    {
    private:
-      typedef unsigned long slot_type;
+      typedef bitset_slots::slot_type slot_type;
       slot_type *bits_slot(ttl::size_t pos) { return bits_ + pos / (sizeof(slot_type) * CHAR_BIT); }
       const slot_type *bits_slot(ttl::size_t pos) const { return bits_ + pos / (sizeof(slot_type) * CHAR_BIT); }
       static slot_type bits_bit(ttl::size_t pos) { return pos % (sizeof(slot_type) * CHAR_BIT); }
@@ -96,6 +358,18 @@ namespace ttl
       bool any() const;
       bool none() const;
       ttl::size_t count() const; // count set bits
+      // the first set bit, or size() if none
+      ttl::size_t find_first() const { return bitset_slots::find_from(bits_, N, 0); }
+      // the first set bit after pos, or size() if none
+      ttl::size_t find_next(ttl::size_t pos) const
+      {
+         return pos + 1 < N ? bitset_slots::find_from(bits_, N, pos + 1): N;
+      }
+      // calls visit(pos) for each set bit, in order, and returns visit
+      template<typename Visitor> Visitor for_each_set_bit(Visitor visit) const
+      {
+         return bitset_slots::for_each(bits_, N, visit);
+      }
       ttl::size_t size() const { return N; }
       ttl::size_t capacity() const { return sizeof(bits_) * CHAR_BIT; }
 
@@ -108,6 +382,9 @@ namespace ttl
       bitset<N> &operator<<=(ttl::size_t pos);
       bitset<N> operator>>(ttl::size_t pos) const;
       bitset<N> &operator>>=(ttl::size_t pos);
+      // the bits shifted out at one end come back in at the other
+      bitset<N> &rotate_left(ttl::size_t pos);
+      bitset<N> &rotate_right(ttl::size_t pos);
 
       bitset<N> &set()
       {
@@ -151,6 +428,16 @@ namespace ttl
          return *this;
       }
 
+      // writes the size() characters of the bits, the highest first and with
+      // no terminating NUL; returns the end, or 0 if they do not fit
+      char *to_chars(char *first, char *last, char zero = '0', char one = '1') const;
+
+      // the bits as 64-bit words, bit i in word i / 64, for storing
+      static ttl::size_t word_count() { return (N + 63) / 64; }
+      void to_words(unsigned long long *words) const;
+      // the other bits are cleared
+      bitset<N> &from_words(const unsigned long long *words, ttl::size_t n);
+
       unsigned long to_ulong() const { return (N < sizeof(*bits_) * CHAR_BIT ? last_bits(): (slot_type)-1) & *bits_; }
       unsigned long long to_ullong() const
       {
@@ -196,19 +483,45 @@ namespace ttl
    template<ttl::size_t N>
    bitset<N>::bitset(const char *bits, ttl::size_t n, char zero, char one)
    {
-      ttl::size_t i;
-      for (i = 0; i < n; ++i)
-         if (!(bits[i] == zero || bits[i] == one))
-            break;
-      for (ttl::size_t s = i / (sizeof(slot_type) * CHAR_BIT); s < sizeof(bits_)/sizeof(*bits_); ++s)
-         bits_[s] = 0;
-      for (; i--; ++bits)
-         if (*bits == zero)
-            reset(i);
-         else if (*bits == one)
-            set(i);
-         else
-            break;
+      // as many characters as there are bits, the first one is the highest
+      const ttl::size_t i = bitset_slots::span(bits, n, N, zero, one);
+      reset();
+      bitset_slots::parse(bits_, bits, i, one);
+   }
+   template<ttl::size_t N>
+   char *bitset<N>::to_chars(char *first, char *last, char zero, char one) const
+   {
+      if ((ttl::size_t)(last - first) < N)
+         return 0;
+      bitset_slots::format(bits_, N, first, zero, one);
+      return first + N;
+   }
+   template<ttl::size_t N>
+   void bitset<N>::to_words(unsigned long long *words) const
+   {
+      const ttl::size_t per = 64 / bitset_slots::slot_bits;
+      for (ttl::size_t w = 0; w < word_count(); ++w)
+      {
+         unsigned long long x = 0;
+         for (ttl::size_t k = 0; k < per && w * per + k <= last_slot_index(); ++k)
+         {
+            slot_type b = bits_[w * per + k];
+            if (w * per + k == last_slot_index())
+               b &= last_bits();
+            x |= (unsigned long long)b << (k * bitset_slots::slot_bits % 64);
+         }
+         words[w] = x;
+      }
+   }
+   template<ttl::size_t N>
+   bitset<N> &bitset<N>::from_words(const unsigned long long *words, ttl::size_t n)
+   {
+      const ttl::size_t per = 64 / bitset_slots::slot_bits;
+      reset();
+      for (ttl::size_t w = 0; w < n && w < word_count(); ++w)
+         for (ttl::size_t k = 0; k < per && w * per + k <= last_slot_index(); ++k)
+            bits_[w * per + k] = (slot_type)(words[w] >> (k * bitset_slots::slot_bits % 64));
+      return *this;
    }
    template<ttl::size_t N>
    inline bool bitset<N>::operator==(const bitset &other) const
@@ -248,25 +561,9 @@ namespace ttl
       return !(bits_[i] & last_bits());
    }
    template<ttl::size_t N>
-   ttl::size_t bitset<N>::count() const
+   inline ttl::size_t bitset<N>::count() const
    {
-      ttl::size_t c = 0;
-      for (unsigned i = 0; i < sizeof(bits_)/sizeof(*bits_); ++i)
-      {
-         slot_type b = bits_[i];
-         if (i == last_slot_index())
-            b &= last_bits();
-#ifdef __GNUC__
-         c += __builtin_popcountl(b);
-#else
-         while (b)
-         {
-            ++c;
-            b &= b - 1;
-         }
-#endif
-      }
-      return c;
+      return bitset_slots::count(bits_, sizeof(bits_)/sizeof(*bits_), last_bits());
    }
    template<ttl::size_t N>
    inline bitset<N> &bitset<N>::operator=(const bitset &other)
@@ -291,22 +588,19 @@ namespace ttl
    template<const ttl::size_t N>
    bitset<N> &bitset<N>::operator&=(const bitset<N> &other)
    {
-      for (unsigned i = 0; i < sizeof(bits_)/sizeof(*bits_); ++i)
-         bits_[i] &= other.bits_[i];
+      bitset_slots::combine(bits_, other.bits_, sizeof(bits_)/sizeof(*bits_), bitset_slots::and_op());
       return *this;
    }
    template<const ttl::size_t N>
    bitset<N> &bitset<N>::operator|=(const bitset<N> &other)
    {
-      for (unsigned i = 0; i < sizeof(bits_)/sizeof(*bits_); ++i)
-         bits_[i] |= other.bits_[i];
+      bitset_slots::combine(bits_, other.bits_, sizeof(bits_)/sizeof(*bits_), bitset_slots::or_op());
       return *this;
    }
    template<const ttl::size_t N>
    bitset<N> &bitset<N>::operator^=(const bitset<N> &other)
    {
-      for (unsigned i = 0; i < sizeof(bits_)/sizeof(*bits_); ++i)
-         bits_[i] ^= other.bits_[i];
+      bitset_slots::combine(bits_, other.bits_, sizeof(bits_)/sizeof(*bits_), bitset_slots::xor_op());
       return *this;
    }
    template<const ttl::size_t N>
@@ -319,37 +613,54 @@ namespace ttl
    }
 
    template<const ttl::size_t N>
-   bitset<N> bitset<N>::operator<<(ttl::size_t pos) const
+   inline bitset<N> bitset<N>::operator<<(ttl::size_t pos) const
    {
-      bitset<N> other;
-      for (unsigned i = 0; pos < N; ++i, ++pos)
-         if (test(i))
-            other.set(pos);
-      return other;
+      bitset<N> other(*this);
+      return other <<= pos;
    }
 
    template<const ttl::size_t N>
    bitset<N> &bitset<N>::operator<<=(ttl::size_t pos)
    {
-      bitset<N> other = *this << pos;
-      return *this = other;
+      bitset_slots::shift_left(bits_, sizeof(bits_)/sizeof(*bits_), pos);
+      return *this;
    }
 
    template<const ttl::size_t N>
-   bitset<N> bitset<N>::operator>>(ttl::size_t pos) const
+   inline bitset<N> bitset<N>::operator>>(ttl::size_t pos) const
    {
-      bitset<N> other;
-      for (unsigned i = 0; pos < N; ++i, ++pos)
-         if (test(pos))
-            other.set(i);
-      return other;
+      bitset<N> other(*this);
+      return other >>= pos;
    }
 
    template<const ttl::size_t N>
    bitset<N> &bitset<N>::operator>>=(ttl::size_t pos)
    {
-      bitset<N> other = *this >> pos;
-      return *this = other;
+      // the unused bits must not be shifted in
+      bits_[last_slot_index()] &= last_bits();
+      bitset_slots::shift_right(bits_, sizeof(bits_)/sizeof(*bits_), pos);
+      return *this;
+   }
+
+   template<const ttl::size_t N>
+   bitset<N> &bitset<N>::rotate_left(ttl::size_t pos)
+   {
+      pos %= N;
+      if (pos)
+      {
+         bitset<N> low(*this);
+         low >>= N - pos;
+         *this <<= pos;
+         *this |= low;
+      }
+      return *this;
+   }
+
+   template<const ttl::size_t N>
+   inline bitset<N> &bitset<N>::rotate_right(ttl::size_t pos)
+   {
+      pos %= N;
+      return pos ? rotate_left(N - pos): *this;
    }
 
    template<const ttl::size_t N>
@@ -383,6 +694,8 @@ namespace ttl
    template<> inline bool bitset<0>::any() const { return false; }
    template<> inline bool bitset<0>::none() const { return true; }
    template<> inline ttl::size_t bitset<0>::count() const { return 0; }
+   template<> inline ttl::size_t bitset<0>::find_first() const { return 0; }
+   template<> inline ttl::size_t bitset<0>::find_next(ttl::size_t) const { return 0; }
    template<> inline unsigned long long bitset<0>::to_ullong() const { return 0; }
    template<> inline unsigned long bitset<0>::to_ulong() const { return 0; }
    template<> inline bitset<0> &bitset<0>::operator&=(const bitset<0> &) { return *this; }
@@ -391,6 +704,12 @@ namespace ttl
    template<> inline bitset<0> bitset<0>::operator~() const { return bitset<0>(); }
    template<> inline bitset<0> bitset<0>::operator<<(ttl::size_t) const { return bitset<0>(); }
    template<> inline bitset<0> bitset<0>::operator>>(ttl::size_t) const { return bitset<0>(); }
+   template<> inline bitset<0> &bitset<0>::operator<<=(ttl::size_t) { return *this; }
+   template<> inline bitset<0> &bitset<0>::operator>>=(ttl::size_t) { return *this; }
+   template<> inline bitset<0> &bitset<0>::rotate_left(ttl::size_t) { return *this; }
+   template<> inline bitset<0> &bitset<0>::rotate_right(ttl::size_t) { return *this; }
+   template<> inline void bitset<0>::to_words(unsigned long long *) const {}
+   template<> inline bitset<0> &bitset<0>::from_words(const unsigned long long *, ttl::size_t) { return *this; }
 
    template<const ttl::size_t N> inline bool operator==(const bitset<0> &, const bitset<N> &b) { return b.none(); }
    template<const ttl::size_t N> inline bool operator==(const bitset<N> &a, const bitset<0> &) { return a.none(); }
@@ -399,4 +718,4 @@ namespace ttl
    template<> inline bool bitset<0>::operator==(const bitset<0> &) const { return true; }
 }
 
-#endif // _TINY_TEMPLATE_LIBRARY_HPP_
+#endif // _TINY_TEMPLATE_LIBRARY_BITSET_HPP_
@@ -0,0 +1,857 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a B+tree, the implementation of btree_map and
+// btree_set
+//
+// The values are kept in leaves of up to btree_node_size bytes, linked to
+// each other in order, the inner nodes hold only the separating keys and
+// the child pointers. A lookup touches one node per level, and there are
+// few levels: with int keys, 4 levels are enough for millions of values,
+// where the red-black tree of map has 20 and more.
+//
+// The keys of a node are contiguous and searched in one pass; for int and
+// unsigned keys ordered by less the keys are compared 4 at a time with
+// SSE2.
+//
+// The nodes do not point to their parents: the modifications remember the
+// path from the root. The iterators are a leaf and an index in it, and any
+// insertion or erasure invalidates them.
+//
+// assign_sorted() builds the tree bottom up from sorted values in O(N),
+// with full leaves.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_BTREE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_BTREE_HPP_ 1
+
+#include <new>
+#include <limits.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+#include "types.hpp"
+#include "type_traits.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "memory_resource.hpp"
+#include "vector.hpp"
+
+namespace ttl
+{
+   // the target size of a node, 4 cache lines
+   static const ttl::size_t btree_node_size = 256;
+
+   //
+   // The search in the sorted keys of a node: lower() is the index of the
+   // first key not less than x, upper() of the first key greater than x;
+   // x is a K, or any type a transparent Compare takes
+   //
+   template<typename K, class Compare>
+   struct btree_search
+   {
+      template<class X>
+      static unsigned lower(const K *keys, unsigned n, const X &x)
+      {
+         Compare comp;
+         unsigned lo = 0, hi = n;
+         while (lo < hi)
+         {
+            const unsigned m = lo + (hi - lo) / 2;
+            if (comp(keys[m], x))
+               lo = m + 1;
+            else
+               hi = m;
+         }
+         return lo;
+      }
+      template<class X>
+      static unsigned upper(const K *keys, unsigned n, const X &x)
+      {
+         Compare comp;
+         unsigned lo = 0, hi = n;
+         while (lo < hi)
+         {
+            const unsigned m = lo + (hi - lo) / 2;
+            if (comp(x, keys[m]))
+               hi = m;
+            else
+               lo = m + 1;
+         }
+         return lo;
+      }
+   };
+
+#if defined(__SSE2__) && defined(__GNUC__)
+   //
+   // Counts the keys below (or above) x, 4 at a time; the keys are biased
+   // so that the signed compare orders them, INT_MIN for unsigned
+   //
+   struct btree_search_sse2
+   {
+      static unsigned sum(__m128i c)
+      {
+         c = _mm_add_epi32(c, _mm_shuffle_epi32(c, 0x4e));
+         c = _mm_add_epi32(c, _mm_shuffle_epi32(c, 0xb1));
+         return _mm_cvtsi128_si32(c);
+      }
+      static unsigned count_less(const int *keys, unsigned n, int x, int bias)
+      {
+         const __m128i b = _mm_set1_epi32(bias), v = _mm_set1_epi32(x ^ bias);
+         __m128i c = _mm_setzero_si128();
+         unsigned i = 0;
+         for (; i + 4 <= n; i += 4)
+         {
+            const __m128i k = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), b);
+            c = _mm_sub_epi32(c, _mm_cmplt_epi32(k, v));
+         }
+         unsigned r = sum(c);
+         for (; i < n; ++i)
+            r += (keys[i] ^ bias) < (x ^ bias);
+         return r;
+      }
+      static unsigned count_greater(const int *keys, unsigned n, int x, int bias)
+      {
+         const __m128i b = _mm_set1_epi32(bias), v = _mm_set1_epi32(x ^ bias);
+         __m128i c = _mm_setzero_si128();
+         unsigned i = 0;
+         for (; i + 4 <= n; i += 4)
+         {
+            const __m128i k = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), b);
+            c = _mm_sub_epi32(c, _mm_cmpgt_epi32(k, v));
+         }
+         unsigned r = sum(c);
+         for (; i < n; ++i)
+            r += (keys[i] ^ bias) > (x ^ bias);
+         return r;
+      }
+   };
+
+   template<>
+   struct btree_search<int, less<int> >
+   {
+      static unsigned lower(const int *keys, unsigned n, int x)
+      {
+         return btree_search_sse2::count_less(keys, n, x, 0);
+      }
+      static unsigned upper(const int *keys, unsigned n, int x)
+      {
+         return n - btree_search_sse2::count_greater(keys, n, x, 0);
+      }
+   };
+
+   template<>
+   struct btree_search<unsigned, less<unsigned> >
+   {
+      static unsigned lower(const unsigned *keys, unsigned n, unsigned x)
+      {
+         return btree_search_sse2::count_less((const int *)keys, n, (int)x, INT_MIN);
+      }
+      static unsigned upper(const unsigned *keys, unsigned n, unsigned x)
+      {
+         return n - btree_search_sse2::count_greater((const int *)keys, n, (int)x, INT_MIN);
+      }
+   };
+#endif
+
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   class btree: private Resource
+   {
+   public:
+      typedef ttl::size_t size_type;
+
+      struct node
+      {
+         unsigned short count;
+         unsigned short leaf;
+      };
+      struct leaf_node: node
+      {
+         leaf_node *prev, *next;
+      };
+
+   private:
+      static const ttl::size_t header_size = (sizeof(leaf_node) + max_align - 1) & ~(max_align - 1);
+
+   public:
+      enum
+      {
+         // one more than the maximum fits, a node is split after it overflows
+         leaf_fit = (btree_node_size - header_size) / sizeof(V),
+         leaf_max = leaf_fit > 5 ? leaf_fit - 1: 4,
+         leaf_min = leaf_max / 2,
+         inner_fit = (btree_node_size - sizeof(void *) - max_align) / (sizeof(K) + sizeof(void *)),
+         inner_max = inner_fit > 5 ? inner_fit - 1: 4,
+         inner_min = inner_max / 2
+      };
+
+      struct inner_node: node
+      {
+         node *children[inner_max + 2];
+      };
+
+   private:
+      static const ttl::size_t keys_offset = (sizeof(inner_node) + max_align - 1) & ~(max_align - 1);
+
+      // the path from the root to a leaf, the inner nodes and the index of
+      // the child taken in each
+      struct path
+      {
+         inner_node *nodes[64];
+         unsigned index[64];
+      };
+
+      node *root_;
+      leaf_node *first_, *last_;
+      size_type size_;
+      unsigned height_; // the inner levels
+
+      static V *values(leaf_node *l) { return reinterpret_cast<V *>(reinterpret_cast<char *>(l) + header_size); }
+      static const V *values(const leaf_node *l)
+      {
+         return reinterpret_cast<const V *>(reinterpret_cast<const char *>(l) + header_size);
+      }
+      static K *keys(inner_node *n) { return reinterpret_cast<K *>(reinterpret_cast<char *>(n) + keys_offset); }
+      static const K *keys(const inner_node *n)
+      {
+         return reinterpret_cast<const K *>(reinterpret_cast<const char *>(n) + keys_offset);
+      }
+      static const K &keyof(const V &v) { return KeyOfValue()(v); }
+      template<class A, class B> static bool key_less(const A &a, const B &b) { return Compare()(a, b); }
+
+      template<typename X> static void relocate(X *to, X *from)
+      {
+         ::new(to) X(*from);
+         from->~X();
+      }
+      // moves [from, from + n) to to, the ranges may overlap
+      template<typename X> static void relocate(X *to, X *from, unsigned n)
+      {
+         if (to < from)
+            for (unsigned i = 0; i < n; ++i)
+               relocate(to + i, from + i);
+         else
+            for (unsigned i = n; i--;)
+               relocate(to + i, from + i);
+      }
+      template<typename X> static void move_children(X *to, X *from, unsigned n)
+      {
+         if (to < from)
+            for (unsigned i = 0; i < n; ++i)
+               to[i] = from[i];
+         else
+            for (unsigned i = n; i--;)
+               to[i] = from[i];
+      }
+
+      leaf_node *create_leaf()
+      {
+         leaf_node *l = static_cast<leaf_node *>(Resource::allocate(header_size + sizeof(V) * (leaf_max + 1)));
+         l->count = 0;
+         l->leaf = 1;
+         l->prev = l->next = 0;
+         return l;
+      }
+      inner_node *create_inner()
+      {
+         inner_node *n = static_cast<inner_node *>(Resource::allocate(keys_offset + sizeof(K) * (inner_max + 1)));
+         n->count = 0;
+         n->leaf = 0;
+         return n;
+      }
+      void destroy_leaf(leaf_node *l)
+      {
+         for (unsigned i = 0; i < l->count; ++i)
+            values(l)[i].~V();
+         Resource::deallocate(l, header_size + sizeof(V) * (leaf_max + 1));
+      }
+      void destroy_inner(inner_node *n)
+      {
+         for (unsigned i = 0; i < n->count; ++i)
+            keys(n)[i].~K();
+         Resource::deallocate(n, keys_offset + sizeof(K) * (inner_max + 1));
+      }
+      void destroy(node *n)
+      {
+         if (n->leaf)
+            return destroy_leaf(static_cast<leaf_node *>(n));
+         inner_node *in = static_cast<inner_node *>(n);
+         for (unsigned i = 0; i <= in->count; ++i)
+            destroy(in->children[i]);
+         destroy_inner(in);
+      }
+
+      template<class X>
+      static unsigned leaf_lower(const leaf_node *l, const X &x, integral_constant<bool, true>)
+      {
+         return btree_search<K, Compare>::lower(values(l), l->count, x);
+      }
+      template<class X>
+      static unsigned leaf_lower(const leaf_node *l, const X &x, integral_constant<bool, false>)
+      {
+         unsigned lo = 0, hi = l->count;
+         while (lo < hi)
+         {
+            const unsigned m = lo + (hi - lo) / 2;
+            if (key_less(keyof(values(l)[m]), x))
+               lo = m + 1;
+            else
+               hi = m;
+         }
+         return lo;
+      }
+      template<class X>
+      static unsigned leaf_lower(const leaf_node *l, const X &x)
+      {
+         return leaf_lower(l, x, integral_constant<bool, is_same<K, V>::value>());
+      }
+      template<class X>
+      static unsigned inner_upper(const inner_node *n, const X &x)
+      {
+         return btree_search<K, Compare>::upper(keys(n), n->count, x);
+      }
+
+      // the leaf where x is or would be
+      template<class X>
+      leaf_node *descend(const X &x, path *p) const
+      {
+         node *n = root_;
+         for (unsigned d = 0; d < height_; ++d)
+         {
+            inner_node *in = static_cast<inner_node *>(n);
+            const unsigned i = inner_upper(in, x);
+            if (p)
+            {
+               p->nodes[d] = in;
+               p->index[d] = i;
+            }
+            n = in->children[i];
+         }
+         return static_cast<leaf_node *>(n);
+      }
+      static K first_key(const node *n)
+      {
+         while (!n->leaf)
+            n = static_cast<const inner_node *>(n)->children[0];
+         return keyof(values(static_cast<const leaf_node *>(n))[0]);
+      }
+
+      struct copy_value
+      {
+         const V &value;
+         explicit copy_value(const V &v): value(v) {}
+         const V &operator()() const { return value; }
+      };
+
+      void insert_in_parent(path &p, unsigned d, const K &separator, node *right);
+      void rebalance_leaf(leaf_node *l, path &p);
+      void rebalance_inner(inner_node *n, path &p, unsigned d);
+      void build_levels();
+
+      btree(const btree &);
+      btree &operator=(const btree &);
+
+   public:
+      struct const_iterator;
+
+      struct iterator
+      {
+      public:
+         typedef V value_type;
+         typedef ttl::ptrdiff_t difference_type;
+         typedef value_type *pointer;
+         typedef value_type &reference;
+
+         iterator(): node_(0), pos_(0) {}
+
+         value_type &operator*() const { return values(node_)[pos_]; }
+         value_type *operator->() const { return values(node_) + pos_; }
+         iterator &operator++()
+         {
+            if (++pos_ == node_->count && node_->next)
+            {
+               node_ = node_->next;
+               pos_ = 0;
+            }
+            return *this;
+         }
+         iterator operator++(int) { iterator tmp(*this); operator++(); return tmp; }
+         iterator &operator--()
+         {
+            if (!pos_)
+            {
+               node_ = node_->prev;
+               pos_ = node_->count;
+            }
+            --pos_;
+            return *this;
+         }
+         iterator operator--(int) { iterator tmp(*this); operator--(); return tmp; }
+
+         bool operator==(const iterator &other) const { return node_ == other.node_ && pos_ == other.pos_; }
+         bool operator!=(const iterator &other) const { return !operator==(other); }
+         bool operator==(const const_iterator &other) const { return other == *this; }
+         bool operator!=(const const_iterator &other) const { return other != *this; }
+      private:
+         leaf_node *node_;
+         unsigned pos_;
+         friend class btree;
+         friend struct btree::const_iterator;
+         iterator(leaf_node *node, unsigned pos): node_(node), pos_(pos) {}
+      };
+      struct const_iterator
+      {
+      public:
+         typedef V value_type;
+         typedef ttl::ptrdiff_t difference_type;
+         typedef const value_type *pointer;
+         typedef const value_type &reference;
+
+         const_iterator(): node_(0), pos_(0) {}
+
+         const value_type &operator*() const { return values(node_)[pos_]; }
+         const value_type *operator->() const { return values(node_) + pos_; }
+         const_iterator &operator++()
+         {
+            if (++pos_ == node_->count && node_->next)
+            {
+               node_ = node_->next;
+               pos_ = 0;
+            }
+            return *this;
+         }
+         const_iterator operator++(int) { const_iterator tmp(*this); operator++(); return tmp; }
+         const_iterator &operator--()
+         {
+            if (!pos_)
+            {
+               node_ = node_->prev;
+               pos_ = node_->count;
+            }
+            --pos_;
+            return *this;
+         }
+         const_iterator operator--(int) { const_iterator tmp(*this); operator--(); return tmp; }
+
+         bool operator==(const const_iterator &other) const { return node_ == other.node_ && pos_ == other.pos_; }
+         bool operator==(const iterator &other) const { return node_ == other.node_ && pos_ == other.pos_; }
+         bool operator!=(const const_iterator &other) const { return !operator==(other); }
+         bool operator!=(const iterator &other) const { return !operator==(other); }
+
+         const_iterator(const iterator &other): node_(other.node_), pos_(other.pos_) {}
+      private:
+         const leaf_node *node_;
+         unsigned pos_;
+         friend class btree;
+         const_iterator(const leaf_node *node, unsigned pos): node_(node), pos_(pos) {}
+      };
+
+      btree(): root_(0), first_(0), last_(0), size_(0), height_(0) {}
+      explicit btree(const Resource &r): Resource(r), root_(0), first_(0), last_(0), size_(0), height_(0) {}
+      ~btree() { clear(); }
+
+      const Resource &get_resource() const { return *this; }
+
+      void assign(const btree &other)
+      {
+         if (this != &other)
+            assign_sorted(other.begin(), other.end());
+      }
+      // builds the tree from values sorted by key, the repeated keys after
+      // the first are skipped
+      template<class InputIt> void assign_sorted(InputIt first, InputIt last);
+
+      void clear()
+      {
+         if (root_)
+            destroy(root_);
+         root_ = 0;
+         first_ = last_ = 0;
+         size_ = 0;
+         height_ = 0;
+      }
+      void swap(btree &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         ttl::swap(root_, other.root_);
+         ttl::swap(first_, other.first_);
+         ttl::swap(last_, other.last_);
+         ttl::swap(size_, other.size_);
+         ttl::swap(height_, other.height_);
+      }
+
+      size_type size() const { return size_; }
+      bool empty() const { return !size_; }
+      // the levels of the tree, 1 for a single leaf
+      unsigned height() const { return root_ ? height_ + 1: 0; }
+
+      iterator begin() { return iterator(first_, 0); }
+      const_iterator begin() const { return const_iterator(first_, 0); }
+      iterator end() { return iterator(last_, last_ ? last_->count: 0); }
+      const_iterator end() const { return const_iterator(last_, last_ ? last_->count: 0); }
+
+      pair<iterator, bool> insert_unique(const V &value)
+      {
+         return insert_unique(keyof(value), copy_value(value));
+      }
+      // inserts the value make() returns if the key is not there, with one
+      // descent for both: make is only called for a new key
+      template<class Make> pair<iterator, bool> insert_unique(const K &key, const Make &make);
+      template<class X> size_type erase_unique(const X &key);
+      iterator erase(const_iterator pos)
+      {
+         const K key = keyof(*pos);
+         erase_unique(key);
+         return lower_bound(key);
+      }
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         size_type n = 0;
+         for (const_iterator i = first; i != last; ++i)
+            ++n;
+         iterator i(const_cast<leaf_node *>(first.node_), first.pos_);
+         while (n--)
+            i = erase(i);
+         return i;
+      }
+
+      //
+      // The lookups take a K, or with a transparent Compare any type X it
+      // takes with the keys (btree_map and btree_set check that)
+      //
+
+      template<class X> const_iterator find(const X &key) const
+      {
+         if (!root_)
+            return end();
+         const leaf_node *l = descend(key, 0);
+         const unsigned i = leaf_lower(l, key);
+         return i < l->count && !key_less(key, keyof(values(l)[i])) ? const_iterator(l, i): end();
+      }
+      template<class X> iterator find(const X &key)
+      {
+         const_iterator i = static_cast<const btree *>(this)->find(key);
+         return iterator(const_cast<leaf_node *>(i.node_), i.pos_);
+      }
+
+      template<class X> const_iterator lower_bound(const X &key) const
+      {
+         if (!root_)
+            return end();
+         const leaf_node *l = descend(key, 0);
+         const unsigned i = leaf_lower(l, key);
+         return i == l->count && l->next ? const_iterator(l->next, 0): const_iterator(l, i);
+      }
+      template<class X> iterator lower_bound(const X &key)
+      {
+         const_iterator i = static_cast<const btree *>(this)->lower_bound(key);
+         return iterator(const_cast<leaf_node *>(i.node_), i.pos_);
+      }
+
+      template<class X> const_iterator upper_bound(const X &key) const
+      {
+         const_iterator i = lower_bound(key);
+         if (i != end() && !key_less(key, keyof(*i)))
+            ++i;
+         return i;
+      }
+      template<class X> iterator upper_bound(const X &key)
+      {
+         const_iterator i = static_cast<const btree *>(this)->upper_bound(key);
+         return iterator(const_cast<leaf_node *>(i.node_), i.pos_);
+      }
+   };
+
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   template<class Make>
+   pair<typename btree<K,V,KeyOfValue,Compare,Resource>::iterator, bool>
+   btree<K,V,KeyOfValue,Compare,Resource>::insert_unique(const K &key, const Make &make)
+   {
+      if (!root_)
+         root_ = first_ = last_ = create_leaf();
+      path p;
+      leaf_node *l = descend(key, &p);
+      unsigned i = leaf_lower(l, key);
+      if (i < l->count && !key_less(key, keyof(values(l)[i])))
+         return pair<iterator, bool>(iterator(l, i), false);
+
+      V *v = values(l);
+      relocate(v + i + 1, v + i, l->count - i);
+      ::new(v + i) V(make());
+      ++l->count;
+      ++size_;
+      if (l->count <= leaf_max)
+         return pair<iterator, bool>(iterator(l, i), true);
+
+      // split, the upper half to a new leaf on the right
+      leaf_node *r = create_leaf();
+      const unsigned h = l->count / 2;
+      relocate(values(r), v + h, l->count - h);
+      r->count = l->count - h;
+      l->count = h;
+      r->prev = l;
+      r->next = l->next;
+      if (l->next)
+         l->next->prev = r;
+      else
+         last_ = r;
+      l->next = r;
+      insert_in_parent(p, height_, keyof(values(r)[0]), r);
+      return pair<iterator, bool>(i < h ? iterator(l, i): iterator(r, i - h), true);
+   }
+
+   // links right after the child at depth d of the path, with the separator
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   void btree<K,V,KeyOfValue,Compare,Resource>::insert_in_parent(path &p, unsigned d, const K &separator, node *right)
+   {
+      if (!d)
+      {
+         inner_node *n = create_inner();
+         ::new(keys(n)) K(separator);
+         n->children[0] = root_;
+         n->children[1] = right;
+         n->count = 1;
+         root_ = n;
+         ++height_;
+         return;
+      }
+      inner_node *n = p.nodes[d - 1];
+      const unsigned i = p.index[d - 1];
+      relocate(keys(n) + i + 1, keys(n) + i, n->count - i);
+      move_children(n->children + i + 2, n->children + i + 1, n->count - i);
+      ::new(keys(n) + i) K(separator);
+      n->children[i + 1] = right;
+      if (++n->count <= inner_max)
+         return;
+
+      // split, the middle key goes up
+      inner_node *r = create_inner();
+      const unsigned h = n->count / 2;
+      r->count = n->count - h - 1;
+      relocate(keys(r), keys(n) + h + 1, r->count);
+      move_children(r->children, n->children + h + 1, r->count + 1);
+      n->count = h;
+      const K up(keys(n)[h]);
+      keys(n)[h].~K();
+      insert_in_parent(p, d - 1, up, r);
+   }
+
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   template<class X>
+   typename btree<K,V,KeyOfValue,Compare,Resource>::size_type
+   btree<K,V,KeyOfValue,Compare,Resource>::erase_unique(const X &key)
+   {
+      if (!root_)
+         return 0;
+      path p;
+      leaf_node *l = descend(key, &p);
+      const unsigned i = leaf_lower(l, key);
+      if (i == l->count || key_less(key, keyof(values(l)[i])))
+         return 0;
+      V *v = values(l);
+      v[i].~V();
+      relocate(v + i, v + i + 1, l->count - i - 1);
+      --l->count;
+      --size_;
+      rebalance_leaf(l, p);
+      return 1;
+   }
+
+   // takes a value from a sibling or merges with it when below leaf_min
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   void btree<K,V,KeyOfValue,Compare,Resource>::rebalance_leaf(leaf_node *l, path &p)
+   {
+      if (!height_)
+      {
+         if (!l->count)
+            clear();
+         return;
+      }
+      if (l->count >= leaf_min)
+         return;
+      inner_node *parent = p.nodes[height_ - 1];
+      const unsigned i = p.index[height_ - 1];
+      leaf_node *left = i ? static_cast<leaf_node *>(parent->children[i - 1]): 0;
+      leaf_node *right = i < parent->count ? static_cast<leaf_node *>(parent->children[i + 1]): 0;
+      if (left && left->count > leaf_min)
+      {
+         relocate(values(l) + 1, values(l), l->count);
+         relocate(values(l), values(left) + --left->count);
+         ++l->count;
+         keys(parent)[i - 1] = keyof(values(l)[0]);
+         return;
+      }
+      if (right && right->count > leaf_min)
+      {
+         relocate(values(l) + l->count++, values(right));
+         relocate(values(right), values(right) + 1, --right->count);
+         keys(parent)[i] = keyof(values(right)[0]);
+         return;
+      }
+      // merge the right one of the two into the left
+      unsigned s = i;
+      if (left)
+      {
+         right = l;
+         l = left;
+         s = i - 1;
+      }
+      relocate(values(l) + l->count, values(right), right->count);
+      l->count += right->count;
+      right->count = 0;
+      l->next = right->next;
+      if (right->next)
+         right->next->prev = l;
+      else
+         last_ = l;
+      destroy_leaf(right);
+
+      keys(parent)[s].~K();
+      relocate(keys(parent) + s, keys(parent) + s + 1, parent->count - s - 1);
+      move_children(parent->children + s + 1, parent->children + s + 2, parent->count - s - 1);
+      --parent->count;
+      rebalance_inner(parent, p, height_ - 1);
+   }
+
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   void btree<K,V,KeyOfValue,Compare,Resource>::rebalance_inner(inner_node *n, path &p, unsigned d)
+   {
+      if (!d)
+      {
+         if (!n->count)
+         {
+            root_ = n->children[0];
+            destroy_inner(n);
+            --height_;
+         }
+         return;
+      }
+      if (n->count >= inner_min)
+         return;
+      inner_node *parent = p.nodes[d - 1];
+      const unsigned i = p.index[d - 1];
+      inner_node *left = i ? static_cast<inner_node *>(parent->children[i - 1]): 0;
+      inner_node *right = i < parent->count ? static_cast<inner_node *>(parent->children[i + 1]): 0;
+      if (left && left->count > inner_min)
+      {
+         // rotate through the separator in the parent
+         relocate(keys(n) + 1, keys(n), n->count);
+         move_children(n->children + 1, n->children, n->count + 1);
+         ::new(keys(n)) K(keys(parent)[i - 1]);
+         n->children[0] = left->children[left->count];
+         ++n->count;
+         keys(parent)[i - 1] = keys(left)[--left->count];
+         keys(left)[left->count].~K();
+         return;
+      }
+      if (right && right->count > inner_min)
+      {
+         ::new(keys(n) + n->count) K(keys(parent)[i]);
+         n->children[++n->count] = right->children[0];
+         keys(parent)[i] = keys(right)[0];
+         keys(right)[0].~K();
+         relocate(keys(right), keys(right) + 1, right->count - 1);
+         move_children(right->children, right->children + 1, right->count);
+         --right->count;
+         return;
+      }
+      unsigned s = i;
+      if (left)
+      {
+         right = n;
+         n = left;
+         s = i - 1;
+      }
+      ::new(keys(n) + n->count) K(keys(parent)[s]);
+      relocate(keys(n) + n->count + 1, keys(right), right->count);
+      move_children(n->children + n->count + 1, right->children, right->count + 1);
+      n->count += right->count + 1;
+      right->count = 0;
+      destroy_inner(right);
+
+      keys(parent)[s].~K();
+      relocate(keys(parent) + s, keys(parent) + s + 1, parent->count - s - 1);
+      move_children(parent->children + s + 1, parent->children + s + 2, parent->count - s - 1);
+      --parent->count;
+      rebalance_inner(parent, p, d - 1);
+   }
+
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   template<class InputIt>
+   void btree<K,V,KeyOfValue,Compare,Resource>::assign_sorted(InputIt first, InputIt last)
+   {
+      clear();
+      leaf_node *l = 0;
+      for (; first != last; ++first)
+      {
+         if (l && !key_less(keyof(values(l)[l->count - 1]), keyof(*first)))
+            continue;
+         if (!l || l->count == leaf_max)
+         {
+            leaf_node *n = create_leaf();
+            n->prev = l;
+            if (l)
+               l->next = n;
+            else
+               first_ = n;
+            l = n;
+         }
+         ::new(values(l) + l->count++) V(*first);
+         ++size_;
+      }
+      if (!l)
+         return;
+      last_ = l;
+      // the last leaf takes from the one before it
+      if (l->prev && l->count < leaf_min)
+      {
+         leaf_node *left = l->prev;
+         const unsigned n = left->count - (left->count + l->count) / 2;
+         relocate(values(l) + n, values(l), l->count);
+         relocate(values(l), values(left) + left->count - n, n);
+         left->count -= n;
+         l->count += n;
+      }
+      build_levels();
+   }
+
+   // the inner levels over the leaves
+   template<typename K, typename V, typename KeyOfValue, typename Compare, typename Resource>
+   void btree<K,V,KeyOfValue,Compare,Resource>::build_levels()
+   {
+      vector<node *, Resource> level(static_cast<const Resource &>(*this)), up(static_cast<const Resource &>(*this));
+      size_type leaves = 0;
+      for (leaf_node *l = first_; l; l = l->next)
+         ++leaves;
+      level.reserve(leaves);
+      for (leaf_node *l = first_; l; l = l->next)
+         level.push_back(l);
+      for (height_ = 0; level.size() > 1; ++height_)
+      {
+         const size_type fanout = inner_max + 1, least = inner_min + 1;
+         up.clear();
+         up.reserve(level.size() / least + 1);
+         for (size_type i = 0; i < level.size();)
+         {
+            // full nodes, the last two share what is left
+            size_type n = level.size() - i;
+            if (n > fanout)
+               n = n < fanout + least ? n / 2: fanout;
+            inner_node *in = create_inner();
+            in->children[0] = level[i];
+            for (size_type c = 1; c < n; ++c)
+            {
+               ::new(keys(in) + c - 1) K(first_key(level[i + c]));
+               in->children[c] = level[i + c];
+            }
+            in->count = n - 1;
+            up.push_back(in);
+            i += n;
+         }
+         level.swap(up);
+      }
+      root_ = level[0];
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_BTREE_HPP_
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: the btree_set template implementation
+//
+// A set on a B+tree (see btree.hpp), the keys of a leaf are contiguous and
+// the int and unsigned ones are searched with SSE2.
+//
+// Unlike with set, any insertion or erasure invalidates the iterators.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_BTREE_SET_HPP_
+#define _TINY_TEMPLATE_LIBRARY_BTREE_SET_HPP_ 1
+
+#include "types.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "btree.hpp"
+
+namespace ttl
+{
+   template<typename KT, typename Compare = less<KT>, typename Resource = new_delete_resource>
+   class btree_set // unique keys
+   {
+   public:
+      typedef KT key_type;
+      typedef KT value_type;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+      typedef Compare key_compare;
+      typedef Compare value_compare;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+
+   private:
+      typedef btree<KT, KT, select_same<KT>, Compare, Resource> tree_type;
+
+      tree_type tree_;
+
+   public:
+      typedef typename tree_type::iterator iterator;
+      typedef typename tree_type::const_iterator const_iterator;
+
+      iterator begin() { return tree_.begin(); }
+      const_iterator begin() const { return tree_.begin(); }
+      const_iterator cbegin() const { return tree_.begin(); }
+      iterator end() { return tree_.end(); }
+      const_iterator end() const { return tree_.end(); }
+      const_iterator cend() const { return tree_.end(); }
+
+      explicit btree_set() {}
+      explicit btree_set(const Resource &r): tree_(r) {}
+      ~btree_set() {}
+
+      btree_set(const btree_set &other):
+         tree_(other.tree_.get_resource())
+      {
+         tree_.assign(other.tree_);
+      }
+
+      template<class InputIt> btree_set(InputIt first, InputIt last, const Resource &r = Resource()):
+         tree_(r)
+      {
+         insert(first, last);
+      }
+
+      btree_set &operator=(const btree_set &other)
+      {
+         tree_.assign(other.tree_);
+         return *this;
+      }
+
+      pair<iterator,bool> insert(const value_type &value) { return tree_.insert_unique(value); }
+      iterator insert(const_iterator, const value_type &value) { return tree_.insert_unique(value).first; }
+
+      template<class InputIt> void insert(InputIt first, InputIt last)
+      {
+         for (; first != last; ++first)
+            tree_.insert_unique(*first);
+      }
+
+      // replaces the contents with the keys of a sorted range, in O(N)
+      template<class InputIt> void assign_sorted(InputIt first, InputIt last)
+      {
+         tree_.assign_sorted(first, last);
+      }
+
+      void clear() { tree_.clear(); }
+
+      size_type size() const { return tree_.size(); }
+      bool empty() const { return tree_.empty(); }
+      size_type max_size() const { return (size_type)-1 / sizeof(value_type); }
+
+      iterator erase(const_iterator pos) { return tree_.erase(pos); }
+      iterator erase(const_iterator first, const_iterator last) { return tree_.erase(first, last); }
+
+      size_type erase(const KT &key) { return tree_.erase_unique(key); }
+
+      void swap(btree_set &other) { tree_.swap(other.tree_); }
+
+      const Resource &get_resource() const { return tree_.get_resource(); }
+
+      iterator find(const KT &key) { return tree_.find(key); }
+      const_iterator find(const KT &key) const { return tree_.find(key); }
+
+      size_type count(const KT &key) const { return tree_.find(key) != tree_.end(); }
+
+      iterator lower_bound(const KT &key) { return tree_.lower_bound(key); }
+      const_iterator lower_bound(const KT &key) const { return tree_.lower_bound(key); }
+
+      iterator upper_bound(const KT &key) { return tree_.upper_bound(key); }
+      const_iterator upper_bound(const KT &key) const { return tree_.upper_bound(key); }
+
+      pair<iterator, iterator> equal_range(const KT &key)
+      {
+         return pair<iterator, iterator>(tree_.lower_bound(key), tree_.upper_bound(key));
+      }
+      pair<const_iterator, const_iterator> equal_range(const KT &key) const
+      {
+         return pair<const_iterator, const_iterator>(tree_.lower_bound(key), tree_.upper_bound(key));
+      }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key) { return tree_.erase_unique(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key) { return tree_.find(key); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const { return tree_.find(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const
+      {
+         return tree_.find(key) != tree_.end();
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key) { return tree_.lower_bound(key); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return tree_.lower_bound(key);
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key) { return tree_.upper_bound(key); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return tree_.upper_bound(key);
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, pair<iterator, iterator> >::type equal_range(const K &key)
+      {
+         return pair<iterator, iterator>(tree_.lower_bound(key), tree_.upper_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+      equal_range(const K &key) const
+      {
+         return pair<const_iterator, const_iterator>(tree_.lower_bound(key), tree_.upper_bound(key));
+      }
+
+      key_compare key_comp() const { return Compare(); }
+      value_compare value_comp() const { return Compare(); }
+   };
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename KT, typename Compare, typename Resource>
+   bool operator==(const btree_set<KT,Compare,Resource> &a, const btree_set<KT,Compare,Resource> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template <typename KT, typename Compare, typename Resource>
+   bool operator!=(const btree_set<KT,Compare,Resource> &a, const btree_set<KT,Compare,Resource> &b)
+   {
+      return !(a == b);
+   }
+}
+#endif // _TINY_TEMPLATE_LIBRARY_BTREE_SET_HPP_
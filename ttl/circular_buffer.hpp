@@ -0,0 +1,313 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a circular buffer (a ring buffer)
+//
+// The elements are kept in an array of a power of two capacity, from a
+// first one on and round the end of the array, so an index is a mask
+// away from a position and the pushes and pops at both ends are O(1).
+// A full buffer grows by doubling its array, as a vector.
+//
+// With a limit (set_limit), the buffer is a sliding window of at most
+// limit elements: it allocates its array once, and a push to a full
+// buffer drops the element at the other end.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_CIRCULAR_BUFFER_HPP_
+#define _TINY_TEMPLATE_LIBRARY_CIRCULAR_BUFFER_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "memory_resource.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+   template<class InputIt1, class InputIt2> bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template<typename T, typename Resource = new_delete_resource>
+   class circular_buffer: private Resource
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+   private:
+      T *elements_;
+      size_type capacity_; // 0 or a power of two
+      size_type first_;
+      size_type size_;
+      size_type limit_;
+
+      T *slot(size_type i) const { return elements_ + ((first_ + i) & (capacity_ - 1)); }
+      void grow(size_type n);
+
+   public:
+      class const_iterator;
+
+      // a position is the index of the element, the iterators are random
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* left uninitialized */ {}
+         reference operator*() const { return *b_->slot(i_); }
+         pointer operator->() const { return b_->slot(i_); }
+         reference operator[](difference_type n) const { return *b_->slot(i_ + n); }
+         iterator &operator++() { ++i_; return *this; }
+         iterator operator++(int) { iterator tmp(*this); ++i_; return tmp; }
+         iterator &operator--() { --i_; return *this; }
+         iterator operator--(int) { iterator tmp(*this); --i_; return tmp; }
+         iterator &operator+=(difference_type n) { i_ += n; return *this; }
+         iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+         iterator operator+(difference_type n) const { return iterator(b_, i_ + n); }
+         iterator operator-(difference_type n) const { return iterator(b_, i_ - n); }
+         difference_type operator-(const iterator &other) const { return (difference_type)(i_ - other.i_); }
+
+         bool operator==(const iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const iterator &other) const { return i_ != other.i_; }
+         bool operator<(const iterator &other) const { return i_ < other.i_; }
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+
+      private:
+         friend class circular_buffer<T,Resource>;
+         friend class circular_buffer<T,Resource>::const_iterator;
+         circular_buffer *b_;
+         size_type i_;
+         iterator(circular_buffer *b, size_type i): b_(b), i_(i) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* left uninitialized */ {}
+         const_iterator(const iterator &o): b_(o.b_), i_(o.i_) {}
+         reference operator*() const { return *b_->slot(i_); }
+         pointer operator->() const { return b_->slot(i_); }
+         reference operator[](difference_type n) const { return *b_->slot(i_ + n); }
+         const_iterator &operator++() { ++i_; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(*this); ++i_; return tmp; }
+         const_iterator &operator--() { --i_; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(*this); --i_; return tmp; }
+         const_iterator &operator+=(difference_type n) { i_ += n; return *this; }
+         const_iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+         const_iterator operator+(difference_type n) const { return const_iterator(b_, i_ + n); }
+         const_iterator operator-(difference_type n) const { return const_iterator(b_, i_ - n); }
+         difference_type operator-(const const_iterator &other) const { return (difference_type)(i_ - other.i_); }
+
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+         bool operator<(const const_iterator &other) const { return i_ < other.i_; }
+
+      private:
+         friend class circular_buffer<T,Resource>;
+         const circular_buffer *b_;
+         size_type i_;
+         const_iterator(const circular_buffer *b, size_type i): b_(b), i_(i) {}
+      };
+
+      circular_buffer(): elements_(0), capacity_(0), first_(0), size_(0), limit_(0) {}
+      explicit circular_buffer(const Resource &r):
+         Resource(r), elements_(0), capacity_(0), first_(0), size_(0), limit_(0)
+      {}
+      circular_buffer(const circular_buffer &other);
+      circular_buffer(size_type n, const T &value):
+         elements_(0), capacity_(0), first_(0), size_(0), limit_(0)
+      {
+         reserve(n);
+         while (n--)
+            push_back(value);
+      }
+      template<typename InputIterator>
+      circular_buffer(InputIterator first, InputIterator last):
+         elements_(0), capacity_(0), first_(0), size_(0), limit_(0)
+      {
+         for (; first != last; ++first)
+            push_back(*first);
+      }
+      ~circular_buffer()
+      {
+         clear();
+         Resource::deallocate(elements_, capacity_ * sizeof(T));
+      }
+
+      circular_buffer &operator=(const circular_buffer &other);
+
+      iterator begin() { return iterator(this, 0); }
+      iterator end() { return iterator(this, size_); }
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, size_); }
+      const_iterator cbegin() const { return const_iterator(this, 0); }
+      const_iterator cend() const { return const_iterator(this, size_); }
+
+      bool empty() const { return !size_; }
+      size_type size() const { return size_; }
+      size_type capacity() const { return capacity_; }
+      size_type max_size() const { return (size_type)-1 / sizeof(T); }
+
+      // a window of at most n elements, 0 for none; the buffer keeps its
+      // n last elements
+      void set_limit(size_type n)
+      {
+         limit_ = n;
+         if (n)
+         {
+            while (size_ > n)
+               pop_front();
+            reserve(n);
+         }
+      }
+      size_type limit() const { return limit_; }
+      bool full() const { return limit_ && size_ == limit_; }
+
+      void reserve(size_type n)
+      {
+         if (n > capacity_)
+            grow(n);
+      }
+
+      reference operator[](size_type n) { return *slot(n); }
+      const_reference operator[](size_type n) const { return *slot(n); }
+      reference at(size_type n) { return *slot(n); }
+      const_reference at(size_type n) const { return *slot(n); }
+      reference front() { return elements_[first_]; }
+      const_reference front() const { return elements_[first_]; }
+      reference back() { return *slot(size_ - 1); }
+      const_reference back() const { return *slot(size_ - 1); }
+
+      void push_back(const T &value)
+      {
+         if (size_ < capacity_ && !full())
+         {
+            ::new(slot(size_)) T(value);
+            ++size_;
+            return;
+         }
+         // the value may be an element of the buffer
+         T copy(value);
+         if (full())
+            pop_front();
+         else
+            grow(size_ + 1);
+         ::new(slot(size_)) T(copy);
+         ++size_;
+      }
+      void push_front(const T &value)
+      {
+         if (size_ == capacity_ || full())
+         {
+            T copy(value);
+            if (full())
+               pop_back();
+            else
+               grow(size_ + 1);
+            push_front(copy);
+            return;
+         }
+         first_ = (first_ - 1) & (capacity_ - 1);
+         ::new(elements_ + first_) T(value);
+         ++size_;
+      }
+
+      void pop_front()
+      {
+         elements_[first_].~T();
+         first_ = (first_ + 1) & (capacity_ - 1);
+         --size_;
+      }
+      void pop_back()
+      {
+         slot(--size_)->~T();
+      }
+
+      void clear()
+      {
+         while (size_)
+            pop_back();
+         first_ = 0;
+      }
+
+      void swap(circular_buffer &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         ttl::swap(elements_, other.elements_);
+         ttl::swap(capacity_, other.capacity_);
+         ttl::swap(first_, other.first_);
+         ttl::swap(size_, other.size_);
+         ttl::swap(limit_, other.limit_);
+      }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   template<typename T, typename Resource>
+   circular_buffer<T,Resource>::circular_buffer(const circular_buffer &other):
+      Resource(other), elements_(0), capacity_(0), first_(0), size_(0), limit_(other.limit_)
+   {
+      reserve(limit_ ? limit_: other.size_);
+      for (size_type i = 0; i < other.size_; ++i)
+         ::new(elements_ + i) T(other[i]);
+      size_ = other.size_;
+   }
+
+   template<typename T, typename Resource>
+   circular_buffer<T,Resource> &circular_buffer<T,Resource>::operator=(const circular_buffer &other)
+   {
+      if (this != &other)
+      {
+         clear();
+         limit_ = other.limit_;
+         reserve(limit_ ? limit_: other.size_);
+         for (size_type i = 0; i < other.size_; ++i)
+            ::new(elements_ + i) T(other[i]);
+         size_ = other.size_;
+      }
+      return *this;
+   }
+
+   template<typename T, typename Resource>
+   void circular_buffer<T,Resource>::grow(size_type n)
+   {
+      size_type capacity = capacity_ ? capacity_: 4;
+      while (capacity < n)
+         capacity *= 2;
+      T *elements = static_cast<T *>(Resource::allocate(capacity * sizeof(T)));
+      for (size_type i = 0; i < size_; ++i)
+      {
+         T *p = slot(i);
+         ::new(elements + i) T(*p);
+         p->~T();
+      }
+      Resource::deallocate(elements_, capacity_ * sizeof(T));
+      elements_ = elements;
+      capacity_ = capacity;
+      first_ = 0;
+   }
+
+   template<typename T, typename Resource>
+   bool operator==(const circular_buffer<T,Resource> &a, const circular_buffer<T,Resource> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template<typename T, typename Resource>
+   bool operator!=(const circular_buffer<T,Resource> &a, const circular_buffer<T,Resource> &b)
+   {
+      return !(a == b);
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_CIRCULAR_BUFFER_HPP_
@@ -0,0 +1,303 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an implementation of STL deque
+//
+// The elements are kept in blocks of block_size elements, the blocks in
+// a circular_buffer of pointers to them. A push at either end fills the
+// first or the last block or adds one, so the elements never move and
+// the references to them stay valid until they are popped; only the
+// pointers move when the circular_buffer grows. The pushes and pops at
+// both ends and the indexed access are O(1).
+//
+// The block emptied last is kept for the next one needed, so a deque
+// used as a FIFO allocates nothing once it has reached its size.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_DEQUE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_DEQUE_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "memory_resource.hpp"
+#include "circular_buffer.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+   template<class InputIt1, class InputIt2> bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template<typename T, typename Resource = new_delete_resource>
+   class deque: private Resource
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+      // up to 1 KB of elements, a power of two for the indexing
+      static const size_type block_size =
+         sizeof(T) <= 4 ? 256: sizeof(T) <= 8 ? 128: sizeof(T) <= 16 ? 64: sizeof(T) <= 32 ? 32: 16;
+
+   private:
+      // the elements are at the positions first_ to first_ + size_ - 1 of
+      // the blocks, first_ is in the first block; no blocks when empty
+      circular_buffer<T *, Resource> blocks_;
+      size_type first_;
+      size_type size_;
+      T *spare_;
+
+      T *slot(size_type i) const
+      {
+         const size_type p = first_ + i;
+         return blocks_[p / block_size] + p % block_size;
+      }
+      T *get_block()
+      {
+         T *b = spare_;
+         if (b)
+            spare_ = 0;
+         else
+            b = static_cast<T *>(Resource::allocate(block_size * sizeof(T)));
+         return b;
+      }
+      void put_block(T *b)
+      {
+         if (spare_)
+            Resource::deallocate(spare_, block_size * sizeof(T));
+         spare_ = b;
+      }
+      // out of line, the pushes stay small enough to be inlined
+      void add_back_block();
+      void add_front_block();
+      void drop_back_block();
+      void drop_front_block();
+
+   public:
+      class const_iterator;
+
+      // a position is the index of the element, the iterators are random
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* left uninitialized */ {}
+         reference operator*() const { return *d_->slot(i_); }
+         pointer operator->() const { return d_->slot(i_); }
+         reference operator[](difference_type n) const { return *d_->slot(i_ + n); }
+         iterator &operator++() { ++i_; return *this; }
+         iterator operator++(int) { iterator tmp(*this); ++i_; return tmp; }
+         iterator &operator--() { --i_; return *this; }
+         iterator operator--(int) { iterator tmp(*this); --i_; return tmp; }
+         iterator &operator+=(difference_type n) { i_ += n; return *this; }
+         iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+         iterator operator+(difference_type n) const { return iterator(d_, i_ + n); }
+         iterator operator-(difference_type n) const { return iterator(d_, i_ - n); }
+         difference_type operator-(const iterator &other) const { return (difference_type)(i_ - other.i_); }
+
+         bool operator==(const iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const iterator &other) const { return i_ != other.i_; }
+         bool operator<(const iterator &other) const { return i_ < other.i_; }
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+
+      private:
+         friend class deque<T,Resource>;
+         friend class deque<T,Resource>::const_iterator;
+         deque *d_;
+         size_type i_;
+         iterator(deque *d, size_type i): d_(d), i_(i) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* left uninitialized */ {}
+         const_iterator(const iterator &o): d_(o.d_), i_(o.i_) {}
+         reference operator*() const { return *d_->slot(i_); }
+         pointer operator->() const { return d_->slot(i_); }
+         reference operator[](difference_type n) const { return *d_->slot(i_ + n); }
+         const_iterator &operator++() { ++i_; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(*this); ++i_; return tmp; }
+         const_iterator &operator--() { --i_; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(*this); --i_; return tmp; }
+         const_iterator &operator+=(difference_type n) { i_ += n; return *this; }
+         const_iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+         const_iterator operator+(difference_type n) const { return const_iterator(d_, i_ + n); }
+         const_iterator operator-(difference_type n) const { return const_iterator(d_, i_ - n); }
+         difference_type operator-(const const_iterator &other) const { return (difference_type)(i_ - other.i_); }
+
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+         bool operator<(const const_iterator &other) const { return i_ < other.i_; }
+
+      private:
+         friend class deque<T,Resource>;
+         const deque *d_;
+         size_type i_;
+         const_iterator(const deque *d, size_type i): d_(d), i_(i) {}
+      };
+
+      deque(): first_(0), size_(0), spare_(0) {}
+      explicit deque(const Resource &r): Resource(r), blocks_(r), first_(0), size_(0), spare_(0) {}
+      deque(const deque &other):
+         Resource(other), blocks_(static_cast<const Resource &>(other)), first_(0), size_(0), spare_(0)
+      {
+         for (size_type i = 0; i < other.size_; ++i)
+            push_back(other[i]);
+      }
+      deque(size_type n, const T &value): first_(0), size_(0), spare_(0)
+      {
+         while (n--)
+            push_back(value);
+      }
+      template<typename InputIterator>
+      deque(InputIterator first, InputIterator last): first_(0), size_(0), spare_(0)
+      {
+         for (; first != last; ++first)
+            push_back(*first);
+      }
+      ~deque()
+      {
+         clear();
+         put_block(0);
+      }
+
+      deque &operator=(const deque &other)
+      {
+         if (this != &other)
+         {
+            clear();
+            for (size_type i = 0; i < other.size_; ++i)
+               push_back(other[i]);
+         }
+         return *this;
+      }
+
+      iterator begin() { return iterator(this, 0); }
+      iterator end() { return iterator(this, size_); }
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, size_); }
+      const_iterator cbegin() const { return const_iterator(this, 0); }
+      const_iterator cend() const { return const_iterator(this, size_); }
+
+      bool empty() const { return !size_; }
+      size_type size() const { return size_; }
+      size_type max_size() const { return (size_type)-1 / sizeof(T); }
+
+      reference operator[](size_type n) { return *slot(n); }
+      const_reference operator[](size_type n) const { return *slot(n); }
+      reference at(size_type n) { return *slot(n); }
+      const_reference at(size_type n) const { return *slot(n); }
+      reference front() { return blocks_.front()[first_]; }
+      const_reference front() const { return blocks_.front()[first_]; }
+      reference back() { return *slot(size_ - 1); }
+      const_reference back() const { return *slot(size_ - 1); }
+
+      void push_back(const T &value)
+      {
+         const size_type p = first_ + size_;
+         if (p % block_size == 0)
+            add_back_block();
+         ::new(blocks_[p / block_size] + p % block_size) T(value);
+         ++size_;
+      }
+      void push_front(const T &value)
+      {
+         if (!first_)
+            add_front_block();
+         ::new(blocks_.front() + first_ - 1) T(value);
+         --first_;
+         ++size_;
+      }
+
+      void pop_front()
+      {
+         blocks_.front()[first_].~T();
+         --size_;
+         if (++first_ == block_size || !size_)
+            drop_front_block();
+      }
+      void pop_back()
+      {
+         slot(--size_)->~T();
+         if (!size_)
+            first_ = 0;
+         if ((blocks_.size() - 1) * block_size >= first_ + size_)
+            drop_back_block();
+      }
+
+      void clear()
+      {
+         while (size_)
+            pop_back();
+      }
+
+      // frees the block kept for the next push
+      void shrink_to_fit() { put_block(0); }
+
+      void swap(deque &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         blocks_.swap(other.blocks_);
+         ttl::swap(first_, other.first_);
+         ttl::swap(size_, other.size_);
+         ttl::swap(spare_, other.spare_);
+      }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   template<typename T, typename Resource>
+   void deque<T,Resource>::add_back_block()
+   {
+      blocks_.push_back(get_block());
+   }
+
+   template<typename T, typename Resource>
+   void deque<T,Resource>::add_front_block()
+   {
+      blocks_.push_front(get_block());
+      first_ = block_size;
+   }
+
+   template<typename T, typename Resource>
+   void deque<T,Resource>::drop_back_block()
+   {
+      put_block(blocks_.back());
+      blocks_.pop_back();
+   }
+
+   template<typename T, typename Resource>
+   void deque<T,Resource>::drop_front_block()
+   {
+      put_block(blocks_.front());
+      blocks_.pop_front();
+      first_ = 0;
+   }
+
+   template<typename T, typename Resource>
+   bool operator==(const deque<T,Resource> &a, const deque<T,Resource> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template<typename T, typename Resource>
+   bool operator!=(const deque<T,Resource> &a, const deque<T,Resource> &b)
+   {
+      return !(a == b);
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_DEQUE_HPP_
@@ -0,0 +1,359 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a bitset sized at run time
+//
+// Like bitset, but the number of bits is given to the constructor or to
+// resize(), and the slots are taken from a memory resource (see
+// memory_resource.hpp):
+//
+//    ttl::dynamic_bitset<> used(config.slots);
+//    used.set(i);
+//    for (ttl::size_t i = used.find_first(); i < used.size(); i = used.find_next(i))
+//       ...
+//
+// The slot operations are the ones of bitset (bitset_slots). The unused
+// bits of the last slot are always 0. The combining operations require the
+// sets to be of the same size.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_DYNAMIC_BITSET_HPP_
+#define _TINY_TEMPLATE_LIBRARY_DYNAMIC_BITSET_HPP_ 1
+
+#include "types.hpp"
+#include "memory_resource.hpp"
+#include "bitset.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+
+   template<typename Resource = new_delete_resource>
+   class dynamic_bitset: private Resource
+   {
+   public:
+      typedef bitset_slots::slot_type slot_type;
+      typedef ttl::size_t size_type;
+
+   private:
+      static const size_type slot_bits = bitset_slots::slot_bits;
+
+      slot_type *bits_;
+      size_type size_;  // bits
+      size_type slots_; // allocated slots
+
+      static size_type slots_for(size_type n) { return (n + slot_bits - 1) / slot_bits; }
+      size_type used_slots() const { return slots_for(size_); }
+
+      // clears the unused bits of the last slot
+      void trim()
+      {
+         if (size_ % slot_bits)
+            bits_[size_ / slot_bits] &= ((slot_type)1 << size_ % slot_bits) - 1;
+      }
+      void grow(size_type bits)
+      {
+         size_type n = slots_ * 2;
+         if (n < slots_for(bits))
+            n = slots_for(bits);
+         reserve(n * slot_bits);
+      }
+
+   public:
+      struct reference
+      {
+      private:
+         friend class dynamic_bitset;
+         reference(slot_type *bits, slot_type mask): bits_(bits), mask_(mask) {}
+         slot_type *bits_;
+         slot_type mask_;
+      public:
+         reference& operator=(bool v)
+         {
+            *bits_ = (*bits_ & ~mask_) | (-(slot_type)v & mask_);
+            return *this;
+         }
+         reference& operator=(const reference &other) { return operator=(other.operator bool()); }
+         operator bool() const { return (*bits_ & mask_) != 0; }
+         bool operator~() const { return (*bits_ & mask_) == 0; }
+         reference &flip() { *bits_ ^= mask_; return *this; }
+      };
+
+      dynamic_bitset(): bits_(0), size_(0), slots_(0) {}
+      explicit dynamic_bitset(const Resource &r): Resource(r), bits_(0), size_(0), slots_(0) {}
+      explicit dynamic_bitset(size_type n, bool value = false): bits_(0), size_(0), slots_(0)
+      {
+         resize(n, value);
+      }
+      dynamic_bitset(size_type n, bool value, const Resource &r): Resource(r), bits_(0), size_(0), slots_(0)
+      {
+         resize(n, value);
+      }
+      dynamic_bitset(const dynamic_bitset &other): Resource(other), bits_(0), size_(0), slots_(0)
+      {
+         operator=(other);
+      }
+      ~dynamic_bitset() { Resource::deallocate(bits_, slots_ * sizeof(slot_type)); }
+
+      dynamic_bitset &operator=(const dynamic_bitset &other);
+
+      Resource &get_resource() { return *this; }
+      const Resource &get_resource() const { return *this; }
+
+      size_type size() const { return size_; }
+      bool empty() const { return !size_; }
+      size_type capacity() const { return slots_ * slot_bits; }
+      void reserve(size_type n);
+      void resize(size_type n, bool value = false);
+      void clear() { size_ = 0; }
+      void swap(dynamic_bitset &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         ttl::swap(bits_, other.bits_);
+         ttl::swap(size_, other.size_);
+         ttl::swap(slots_, other.slots_);
+      }
+
+      // the slots, bit i is bit i % slot_bits of slot i / slot_bits
+      size_type num_slots() const { return used_slots(); }
+      slot_type slot(size_type s) const { return bits_[s]; }
+      const slot_type *data() const { return bits_; }
+
+      void push_back(bool value)
+      {
+         if (size_ == capacity())
+            grow(size_ + 1);
+         if (!(size_ % slot_bits))
+            bits_[size_ / slot_bits] = 0;
+         ++size_;
+         set(size_ - 1, value);
+      }
+      // appends the slot_bits bits of the word, the lowest first
+      void append(slot_type word);
+      // appends n words
+      void append(const slot_type *words, size_type n);
+
+      // pos must be less than size(), as in the modifiers below
+      bool operator[](size_type pos) const { return test(pos); }
+      reference operator[](size_type pos)
+      {
+         return reference(bits_ + pos / slot_bits, (slot_type)1 << pos % slot_bits);
+      }
+      bool test(size_type pos) const
+      {
+         return pos < size_ && (bits_[pos / slot_bits] >> pos % slot_bits & 1);
+      }
+
+      dynamic_bitset &set(size_type pos)
+      {
+         bits_[pos / slot_bits] |= (slot_type)1 << pos % slot_bits;
+         return *this;
+      }
+      dynamic_bitset &set(size_type pos, bool value)
+      {
+         return value ? set(pos): reset(pos);
+      }
+      dynamic_bitset &reset(size_type pos)
+      {
+         bits_[pos / slot_bits] &= ~((slot_type)1 << pos % slot_bits);
+         return *this;
+      }
+      dynamic_bitset &flip(size_type pos)
+      {
+         bits_[pos / slot_bits] ^= (slot_type)1 << pos % slot_bits;
+         return *this;
+      }
+      dynamic_bitset &set()
+      {
+         for (size_type i = 0; i < used_slots(); ++i)
+            bits_[i] = (slot_type)-1;
+         trim();
+         return *this;
+      }
+      dynamic_bitset &reset()
+      {
+         bitset_slots::zero(bits_, 0, used_slots());
+         return *this;
+      }
+      dynamic_bitset &flip()
+      {
+         for (size_type i = 0; i < used_slots(); ++i)
+            bits_[i] = ~bits_[i];
+         trim();
+         return *this;
+      }
+
+      bool all() const { return count() == size_; }
+      bool any() const
+      {
+         for (size_type i = 0; i < used_slots(); ++i)
+            if (bits_[i])
+               return true;
+         return false;
+      }
+      bool none() const { return !any(); }
+      size_type count() const { return bitset_slots::count(bits_, used_slots(), (slot_type)-1); }
+
+      // the first set bit, or size() if none
+      size_type find_first() const { return bitset_slots::find_from(bits_, size_, 0); }
+      // the first set bit after pos, or size() if none
+      size_type find_next(size_type pos) const
+      {
+         return pos + 1 < size_ ? bitset_slots::find_from(bits_, size_, pos + 1): size_;
+      }
+      // calls visit(pos) for each set bit, in order, and returns visit
+      template<typename Visitor> Visitor for_each_set_bit(Visitor visit) const
+      {
+         return bitset_slots::for_each(bits_, size_, visit);
+      }
+
+      bool operator==(const dynamic_bitset &other) const;
+      bool operator!=(const dynamic_bitset &other) const { return !operator==(other); }
+
+      dynamic_bitset &operator&=(const dynamic_bitset &other)
+      {
+         bitset_slots::combine(bits_, other.bits_, used_slots(), bitset_slots::and_op());
+         return *this;
+      }
+      dynamic_bitset &operator|=(const dynamic_bitset &other)
+      {
+         bitset_slots::combine(bits_, other.bits_, used_slots(), bitset_slots::or_op());
+         return *this;
+      }
+      dynamic_bitset &operator^=(const dynamic_bitset &other)
+      {
+         bitset_slots::combine(bits_, other.bits_, used_slots(), bitset_slots::xor_op());
+         return *this;
+      }
+      // the set difference, *this & ~other
+      dynamic_bitset &operator-=(const dynamic_bitset &other)
+      {
+         bitset_slots::combine(bits_, other.bits_, used_slots(), bitset_slots::and_not_op());
+         return *this;
+      }
+      dynamic_bitset operator~() const { return dynamic_bitset(*this).flip(); }
+
+      dynamic_bitset &operator<<=(size_type pos)
+      {
+         bitset_slots::shift_left(bits_, used_slots(), pos);
+         trim();
+         return *this;
+      }
+      dynamic_bitset &operator>>=(size_type pos)
+      {
+         bitset_slots::shift_right(bits_, used_slots(), pos);
+         return *this;
+      }
+      dynamic_bitset operator<<(size_type pos) const { return dynamic_bitset(*this) <<= pos; }
+      dynamic_bitset operator>>(size_type pos) const { return dynamic_bitset(*this) >>= pos; }
+   };
+
+   template<typename Resource>
+   dynamic_bitset<Resource> &dynamic_bitset<Resource>::operator=(const dynamic_bitset &other)
+   {
+      if (this == &other)
+         return *this;
+      if (other.size_ > capacity())
+      {
+         Resource::deallocate(bits_, slots_ * sizeof(slot_type));
+         slots_ = other.used_slots();
+         bits_ = static_cast<slot_type *>(Resource::allocate(slots_ * sizeof(slot_type)));
+      }
+      size_ = other.size_;
+      for (size_type i = 0; i < used_slots(); ++i)
+         bits_[i] = other.bits_[i];
+      return *this;
+   }
+
+   template<typename Resource>
+   void dynamic_bitset<Resource>::reserve(size_type n)
+   {
+      const size_type slots = slots_for(n);
+      if (slots <= slots_)
+         return;
+      slot_type *bits = static_cast<slot_type *>(Resource::allocate(slots * sizeof(slot_type)));
+      for (size_type i = 0; i < used_slots(); ++i)
+         bits[i] = bits_[i];
+      Resource::deallocate(bits_, slots_ * sizeof(slot_type));
+      bits_ = bits;
+      slots_ = slots;
+   }
+
+   template<typename Resource>
+   void dynamic_bitset<Resource>::resize(size_type n, bool value)
+   {
+      if (n <= size_)
+      {
+         size_ = n;
+         trim();
+         return;
+      }
+      reserve(n);
+      const slot_type fill = value ? (slot_type)-1: 0;
+      // the rest of the last slot, then whole slots
+      if (size_ % slot_bits)
+         bits_[size_ / slot_bits] |= fill << size_ % slot_bits;
+      for (size_type i = used_slots(); i < slots_for(n); ++i)
+         bits_[i] = fill;
+      size_ = n;
+      trim();
+   }
+
+   template<typename Resource>
+   void dynamic_bitset<Resource>::append(slot_type word)
+   {
+      if (size_ + slot_bits > capacity())
+         grow(size_ + slot_bits);
+      const size_type s = size_ / slot_bits, shift = size_ % slot_bits;
+      if (!shift)
+         bits_[s] = word;
+      else
+      {
+         bits_[s] |= word << shift;
+         bits_[s + 1] = word >> (slot_bits - shift);
+      }
+      size_ += slot_bits;
+   }
+
+   template<typename Resource>
+   void dynamic_bitset<Resource>::append(const slot_type *words, size_type n)
+   {
+      reserve(size_ + n * slot_bits);
+      for (size_type i = 0; i < n; ++i)
+         append(words[i]);
+   }
+
+   template<typename Resource>
+   bool dynamic_bitset<Resource>::operator==(const dynamic_bitset &other) const
+   {
+      if (size_ != other.size_)
+         return false;
+      for (size_type i = 0; i < used_slots(); ++i)
+         if (bits_[i] != other.bits_[i])
+            return false;
+      return true;
+   }
+
+   template<typename Resource>
+   dynamic_bitset<Resource> operator&(const dynamic_bitset<Resource> &a, const dynamic_bitset<Resource> &b)
+   {
+      return dynamic_bitset<Resource>(a) &= b;
+   }
+   template<typename Resource>
+   dynamic_bitset<Resource> operator|(const dynamic_bitset<Resource> &a, const dynamic_bitset<Resource> &b)
+   {
+      return dynamic_bitset<Resource>(a) |= b;
+   }
+   template<typename Resource>
+   dynamic_bitset<Resource> operator^(const dynamic_bitset<Resource> &a, const dynamic_bitset<Resource> &b)
+   {
+      return dynamic_bitset<Resource>(a) ^= b;
+   }
+   template<typename Resource>
+   dynamic_bitset<Resource> operator-(const dynamic_bitset<Resource> &a, const dynamic_bitset<Resource> &b)
+   {
+      return dynamic_bitset<Resource>(a) -= b;
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_DYNAMIC_BITSET_HPP_
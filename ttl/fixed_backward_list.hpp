@@ -0,0 +1,316 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a single-linked list with O(1) insertion in
+// the back, as backward_list, with a fixed predefined storage of N
+// nodes. A queue, or a FIFO, that never allocates.
+//
+// The nodes are slist_node and live in a pool inside the list, as in
+// fixed_list: the inserts past N elements do nothing, insert_after()
+// returns end().
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FIXED_BACKWARD_LIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FIXED_BACKWARD_LIST_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "slist_node.hpp"
+#include "fixed_node_pool.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+
+   template<typename T, const ttl::size_t N>
+   class fixed_backward_list
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      struct node: slist_node
+      {
+         T value;
+         node(const T &v): value(v) {}
+      };
+      slist_node head_;
+      slist_node *tail_;
+      fixed_node_pool<node, N> pool_;
+
+      node *create_node(const T &v)
+      {
+         void *p = pool_.allocate();
+         return p ? ::new(p) node(v): 0;
+      }
+      void destroy_node(slist_node *n)
+      {
+         static_cast<node *>(n)->~node();
+         pool_.deallocate(n);
+      }
+      static T &value_of(slist_node *n) { return static_cast<node *>(n)->value; }
+      static const T &value_of(const slist_node *n) { return static_cast<const node *>(n)->value; }
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* head_ left uninitialized */ {}
+         ~iterator() {}
+         iterator &operator++() { head_ = head_->next; return *this; }
+         iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return static_cast<fixed_backward_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<fixed_backward_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const iterator &other) const { return head_ != other.head_; }
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         slist_node *head_;
+         friend class fixed_backward_list<T,N>;
+         iterator(slist_node *head): head_(head) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef fixed_backward_list<T,N>::iterator iterator;
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* head_ left uninitialized */ {}
+         const_iterator(const iterator &o): head_(o.head_) {}
+         ~const_iterator() {}
+         const_iterator &operator++() { head_ = head_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return static_cast<const fixed_backward_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const fixed_backward_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         friend class fixed_backward_list<T,N>;
+         friend class fixed_backward_list<T,N>::iterator;
+         const slist_node *head_;
+         const_iterator(const slist_node *head): head_(head) {}
+      };
+
+      fixed_backward_list()
+      {
+         head_.next = 0;
+         tail_ = &head_;
+      }
+      fixed_backward_list(const fixed_backward_list &other)
+      {
+         head_.next = 0;
+         tail_ = &head_;
+         insert_after(cbefore_begin(), other.cbegin(), other.cend());
+      }
+      fixed_backward_list(size_type n, const T &value)
+      {
+         head_.next = 0;
+         tail_ = &head_;
+         insert_after(cbefore_begin(), n, value);
+      }
+      template<typename InputIterator>
+      fixed_backward_list(InputIterator first, InputIterator last)
+      {
+         head_.next = 0;
+         tail_ = &head_;
+         insert_after(cbefore_begin(), first, last);
+      }
+      ~fixed_backward_list() { clear(); }
+
+      fixed_backward_list &operator=(const fixed_backward_list &other)
+      {
+         if (this != &other)
+         {
+            clear();
+            insert_after(cbefore_begin(), other.cbegin(), other.cend());
+         }
+         return *this;
+      }
+
+      iterator before_begin() { return iterator(&head_); }
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(0); }
+      iterator before_end() { return iterator(tail_); }
+      const_iterator before_begin() const { return const_iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(0); }
+      const_iterator before_end() const { return const_iterator(tail_); }
+      const_iterator cbefore_begin() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(0); }
+      const_iterator cbefore_end() const { return const_iterator(tail_); }
+
+      bool empty() const { return &head_ == tail_; }
+      bool full() const { return pool_.full(); }
+      size_type size() const { return pool_.size(); }
+      size_type max_size() const { return N; }
+      size_type capacity() const { return N; }
+
+      reference front() { return value_of(head_.next); }
+      const_reference front() const { return value_of(head_.next); }
+      reference back() { return value_of(tail_); }
+      const_reference back() const { return value_of(tail_); }
+
+      template<typename InputIterator>
+      void assign(InputIterator first, InputIterator last)
+      {
+         clear();
+         insert_after(cbefore_begin(), first, last);
+      }
+
+      void assign(size_type n, const T &value)
+      {
+         clear();
+         insert_after(cbefore_begin(), n, value);
+      }
+
+      void push_front(const T &value)
+      {
+         insert_after(cbefore_begin(), value);
+      }
+      void push_back(const T &value)
+      {
+         if (node *n = create_node(value))
+            tail_ = tail_->insert_after(n);
+      }
+
+      void pop_front()
+      {
+         destroy_node(head_.unlink_next());
+         if (!head_.next)
+            tail_ = &head_;
+      }
+
+      iterator insert_after(const_iterator pos, const T &value)
+      {
+         slist_node *pn = const_cast<slist_node *>(pos.head_);
+         node *n = create_node(value);
+         if (!n)
+            return end();
+         pn->insert_after(n);
+         if (pn == tail_)
+            tail_ = n;
+         return iterator(n);
+      }
+      void insert_after(const_iterator pos, size_type n, const T &value);
+      template<typename InputIterator>
+      void insert_after(const_iterator pos, InputIterator first, InputIterator last);
+
+      iterator erase_after(const_iterator pos)
+      {
+         slist_node *pn = const_cast<slist_node *>(pos.head_);
+         slist_node *p = pn->unlink_next();
+         if (p == tail_)
+            tail_ = pn;
+         destroy_node(p);
+         return iterator(pn->next);
+      }
+      iterator erase_after(const_iterator pos, const_iterator last);
+
+      void swap(fixed_backward_list &other);
+
+      void clear();
+
+      void reverse()
+      {
+         if (!empty())
+            tail_ = head_.next;
+         head_.reverse();
+      }
+   };
+   template<typename T, const ttl::size_t N>
+   void fixed_backward_list<T,N>::insert_after(const_iterator pos, size_type n, const T &value)
+   {
+      slist_node *pn = const_cast<slist_node *>(pos.head_);
+      slist_node *p = pn;
+      for (node *e; n-- && (e = create_node(value)) != 0;)
+         p = p->insert_after(e);
+      if (pn == tail_)
+         tail_ = p;
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename InputIterator>
+   void fixed_backward_list<T,N>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
+   {
+      slist_node *pn = const_cast<slist_node *>(pos.head_);
+      slist_node *p = pn;
+      for (node *e; first != last && (e = create_node(*first)) != 0; ++first)
+         p = p->insert_after(e);
+      if (pn == tail_)
+         tail_ = p;
+   }
+   template<typename T, const ttl::size_t N>
+   typename fixed_backward_list<T,N>::iterator fixed_backward_list<T,N>::erase_after(const_iterator pos, const_iterator last)
+   {
+      slist_node *p = const_cast<slist_node *>(pos.head_);
+      while (p->next != last.head_)
+         destroy_node(p->unlink_next());
+      if (!last.head_)
+         tail_ = p;
+      return iterator(p->next);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_backward_list<T,N>::swap(fixed_backward_list &other)
+   {
+      slist_node *a = &head_, *b = &other.head_;
+      for (; a->next && b->next; a = a->next, b = b->next)
+         ttl::swap(value_of(a->next), value_of(b->next));
+      // the rest of the longer list moves to the back of the other one
+      while (b->next)
+      {
+         push_back(value_of(b->next));
+         other.erase_after(const_iterator(b));
+         a = tail_;
+      }
+      while (a->next)
+      {
+         other.push_back(value_of(a->next));
+         erase_after(const_iterator(a));
+      }
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_backward_list<T,N>::clear()
+   {
+      for (slist_node *p = head_.next; p; p = p->next)
+         static_cast<node *>(p)->~node();
+      head_.next = 0;
+      tail_ = &head_;
+      pool_.clear();
+   }
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename T, const ttl::size_t N>
+   bool operator==(const fixed_backward_list<T,N> &a, const fixed_backward_list<T,N> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template <typename T, const ttl::size_t N>
+   bool operator!=(const fixed_backward_list<T,N> &a, const fixed_backward_list<T,N> &b)
+   {
+      return !(a == b);
+   }
+}
+#endif // _TINY_TEMPLATE_LIBRARY_FIXED_BACKWARD_LIST_HPP_
@@ -0,0 +1,416 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an implementation of STL forward_list with a
+// fixed predefined storage of N nodes
+//
+// The nodes are slist_node and live in a pool inside the list, as in
+// fixed_list: the inserts past N elements do nothing, insert_after()
+// returns end(), and splice_after() and merge() from another list copy
+// the values.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FIXED_FORWARD_LIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FIXED_FORWARD_LIST_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "slist_node.hpp"
+#include "fixed_node_pool.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+
+   template<typename T, const ttl::size_t N>
+   class fixed_forward_list
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      struct node: slist_node
+      {
+         T value;
+         node() {}
+         node(const T &v): value(v) {}
+      };
+      slist_node head_;
+      fixed_node_pool<node, N> pool_;
+
+      node *create_node()
+      {
+         void *p = pool_.allocate();
+         return p ? ::new(p) node: 0;
+      }
+      node *create_node(const T &v)
+      {
+         void *p = pool_.allocate();
+         return p ? ::new(p) node(v): 0;
+      }
+      void destroy_node(slist_node *n)
+      {
+         static_cast<node *>(n)->~node();
+         pool_.deallocate(n);
+      }
+      static T &value_of(slist_node *n) { return static_cast<node *>(n)->value; }
+      static const T &value_of(const slist_node *n) { return static_cast<const node *>(n)->value; }
+
+      // copies the value after o of the other list after pos and erases
+      // it, returns the new node or 0 if there is no room
+      slist_node *take_after(slist_node *pos, fixed_forward_list &other, slist_node *o)
+      {
+         node *n = create_node(value_of(o->next));
+         if (!n)
+            return 0;
+         pos->insert_after(n);
+         other.destroy_node(o->unlink_next());
+         return n;
+      }
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* head_ left uninitialized */ {}
+         ~iterator() {}
+         iterator &operator++() { head_ = head_->next; return *this; }
+         iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return static_cast<fixed_forward_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<fixed_forward_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const iterator &other) const { return head_ != other.head_; }
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         slist_node *head_;
+         friend class fixed_forward_list<T,N>;
+         iterator(slist_node *head): head_(head) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef fixed_forward_list<T,N>::iterator iterator;
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* head_ left uninitialized */ {}
+         const_iterator(const iterator &o): head_(o.head_) {}
+         ~const_iterator() {}
+         const_iterator &operator++() { head_ = head_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return static_cast<const fixed_forward_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const fixed_forward_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         friend class fixed_forward_list<T,N>;
+         friend class fixed_forward_list<T,N>::iterator;
+         const slist_node *head_;
+         const_iterator(const slist_node *head): head_(head) {}
+      };
+
+      fixed_forward_list() { head_.next = 0; }
+      fixed_forward_list(const fixed_forward_list &other)
+      {
+         head_.next = 0;
+         insert_after(cbefore_begin(), other.cbegin(), other.cend());
+      }
+      fixed_forward_list(size_type n, const T &value)
+      {
+         head_.next = 0;
+         insert_after(cbefore_begin(), n, value);
+      }
+      template<typename InputIterator>
+      fixed_forward_list(InputIterator first, InputIterator last)
+      {
+         head_.next = 0;
+         insert_after(cbefore_begin(), first, last);
+      }
+      ~fixed_forward_list() { clear(); }
+
+      fixed_forward_list &operator=(const fixed_forward_list &other)
+      {
+         if (this != &other)
+         {
+            clear();
+            insert_after(cbefore_begin(), other.cbegin(), other.cend());
+         }
+         return *this;
+      }
+
+      iterator before_begin() { return iterator(&head_); }
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(0); }
+      const_iterator before_begin() const { return const_iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(0); }
+      const_iterator cbefore_begin() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(0); }
+
+      bool empty() const { return !head_.next; }
+      bool full() const { return pool_.full(); }
+      size_type size() const { return pool_.size(); }
+      size_type max_size() const { return N; }
+      size_type capacity() const { return N; }
+
+      reference front() { return value_of(head_.next); }
+      const_reference front() const { return value_of(head_.next); }
+
+      template<typename InputIterator>
+      void assign(InputIterator first, InputIterator last)
+      {
+         clear();
+         insert_after(cbefore_begin(), first, last);
+      }
+
+      void assign(size_type n, const T &value)
+      {
+         clear();
+         insert_after(cbefore_begin(), n, value);
+      }
+
+      void push_front(const T &value)
+      {
+         if (node *n = create_node(value))
+            head_.insert_after(n);
+      }
+
+      void pop_front()
+      {
+         destroy_node(head_.unlink_next());
+      }
+
+      void splice_after(const_iterator pos, fixed_forward_list &other)
+      {
+         if (&other != this)
+            splice_after(pos, other, other.cbefore_begin(), other.cend());
+      }
+      void splice_after(const_iterator pos, fixed_forward_list &other, const_iterator it)
+      {
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         slist_node *o = const_cast<slist_node *>(it.head_);
+         if (&other != this)
+            take_after(p, other, o);
+         else if (o != p)
+            p->splice_after(o);
+      }
+      void splice_after(const_iterator pos, fixed_forward_list &other, const_iterator first, const_iterator last);
+
+      iterator insert_after(const_iterator pos, const T &value)
+      {
+         node *n = create_node(value);
+         return iterator(n ? const_cast<slist_node *>(pos.head_)->insert_after(n): 0);
+      }
+      void insert_after(const_iterator pos, size_type n, const T &value);
+      template<typename InputIterator>
+      void insert_after(const_iterator pos, InputIterator first, InputIterator last);
+
+      iterator erase_after(const_iterator pos)
+      {
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         destroy_node(p->unlink_next());
+         return iterator(p->next);
+      }
+      iterator erase_after(const_iterator pos, const_iterator last);
+
+      void swap(fixed_forward_list &other);
+
+      void resize(size_type);
+      void resize(size_type, const T &value);
+
+      void clear();
+
+      void remove(const T &);
+      template<typename Predicate>
+      void remove_if(Predicate);
+
+      void unique();
+      template<typename BinaryPredicate>
+      void unique(BinaryPredicate);
+
+      void merge(fixed_forward_list &); // merge sorted lists
+      template<typename Compare>
+      void merge(fixed_forward_list &, Compare);
+
+      void reverse()
+      {
+         head_.reverse();
+      }
+   };
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::splice_after(const_iterator pos, fixed_forward_list &other, const_iterator first, const_iterator last)
+   {
+      slist_node *p = const_cast<slist_node *>(pos.head_);
+      slist_node *f = const_cast<slist_node *>(first.head_);
+      if (!f || f->next == last.head_)
+         return;
+      if (&other == this)
+      {
+         p->splice_after(f, const_cast<slist_node *>(last.head_));
+         return;
+      }
+      while (f->next != last.head_ && (p = take_after(p, other, f)) != 0)
+         ;
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::insert_after(const_iterator pos, size_type n, const T &value)
+   {
+      slist_node *p = const_cast<slist_node *>(pos.head_);
+      for (node *e; n-- && (e = create_node(value)) != 0;)
+         p = p->insert_after(e);
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename InputIterator>
+   void fixed_forward_list<T,N>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
+   {
+      slist_node *p = const_cast<slist_node *>(pos.head_);
+      for (node *e; first != last && (e = create_node(*first)) != 0; ++first)
+         p = p->insert_after(e);
+   }
+   template<typename T, const ttl::size_t N>
+   typename fixed_forward_list<T,N>::iterator fixed_forward_list<T,N>::erase_after(const_iterator pos, const_iterator last)
+   {
+      slist_node *p = const_cast<slist_node *>(pos.head_);
+      while (p->next != last.head_)
+         destroy_node(p->unlink_next());
+      return iterator(p->next);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::swap(fixed_forward_list &other)
+   {
+      slist_node *a = &head_, *b = &other.head_;
+      for (; a->next && b->next; a = a->next, b = b->next)
+         ttl::swap(value_of(a->next), value_of(b->next));
+      // the rest of the longer list moves, it fits into the other one
+      while (b->next)
+         a = take_after(a, other, b);
+      while (a->next)
+         b = other.take_after(b, *this, a);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::resize(size_type newsize)
+   {
+      slist_node *p = &head_;
+      for (; newsize && p->next; --newsize)
+         p = p->next;
+      erase_after(const_iterator(p), cend());
+      for (node *e; newsize-- && (e = create_node()) != 0;)
+         p = p->insert_after(e);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::resize(size_type newsize, const T &value)
+   {
+      slist_node *p = &head_;
+      for (; newsize && p->next; --newsize)
+         p = p->next;
+      erase_after(const_iterator(p), cend());
+      insert_after(const_iterator(p), newsize, value);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::clear()
+   {
+      for (slist_node *p = head_.next; p; p = p->next)
+         static_cast<node *>(p)->~node();
+      head_.next = 0;
+      pool_.clear();
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::remove(const T &value)
+   {
+      for (slist_node *p = &head_; p->next;)
+         if (value_of(p->next) == value)
+            destroy_node(p->unlink_next());
+         else
+            p = p->next;
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename Predicate>
+   void fixed_forward_list<T,N>::remove_if(Predicate pred)
+   {
+      for (slist_node *p = &head_; p->next;)
+         if (pred(value_of(p->next)))
+            destroy_node(p->unlink_next());
+         else
+            p = p->next;
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::unique()
+   {
+      for (slist_node *p = head_.next; p && p->next;)
+         if (value_of(p->next) == value_of(p))
+            destroy_node(p->unlink_next());
+         else
+            p = p->next;
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename BinaryPredicate>
+   void fixed_forward_list<T,N>::unique(BinaryPredicate pred)
+   {
+      for (slist_node *p = head_.next; p && p->next;)
+         if (pred(value_of(p->next), value_of(p)))
+            destroy_node(p->unlink_next());
+         else
+            p = p->next;
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_forward_list<T,N>::merge(fixed_forward_list &other)
+   {
+      if (&other == this)
+         return;
+      slist_node *i = &head_;
+      for (; other.head_.next && i->next; i = i->next)
+         if (value_of(other.head_.next) < value_of(i->next) && !take_after(i, other, &other.head_))
+            return;
+      while (other.head_.next && (i = take_after(i, other, &other.head_)) != 0)
+         ;
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename Compare>
+   void fixed_forward_list<T,N>::merge(fixed_forward_list &other, Compare cmp)
+   {
+      if (&other == this)
+         return;
+      slist_node *i = &head_;
+      for (; other.head_.next && i->next; i = i->next)
+         if (cmp(value_of(other.head_.next), value_of(i->next)) && !take_after(i, other, &other.head_))
+            return;
+      while (other.head_.next && (i = take_after(i, other, &other.head_)) != 0)
+         ;
+   }
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename T, const ttl::size_t N>
+   bool operator==(const fixed_forward_list<T,N> &a, const fixed_forward_list<T,N> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template <typename T, const ttl::size_t N>
+   bool operator!=(const fixed_forward_list<T,N> &a, const fixed_forward_list<T,N> &b)
+   {
+      return !(a == b);
+   }
+}
+#endif // _TINY_TEMPLATE_LIBRARY_FIXED_FORWARD_LIST_HPP_
@@ -0,0 +1,482 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an implementation of STL list with a fixed
+// predefined storage of N nodes
+//
+// The nodes are the list_node of ttl::list and live in a pool inside the
+// list, no operation allocates. The inserts past N elements do nothing:
+// push_front() and push_back() drop the value, insert() returns end().
+// The nodes of a list cannot move to another one, so splice() and
+// merge() from another list copy the values it has room for and erase
+// them from the other list; swap() swaps the values.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FIXED_LIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FIXED_LIST_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "list.hpp"
+#include "fixed_node_pool.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+
+   template<typename T, const ttl::size_t N>
+   class fixed_list
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      struct node: list_node
+      {
+         T value;
+         node() {}
+         node(const T &v): value(v) {}
+      };
+      list_node head_;
+      fixed_node_pool<node, N> pool_;
+
+      node *create_node()
+      {
+         void *p = pool_.allocate();
+         return p ? ::new(p) node: 0;
+      }
+      node *create_node(const T &v)
+      {
+         void *p = pool_.allocate();
+         return p ? ::new(p) node(v): 0;
+      }
+      void destroy_node(list_node *n)
+      {
+         static_cast<node *>(n)->~node();
+         pool_.deallocate(n);
+      }
+      static T &value_of(list_node *n) { return static_cast<node *>(n)->value; }
+      static const T &value_of(const list_node *n) { return static_cast<const node *>(n)->value; }
+
+      // copies the value of o of the other list before pos and erases o,
+      // false if there is no room
+      bool take(list_node *pos, fixed_list &other, list_node *o)
+      {
+         node *n = create_node(value_of(o));
+         if (!n)
+            return false;
+         pos->insert_before(n);
+         o->unlink();
+         other.destroy_node(o);
+         return true;
+      }
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* head_ left uninitialized */ {}
+         ~iterator() {}
+         iterator &operator++() { head_ = head_->next; return *this; }
+         iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
+         iterator &operator--() { head_ = head_->prev; return *this; }
+         iterator operator--(int) { iterator tmp(head_); head_ = head_->prev; return tmp; }
+         reference operator*() const { return static_cast<fixed_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<fixed_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const iterator &other) const { return head_ != other.head_; }
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         list_node *head_;
+         friend class fixed_list<T,N>;
+         iterator(list_node *head): head_(head) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef fixed_list<T,N>::iterator iterator;
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* head_ left uninitialized */ {}
+         const_iterator(const iterator &o): head_(o.head_) {}
+         ~const_iterator() {}
+         const_iterator &operator++() { head_ = head_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
+         const_iterator &operator--() { head_ = head_->prev; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(head_); head_ = head_->prev; return tmp; }
+         reference operator*() const { return static_cast<const fixed_list<T,N>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const fixed_list<T,N>::node *>(head_)->value; }
+
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         friend class fixed_list<T,N>;
+         friend class fixed_list<T,N>::iterator;
+         const list_node *head_;
+         const_iterator(const list_node *head): head_(head) {}
+      };
+
+      fixed_list() { head_.init(); }
+      fixed_list(const fixed_list &other)
+      {
+         head_.init();
+         insert(cend(), other.cbegin(), other.cend());
+      }
+      fixed_list(size_type n, const T &value)
+      {
+         head_.init();
+         insert(cend(), n, value);
+      }
+      template<typename InputIterator>
+      fixed_list(InputIterator first, InputIterator last)
+      {
+         head_.init();
+         insert(cend(), first, last);
+      }
+      ~fixed_list() { clear(); }
+
+      fixed_list &operator=(const fixed_list &other)
+      {
+         if (this != &other)
+         {
+            clear();
+            insert(cend(), other.cbegin(), other.cend());
+         }
+         return *this;
+      }
+
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(&head_); }
+
+      bool empty() const { return head_.next == &head_; }
+      bool full() const { return pool_.full(); }
+      size_type size() const { return pool_.size(); }
+      size_type max_size() const { return N; }
+      size_type capacity() const { return N; }
+
+      reference front() { return value_of(head_.next); }
+      const_reference front() const { return value_of(head_.next); }
+      reference back() { return value_of(head_.prev); }
+      const_reference back() const { return value_of(head_.prev); }
+
+      template<typename InputIterator>
+      void assign(InputIterator first, InputIterator last)
+      {
+         clear();
+         insert(cend(), first, last);
+      }
+
+      void assign(size_type n, const T &value)
+      {
+         clear();
+         insert(cend(), n, value);
+      }
+
+      void push_front(const T &value)
+      {
+         if (node *n = create_node(value))
+            head_.next->insert_before(n);
+      }
+
+      void push_back(const T &value)
+      {
+         if (node *n = create_node(value))
+            head_.insert_before(n);
+      }
+
+      void pop_front()
+      {
+         list_node *p = head_.next;
+         p->unlink();
+         destroy_node(p);
+      }
+
+      void pop_back()
+      {
+         list_node *p = head_.prev;
+         p->unlink();
+         destroy_node(p);
+      }
+
+      void splice(const_iterator pos, fixed_list &other)
+      {
+         if (&other != this)
+            splice(pos, other, other.cbegin(), other.cend());
+      }
+      void splice(const_iterator pos, fixed_list &other, const_iterator it)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         list_node *o = const_cast<list_node *>(it.head_);
+         if (&other != this)
+            take(p, other, o);
+         else if (o != p)
+            p->splice(o, o->next);
+      }
+      void splice(const_iterator pos, fixed_list &other, const_iterator first, const_iterator last);
+
+      iterator insert(const_iterator pos, const T &value)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         node *n = create_node(value);
+         return n ? iterator(p->insert_before(n)): end();
+      }
+      void insert(const_iterator pos, size_type n, const T &value);
+      template<typename InputIterator>
+      void insert(const_iterator pos, InputIterator first, InputIterator last);
+
+      iterator erase(const_iterator pos)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         list_node *next = p->next;
+         p->unlink();
+         destroy_node(p);
+         return iterator(next);
+      }
+      iterator erase(const_iterator pos, const_iterator last);
+
+      void swap(fixed_list &other);
+
+      void resize(size_type);
+      void resize(size_type, const T &value);
+
+      void clear();
+
+      void remove(const T &value);
+      template<typename Predicate>
+      void remove_if(Predicate);
+
+      void unique();
+      template<typename BinaryPredicate>
+      void unique(BinaryPredicate);
+
+      void merge(fixed_list &);
+      template<typename Compare>
+      void merge(fixed_list &, Compare);
+
+      void reverse()
+      {
+         head_.reverse();
+      }
+   };
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::splice(const_iterator pos, fixed_list &other, const_iterator first, const_iterator last)
+   {
+      list_node *p = const_cast<list_node *>(pos.head_);
+      list_node *f = const_cast<list_node *>(first.head_);
+      if (&other == this)
+      {
+         // before last the range would stay where it is
+         if (f != last.head_ && p != last.head_)
+            p->splice(f, const_cast<list_node *>(last.head_));
+         return;
+      }
+      while (f != last.head_)
+      {
+         list_node *next = f->next;
+         if (!take(p, other, f))
+            break;
+         f = next;
+      }
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::insert(const_iterator pos, size_type n, const T &value)
+   {
+      list_node *p = const_cast<list_node *>(pos.head_);
+      for (node *e; n-- && (e = create_node(value)) != 0;)
+         p->insert_before(e);
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename InputIterator>
+   void fixed_list<T,N>::insert(const_iterator pos, InputIterator first, InputIterator last)
+   {
+      list_node *p = const_cast<list_node *>(pos.head_);
+      for (node *e; first != last && (e = create_node(*first)) != 0; ++first)
+         p->insert_before(e);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::resize(size_type newsize)
+   {
+      size_type siz = size();
+      for (; siz > newsize; --siz)
+         pop_back();
+      for (node *e; siz < newsize && (e = create_node()) != 0; ++siz)
+         head_.insert_before(e);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::resize(size_type newsize, const T &value)
+   {
+      size_type siz = size();
+      for (; siz > newsize; --siz)
+         pop_back();
+      insert(cend(), newsize - siz, value);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::clear()
+   {
+      for (list_node *p = head_.next; p != &head_; p = p->next)
+         static_cast<node *>(p)->~node();
+      head_.init();
+      pool_.clear();
+   }
+   template<typename T, const ttl::size_t N>
+   typename fixed_list<T,N>::iterator fixed_list<T,N>::erase(const_iterator pos, const_iterator last)
+   {
+      list_node *p = const_cast<list_node *>(pos.head_);
+      while (p != last.head_)
+      {
+         list_node *next = p->next;
+         p->unlink();
+         destroy_node(p);
+         p = next;
+      }
+      return iterator(p);
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::swap(fixed_list &other)
+   {
+      list_node *a = head_.next, *b = other.head_.next;
+      for (; a != &head_ && b != &other.head_; a = a->next, b = b->next)
+         ttl::swap(value_of(a), value_of(b));
+      // the rest of the longer list moves, it fits into the other one
+      while (b != &other.head_)
+      {
+         list_node *next = b->next;
+         take(&head_, other, b);
+         b = next;
+      }
+      while (a != &head_)
+      {
+         list_node *next = a->next;
+         other.take(&other.head_, *this, a);
+         a = next;
+      }
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::remove(const T &value)
+   {
+      for (list_node *p = head_.next, *n = p->next; p != &head_; p = n, n = n->next)
+         if (static_cast<const node *>(p)->value == value)
+         {
+            p->unlink();
+            destroy_node(p);
+         }
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename Predicate>
+   void fixed_list<T,N>::remove_if(Predicate pred)
+   {
+      for (list_node *p = head_.next, *n = p->next; p != &head_; p = n, n = n->next)
+         if (pred(static_cast<const node *>(p)->value))
+         {
+            p->unlink();
+            destroy_node(p);
+         }
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::unique()
+   {
+      list_node *prev = head_.next;
+      for (list_node *p = prev->next, *n = p->next; p != &head_; p = n, n = n->next)
+         if (value_of(p) == value_of(prev))
+         {
+            p->unlink();
+            destroy_node(p);
+         }
+         else
+            prev = p;
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename BinaryPredicate>
+   void fixed_list<T,N>::unique(BinaryPredicate pred)
+   {
+      list_node *prev = head_.next;
+      for (list_node *p = prev->next, *n = p->next; p != &head_; p = n, n = n->next)
+         if (pred(value_of(p), value_of(prev)))
+         {
+            p->unlink();
+            destroy_node(p);
+         }
+         else
+            prev = p;
+   }
+   template<typename T, const ttl::size_t N>
+   void fixed_list<T,N>::merge(fixed_list &other) // merge sorted lists
+   {
+      if (&other == this)
+         return;
+      list_node *o = other.head_.next;
+      for (list_node *i = head_.next; o != &other.head_ && i != &head_;)
+      {
+         if (value_of(o) < value_of(i))
+         {
+            list_node *on = o->next;
+            if (!take(i, other, o))
+               return;
+            o = on;
+         }
+         else
+            i = i->next;
+      }
+      splice(cend(), other);
+   }
+   template<typename T, const ttl::size_t N>
+   template<typename Compare>
+   void fixed_list<T,N>::merge(fixed_list &other, Compare cmp)
+   {
+      if (&other == this)
+         return;
+      list_node *o = other.head_.next;
+      for (list_node *i = head_.next; o != &other.head_ && i != &head_;)
+      {
+         if (cmp(value_of(o), value_of(i)))
+         {
+            list_node *on = o->next;
+            if (!take(i, other, o))
+               return;
+            o = on;
+         }
+         else
+            i = i->next;
+      }
+      splice(cend(), other);
+   }
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename T, const ttl::size_t N>
+   bool operator==(const fixed_list<T,N> &a, const fixed_list<T,N> &b)
+   {
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
+   }
+   template <typename T, const ttl::size_t N>
+   bool operator!=(const fixed_list<T,N> &a, const fixed_list<T,N> &b)
+   {
+      return !(a == b);
+   }
+}
+#endif // _TINY_TEMPLATE_LIBRARY_FIXED_LIST_HPP_
@@ -0,0 +1,76 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: the storage of N nodes of the fixed lists
+//
+// The nodes are an array inside the pool, the free nodes are linked
+// through their own memory. The array is handed out from its start
+// first, so a new pool costs nothing to construct whatever N is, and
+// allocate() and deallocate() are a pop and a push of the free list.
+// allocate() returns 0 when all N nodes are in use.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FIXED_NODE_POOL_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FIXED_NODE_POOL_HPP_ 1
+
+#include "types.hpp"
+#include "slist_node.hpp"
+
+namespace ttl
+{
+   template<class Node, const ttl::size_t N>
+   class fixed_node_pool
+   {
+      union slot
+      {
+         char bytes[sizeof(Node)];
+         slist_node free;
+         // the alignment of the fundamental types
+         void *p;
+         long long ll;
+         double d;
+      };
+
+      slot slots_[N];
+      slist_node free_;
+      ttl::size_t fresh_; // the slots from fresh_ on were never used
+      ttl::size_t used_;
+
+      fixed_node_pool(const fixed_node_pool &);
+      fixed_node_pool &operator=(const fixed_node_pool &);
+
+   public:
+      fixed_node_pool(): fresh_(0), used_(0) { free_.next = 0; }
+
+      void *allocate()
+      {
+         if (free_.next)
+         {
+            ++used_;
+            return free_.unlink_next();
+         }
+         if (fresh_ == N)
+            return 0;
+         ++used_;
+         return slots_ + fresh_++;
+      }
+      void deallocate(void *p)
+      {
+         --used_;
+         free_.insert_after(&static_cast<slot *>(p)->free);
+      }
+
+      // forgets all the nodes at once, their values must be destroyed
+      void clear()
+      {
+         free_.next = 0;
+         fresh_ = used_ = 0;
+      }
+
+      ttl::size_t size() const { return used_; }
+      bool empty() const { return !used_; }
+      bool full() const { return used_ == N; }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_FIXED_NODE_POOL_HPP_
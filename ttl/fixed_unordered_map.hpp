@@ -0,0 +1,383 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a hash map of at most N unique keys in a fixed
+// predefined storage, no operation allocates.
+//
+// The values are kept in an open addressing table of a power of two
+// slots, at least N + N / 4 + 1, so at most 80% of it is used and one
+// slot at least is always empty. The collisions are resolved with
+// Robin Hood linear probing: a key is inserted before the first key
+// closer to its home slot, so the keys of one home slot are contiguous
+// and a lookup stops at the first key closer to its home than the key
+// looked up would be. An erase shifts the following keys one slot back
+// instead of leaving a tombstone, so the probe lengths never degrade.
+// The distances of the keys from their home slots are kept apart from
+// the values in the smallest unsigned type that holds them, the probes
+// scan them and compare a key only at the slots of its home.
+//
+// Like fixed_vector, the map does nothing when it is full: insert() of
+// a new key returns (end(), false). operator[] of a new key needs room.
+// An insert moves the values and invalidates the iterators, an erase
+// invalidates only the iterators to the erased value; erase(pos) returns
+// the next position and visits every value once.
+//
+// The keys are hashed with Hash, hash<KT> by default, and compared with
+// KeyEqual.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FIXED_UNORDERED_MAP_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FIXED_UNORDERED_MAP_HPP_ 1
+
+#include <new>
+#include <string.h>
+#include "types.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+
+namespace ttl
+{
+   // the smallest power of two not less than N
+   template<ttl::size_t N, ttl::size_t P = 1, bool = (P >= N)>
+   struct _pow2_at_least
+   {
+      static const ttl::size_t value = _pow2_at_least<N, P * 2>::value;
+   };
+   template<ttl::size_t N, ttl::size_t P>
+   struct _pow2_at_least<N, P, true>
+   {
+      static const ttl::size_t value = P;
+   };
+
+   // an unsigned type for the numbers up to N
+   template<ttl::size_t N, bool = (N < 256), bool = (N < 65536)>
+   struct _uint_for { typedef unsigned int type; };
+   template<ttl::size_t N>
+   struct _uint_for<N, false, true> { typedef unsigned short type; };
+   template<ttl::size_t N>
+   struct _uint_for<N, true, true> { typedef unsigned char type; };
+
+   template<typename KT, typename T, const ttl::size_t N, typename Hash = hash<KT>, typename KeyEqual = equal_to<KT> >
+   class fixed_unordered_map
+   {
+   public:
+      typedef KT key_type;
+      typedef T mapped_type;
+      typedef pair<const KT, T> value_type;
+      typedef Hash hasher;
+      typedef KeyEqual key_equal;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+
+   private:
+      static const size_type slots = _pow2_at_least<N + N / 4 + 1>::value;
+      static const size_type mask = slots - 1;
+
+      // 0 for an empty slot, else 1 + the distance from the home slot
+      typedef typename _uint_for<slots>::type distance_type;
+
+      distance_type dist_[slots];
+      union { char b[sizeof(value_type)]; void *p; long long ll; double d; } values_[slots];
+      size_type size_;
+      mutable size_type origin_; // an empty slot, the iteration goes round from it
+
+      value_type &value(size_type i) { return *reinterpret_cast<value_type *>(values_[i].b); }
+      const value_type &value(size_type i) const { return *reinterpret_cast<const value_type *>(values_[i].b); }
+      static size_type home(const KT &key) { return Hash()(key) & mask; }
+
+      // the slot of the key, or slots and where the key would be inserted
+      size_type probe(const KT &key, size_type &pos, distance_type &d) const
+      {
+         size_type i = home(key);
+         for (d = 1; dist_[i] >= d; ++d, i = (i + 1) & mask)
+            if (dist_[i] == d && KeyEqual()(value(i).first, key))
+               return i;
+         pos = i;
+         return slots;
+      }
+      size_type lookup(const KT &key) const
+      {
+         size_type pos;
+         distance_type d;
+         return probe(key, pos, d);
+      }
+
+      // moves the keys from pos to the next empty slot one slot further
+      // and creates the value at pos
+      size_type place(size_type pos, distance_type d, const value_type &v)
+      {
+         size_type e = pos;
+         while (dist_[e])
+            e = (e + 1) & mask;
+         for (; e != pos; e = (e - 1) & mask)
+         {
+            const size_type f = (e - 1) & mask;
+            ::new(values_[e].b) value_type(value(f));
+            value(f).~value_type();
+            dist_[e] = dist_[f] + 1;
+         }
+         ::new(values_[pos].b) value_type(v);
+         dist_[pos] = d;
+         ++size_;
+         return pos;
+      }
+
+      // erases the value at i and shifts the following keys one slot back
+      void remove(size_type i)
+      {
+         value(i).~value_type();
+         for (size_type j = (i + 1) & mask; dist_[j] > 1; i = j, j = (j + 1) & mask)
+         {
+            ::new(values_[i].b) value_type(value(j));
+            value(j).~value_type();
+            dist_[i] = dist_[j] - 1;
+         }
+         dist_[i] = 0;
+         --size_;
+      }
+
+      size_type origin() const
+      {
+         if (dist_[origin_])
+            for (origin_ = 0; dist_[origin_]; ++origin_)
+               ;
+         return origin_;
+      }
+      // the next value after the slot i, or slots after the last one
+      size_type next(size_type i) const
+      {
+         const size_type o = origin();
+         do
+         {
+            i = (i + 1) & mask;
+            if (i == o)
+               return slots;
+         }
+         while (!dist_[i]);
+         return i;
+      }
+
+      void copy(const fixed_unordered_map &other)
+      {
+         for (size_type i = 0; i < slots; ++i)
+            if ((dist_[i] = other.dist_[i]) != 0)
+               ::new(values_[i].b) value_type(other.value(i));
+         size_ = other.size_;
+         origin_ = other.origin_;
+      }
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef fixed_unordered_map<KT,T,N,Hash,KeyEqual>::value_type value_type;
+         typedef value_type *pointer;
+         typedef value_type &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* left uninitialized */ {}
+         iterator &operator++() { i_ = m_->next(i_); return *this; }
+         iterator operator++(int) { iterator tmp(*this); i_ = m_->next(i_); return tmp; }
+         reference operator*() const { return m_->value(i_); }
+         pointer operator->() const { return &m_->value(i_); }
+
+         bool operator==(const iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const iterator &other) const { return i_ != other.i_; }
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+
+      private:
+         friend class fixed_unordered_map<KT,T,N,Hash,KeyEqual>;
+         friend class fixed_unordered_map<KT,T,N,Hash,KeyEqual>::const_iterator;
+         fixed_unordered_map *m_;
+         size_type i_;
+         iterator(fixed_unordered_map *m, size_type i): m_(m), i_(i) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef fixed_unordered_map<KT,T,N,Hash,KeyEqual>::value_type value_type;
+         typedef const value_type *pointer;
+         typedef const value_type &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* left uninitialized */ {}
+         const_iterator(const iterator &o): m_(o.m_), i_(o.i_) {}
+         const_iterator &operator++() { i_ = m_->next(i_); return *this; }
+         const_iterator operator++(int) { const_iterator tmp(*this); i_ = m_->next(i_); return tmp; }
+         reference operator*() const { return m_->value(i_); }
+         pointer operator->() const { return &m_->value(i_); }
+
+         bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+
+      private:
+         friend class fixed_unordered_map<KT,T,N,Hash,KeyEqual>;
+         friend class fixed_unordered_map<KT,T,N,Hash,KeyEqual>::iterator;
+         const fixed_unordered_map *m_;
+         size_type i_;
+         const_iterator(const fixed_unordered_map *m, size_type i): m_(m), i_(i) {}
+      };
+
+      fixed_unordered_map():
+         size_(0), origin_(0)
+      {
+         memset(dist_, 0, sizeof(dist_));
+      }
+      fixed_unordered_map(const fixed_unordered_map &other)
+      {
+         copy(other);
+      }
+      template<typename InputIterator>
+      fixed_unordered_map(InputIterator first, InputIterator last):
+         size_(0), origin_(0)
+      {
+         memset(dist_, 0, sizeof(dist_));
+         insert(first, last);
+      }
+      ~fixed_unordered_map() { clear(); }
+
+      fixed_unordered_map &operator=(const fixed_unordered_map &other)
+      {
+         if (this != &other)
+         {
+            clear();
+            copy(other);
+         }
+         return *this;
+      }
+
+      iterator begin() { return iterator(this, next(origin())); }
+      iterator end() { return iterator(this, slots); }
+      const_iterator begin() const { return const_iterator(this, next(origin())); }
+      const_iterator end() const { return const_iterator(this, slots); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      bool empty() const { return !size_; }
+      bool full() const { return size_ == N; }
+      size_type size() const { return size_; }
+      size_type max_size() const { return N; }
+      size_type capacity() const { return N; }
+      size_type bucket_count() const { return slots; }
+
+      // the key must be in the map, or the map must not be full
+      T &operator[](const KT &key)
+      {
+         size_type pos;
+         distance_type d;
+         size_type i = probe(key, pos, d);
+         if (i == slots)
+            i = place(pos, d, value_type(key, T()));
+         return value(i).second;
+      }
+
+      pair<iterator, bool> insert(const value_type &v)
+      {
+         size_type pos;
+         distance_type d;
+         const size_type i = probe(v.first, pos, d);
+         if (i != slots)
+            return pair<iterator, bool>(iterator(this, i), false);
+         if (full())
+            return pair<iterator, bool>(end(), false);
+         return pair<iterator, bool>(iterator(this, place(pos, d, v)), true);
+      }
+      template<typename InputIterator>
+      void insert(InputIterator first, InputIterator last)
+      {
+         for (; first != last; ++first)
+            insert(*first);
+      }
+
+      iterator erase(const_iterator pos)
+      {
+         const size_type i = pos.i_;
+         remove(i);
+         // a following value shifted into i is not visited yet
+         return iterator(this, dist_[i] ? i: next(i));
+      }
+      size_type erase(const KT &key)
+      {
+         const size_type i = lookup(key);
+         if (i == slots)
+            return 0;
+         remove(i);
+         return 1;
+      }
+
+      iterator find(const KT &key) { return iterator(this, lookup(key)); }
+      const_iterator find(const KT &key) const { return const_iterator(this, lookup(key)); }
+      size_type count(const KT &key) const { return lookup(key) != slots; }
+
+      void clear()
+      {
+         for (size_type i = 0; i < slots; ++i)
+            if (dist_[i])
+            {
+               value(i).~value_type();
+               dist_[i] = 0;
+            }
+         size_ = 0;
+      }
+
+      void swap(fixed_unordered_map &other);
+   };
+
+   template<typename KT, typename T, const ttl::size_t N, typename Hash, typename KeyEqual>
+   void fixed_unordered_map<KT,T,N,Hash,KeyEqual>::swap(fixed_unordered_map &other)
+   {
+      // the same keys go to the same slots in both maps
+      for (size_type i = 0; i < slots; ++i)
+      {
+         if (dist_[i] && other.dist_[i])
+         {
+            value_type t(value(i));
+            value(i).~value_type();
+            ::new(values_[i].b) value_type(other.value(i));
+            other.value(i).~value_type();
+            ::new(other.values_[i].b) value_type(t);
+         }
+         else if (dist_[i])
+         {
+            ::new(other.values_[i].b) value_type(value(i));
+            value(i).~value_type();
+         }
+         else if (other.dist_[i])
+         {
+            ::new(values_[i].b) value_type(other.value(i));
+            other.value(i).~value_type();
+         }
+         ttl::swap(dist_[i], other.dist_[i]);
+      }
+      ttl::swap(size_, other.size_);
+      ttl::swap(origin_, other.origin_);
+   }
+
+   template<typename KT, typename T, const ttl::size_t N, typename Hash, typename KeyEqual>
+   bool operator==(const fixed_unordered_map<KT,T,N,Hash,KeyEqual> &a, const fixed_unordered_map<KT,T,N,Hash,KeyEqual> &b)
+   {
+      if (a.size() != b.size())
+         return false;
+      for (typename fixed_unordered_map<KT,T,N,Hash,KeyEqual>::const_iterator i = a.begin(); i != a.end(); ++i)
+      {
+         typename fixed_unordered_map<KT,T,N,Hash,KeyEqual>::const_iterator j = b.find(i->first);
+         if (j == b.end() || !(j->second == i->second))
+            return false;
+      }
+      return true;
+   }
+   template<typename KT, typename T, const ttl::size_t N, typename Hash, typename KeyEqual>
+   bool operator!=(const fixed_unordered_map<KT,T,N,Hash,KeyEqual> &a, const fixed_unordered_map<KT,T,N,Hash,KeyEqual> &b)
+   {
+      return !(a == b);
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_FIXED_UNORDERED_MAP_HPP_
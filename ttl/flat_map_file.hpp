@@ -0,0 +1,368 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a read-only sorted map in a file, used in place
+//
+// A flat map file holds the sorted keys and the values of a map in two
+// arrays, so that a view of a mapping of it serves the lookups with no
+// parsing and no allocation: opening it is O(1), plus the page faults of
+// the parts used.
+//
+//    ttl::write_flat_map("table.bin", m);     // m: any ordered ttl map
+//    ...
+//    ttl::flat_map_view<int, double> table;
+//    if (table.open("table.bin"))
+//       ... table.find(key).value() ...
+//
+// The file is, with every section at a multiple of 64 bytes:
+//
+//    flat_map_header
+//    K keys[count]              sorted by Compare
+//    V values[count]            values[i] is the value of keys[i]
+//    K index[index_count + 1]   the optional Eytzinger index, from 1
+//    unsigned long long ranks[index_count + 1]
+//
+// The index holds every index_stride-th key in the Eytzinger (BFS) order
+// of a binary search tree, see Khuong and Morin, "Array layouts for
+// comparison-based searching": a lookup walks it with the next levels in
+// the same cache lines, then searches index_stride keys. ranks[k] is the
+// position among the sampled keys of index[k].
+//
+// K and V are stored as their bytes: they must be trivially copyable,
+// hold no pointers, and the file is for the byte order and the layout of
+// the writer (the header checks the byte order and the sizes).
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_FLAT_MAP_FILE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_FLAT_MAP_FILE_HPP_ 1
+
+#include <stdio.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define _TTL_FLAT_MAP_MMAP 1
+#endif
+#include "types.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "algorithm.hpp"
+#include "vector.hpp"
+
+namespace ttl
+{
+   struct flat_map_header
+   {
+      enum { alignment = 64, current_version = 1, byte_order = 0x01020304 };
+
+      char magic[8];                    // "ttlflat"
+      unsigned order;                   // byte_order as written
+      unsigned version;
+      unsigned key_size, value_size;
+      unsigned long long count;         // of the elements
+      unsigned long long index_stride;  // 0 without an index
+      unsigned long long index_count;   // of the sampled keys
+      // the offsets of the sections from the start of the file
+      unsigned long long keys, values, index, ranks;
+      unsigned long long file_size;
+
+      static const char *signature() { return "ttlflat"; }
+      static unsigned long long align(unsigned long long n)
+      {
+         return (n + alignment - 1) / alignment * alignment;
+      }
+      // the header of count elements with the index of every stride-th key
+      void layout(unsigned ksize, unsigned vsize, unsigned long long n, unsigned long long stride)
+      {
+         memset(this, 0, sizeof(*this));
+         memcpy(magic, signature(), sizeof(magic));
+         order = byte_order;
+         version = current_version;
+         key_size = ksize;
+         value_size = vsize;
+         count = n;
+         index_stride = n ? stride: 0;
+         index_count = index_stride ? (n + stride - 1) / stride: 0;
+         keys = align(sizeof(*this));
+         values = align(keys + n * ksize);
+         index = align(values + n * vsize);
+         ranks = align(index + (index_count ? (index_count + 1) * ksize: 0));
+         file_size = ranks + (index_count ? (index_count + 1) * sizeof(unsigned long long): 0);
+      }
+      // whether the header is one of layout(ksize, vsize, ...) in size bytes
+      bool valid(unsigned ksize, unsigned vsize, unsigned long long size) const
+      {
+         flat_map_header h;
+         h.layout(ksize, vsize, count, index_stride);
+         return !memcmp(magic, h.magic, sizeof(magic)) && order == h.order && version == h.version &&
+                key_size == ksize && value_size == vsize && count <= size && index_count == h.index_count &&
+                keys == h.keys && values == h.values && index == h.index && ranks == h.ranks &&
+                file_size == h.file_size && file_size <= size;
+      }
+   };
+
+   template<typename K, typename V, typename Compare = ttl::less<K> >
+   class flat_map_view // read-only sorted keys to values in a flat map file
+   {
+   public:
+      typedef K key_type;
+      typedef V mapped_type;
+      typedef ttl::pair<K, V> value_type;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+      typedef Compare key_compare;
+
+      struct const_iterator
+      {
+      public:
+         typedef flat_map_view<K,V,Compare>::value_type value_type;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const K &key() const { return *key_; }
+         const V &value() const { return *value_; }
+         value_type operator*() const { return value_type(*key_, *value_); }
+
+         const_iterator &operator++() { ++key_; ++value_; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+         const_iterator &operator--() { --key_; --value_; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(*this); --*this; return tmp; }
+
+         bool operator==(const const_iterator &other) const { return key_ == other.key_; }
+         bool operator!=(const const_iterator &other) const { return key_ != other.key_; }
+      private:
+         const K *key_;
+         const V *value_;
+         friend class flat_map_view<K,V,Compare>;
+         const_iterator(const K *key, const V *value): key_(key), value_(value) {}
+      };
+      typedef const_iterator iterator;
+
+   public:
+      flat_map_view():
+         map_(0), map_size_(0)
+      {
+         detach();
+      }
+      ~flat_map_view() { close(); }
+
+#ifdef _TTL_FLAT_MAP_MMAP
+      // Maps the file read-only, false when it cannot or it is not a flat
+      // map file of K and V
+      bool open(const char *path);
+#endif
+      // Views a flat map file already in memory, aligned to 8 bytes at
+      // least, which must outlive the view
+      bool attach(const void *data, ttl::size_t size);
+      void close();
+      bool is_open() const { return keys_ != 0; }
+
+      const_iterator begin() const { return const_iterator(keys_, values_); }
+      const_iterator end() const { return const_iterator(keys_ + count_, values_ + count_); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      size_type size() const { return count_; }
+      bool empty() const { return !count_; }
+
+      const_iterator find(const K &key) const
+      {
+         size_type i = rank(key);
+         return i != count_ && !Compare()(key, keys_[i]) ? at_rank(i): end();
+      }
+      size_type count(const K &key) const { return find(key) != end(); }
+      const_iterator lower_bound(const K &key) const { return at_rank(rank(key)); }
+      const_iterator upper_bound(const K &key) const
+      {
+         size_type i = rank(key);
+         return at_rank(i != count_ && !Compare()(key, keys_[i]) ? i + 1: i);
+      }
+
+      key_compare key_comp() const { return Compare(); }
+
+   private:
+      const K *keys_;
+      const V *values_;
+      const K *index_;
+      const unsigned long long *ranks_;
+      size_type count_, stride_, index_count_;
+      void *map_;
+      ttl::size_t map_size_;
+
+      flat_map_view(const flat_map_view &);
+      flat_map_view &operator=(const flat_map_view &);
+
+      void detach()
+      {
+         keys_ = 0;
+         values_ = 0;
+         index_ = 0;
+         ranks_ = 0;
+         count_ = stride_ = index_count_ = 0;
+      }
+      const_iterator at_rank(size_type i) const { return const_iterator(keys_ + i, values_ + i); }
+      // the position of the lower bound of the key
+      size_type rank(const K &key) const;
+   };
+
+#ifdef _TTL_FLAT_MAP_MMAP
+   template<typename K, typename V, typename Compare>
+   bool flat_map_view<K,V,Compare>::open(const char *path)
+   {
+      close();
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0)
+         return false;
+      struct stat st;
+      void *p = MAP_FAILED;
+      if (!fstat(fd, &st) && st.st_size >= (off_t)sizeof(flat_map_header))
+         p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (p == MAP_FAILED)
+         return false;
+      if (!attach(p, st.st_size))
+      {
+         munmap(p, st.st_size);
+         return false;
+      }
+      map_ = p;
+      map_size_ = st.st_size;
+      return true;
+   }
+#endif
+
+   template<typename K, typename V, typename Compare>
+   bool flat_map_view<K,V,Compare>::attach(const void *data, ttl::size_t size)
+   {
+      close();
+      const flat_map_header *h = static_cast<const flat_map_header *>(data);
+      if (size < sizeof(*h) || !h->valid(sizeof(K), sizeof(V), size))
+         return false;
+      const char *base = static_cast<const char *>(data);
+      keys_ = reinterpret_cast<const K *>(base + h->keys);
+      values_ = reinterpret_cast<const V *>(base + h->values);
+      count_ = h->count;
+      if (h->index_count)
+      {
+         index_ = reinterpret_cast<const K *>(base + h->index);
+         ranks_ = reinterpret_cast<const unsigned long long *>(base + h->ranks);
+         stride_ = h->index_stride;
+         index_count_ = h->index_count;
+      }
+      return true;
+   }
+
+   template<typename K, typename V, typename Compare>
+   void flat_map_view<K,V,Compare>::close()
+   {
+#ifdef _TTL_FLAT_MAP_MMAP
+      if (map_)
+         munmap(map_, map_size_);
+#endif
+      map_ = 0;
+      map_size_ = 0;
+      detach();
+   }
+
+   template<typename K, typename V, typename Compare>
+   typename flat_map_view<K,V,Compare>::size_type
+   flat_map_view<K,V,Compare>::rank(const K &key) const
+   {
+      Compare comp;
+      size_type lo = 0, hi = count_;
+      if (index_count_)
+      {
+         // the first sampled key not less than the key: down the tree,
+         // then back up past the right turns
+         size_type k = 1;
+         while (k <= index_count_)
+            k = 2 * k + comp(index_[k], key);
+         while (k & 1)
+            k >>= 1;
+         k >>= 1;
+         const size_type j = k ? (size_type)ranks_[k]: index_count_;
+         // the sample j - 1 is less than the key
+         lo = j ? (j - 1) * stride_ + 1: 0;
+         hi = ttl::min(count_, j * stride_);
+      }
+      while (lo < hi)
+      {
+         size_type m = lo + (hi - lo) / 2;
+         if (comp(keys_[m], key))
+            lo = m + 1;
+         else
+            hi = m;
+      }
+      return lo;
+   }
+
+   // the sampled keys from sorted in the Eytzinger order from k, in order
+   // from i, returns the next i
+   template<typename K>
+   ttl::size_t _eytzinger(const K *sorted, K *index, unsigned long long *ranks,
+                          ttl::size_t i, ttl::size_t k, ttl::size_t n)
+   {
+      if (k > n)
+         return i;
+      i = _eytzinger(sorted, index, ranks, i, 2 * k, n);
+      index[k] = sorted[i];
+      ranks[k] = i++;
+      return _eytzinger(sorted, index, ranks, i, 2 * k + 1, n);
+   }
+
+   inline bool _write_padding(FILE *f, unsigned long long to)
+   {
+      static const char zeros[flat_map_header::alignment] = { 0 };
+      long pos = ftell(f);
+      return pos >= 0 && (unsigned long long)pos <= to &&
+             fwrite(zeros, 1, to - pos, f) == to - pos;
+   }
+
+   // Writes the elements of a map in the order of its iteration to a flat
+   // map file, with the index of every index_stride-th key (0 for none),
+   // false on a write error. Map is any ttl map with iterators to pairs.
+   template<class Map>
+   bool write_flat_map(const char *path, const Map &m, ttl::size_t index_stride = 16)
+   {
+      typedef typename Map::key_type K;
+      typedef typename Map::mapped_type V;
+      typedef typename Map::const_iterator const_iterator;
+      // not every map has size()
+      ttl::size_t n = 0;
+      for (const_iterator i = m.begin(); i != m.end(); ++i)
+         ++n;
+      flat_map_header h;
+      h.layout(sizeof(K), sizeof(V), n, index_stride);
+
+      FILE *f = fopen(path, "wb");
+      if (!f)
+         return false;
+      bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && _write_padding(f, h.keys);
+      vector<K> sampled;
+      sampled.reserve(h.index_count);
+      n = 0;
+      for (const_iterator i = m.begin(); ok && i != m.end(); ++i, ++n)
+      {
+         if (h.index_stride && n % h.index_stride == 0)
+            sampled.push_back(i->first);
+         ok = fwrite(&i->first, sizeof(K), 1, f) == 1;
+      }
+      ok = ok && _write_padding(f, h.values);
+      for (const_iterator i = m.begin(); ok && i != m.end(); ++i)
+         ok = fwrite(&i->second, sizeof(V), 1, f) == 1;
+      if (ok && h.index_count)
+      {
+         vector<K> index(h.index_count + 1, sampled[0]);
+         vector<unsigned long long> ranks(h.index_count + 1, 0);
+         _eytzinger(sampled.begin(), index.begin(), ranks.begin(), 0, 1, h.index_count);
+         ok = _write_padding(f, h.index) &&
+              fwrite(index.begin(), sizeof(K), index.size(), f) == index.size() &&
+              _write_padding(f, h.ranks) &&
+              fwrite(ranks.begin(), sizeof(unsigned long long), ranks.size(), f) == ranks.size();
+      }
+      ok = ok && _write_padding(f, h.file_size) && n == h.count;
+      return fclose(f) == 0 && ok;
+   }
+}
+#endif // _TINY_TEMPLATE_LIBRARY_FLAT_MAP_FILE_HPP_
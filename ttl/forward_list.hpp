@@ -7,13 +7,17 @@
 #ifndef _TINY_TEMPLATE_LIBRARY_FORWARD_LIST_HPP_
 #define _TINY_TEMPLATE_LIBRARY_FORWARD_LIST_HPP_ 1
 
+#include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 #include "slist_node.hpp"
 
 namespace ttl
 {
-   template<typename T>
-   class forward_list
+   template<typename T> void swap(T &, T &);
+
+   template<typename T, typename Resource = new_delete_resource>
+   class forward_list: private Resource
    {
    public:
       typedef T value_type;
@@ -30,6 +34,13 @@ namespace ttl
          T value;
          node(const T &v): value(v) {}
       };
+
+      node *create_node(const T &v) { return ::new(Resource::allocate(sizeof(node))) node(v); }
+      void destroy_node(slist_node *n)
+      {
+         static_cast<node *>(n)->~node();
+         Resource::deallocate(n, sizeof(node));
+      }
       slist_node head_;
 
    public:
@@ -47,8 +58,8 @@ namespace ttl
          ~iterator() {}
          iterator &operator++() { head_ = head_->next; return *this; }
          iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<forward_list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<forward_list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<forward_list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<forward_list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const iterator &other) const { return head_ == other.head_; }
          bool operator!=(const iterator &other) const { return head_ != other.head_; }
@@ -57,13 +68,13 @@ namespace ttl
 
       private:
          slist_node *head_;
-         friend class forward_list<T>;
+         friend class forward_list<T,Resource>;
          iterator(slist_node *head): head_(head) {}
       };
       class const_iterator
       {
       public:
-         typedef forward_list<T>::iterator iterator;
+         typedef forward_list<T,Resource>::iterator iterator;
          typedef T value_type;
          typedef const T *pointer;
          typedef const T &reference;
@@ -74,32 +85,36 @@ namespace ttl
          ~const_iterator() {}
          const_iterator &operator++() { head_ = head_->next; return *this; }
          const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<const forward_list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<const forward_list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<const forward_list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const forward_list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const const_iterator &other) const { return head_ == other.head_; }
          bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
 
       private:
-         friend class forward_list<T>;
-         friend class forward_list<T>::iterator;
+         friend class forward_list<T,Resource>;
+         friend class forward_list<T,Resource>::iterator;
          const slist_node *head_;
          const_iterator(const slist_node *head): head_(head) {}
       };
 
       forward_list() { head_.next = 0; }
-      forward_list(const forward_list &other)
+      explicit forward_list(const Resource &r): Resource(r) { head_.next = 0; }
+      forward_list(const forward_list &other):
+         Resource(other)
       {
          head_.next = 0;
          insert_after(cbefore_begin(), other.cbegin(), other.cend());
       }
-      forward_list(size_type n, const T &value)
+      forward_list(size_type n, const T &value, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.next = 0;
          insert_after(cbefore_begin(), n, value);
       }
       template<typename InputIterator>
-      forward_list(InputIterator first, InputIterator last)
+      forward_list(InputIterator first, InputIterator last, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.next = 0;
          insert_after(cbefore_begin(), first, last);
@@ -144,12 +159,12 @@ namespace ttl
 
       void push_front(const T &value)
       {
-         head_.insert_after(new node(value));
+         head_.insert_after(create_node(value));
       }
 
       void pop_front()
       {
-         delete static_cast<node *>(head_.unlink_next());
+         destroy_node(head_.unlink_next());
       }
 
       void splice_after(const_iterator pos, forward_list &other)
@@ -168,7 +183,7 @@ namespace ttl
 
       iterator insert_after(const_iterator pos, const T &value)
       {
-         return iterator(const_cast<slist_node *>(pos.head_)->insert_after(new node(value)));
+         return iterator(const_cast<slist_node *>(pos.head_)->insert_after(create_node(value)));
       }
       void insert_after(const_iterator pos, size_type n, const T &value);
       template<typename InputIterator>
@@ -177,16 +192,19 @@ namespace ttl
       iterator erase_after(const_iterator pos)
       {
          slist_node *p = const_cast<slist_node *>(pos.head_);
-         delete static_cast<node *>(p->unlink_next());
+         destroy_node(p->unlink_next());
          return iterator(p->next);
       }
       iterator erase_after(const_iterator pos, const_iterator last);
 
       void swap(forward_list &other)
       {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
          ttl::swap(head_.next, other.head_.next);
       }
 
+      const Resource &get_resource() const { return *this; }
+
       void resize(size_type);
       void resize(size_type, const T &value);
 
@@ -211,42 +229,42 @@ namespace ttl
 
       void reverse();
    };
-   template<typename T>
-   void forward_list<T>::insert_after(const_iterator pos, size_type n, const T &value)
+   template<typename T, typename Resource>
+   void forward_list<T,Resource>::insert_after(const_iterator pos, size_type n, const T &value)
    {
       slist_node *p = const_cast<slist_node *>(pos.head_);
       while (n--)
-         p = p->insert_after(new node(value));
+         p = p->insert_after(create_node(value));
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename InputIterator>
-   void forward_list<T>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
+   void forward_list<T,Resource>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
    {
       slist_node *p = const_cast<slist_node *>(pos.head_);
       for ( ; first != last; ++first)
-         p = p->insert_after(new node(*first));
+         p = p->insert_after(create_node(*first));
    }
-   template<typename T>
-   void forward_list<T>::clear()
+   template<typename T, typename Resource>
+   void forward_list<T,Resource>::clear()
    {
       while (head_.next)
-         delete static_cast<node *>(head_.unlink_next());
+         destroy_node(head_.unlink_next());
    }
-   template<typename T>
-   typename forward_list<T>::iterator forward_list<T>::erase_after(const_iterator pos, const_iterator last)
+   template<typename T, typename Resource>
+   typename forward_list<T,Resource>::iterator forward_list<T,Resource>::erase_after(const_iterator pos, const_iterator last)
    {
       slist_node *p = const_cast<slist_node *>(pos.head_);
       while (p->next != last.head_)
-         delete static_cast<node *>(p->unlink_next());
+         destroy_node(p->unlink_next());
       return iterator(p->next);
    }
-   template<typename T>
-   void forward_list<T>::reverse()
+   template<typename T, typename Resource>
+   void forward_list<T,Resource>::reverse()
    {
       head_.reverse();
    }
-   template<typename T>
-   void forward_list<T>::splice_after(const_iterator pos, forward_list &, const_iterator first, const_iterator last)
+   template<typename T, typename Resource>
+   void forward_list<T,Resource>::splice_after(const_iterator pos, forward_list &, const_iterator first, const_iterator last)
    {
       slist_node *f = const_cast<slist_node *>(first.head_);
 
@@ -259,13 +277,13 @@ namespace ttl
    template<class InputIt1, class InputIt2>
    bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
 
-   template <typename T>
-   bool operator==(const forward_list<T> &a, const forward_list<T> &b)
+   template <typename T, typename Resource>
+   bool operator==(const forward_list<T,Resource> &a, const forward_list<T,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template <typename T>
-   bool operator!=(const forward_list<T> &a, const forward_list<T> &b)
+   template <typename T, typename Resource>
+   bool operator!=(const forward_list<T,Resource> &a, const forward_list<T,Resource> &b)
    {
       return !(a == b);
    }
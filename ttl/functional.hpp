@@ -7,9 +7,12 @@
 #ifndef _TINY_TEMPLATE_LIBRARY_FUNCTIONAL_HPP_
 #define _TINY_TEMPLATE_LIBRARY_FUNCTIONAL_HPP_ 1
 
+#include "types.hpp"
+#include "type_traits.hpp"
+
 namespace ttl
 {
-   template<typename T>
+   template<typename T = void>
    struct less
    {
       typedef T first_argument_type;
@@ -18,7 +21,7 @@ namespace ttl
       bool operator()(const T &a, const T &b) const { return a < b; }
    };
 
-   template<typename T>
+   template<typename T = void>
    struct greater
    {
       typedef T first_argument_type;
@@ -27,7 +30,7 @@ namespace ttl
       bool operator()(const T &a, const T &b) const { return a > b; }
    };
 
-   template<typename T>
+   template<typename T = void>
    struct equal_to
    {
       typedef T first_argument_type;
@@ -36,7 +39,7 @@ namespace ttl
       bool operator()(const T &a, const T &b) const { return a == b; }
    };
 
-   template<typename T>
+   template<typename T = void>
    struct not_equal_to
    {
       typedef T first_argument_type;
@@ -44,6 +47,108 @@ namespace ttl
       typedef bool result_type;
       bool operator()(const T &a, const T &b) const { return a != b; }
    };
+
+   //
+   // The transparent function objects compare any two types, less<void>
+   // as a Compare lets the lookups of map, set and sorted_vector_map take
+   // any type comparable with the keys instead of building a key.
+   //
+   template<>
+   struct less<void>
+   {
+      typedef void is_transparent;
+      template<typename T, typename U>
+      bool operator()(const T &a, const U &b) const { return a < b; }
+   };
+
+   template<>
+   struct greater<void>
+   {
+      typedef void is_transparent;
+      template<typename T, typename U>
+      bool operator()(const T &a, const U &b) const { return a > b; }
+   };
+
+   template<>
+   struct equal_to<void>
+   {
+      typedef void is_transparent;
+      template<typename T, typename U>
+      bool operator()(const T &a, const U &b) const { return a == b; }
+   };
+
+   template<>
+   struct not_equal_to<void>
+   {
+      typedef void is_transparent;
+      template<typename T, typename U>
+      bool operator()(const T &a, const U &b) const { return a != b; }
+   };
+
+   // is_transparent<F>::value if F::is_transparent names a type
+   template<typename F>
+   struct is_transparent
+   {
+   private:
+      template<typename U> static char test(typename U::is_transparent *);
+      template<typename U> static long test(...);
+   public:
+      static const bool value = sizeof(test<F>(0)) == 1;
+   };
+
+   // if_transparent<F, K, R>::type is R for a transparent F, else the
+   // lookup by K is not a candidate; K only makes the failure depend on
+   // the lookup member template
+   template<typename F, typename K, typename R>
+   struct if_transparent: enable_if<is_transparent<F>::value, R> {};
+
+   //
+   // hash<T>()(value) for the integral types and the pointers. The bits
+   // are mixed with the finalizer of MurmurHash3, so a hashed container
+   // can take the low bits of a hash as the bucket even for the keys that
+   // differ only in their high bits.
+   //
+   inline ttl::size_t hash_mix(unsigned long long x)
+   {
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdull;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ull;
+      x ^= x >> 33;
+      return (ttl::size_t)x;
+   }
+
+   template<typename T> struct hash;
+
+   template<typename T>
+   struct _hash_integral
+   {
+      typedef T argument_type;
+      typedef ttl::size_t result_type;
+      ttl::size_t operator()(T value) const { return hash_mix((unsigned long long)value); }
+   };
+
+   template<> struct hash<bool>: _hash_integral<bool> {};
+   template<> struct hash<char>: _hash_integral<char> {};
+   template<> struct hash<signed char>: _hash_integral<signed char> {};
+   template<> struct hash<unsigned char>: _hash_integral<unsigned char> {};
+   template<> struct hash<wchar_t>: _hash_integral<wchar_t> {};
+   template<> struct hash<short>: _hash_integral<short> {};
+   template<> struct hash<unsigned short>: _hash_integral<unsigned short> {};
+   template<> struct hash<int>: _hash_integral<int> {};
+   template<> struct hash<unsigned int>: _hash_integral<unsigned int> {};
+   template<> struct hash<long>: _hash_integral<long> {};
+   template<> struct hash<unsigned long>: _hash_integral<unsigned long> {};
+   template<> struct hash<long long>: _hash_integral<long long> {};
+   template<> struct hash<unsigned long long>: _hash_integral<unsigned long long> {};
+
+   template<typename T>
+   struct hash<T *>
+   {
+      typedef T *argument_type;
+      typedef ttl::size_t result_type;
+      ttl::size_t operator()(T *p) const { return hash_mix((unsigned long long)(ttl::size_t)p); }
+   };
 }
 
 #endif // _TINY_TEMPLATE_LIBRARY_FUNCTIONAL_HPP_
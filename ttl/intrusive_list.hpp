@@ -0,0 +1,194 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an intrusive double linked list
+//
+// The list links the objects themselves through a list_node member, so it
+// never allocates or copies: an object is in the list as long as its hook
+// is linked, and an object with several hooks can be in several lists.
+//
+//    struct connection
+//    {
+//       ttl::list_node by_age, by_owner;
+//       ...
+//    };
+//    ttl::intrusive_list<connection, &connection::by_age> lru;
+//
+// The list does not own the objects: an object must be erased before it is
+// destroyed. The hooks of erased objects are left self-linked, so
+// intrusive_list::is_linked() tells whether an object is in a list (the
+// hook must have been init()ed or erased before for that).
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_INTRUSIVE_LIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_INTRUSIVE_LIST_HPP_ 1
+
+#include "types.hpp"
+#include "list.hpp"
+#include "member_hook.hpp"
+
+namespace ttl
+{
+   template<typename T, list_node T::*Hook>
+   class intrusive_list
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      typedef member_hook<T, list_node, Hook> hook;
+      list_node head_;
+
+      intrusive_list(const intrusive_list &);
+      intrusive_list &operator=(const intrusive_list &);
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* head_ left uninitialized */ {}
+         iterator &operator++() { head_ = head_->next; return *this; }
+         iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
+         iterator &operator--() { head_ = head_->prev; return *this; }
+         iterator operator--(int) { iterator tmp(head_); head_ = head_->prev; return tmp; }
+         reference operator*() const { return *hook::owner(head_); }
+         pointer operator->() const { return hook::owner(head_); }
+
+         bool operator==(const iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const iterator &other) const { return head_ != other.head_; }
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         list_node *head_;
+         friend class intrusive_list;
+         iterator(list_node *head): head_(head) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* head_ left uninitialized */ {}
+         const_iterator(const iterator &o): head_(o.head_) {}
+         const_iterator &operator++() { head_ = head_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
+         const_iterator &operator--() { head_ = head_->prev; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(head_); head_ = head_->prev; return tmp; }
+         reference operator*() const { return *hook::owner(head_); }
+         pointer operator->() const { return hook::owner(head_); }
+
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         friend class intrusive_list;
+         friend class iterator;
+         const list_node *head_;
+         const_iterator(const list_node *head): head_(head) {}
+      };
+
+      intrusive_list() { head_.init(); }
+      ~intrusive_list() { clear(); }
+
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(&head_); }
+
+      // the iterator to an object in the list, in O(1)
+      static iterator iterator_to(reference value) { return iterator(hook::node(value)); }
+      static const_iterator iterator_to(const_reference value) { return const_iterator(hook::node(value)); }
+
+      static bool is_linked(const_reference value)
+      {
+         const list_node *n = hook::node(value);
+         return n->next != n;
+      }
+
+      bool empty() const { return head_.next == &head_; }
+      size_type size() const
+      {
+         size_type siz = 0;
+         for (const list_node *n = head_.next; n != &head_; n = n->next)
+            ++siz;
+         return siz;
+      }
+
+      reference front() { return *hook::owner(head_.next); }
+      const_reference front() const { return *hook::owner(head_.next); }
+      reference back() { return *hook::owner(head_.prev); }
+      const_reference back() const { return *hook::owner(head_.prev); }
+
+      void push_front(reference value) { head_.next->insert_before(hook::node(value)); }
+      void push_back(reference value) { head_.insert_before(hook::node(value)); }
+      void pop_front() { erase(front()); }
+      void pop_back() { erase(back()); }
+
+      iterator insert(const_iterator pos, reference value)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         return iterator(p->insert_before(hook::node(value)));
+      }
+
+      iterator erase(const_iterator pos)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         list_node *next = p->next;
+         p->unlink();
+         p->init();
+         return iterator(next);
+      }
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         while (first != last)
+            first = erase(first);
+         return iterator(const_cast<list_node *>(last.head_));
+      }
+      // the list of the object is not needed to erase it
+      static void erase(reference value)
+      {
+         list_node *n = hook::node(value);
+         n->unlink();
+         n->init();
+      }
+
+      void splice(const_iterator pos, intrusive_list &other)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         p->splice(other.head_.next, &other.head_);
+      }
+      void splice(const_iterator pos, reference value)
+      {
+         list_node *p = const_cast<list_node *>(pos.head_);
+         list_node *n = hook::node(value);
+         if (n != p)
+            p->splice(n, n->next);
+      }
+
+      void swap(intrusive_list &other) { list_node::swap(&head_, &other.head_); }
+      void reverse() { head_.reverse(); }
+
+      void clear() { erase(begin(), end()); }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_INTRUSIVE_LIST_HPP_
@@ -0,0 +1,210 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an intrusive red-black tree and set
+//
+// The objects themselves are linked through an rbnode member, so insertion
+// and erasure never allocate or copy (see intrusive_list.hpp). The keys
+// are unique, KeyOfValue extracts the key from an object:
+//
+//    struct connection
+//    {
+//       int fd;
+//       ttl::rbnode by_fd;
+//       ...
+//    };
+//    struct fd_of { const int &operator()(const connection &c) const { return c.fd; } };
+//    ttl::intrusive_rbtree<int, connection, &connection::by_fd, fd_of> connections;
+//
+// The key of an object must not change while it is in the tree. The tree
+// does not own the objects: an object must be erased before it is destroyed.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_INTRUSIVE_RBTREE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_INTRUSIVE_RBTREE_HPP_ 1
+
+#include "types.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "rbtree.hpp"
+#include "member_hook.hpp"
+
+namespace ttl
+{
+   template<typename K, typename T, rbnode T::*Hook, typename KeyOfValue, typename Compare = ttl::less<K> >
+   class intrusive_rbtree: public rbtree_base
+   {
+   public:
+      typedef K key_type;
+      typedef T value_type;
+      typedef Compare key_compare;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      typedef member_hook<T, rbnode, Hook> hook;
+
+      struct node_key
+      {
+         const KeyOfValue &keyof;
+         node_key(const KeyOfValue &k): keyof(k) {}
+         const K &operator()(const rbnode *n) const { return keyof(*hook::owner(n)); }
+      };
+
+      KeyOfValue keyof_;
+      Compare is_less_;
+
+      intrusive_rbtree(const intrusive_rbtree &);
+      intrusive_rbtree &operator=(const intrusive_rbtree &);
+
+      // the header is red and is the parent of the black root
+      static const rbnode *prev(const rbnode *n)
+      {
+         if (n->color == rbnode::RED && n->parent && n->parent->parent == n)
+            return max_node(n->parent);
+         return prev_node(n);
+      }
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* n_ left uninitialized */ {}
+         iterator &operator++() { n_ = next_node(n_); return *this; }
+         iterator operator++(int) { iterator tmp(n_); n_ = next_node(n_); return tmp; }
+         iterator &operator--() { n_ = const_cast<rbnode *>(prev(n_)); return *this; }
+         iterator operator--(int) { iterator tmp(n_); n_ = const_cast<rbnode *>(prev(n_)); return tmp; }
+         reference operator*() const { return *hook::owner(n_); }
+         pointer operator->() const { return hook::owner(n_); }
+
+         bool operator==(const iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const iterator &other) const { return n_ != other.n_; }
+         bool operator==(const const_iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const const_iterator &other) const { return n_ != other.n_; }
+
+      private:
+         rbnode *n_;
+         friend class intrusive_rbtree;
+         iterator(rbnode *n): n_(n) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* n_ left uninitialized */ {}
+         const_iterator(const iterator &o): n_(o.n_) {}
+         const_iterator &operator++() { n_ = next_node(n_); return *this; }
+         const_iterator operator++(int) { const_iterator tmp(n_); n_ = next_node(n_); return tmp; }
+         const_iterator &operator--() { n_ = prev(n_); return *this; }
+         const_iterator operator--(int) { const_iterator tmp(n_); n_ = prev(n_); return tmp; }
+         reference operator*() const { return *hook::owner(n_); }
+         pointer operator->() const { return hook::owner(n_); }
+
+         bool operator==(const const_iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const const_iterator &other) const { return n_ != other.n_; }
+
+      private:
+         friend class intrusive_rbtree;
+         friend class iterator;
+         const rbnode *n_;
+         const_iterator(const rbnode *n): n_(n) {}
+      };
+
+      explicit intrusive_rbtree(const Compare &comp = Compare()): is_less_(comp) {}
+
+      iterator begin() { return iterator(root_() ? min_node(root_()): &header_); }
+      iterator end() { return iterator(&header_); }
+      const_iterator begin() const { return const_iterator(root_() ? min_node(root_()): &header_); }
+      const_iterator end() const { return const_iterator(&header_); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      static iterator iterator_to(reference value) { return iterator(hook::node(value)); }
+      static const_iterator iterator_to(const_reference value) { return const_iterator(hook::node(value)); }
+
+      bool empty() const { return !root_(); }
+      size_type size() const
+      {
+         size_type siz = 0;
+         for (const_iterator i = begin(); i != end(); ++i)
+            ++siz;
+         return siz;
+      }
+
+      // Links the object, unless there is one with the same key already
+      pair<iterator, bool> insert(reference value)
+      {
+         rbnode *parent;
+         rbnode **edge = insert_edge(keyof_(value), &parent, true, node_key(keyof_), is_less_);
+         if (*edge)
+            return pair<iterator, bool>(iterator(*edge), false);
+         link_node(edge, parent, hook::node(value));
+         return pair<iterator, bool>(iterator(hook::node(value)), true);
+      }
+
+      // Unlinks and returns the object with the key, or 0
+      pointer erase(const K &key)
+      {
+         rbnode *n = remove_node(key, node_key(keyof_), is_less_);
+         return n ? hook::owner(n): 0;
+      }
+      // The object must be in the tree
+      void erase(reference value) { remove_node(keyof_(value), node_key(keyof_), is_less_); }
+
+      iterator find(const K &key)
+      {
+         return iterator(const_cast<rbnode *>(find_node(key, node_key(keyof_), is_less_)));
+      }
+      const_iterator find(const K &key) const
+      {
+         return const_iterator(find_node(key, node_key(keyof_), is_less_));
+      }
+      size_type count(const K &key) const { return find(key) != end(); }
+
+      iterator lower_bound(const K &key)
+      {
+         return iterator(const_cast<rbnode *>(lower_bound_node(key, node_key(keyof_), is_less_)));
+      }
+      const_iterator lower_bound(const K &key) const
+      {
+         return const_iterator(lower_bound_node(key, node_key(keyof_), is_less_));
+      }
+      iterator upper_bound(const K &key)
+      {
+         return iterator(const_cast<rbnode *>(upper_bound_node(key, node_key(keyof_), is_less_)));
+      }
+      const_iterator upper_bound(const K &key) const
+      {
+         return const_iterator(upper_bound_node(key, node_key(keyof_), is_less_));
+      }
+
+      // The objects are left as they are
+      void clear() { *root_edge() = 0; }
+   };
+
+   // The objects are their own keys
+   template<typename T, rbnode T::*Hook, typename Compare = ttl::less<T> >
+   class intrusive_set: public intrusive_rbtree<T, T, Hook, select_same<T>, Compare>
+   {
+   public:
+      explicit intrusive_set(const Compare &comp = Compare()):
+         intrusive_rbtree<T, T, Hook, select_same<T>, Compare>(comp) {}
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_INTRUSIVE_RBTREE_HPP_
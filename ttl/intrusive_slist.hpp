@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an intrusive single linked list
+//
+// Like forward_list, but the objects themselves are linked through an
+// slist_node member, so insertion and erasure never allocate or copy (see
+// intrusive_list.hpp). The list does not own the objects.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_INTRUSIVE_SLIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_INTRUSIVE_SLIST_HPP_ 1
+
+#include "types.hpp"
+#include "slist_node.hpp"
+#include "member_hook.hpp"
+
+namespace ttl
+{
+   template<typename T, slist_node T::*Hook>
+   class intrusive_slist
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+   private:
+      typedef member_hook<T, slist_node, Hook> hook;
+      slist_node head_;
+
+      intrusive_slist(const intrusive_slist &);
+      intrusive_slist &operator=(const intrusive_slist &);
+
+   public:
+      class const_iterator;
+
+      class iterator
+      {
+      public:
+         typedef T value_type;
+         typedef T *pointer;
+         typedef T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* head_ left uninitialized */ {}
+         iterator &operator++() { head_ = head_->next; return *this; }
+         iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return *hook::owner(head_); }
+         pointer operator->() const { return hook::owner(head_); }
+
+         bool operator==(const iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const iterator &other) const { return head_ != other.head_; }
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         slist_node *head_;
+         friend class intrusive_slist;
+         iterator(slist_node *head): head_(head) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef T value_type;
+         typedef const T *pointer;
+         typedef const T &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* head_ left uninitialized */ {}
+         const_iterator(const iterator &o): head_(o.head_) {}
+         const_iterator &operator++() { head_ = head_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
+         reference operator*() const { return *hook::owner(head_); }
+         pointer operator->() const { return hook::owner(head_); }
+
+         bool operator==(const const_iterator &other) const { return head_ == other.head_; }
+         bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
+
+      private:
+         friend class intrusive_slist;
+         friend class iterator;
+         const slist_node *head_;
+         const_iterator(const slist_node *head): head_(head) {}
+      };
+
+      intrusive_slist() { head_.next = 0; }
+      ~intrusive_slist() { clear(); }
+
+      iterator before_begin() { return iterator(&head_); }
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(0); }
+      const_iterator before_begin() const { return const_iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(0); }
+      const_iterator cbefore_begin() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(0); }
+
+      static iterator iterator_to(reference value) { return iterator(hook::node(value)); }
+      static const_iterator iterator_to(const_reference value) { return const_iterator(hook::node(value)); }
+
+      bool empty() const { return !head_.next; }
+      size_type size() const
+      {
+         size_type siz = 0;
+         for (const slist_node *n = head_.next; n; n = n->next)
+            ++siz;
+         return siz;
+      }
+
+      reference front() { return *hook::owner(head_.next); }
+      const_reference front() const { return *hook::owner(head_.next); }
+
+      void push_front(reference value) { head_.insert_after(hook::node(value)); }
+      void pop_front() { head_.unlink_next(); }
+
+      iterator insert_after(const_iterator pos, reference value)
+      {
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         return iterator(p->insert_after(hook::node(value)));
+      }
+
+      iterator erase_after(const_iterator pos)
+      {
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         p->unlink_next();
+         return iterator(p->next);
+      }
+      iterator erase_after(const_iterator pos, const_iterator last)
+      {
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         p->next = const_cast<slist_node *>(last.head_);
+         return iterator(p->next);
+      }
+
+      void splice_after(const_iterator pos, intrusive_slist &other)
+      {
+         if (other.empty())
+            return;
+         slist_node *p = const_cast<slist_node *>(pos.head_);
+         p->splice_after(&other.head_, 0);
+      }
+
+      void swap(intrusive_slist &other)
+      {
+         slist_node *t = head_.next;
+         head_.next = other.head_.next;
+         other.head_.next = t;
+      }
+      void reverse() { head_.reverse(); }
+
+      void clear() { head_.next = 0; }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_INTRUSIVE_SLIST_HPP_
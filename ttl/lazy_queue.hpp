@@ -14,14 +14,15 @@
 
 #include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 #include "slist_node.hpp"
 
 namespace ttl
 {
    template<typename T> void swap(T &, T &);
 
-   template<typename T>
-   class lazy_queue
+   template<typename T, typename Resource = new_delete_resource>
+   class lazy_queue: private Resource
    {
    public:
       typedef T value_type;
@@ -44,7 +45,7 @@ namespace ttl
 
       node *get_node(const T &v)
       {
-         node *n = static_cast<node *>(dead_.next ? dead_.unlink_next(): ::operator new(sizeof(node)));
+         node *n = static_cast<node *>(dead_.next ? dead_.unlink_next(): Resource::allocate(sizeof(node)));
          ::new(&n->value) T(v);
          return n;
       }
@@ -69,8 +70,8 @@ namespace ttl
          ~iterator() {}
          iterator &operator++() { head_ = head_->next; return *this; }
          iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<lazy_queue<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<lazy_queue<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<lazy_queue<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<lazy_queue<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const iterator &other) const { return head_ == other.head_; }
          bool operator!=(const iterator &other) const { return head_ != other.head_; }
@@ -79,13 +80,13 @@ namespace ttl
 
       private:
          slist_node *head_;
-         friend class lazy_queue<T>;
+         friend class lazy_queue<T,Resource>;
          iterator(slist_node *head): head_(head) {}
       };
       class const_iterator
       {
       public:
-         typedef lazy_queue<T>::iterator iterator;
+         typedef lazy_queue<T,Resource>::iterator iterator;
          typedef T value_type;
          typedef const T *pointer;
          typedef const T &reference;
@@ -96,15 +97,15 @@ namespace ttl
          ~const_iterator() {}
          const_iterator &operator++() { head_ = head_->next; return *this; }
          const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
-         reference operator*() const { return static_cast<const lazy_queue<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<const lazy_queue<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<const lazy_queue<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const lazy_queue<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const const_iterator &other) const { return head_ == other.head_; }
          bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
 
       private:
-         friend class lazy_queue<T>;
-         friend class lazy_queue<T>::iterator;
+         friend class lazy_queue<T,Resource>;
+         friend class lazy_queue<T,Resource>::iterator;
          const slist_node *head_;
          const_iterator(const slist_node *head): head_(head) {}
       };
@@ -115,14 +116,23 @@ namespace ttl
          tail_ = &head_;
          dead_.next = 0;
       }
-      lazy_queue(const lazy_queue &other)
+      explicit lazy_queue(const Resource &r):
+         Resource(r)
+      {
+         head_.next = 0;
+         tail_ = &head_;
+         dead_.next = 0;
+      }
+      lazy_queue(const lazy_queue &other):
+         Resource(other)
       {
          head_.next = 0;
          tail_ = &head_;
          dead_.next = 0;
          insert_after(cbefore_begin(), other.cbegin(), other.cend());
       }
-      lazy_queue(size_type n, const T &value)
+      lazy_queue(size_type n, const T &value, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.next = 0;
          tail_ = &head_;
@@ -131,15 +141,15 @@ namespace ttl
       }
       ~lazy_queue()
       {
-         while (head_.next)
-            delete static_cast<node *>(head_.unlink_next());
+         clear();
          cleanup();
       }
 
+      // the dead nodes hold no values
       void cleanup()
       {
          while (dead_.next)
-            ::delete(static_cast<node *>(dead_.unlink_next()));
+            Resource::deallocate(dead_.unlink_next(), sizeof(node));
       }
 
       lazy_queue &operator=(const lazy_queue &other)
@@ -205,10 +215,14 @@ namespace ttl
 
       void swap(lazy_queue &other)
       {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
          ttl::swap(head_.next, other.head_.next);
          ttl::swap(tail_, other.tail_);
+         ttl::swap(dead_.next, other.dead_.next);
       }
 
+      const Resource &get_resource() const { return *this; }
+
       void clear();
 
       void remove(const T &); // TODO
@@ -224,8 +238,8 @@ namespace ttl
          }
       }
    };
-   template<typename T>
-   void lazy_queue<T>::insert_after(const_iterator pos, size_type n, const T &value)
+   template<typename T, typename Resource>
+   void lazy_queue<T,Resource>::insert_after(const_iterator pos, size_type n, const T &value)
    {
       slist_node *pn = const_cast<slist_node *>(pos.head_);
       slist_node *p = pn;
@@ -234,9 +248,9 @@ namespace ttl
       if (pn == tail_)
          tail_ = p;
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename InputIterator>
-   void lazy_queue<T>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
+   void lazy_queue<T,Resource>::insert_after(const_iterator pos, InputIterator first, InputIterator last)
    {
       slist_node *pn = const_cast<slist_node *>(pos.head_);
       slist_node *p = pn;
@@ -245,8 +259,8 @@ namespace ttl
       if (pn == tail_)
          tail_ = p;
    }
-   template<typename T>
-   typename lazy_queue<T>::iterator lazy_queue<T>::erase_after(const_iterator pos)
+   template<typename T, typename Resource>
+   typename lazy_queue<T,Resource>::iterator lazy_queue<T,Resource>::erase_after(const_iterator pos)
    {
       slist_node *pn = const_cast<slist_node *>(pos.head_);
       slist_node *p = pn->unlink_next();
@@ -255,8 +269,8 @@ namespace ttl
       put_node(static_cast<node *>(p));
       return iterator(pn->next);
    }
-   template<typename T>
-   typename lazy_queue<T>::iterator lazy_queue<T>::erase_after(const_iterator pos, const_iterator last)
+   template<typename T, typename Resource>
+   typename lazy_queue<T,Resource>::iterator lazy_queue<T,Resource>::erase_after(const_iterator pos, const_iterator last)
    {
       slist_node *p = const_cast<slist_node *>(pos.head_);
       while (p->next != last.head_)
@@ -265,8 +279,8 @@ namespace ttl
          tail_ = p;
       return iterator(p->next);
    }
-   template<typename T>
-   void lazy_queue<T>::clear()
+   template<typename T, typename Resource>
+   void lazy_queue<T,Resource>::clear()
    {
       while (head_.next)
          put_node(static_cast<node *>(head_.unlink_next()));
@@ -5,13 +5,17 @@
 //
 // This code is Public Domain
 //
-#ifndef _TINY_TEMPLATE_LIBRARY_FORWARD_LIST_HPP_
-#define _TINY_TEMPLATE_LIBRARY_FORWARD_LIST_HPP_ 1
+#ifndef _TINY_TEMPLATE_LIBRARY_LIST_HPP_
+#define _TINY_TEMPLATE_LIBRARY_LIST_HPP_ 1
 
+#include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 
 namespace ttl
 {
+   template<typename T> void swap(T &, T &);
+
    struct list_node
    {
       list_node *prev, *next;
@@ -108,8 +112,8 @@ namespace ttl
       }
 #endif
    };
-   template<typename T>
-   class list
+   template<typename T, typename Resource = new_delete_resource>
+   class list: private Resource
    {
    public:
       typedef T value_type;
@@ -129,6 +133,15 @@ namespace ttl
       };
       list_node head_;
 
+      node *create_node() { return ::new(Resource::allocate(sizeof(node))) node; }
+      node *create_node(const T &v) { return ::new(Resource::allocate(sizeof(node))) node(v); }
+      void destroy_node(node *n)
+      {
+         n->~node();
+         Resource::deallocate(n, sizeof(node));
+      }
+      void destroy_node(list_node *n) { destroy_node(static_cast<node *>(n)); }
+
    public:
       class const_iterator;
 
@@ -146,8 +159,8 @@ namespace ttl
          iterator operator++(int) { iterator tmp(head_); head_ = head_->next; return tmp; }
          iterator &operator--() { head_ = head_->prev; return *this; }
          iterator operator--(int) { iterator tmp(head_); head_ = head_->prev; return tmp; }
-         reference operator*() const { return static_cast<list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const iterator &other) const { return head_ == other.head_; }
          bool operator!=(const iterator &other) const { return head_ != other.head_; }
@@ -156,13 +169,13 @@ namespace ttl
 
       private:
          list_node *head_;
-         friend class list<T>;
+         friend class list<T,Resource>;
          iterator(list_node *head): head_(head) {}
       };
       class const_iterator
       {
       public:
-         typedef list<T>::iterator iterator;
+         typedef list<T,Resource>::iterator iterator;
          typedef T value_type;
          typedef const T *pointer;
          typedef const T &reference;
@@ -175,32 +188,36 @@ namespace ttl
          const_iterator operator++(int) { const_iterator tmp(head_); head_ = head_->next; return tmp; }
          const_iterator &operator--() { head_ = head_->prev; return *this; }
          const_iterator operator--(int) { const_iterator tmp(head_); head_ = head_->prev; return tmp; }
-         reference operator*() const { return static_cast<const list<T>::node *>(head_)->value; }
-         pointer operator->() const { return &static_cast<const list<T>::node *>(head_)->value; }
+         reference operator*() const { return static_cast<const list<T,Resource>::node *>(head_)->value; }
+         pointer operator->() const { return &static_cast<const list<T,Resource>::node *>(head_)->value; }
 
          bool operator==(const const_iterator &other) const { return head_ == other.head_; }
          bool operator!=(const const_iterator &other) const { return head_ != other.head_; }
 
       private:
-         friend class list<T>;
-         friend class list<T>::iterator;
+         friend class list<T,Resource>;
+         friend class list<T,Resource>::iterator;
          const list_node *head_;
          const_iterator(const list_node *head): head_(head) {}
       };
 
       list() { head_.init(); }
-      list(const list &other)
+      explicit list(const Resource &r): Resource(r) { head_.init(); }
+      list(const list &other):
+         Resource(other)
       {
          head_.init();
          insert(cbegin(), other.cbegin(), other.cend());
       }
-      list(size_type n, const T &value)
+      list(size_type n, const T &value, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.init();
          insert(cend(), n, value);
       }
       template<typename InputIterator>
-      list(InputIterator first, InputIterator last)
+      list(InputIterator first, InputIterator last, const Resource &r = Resource()):
+         Resource(r)
       {
          head_.init();
          insert(end(), first, last);
@@ -251,26 +268,26 @@ namespace ttl
 
       void push_front(const T &value)
       {
-         head_.next->insert_before(new node(value));
+         head_.next->insert_before(create_node(value));
       }
 
       void push_back(const T &value)
       {
-         head_.insert_before(new node(value));
+         head_.insert_before(create_node(value));
       }
 
       void pop_front()
       {
          node *p = static_cast<node *>(head_.next);
          p->unlink();
-         delete p;
+         destroy_node(p);
       }
 
       void pop_back()
       {
          node *p = static_cast<node *>(head_.prev);
          p->unlink();
-         delete p;
+         destroy_node(p);
       }
 
       void splice(const_iterator pos, list &other)
@@ -294,7 +311,7 @@ namespace ttl
       iterator insert(const_iterator pos, const T &value)
       {
          list_node *p = const_cast<list_node *>(pos.head_);
-         return iterator(p->insert_before(new node(value)));
+         return iterator(p->insert_before(create_node(value)));
       }
       void insert(const_iterator pos, size_type n, const T &value);
       template<typename InputIterator>
@@ -305,16 +322,19 @@ namespace ttl
          list_node *p = const_cast<list_node *>(pos.head_);
          list_node *next = p->next;
          p->unlink();
-         delete static_cast<node *>(p);
+         destroy_node(p);
          return iterator(next);
       }
       iterator erase(const_iterator pos, const_iterator last);
 
       void swap(list &other)
       {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
          list_node::swap(&head_, &other.head_);
       }
 
+      const Resource &get_resource() const { return *this; }
+
       void resize(size_type);
       void resize(size_type, const T &value);
 
@@ -342,23 +362,23 @@ namespace ttl
          head_.reverse();
       }
    };
-   template<typename T>
-   void list<T>::insert(const_iterator pos, size_type n, const T &value)
+   template<typename T, typename Resource>
+   void list<T,Resource>::insert(const_iterator pos, size_type n, const T &value)
    {
       list_node *p = const_cast<list_node *>(pos.head_);
       while (n--)
-         p->insert_before(new node(value));
+         p->insert_before(create_node(value));
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename InputIterator>
-   void list<T>::insert(const_iterator pos, InputIterator first, InputIterator last)
+   void list<T,Resource>::insert(const_iterator pos, InputIterator first, InputIterator last)
    {
       list_node *p = const_cast<list_node *>(pos.head_);
       for ( ; first != last; ++first)
-         p->insert_before(new node(*first));
+         p->insert_before(create_node(*first));
    }
-   template<typename T>
-   void list<T>::resize(size_type newsize)
+   template<typename T, typename Resource>
+   void list<T,Resource>::resize(size_type newsize)
    {
       size_type siz = 0;
       list_node *p;
@@ -369,15 +389,15 @@ namespace ttl
             {
                list_node *e = head_.prev;
                e->unlink();
-               delete static_cast<node *>(e);
+               destroy_node(e);
             }
             return;
          }
       while (siz++ < newsize)
-         head_.insert_before(new node);
+         head_.insert_before(create_node());
    }
-   template<typename T>
-   void list<T>::resize(size_type newsize, const T &value)
+   template<typename T, typename Resource>
+   void list<T,Resource>::resize(size_type newsize, const T &value)
    {
       size_type siz = 0;
       list_node *p;
@@ -388,86 +408,86 @@ namespace ttl
             {
                list_node *e = head_.prev;
                e->unlink();
-               delete static_cast<node *>(e);
+               destroy_node(e);
             }
             return;
          }
       while (siz++ < newsize)
-         head_.insert_before(new node(value));
+         head_.insert_before(create_node(value));
    }
-   template<typename T>
-   void list<T>::clear()
+   template<typename T, typename Resource>
+   void list<T,Resource>::clear()
    {
       while (head_.next != &head_)
       {
          node *p = static_cast<node *>(head_.next);
          head_.next = head_.next->next;
-         delete p;
+         destroy_node(p);
       }
    }
-   template<typename T>
-   typename list<T>::iterator list<T>::erase(const_iterator pos, const_iterator last)
+   template<typename T, typename Resource>
+   typename list<T,Resource>::iterator list<T,Resource>::erase(const_iterator pos, const_iterator last)
    {
       list_node *p = const_cast<list_node *>(pos.head_);
       while (p->next != last.head_)
       {
          node *next = static_cast<node *>(p->next);
          p->unlink();
-         delete static_cast<node *>(p);
+         destroy_node(p);
          p = next;
       }
       return iterator(p->next);
    }
-   template<typename T>
-   void list<T>::remove(const T &value)
+   template<typename T, typename Resource>
+   void list<T,Resource>::remove(const T &value)
    {
       for (list_node *p = head_.next, *n = p->next; p != &head_; p = n, n = n->next)
          if (static_cast<const node *>(p)->value == value)
          {
             p->unlink();
-            delete static_cast<node *>(p);
+            destroy_node(p);
          }
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename Predicate>
-   void list<T>::remove_if(Predicate pred)
+   void list<T,Resource>::remove_if(Predicate pred)
    {
       for (list_node *p = head_.next, *n = p->next; p != &head_; p = n, n = n->next)
          if (pred(static_cast<const node *>(p)->value))
          {
             p->unlink();
-            delete static_cast<node *>(p);
+            destroy_node(p);
          }
    }
-   template<typename T>
-   void list<T>::unique()
+   template<typename T, typename Resource>
+   void list<T,Resource>::unique()
    {
       list_node *prev = head_.next;
       for (list_node *p = prev->next, *n = p->next; p != &head_; p = n, n = n->next)
          if (static_cast<const node *>(p)->value == static_cast<const node *>(prev)->value)
          {
             p->unlink();
-            delete static_cast<node *>(p);
+            destroy_node(p);
          }
          else
             prev = p;
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename BinaryPredicate>
-   void list<T>::unique(BinaryPredicate pred)
+   void list<T,Resource>::unique(BinaryPredicate pred)
    {
       list_node *prev = head_.next;
       for (list_node *p = prev->next, *n = p->next; p != &head_; p = n, n = n->next)
          if (pred(static_cast<const node *>(p)->value, static_cast<const node *>(prev)->value))
          {
             p->unlink();
-            delete static_cast<node *>(p);
+            destroy_node(p);
          }
          else
             prev = p;
    }
-   template<typename T>
-   void list<T>::merge(list &other) // merge sorted lists
+   template<typename T, typename Resource>
+   void list<T,Resource>::merge(list &other) // merge sorted lists
    {
       list_node *o = other.head_.next;
       for (list_node *i = head_.next; o != &other.head_ && i != &head_;)
@@ -486,9 +506,9 @@ namespace ttl
       if (o != &other.head_)
          head_.splice(other.head_.next, &other.head_);
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename Compare>
-   void list<T>::merge(list &other, Compare cmp)
+   void list<T,Resource>::merge(list &other, Compare cmp)
    {
       list_node *o = other.head_.next;
       for (list_node *i = head_.next; o != &other.head_ && i != &head_;)
@@ -511,15 +531,15 @@ namespace ttl
    template<class InputIt1, class InputIt2>
    bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
 
-   template <typename T>
-   bool operator==(const list<T> &a, const list<T> &b)
+   template <typename T, typename Resource>
+   bool operator==(const list<T,Resource> &a, const list<T,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template <typename T>
-   bool operator!=(const list<T> &a, const list<T> &b)
+   template <typename T, typename Resource>
+   bool operator!=(const list<T,Resource> &a, const list<T,Resource> &b)
    {
       return !(a == b);
    }
 }
-#endif // _TINY_TEMPLATE_LIBRARY_FORWARD_LIST_HPP_
+#endif // _TINY_TEMPLATE_LIBRARY_LIST_HPP_
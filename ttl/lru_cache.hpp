@@ -0,0 +1,589 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: caches of a bounded number of entries, with the
+// least recently used (lru_cache) or a not recently used (clock_cache)
+// entry evicted to make room for a new one
+//
+// Both index their entries with an open addressing table of pointers,
+// allocated once for the capacity and at most 3/4 full: linear probing,
+// the hash of each key kept in its entry, backward shift deletion. get(),
+// put(), touch() and erase() are O(1).
+//
+// lru_cache keeps its entries on a list_node chain, from the most to the
+// least recently used one; a hit moves the entry to the front. An entry
+// is one allocation from the Resource, and an insert into a full cache
+// reuses the node of the entry it evicts.
+//
+// clock_cache keeps its entries in an array allocated once, each with a
+// referenced flag. A hit only sets the flag of its entry if it is not
+// set yet, no links change, so the reads of hot entries do not write to
+// memory shared by the others. An insert into a full cache sweeps a
+// hand round the array, clearing the flags, to the first entry not
+// referenced since the last sweep, and replaces it.
+//
+// get() counts the hits and the misses. In a clock_cache the counters are
+// in a cache line of their own, apart from the members the lookups read.
+//
+// Neither cache is synchronized. An lru_cache shared by threads needs an
+// exclusive lock around each call, get() and touch() included. In a
+// clock_cache the flags and the counters are relaxed atomics: get(),
+// touch(), peek() and contains() are safe under a shared (reader) lock,
+// put(), erase() and clear() need the exclusive one. This needs the
+// __atomic builtins of GCC or clang.
+//
+//    ttl::lru_cache<ttl::string, record> cache(1000);
+//    if (record *r = cache.get(key))
+//       return *r;
+//    return cache.put(key, load(key));
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_LRU_CACHE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_LRU_CACHE_HPP_ 1
+
+#include <new>
+#include <string.h>
+#include "types.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "memory_resource.hpp"
+#include "list.hpp"
+
+namespace ttl
+{
+   // the open addressing index of the caches: an Entry has a member hash
+   // and a key()
+   template<class Entry>
+   struct _cache_index
+   {
+      Entry **slots;
+      ttl::size_t mask;
+
+      // room for n entries, at most 3/4 of the slots
+      static ttl::size_t slots_for(ttl::size_t n)
+      {
+         ttl::size_t s = 4;
+         while (s - s / 4 < n)
+            s *= 2;
+         return s;
+      }
+
+      template<class KeyEqual, typename K>
+      Entry **find(const K &key, ttl::size_t hash) const
+      {
+         for (ttl::size_t i = hash & mask; slots[i]; i = (i + 1) & mask)
+            if (slots[i]->hash == hash && KeyEqual()(slots[i]->key(), key))
+               return slots + i;
+         return 0;
+      }
+      Entry **find(const Entry *e) const
+      {
+         ttl::size_t i = e->hash & mask;
+         while (slots[i] != e)
+            i = (i + 1) & mask;
+         return slots + i;
+      }
+      void insert(Entry *e)
+      {
+         ttl::size_t i = e->hash & mask;
+         while (slots[i])
+            i = (i + 1) & mask;
+         slots[i] = e;
+      }
+      // moves back the entries after the slot which are not at their home
+      // slot or between it and the slot
+      void erase(Entry **slot)
+      {
+         ttl::size_t i = slot - slots;
+         for (ttl::size_t j = (i + 1) & mask; slots[j]; j = (j + 1) & mask)
+         {
+            const ttl::size_t home = slots[j]->hash & mask;
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+               slots[i] = slots[j];
+               i = j;
+            }
+         }
+         slots[i] = 0;
+      }
+   };
+
+   // whether p points into the n bytes from first
+   inline bool _points_into(const void *p, const void *first, ttl::size_t n)
+   {
+      const char *c = static_cast<const char *>(p), *f = static_cast<const char *>(first);
+      return c >= f && c < f + n;
+   }
+
+   template<typename KT, typename T, typename Hash = hash<KT>, typename KeyEqual = equal_to<KT>,
+            typename Resource = new_delete_resource>
+   class lru_cache: private Resource
+   {
+   public:
+      typedef KT key_type;
+      typedef T mapped_type;
+      typedef pair<const KT, T> value_type;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+   private:
+      struct entry: list_node
+      {
+         ttl::size_t hash;
+         value_type value;
+         entry(ttl::size_t h, const KT &k, const T &v): hash(h), value(k, v) {}
+         const KT &key() const { return value.first; }
+      };
+
+      list_node head_; // the most recently used entry first
+      _cache_index<entry> index_;
+      size_type size_, capacity_;
+      unsigned long hits_, misses_;
+
+      lru_cache(const lru_cache &);
+      lru_cache &operator=(const lru_cache &);
+
+      entry *lookup(const KT &key) const
+      {
+         entry **slot = index_.template find<KeyEqual>(key, Hash()(key));
+         return slot ? *slot: 0;
+      }
+      void to_front(entry *e)
+      {
+         if (head_.next != e)
+         {
+            e->unlink();
+            head_.next->insert_before(e);
+         }
+      }
+      void destroy(entry *e)
+      {
+         e->~entry();
+         Resource::deallocate(e, sizeof(entry));
+      }
+
+   public:
+      class const_iterator;
+
+      // from the most to the least recently used entry
+      class iterator
+      {
+      public:
+         typedef typename lru_cache::value_type value_type;
+         typedef value_type *pointer;
+         typedef value_type &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         iterator() /* left uninitialized */ {}
+         reference operator*() const { return static_cast<entry *>(n_)->value; }
+         pointer operator->() const { return &static_cast<entry *>(n_)->value; }
+         iterator &operator++() { n_ = n_->next; return *this; }
+         iterator operator++(int) { iterator tmp(*this); n_ = n_->next; return tmp; }
+         iterator &operator--() { n_ = n_->prev; return *this; }
+         iterator operator--(int) { iterator tmp(*this); n_ = n_->prev; return tmp; }
+
+         bool operator==(const iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const iterator &other) const { return n_ != other.n_; }
+         bool operator==(const const_iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const const_iterator &other) const { return n_ != other.n_; }
+
+      private:
+         friend class lru_cache;
+         friend class lru_cache::const_iterator;
+         list_node *n_;
+         iterator(list_node *n): n_(n) {}
+      };
+      class const_iterator
+      {
+      public:
+         typedef typename lru_cache::value_type value_type;
+         typedef const value_type *pointer;
+         typedef const value_type &reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* left uninitialized */ {}
+         const_iterator(const iterator &o): n_(o.n_) {}
+         reference operator*() const { return static_cast<const entry *>(n_)->value; }
+         pointer operator->() const { return &static_cast<const entry *>(n_)->value; }
+         const_iterator &operator++() { n_ = n_->next; return *this; }
+         const_iterator operator++(int) { const_iterator tmp(*this); n_ = n_->next; return tmp; }
+         const_iterator &operator--() { n_ = n_->prev; return *this; }
+         const_iterator operator--(int) { const_iterator tmp(*this); n_ = n_->prev; return tmp; }
+
+         bool operator==(const const_iterator &other) const { return n_ == other.n_; }
+         bool operator!=(const const_iterator &other) const { return n_ != other.n_; }
+
+      private:
+         friend class lru_cache;
+         const list_node *n_;
+         const_iterator(const list_node *n): n_(n) {}
+      };
+
+      // a capacity of 0 is taken as 1
+      explicit lru_cache(size_type capacity, const Resource &r = Resource());
+      ~lru_cache()
+      {
+         clear();
+         Resource::deallocate(index_.slots, (index_.mask + 1) * sizeof(entry *));
+      }
+
+      iterator begin() { return iterator(head_.next); }
+      iterator end() { return iterator(&head_); }
+      const_iterator begin() const { return const_iterator(head_.next); }
+      const_iterator end() const { return const_iterator(&head_); }
+      const_iterator cbegin() const { return const_iterator(head_.next); }
+      const_iterator cend() const { return const_iterator(&head_); }
+
+      size_type size() const { return size_; }
+      size_type capacity() const { return capacity_; }
+      bool empty() const { return !size_; }
+      bool full() const { return size_ == capacity_; }
+
+      // the value of the key, made the most recently used, or 0
+      T *get(const KT &key)
+      {
+         entry *e = lookup(key);
+         if (!e)
+         {
+            ++misses_;
+            return 0;
+         }
+         ++hits_;
+         to_front(e);
+         return &e->value.second;
+      }
+      // the value of the key or 0, as it is: not counted, not touched
+      const T *peek(const KT &key) const
+      {
+         const entry *e = lookup(key);
+         return e ? &e->value.second: 0;
+      }
+      bool contains(const KT &key) const { return lookup(key) != 0; }
+      // makes the key the most recently used, false if it is not cached
+      bool touch(const KT &key)
+      {
+         entry *e = lookup(key);
+         if (e)
+            to_front(e);
+         return e != 0;
+      }
+
+      // sets the value of the key, made the most recently used; a new key
+      // in a full cache evicts the least recently used entry
+      T &put(const KT &key, const T &value);
+      bool erase(const KT &key);
+      void clear();
+
+      unsigned long hits() const { return hits_; }
+      unsigned long misses() const { return misses_; }
+      void reset_stats() { hits_ = misses_ = 0; }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   lru_cache<KT,T,Hash,KeyEqual,Resource>::lru_cache(size_type capacity, const Resource &r):
+      Resource(r), size_(0), capacity_(capacity ? capacity: 1), hits_(0), misses_(0)
+   {
+      head_.init();
+      const size_type slots = _cache_index<entry>::slots_for(capacity_);
+      index_.slots = static_cast<entry **>(Resource::allocate(slots * sizeof(entry *)));
+      index_.mask = slots - 1;
+      memset(index_.slots, 0, slots * sizeof(entry *));
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   T &lru_cache<KT,T,Hash,KeyEqual,Resource>::put(const KT &key, const T &value)
+   {
+      const ttl::size_t h = Hash()(key);
+      entry **slot = index_.template find<KeyEqual>(key, h);
+      if (slot)
+      {
+         entry *e = *slot;
+         e->value.second = value;
+         to_front(e);
+         return e->value.second;
+      }
+      void *p;
+      if (size_ < capacity_)
+      {
+         p = Resource::allocate(sizeof(entry));
+         ++size_;
+      }
+      else
+      {
+         entry *e = static_cast<entry *>(head_.prev);
+         if (_points_into(&key, e, sizeof(entry)) || _points_into(&value, e, sizeof(entry)))
+         {
+            // the key or the value is in the entry evicted
+            const KT key_copy(key);
+            const T value_copy(value);
+            return put(key_copy, value_copy);
+         }
+         index_.erase(index_.find(e));
+         e->unlink();
+         e->~entry();
+         p = e;
+      }
+      entry *e = ::new(p) entry(h, key, value);
+      head_.next->insert_before(e);
+      index_.insert(e);
+      return e->value.second;
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   bool lru_cache<KT,T,Hash,KeyEqual,Resource>::erase(const KT &key)
+   {
+      entry **slot = index_.template find<KeyEqual>(key, Hash()(key));
+      if (!slot)
+         return false;
+      entry *e = *slot;
+      index_.erase(slot);
+      e->unlink();
+      destroy(e);
+      --size_;
+      return true;
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   void lru_cache<KT,T,Hash,KeyEqual,Resource>::clear()
+   {
+      while (head_.next != &head_)
+      {
+         entry *e = static_cast<entry *>(head_.next);
+         e->unlink();
+         destroy(e);
+      }
+      memset(index_.slots, 0, (index_.mask + 1) * sizeof(entry *));
+      size_ = 0;
+   }
+
+   template<typename KT, typename T, typename Hash = hash<KT>, typename KeyEqual = equal_to<KT>,
+            typename Resource = new_delete_resource>
+   class clock_cache: private Resource
+   {
+   public:
+      typedef KT key_type;
+      typedef T mapped_type;
+      typedef pair<const KT, T> value_type;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+   private:
+      enum { unused, used, referenced };
+      struct entry
+      {
+         ttl::size_t hash; // or the next free entry
+         unsigned char state;
+         union
+         {
+            char bytes[sizeof(value_type)];
+            // the alignment of the fundamental types
+            void *p;
+            long long ll;
+            double d;
+         } storage;
+         value_type &value() { return *reinterpret_cast<value_type *>(storage.bytes); }
+         const value_type &value() const { return *reinterpret_cast<const value_type *>(storage.bytes); }
+         const KT &key() const { return value().first; }
+      };
+
+      entry *entries_;
+      _cache_index<entry> index_;
+      size_type size_, capacity_;
+      size_type hand_;
+      size_type fresh_; // the entries from fresh_ on were never used
+      size_type free_; // the erased entries, linked by their hash
+      char pad_[cache_line_size];
+      unsigned long hits_, misses_;
+
+      clock_cache(const clock_cache &);
+      clock_cache &operator=(const clock_cache &);
+
+      entry *lookup(const KT &key) const
+      {
+         entry **slot = index_.template find<KeyEqual>(key, Hash()(key));
+         return slot ? *slot: 0;
+      }
+      // the flags are set by the readers under a shared lock
+      static unsigned char state(const entry *e) { return __atomic_load_n(&e->state, __ATOMIC_RELAXED); }
+      static void set_state(entry *e, unsigned char s) { __atomic_store_n(&e->state, s, __ATOMIC_RELAXED); }
+      static void mark(entry *e)
+      {
+         if (state(e) != referenced)
+            set_state(e, referenced);
+      }
+      static void count(unsigned long &n) { __atomic_fetch_add(&n, 1, __ATOMIC_RELAXED); }
+      // the entry of a new key, unused
+      entry *take();
+
+   public:
+      // a capacity of 0 is taken as 1
+      explicit clock_cache(size_type capacity, const Resource &r = Resource());
+      ~clock_cache()
+      {
+         clear();
+         Resource::deallocate(index_.slots, (index_.mask + 1) * sizeof(entry *));
+         Resource::deallocate(entries_, capacity_ * sizeof(entry));
+      }
+
+      size_type size() const { return size_; }
+      size_type capacity() const { return capacity_; }
+      bool empty() const { return !size_; }
+      bool full() const { return size_ == capacity_; }
+
+      // the value of the key, marked referenced, or 0
+      T *get(const KT &key)
+      {
+         entry *e = lookup(key);
+         if (!e)
+         {
+            count(misses_);
+            return 0;
+         }
+         count(hits_);
+         mark(e);
+         return &e->value().second;
+      }
+      // the value of the key or 0, as it is: not counted, not referenced
+      const T *peek(const KT &key) const
+      {
+         const entry *e = lookup(key);
+         return e ? &e->value().second: 0;
+      }
+      bool contains(const KT &key) const { return lookup(key) != 0; }
+      // marks the key referenced, false if it is not cached
+      bool touch(const KT &key)
+      {
+         entry *e = lookup(key);
+         if (e)
+            mark(e);
+         return e != 0;
+      }
+
+      // sets the value of the key, marked referenced; a new key in a full
+      // cache replaces the first entry not referenced from the hand on
+      T &put(const KT &key, const T &value);
+      bool erase(const KT &key);
+      void clear();
+
+      unsigned long hits() const { return __atomic_load_n(&hits_, __ATOMIC_RELAXED); }
+      unsigned long misses() const { return __atomic_load_n(&misses_, __ATOMIC_RELAXED); }
+      void reset_stats()
+      {
+         __atomic_store_n(&hits_, 0, __ATOMIC_RELAXED);
+         __atomic_store_n(&misses_, 0, __ATOMIC_RELAXED);
+      }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   clock_cache<KT,T,Hash,KeyEqual,Resource>::clock_cache(size_type capacity, const Resource &r):
+      Resource(r), size_(0), capacity_(capacity ? capacity: 1), hand_(0), fresh_(0),
+      free_((size_type)-1), hits_(0), misses_(0)
+   {
+      entries_ = static_cast<entry *>(Resource::allocate(capacity_ * sizeof(entry)));
+      const size_type slots = _cache_index<entry>::slots_for(capacity_);
+      index_.slots = static_cast<entry **>(Resource::allocate(slots * sizeof(entry *)));
+      index_.mask = slots - 1;
+      memset(index_.slots, 0, slots * sizeof(entry *));
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   typename clock_cache<KT,T,Hash,KeyEqual,Resource>::entry *clock_cache<KT,T,Hash,KeyEqual,Resource>::take()
+   {
+      entry *e;
+      if (free_ != (size_type)-1)
+      {
+         e = entries_ + free_;
+         free_ = e->hash;
+      }
+      else if (fresh_ < capacity_)
+         e = entries_ + fresh_++;
+      else
+      {
+         // a second chance for the referenced entries, the erased ones are
+         // on the free list
+         for (;;)
+         {
+            e = entries_ + hand_;
+            if (++hand_ == capacity_)
+               hand_ = 0;
+            if (state(e) != referenced)
+               break;
+            set_state(e, used);
+         }
+         index_.erase(index_.find(e));
+         e->value().~value_type();
+         --size_;
+      }
+      return e;
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   T &clock_cache<KT,T,Hash,KeyEqual,Resource>::put(const KT &key, const T &value)
+   {
+      const ttl::size_t h = Hash()(key);
+      entry **slot = index_.template find<KeyEqual>(key, h);
+      if (slot)
+      {
+         entry *e = *slot;
+         e->value().second = value;
+         mark(e);
+         return e->value().second;
+      }
+      if (size_ == capacity_ && (_points_into(&key, entries_, capacity_ * sizeof(entry)) ||
+                                 _points_into(&value, entries_, capacity_ * sizeof(entry))))
+      {
+         // the key or the value may be in the entry evicted
+         const KT key_copy(key);
+         const T value_copy(value);
+         return put(key_copy, value_copy);
+      }
+      entry *e = take();
+      ::new(e->storage.bytes) value_type(key, value);
+      e->hash = h;
+      set_state(e, referenced);
+      index_.insert(e);
+      ++size_;
+      return e->value().second;
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   bool clock_cache<KT,T,Hash,KeyEqual,Resource>::erase(const KT &key)
+   {
+      entry **slot = index_.template find<KeyEqual>(key, Hash()(key));
+      if (!slot)
+         return false;
+      entry *e = *slot;
+      index_.erase(slot);
+      e->value().~value_type();
+      set_state(e, unused);
+      e->hash = free_;
+      free_ = e - entries_;
+      --size_;
+      return true;
+   }
+
+   template<typename KT, typename T, typename Hash, typename KeyEqual, typename Resource>
+   void clock_cache<KT,T,Hash,KeyEqual,Resource>::clear()
+   {
+      for (size_type i = 0; i < fresh_; ++i)
+         if (state(entries_ + i) != unused)
+            entries_[i].value().~value_type();
+      memset(index_.slots, 0, (index_.mask + 1) * sizeof(entry *));
+      size_ = hand_ = fresh_ = 0;
+      free_ = (size_type)-1;
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_LRU_CACHE_HPP_
@@ -14,7 +14,9 @@
 
 namespace ttl
 {
-   template<typename KT, typename T, typename Compare = less<KT> >
+   template<typename KT, typename T, typename Compare, typename Resource> class multimap;
+
+   template<typename KT, typename T, typename Compare = less<KT>, typename Resource = new_delete_resource>
    class map // unique keys to values
    {
    public:
@@ -42,7 +44,7 @@ namespace ttl
       };
 
    private:
-      typedef rbtree<KT, pair<const KT, T>, select_first< pair<const KT,T> >, Compare> tree_type;
+      typedef rbtree<KT, pair<const KT, T>, select_first< pair<const KT,T> >, Compare, Resource> tree_type;
       typedef typename tree_type::node node_type;
 
       tree_type rbtree_;
@@ -52,9 +54,9 @@ namespace ttl
 
       struct iterator
       {
-         typedef typename map<KT,T,Compare>::node_type node_type;
+         typedef typename map<KT,T,Compare,Resource>::node_type node_type;
       public:
-         typedef map<KT,T,Compare>::value_type value_type;
+         typedef map<KT,T,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
@@ -86,16 +88,17 @@ namespace ttl
          bool operator!=(const const_iterator &other) const { return other != *this; }
       private:
          node_type *ptr_;
-         friend class map<KT,T,Compare>;
-         friend class map<KT,T,Compare>::const_iterator;
+         friend class map<KT,T,Compare,Resource>;
+         friend class map<KT,T,Compare,Resource>::const_iterator;
+         friend class multimap<KT,T,Compare,Resource>;
          iterator(node_type *ptr): ptr_(ptr) {}
          static node_type *prev(const node_type *);
       };
       struct const_iterator
       {
-         typedef typename map<KT,T,Compare>::iterator::node_type node_type;
+         typedef typename map<KT,T,Compare,Resource>::iterator::node_type node_type;
       public:
-         typedef map<KT,T,Compare>::value_type value_type;
+         typedef map<KT,T,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
@@ -133,7 +136,8 @@ namespace ttl
          const_iterator(const iterator &other): ptr_(other.ptr_) {}
       private:
          const node_type *ptr_;
-         friend class map<KT,T,Compare>;
+         friend class map<KT,T,Compare,Resource>;
+         friend class multimap<KT,T,Compare,Resource>;
          const_iterator(const node_type *ptr): ptr_(ptr) {}
       };
 
@@ -167,14 +171,17 @@ namespace ttl
       }
 
       explicit map() {}
+      explicit map(const Resource &r): rbtree_(r) {}
       ~map() {}
 
-      map(const map &other)
+      map(const map &other):
+         rbtree_(other.rbtree_.get_resource())
       {
          rbtree_.assign(other.rbtree_);
       }
 
-      template<class InputIt> map(InputIt first, InputIt last)
+      template<class InputIt> map(InputIt first, InputIt last, const Resource &r = Resource()):
+         rbtree_(r)
       {
          insert(first, last);
       }
@@ -215,18 +222,59 @@ namespace ttl
       bool empty() const { return !rbtree_.get_root(); }
       size_type max_size() const { return (size_type)-1 / sizeof(node_type); }
 
-      iterator erase(const_iterator pos);
-      iterator erase(const_iterator first, const_iterator last);
+      iterator erase(const_iterator pos)
+      {
+         iterator next(static_cast<node_type *>(rbtree_base::next_node(pos.ptr_)));
+         rbtree_.destroy_node(rbtree_.remove(pos->first));
+         return next;
+      }
+      // O(log N) plus the destruction of the erased nodes
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         if (first != last)
+         {
+            if (last == cend())
+               rbtree_.erase_from(first->first);
+            else
+               rbtree_.erase_range(first->first, last->first);
+         }
+         return iterator(const_cast<node_type *>(last.ptr_));
+      }
+      // the keys in [lo, hi), returns their count
+      size_type erase_range(const KT &lo, const KT &hi)
+      {
+         return Compare()(lo, hi) ? rbtree_.erase_range(lo, hi): 0;
+      }
 
       size_type erase(const KT &key)
       {
          node_type *n = rbtree_.remove(key);
-         delete n;
-         return !!n;
+         if (!n)
+            return 0;
+         rbtree_.destroy_node(n);
+         return 1;
+      }
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key)
+      {
+         node_type *n = rbtree_.remove(key);
+         if (!n)
+            return 0;
+         rbtree_.destroy_node(n);
+         return 1;
       }
 
       void swap(map &other);
 
+      // Moves the values of other with keys not here to this, and destroys
+      // the rest of other, which must use the same memory resource;
+      // O(M log(N / M + 1)) for M values in other
+      void unite(map &other) { rbtree_.unite(other.rbtree_); }
+      // Erases the keys of other; O(M log(N / M + 1))
+      void subtract(const map &other) { rbtree_.subtract(other.rbtree_); }
+
+      const Resource &get_resource() const { return rbtree_.get_resource(); }
+
       //
       // The map template has unique keys (so all ranges are either empty or
       // 1 element long), so the amount of generated template code can be
@@ -241,24 +289,100 @@ namespace ttl
       iterator lower_bound(const KT &key) { return iterator(rbtree_.lower_bound(key)); }
       const_iterator lower_bound(const KT &key) const { return const_iterator(rbtree_.lower_bound(key)); }
 
-      iterator upper_bound(const KT &key);
-      const_iterator upper_bound(const KT &key) const;
+      iterator upper_bound(const KT &key) { return iterator(after(rbtree_.lower_bound(key), key)); }
+      const_iterator upper_bound(const KT &key) const { return const_iterator(after(rbtree_.lower_bound(key), key)); }
+
+      pair<iterator, iterator> equal_range(const KT &key)
+      {
+         node_type *lo = rbtree_.lower_bound(key);
+         return pair<iterator, iterator>(iterator(lo), iterator(after(lo, key)));
+      }
+      pair<const_iterator, const_iterator> equal_range(const KT &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(after(lo, key)));
+      }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key)
+      {
+         return iterator(rbtree_.find(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const
+      {
+         return const_iterator(rbtree_.find(key));
+      }
 
-      pair<iterator, iterator> equal_range(const KT &key);
-      pair<const_iterator, const_iterator> equal_range(const KT &key) const;
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const
+      {
+         return rbtree_.find(key) != rbtree_.end();
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key)
+      {
+         return iterator(rbtree_.lower_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.lower_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key)
+      {
+         return iterator(after(rbtree_.lower_bound(key), key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return const_iterator(after(rbtree_.lower_bound(key), key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, pair<iterator, iterator> >::type equal_range(const K &key)
+      {
+         node_type *lo = rbtree_.lower_bound(key);
+         return pair<iterator, iterator>(iterator(lo), iterator(after(lo, key)));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+      equal_range(const K &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(after(lo, key)));
+      }
+
+   private:
+      // the node after lo = lower_bound(key) when it has the key
+      template<class K>
+      node_type *after(const node_type *lo, const K &key) const
+      {
+         if (lo != rbtree_.end() && !Compare()(key, lo->data.first))
+            lo = static_cast<const node_type *>(rbtree_base::next_node(lo));
+         return const_cast<node_type *>(lo);
+      }
    };
 
-   template<typename KT, typename T, typename Compare>
+   template<typename KT, typename T, typename Compare, typename Resource>
    template<class InputIt>
-   void map<KT,T,Compare>::insert(InputIt first, InputIt last)
+   void map<KT,T,Compare,Resource>::insert(InputIt first, InputIt last)
    {
       for (; first != last; ++first)
          rbtree_.insert_unique(value_type(first->first, first->second));
    }
 
-   template<typename KT, typename T, typename Compare>
-   typename map<KT,T,Compare>::iterator::node_type *
-   map<KT,T,Compare>::iterator::prev(const node_type *n)
+   template<typename KT, typename T, typename Compare, typename Resource>
+   typename map<KT,T,Compare,Resource>::iterator::node_type *
+   map<KT,T,Compare,Resource>::iterator::prev(const node_type *n)
    {
       // check if it is the sentinel/header
       if (!n->parent)
@@ -270,54 +394,247 @@ namespace ttl
       return const_cast<node_type *>(n);
    }
 
-   template<typename KT, typename T, typename Compare>
-   typename map<KT,T,Compare>::iterator map<KT,T,Compare>::upper_bound(const KT &key)
+   //
+   // The multimap: equal keys are kept in the order of their insertion.
+   // The ranges of a key are found in O(log N + K) for K values with it,
+   // and the values of a key are erased at once in the same.
+   //
+   template<typename KT, typename T, typename Compare = less<KT>, typename Resource = new_delete_resource>
+   class multimap // keys to values
    {
-      node_type *lo = rbtree_.lower_bound(key);
-      if (lo == rbtree_.end())
-         return end();
-      return iterator(static_cast<node_type *>(rbtree_base::next_node(lo)));
-   }
-   template<typename KT, typename T, typename Compare>
-   typename map<KT,T,Compare>::const_iterator map<KT,T,Compare>::upper_bound(const KT &key) const
-   {
-      const node_type *lo = rbtree_.lower_bound(key);
-      if (lo == rbtree_.end())
-         return end();
-      return const_iterator(static_cast<const node_type *>(rbtree_base::next_node(lo)));
-   }
+   public:
+      typedef KT key_type;
+      typedef T mapped_type;
+      typedef pair<const KT, T> value_type;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+      typedef Compare key_compare;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+      typedef typename map<KT,T,Compare,Resource>::value_compare value_compare;
+
+      // the iterators are those of the map
+      typedef typename map<KT,T,Compare,Resource>::iterator iterator;
+      typedef typename map<KT,T,Compare,Resource>::const_iterator const_iterator;
 
-   template<typename KT, typename T, typename Compare>
-   pair<typename map<KT,T,Compare>::iterator, typename map<KT,T,Compare>::iterator>
-   map<KT,T,Compare>::equal_range(const KT &key)
+   private:
+      typedef rbtree<KT, pair<const KT, T>, select_first< pair<const KT,T> >, Compare, Resource> tree_type;
+      typedef typename tree_type::node node_type;
+
+      tree_type rbtree_;
+
+   public:
+      iterator end() { return iterator(rbtree_.end()); }
+      const_iterator end() const { return const_iterator(rbtree_.end()); }
+      const_iterator cend() const { return end(); }
+
+      iterator begin()
+      {
+         rbnode *root = rbtree_.get_root();
+         return root ? iterator(static_cast<node_type *>(rbtree_base::min_node(root))): end();
+      }
+      const_iterator begin() const
+      {
+         const rbnode *root = rbtree_.get_root();
+         return root ? const_iterator(static_cast<const node_type *>(rbtree_base::min_node(root))): end();
+      }
+      const_iterator cbegin() const { return begin(); }
+
+      explicit multimap() {}
+      explicit multimap(const Resource &r): rbtree_(r) {}
+      ~multimap() {}
+
+      multimap(const multimap &other):
+         rbtree_(other.rbtree_.get_resource())
+      {
+         rbtree_.assign(other.rbtree_);
+      }
+
+      template<class InputIt> multimap(InputIt first, InputIt last, const Resource &r = Resource()):
+         rbtree_(r)
+      {
+         insert(first, last);
+      }
+
+      multimap &operator=(const multimap &other)
+      {
+         clear();
+         rbtree_.assign(other.rbtree_);
+         return *this;
+      }
+
+      // After the values with an equal key
+      iterator insert(const value_type &value) { return iterator(rbtree_.insert_equal(value)); }
+
+      template<class InputIt> void insert(InputIt first, InputIt last)
+      {
+         for (; first != last; ++first)
+            rbtree_.insert_equal(value_type(first->first, first->second));
+      }
+
+      void clear()
+      {
+         rbtree_.clear();
+      }
+
+      bool empty() const { return !rbtree_.get_root(); }
+      size_type max_size() const { return (size_type)-1 / sizeof(node_type); }
+
+      // O(log N), this value and not another of the key
+      iterator erase(const_iterator pos)
+      {
+         iterator next(static_cast<node_type *>(rbtree_base::next_node(pos.ptr_)));
+         rbtree_.destroy_node(rbtree_.remove(const_cast<node_type *>(pos.ptr_)));
+         return next;
+      }
+      // O(log N) plus the destruction of the erased nodes when the range
+      // does not split the values of a key, else one by one
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         if (first == last)
+            ;
+         else if (!starts_key(first))
+            while (first != last)
+               first = erase(first);
+         else if (last == cend())
+            rbtree_.erase_from(first->first);
+         else if (starts_key(last))
+            rbtree_.erase_range(first->first, last->first);
+         else
+            while (first != last)
+               first = erase(first);
+         return iterator(const_cast<node_type *>(last.ptr_));
+      }
+      // the keys in [lo, hi), returns their count
+      size_type erase_range(const KT &lo, const KT &hi)
+      {
+         return Compare()(lo, hi) ? rbtree_.erase_range(lo, hi): 0;
+      }
+
+      // All the values of the key, returns their count; O(log N + K)
+      size_type erase(const KT &key) { return rbtree_.erase_equal(key); }
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key)
+      {
+         return rbtree_.erase_equal(key);
+      }
+
+      const Resource &get_resource() const { return rbtree_.get_resource(); }
+
+      // the first value of the key
+      iterator find(const KT &key) { return iterator(first_of(key)); }
+      const_iterator find(const KT &key) const { return const_iterator(first_of(key)); }
+
+      size_type count(const KT &key) const { return rbtree_.count(key); }
+
+      iterator lower_bound(const KT &key) { return iterator(rbtree_.lower_bound(key)); }
+      const_iterator lower_bound(const KT &key) const { return const_iterator(rbtree_.lower_bound(key)); }
+
+      iterator upper_bound(const KT &key) { return iterator(rbtree_.upper_bound(key)); }
+      const_iterator upper_bound(const KT &key) const { return const_iterator(rbtree_.upper_bound(key)); }
+
+      // O(log N), the values of the key are the K steps between
+      pair<iterator, iterator> equal_range(const KT &key)
+      {
+         return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+      }
+      pair<const_iterator, const_iterator> equal_range(const KT &key) const
+      {
+         return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+      }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key) { return iterator(first_of(key)); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const
+      {
+         return const_iterator(first_of(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const { return rbtree_.count(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key)
+      {
+         return iterator(rbtree_.lower_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.lower_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key)
+      {
+         return iterator(rbtree_.upper_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.upper_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, pair<iterator, iterator> >::type equal_range(const K &key)
+      {
+         return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+      equal_range(const K &key) const
+      {
+         return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+      }
+
+   private:
+      template<class K>
+      node_type *first_of(const K &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         if (lo != rbtree_.end() && Compare()(key, lo->data.first))
+            lo = rbtree_.end();
+         return const_cast<node_type *>(lo);
+      }
+      // whether i is the first value of its key
+      bool starts_key(const_iterator i) const
+      {
+         if (i == begin())
+            return true;
+         const_iterator prev(i);
+         return Compare()((--prev)->first, i->first);
+      }
+   };
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename KT, typename T, typename Compare, typename Resource>
+   bool operator==(const map<KT,T,Compare,Resource> &a, const map<KT,T,Compare,Resource> &b)
    {
-      node_type *lo = rbtree_.lower_bound(key);
-      node_type *up = lo;
-      if (lo != rbtree_.end())
-         up = static_cast<node_type *>(rbtree_base::next_node(lo));
-      return pair<iterator, iterator>(iterator(lo), iterator(up));
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template<typename KT, typename T, typename Compare>
-   pair<typename map<KT,T,Compare>::const_iterator, typename map<KT,T,Compare>::const_iterator>
-   map<KT,T,Compare>::equal_range(const KT &key) const
+   template <typename KT, typename T, typename Compare, typename Resource>
+   bool operator!=(const map<KT,T,Compare,Resource> &a, const map<KT,T,Compare,Resource> &b)
    {
-      const node_type *lo = rbtree_.lower_bound(key);
-      const node_type *up = lo;
-      if (lo != rbtree_.end())
-         up = static_cast<const node_type *>(rbtree_base::next_node(lo));
-      return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(up));
+      return !(a == b);
    }
 
-   template<class InputIt1, class InputIt2>
-   bool equal(InputIt1, InputIt1, InputIt2);
-
-   template <typename KT, typename T, typename Compare>
-   bool operator==(const map<KT,T,Compare> &a, const map<KT,T,Compare> &b)
+   template <typename KT, typename T, typename Compare, typename Resource>
+   bool operator==(const multimap<KT,T,Compare,Resource> &a, const multimap<KT,T,Compare,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template <typename KT, typename T, typename Compare>
-   bool operator!=(const map<KT,T,Compare> &a, const map<KT,T,Compare> &b)
+   template <typename KT, typename T, typename Compare, typename Resource>
+   bool operator!=(const multimap<KT,T,Compare,Resource> &a, const multimap<KT,T,Compare,Resource> &b)
    {
       return !(a == b);
    }
@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: the mapping between an object and the node of an
+// intrusive container embedded in it as a member (the hook)
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_MEMBER_HOOK_HPP_
+#define _TINY_TEMPLATE_LIBRARY_MEMBER_HOOK_HPP_ 1
+
+#include "types.hpp"
+
+namespace ttl
+{
+   template<typename T, typename Node, Node T::*Hook>
+   struct member_hook
+   {
+      static Node *node(T &value) { return &(value.*Hook); }
+      static const Node *node(const T &value) { return &(value.*Hook); }
+
+      static T *owner(Node *n)
+      {
+         return reinterpret_cast<T *>(reinterpret_cast<char *>(n) - offset());
+      }
+      static const T *owner(const Node *n)
+      {
+         return reinterpret_cast<const T *>(reinterpret_cast<const char *>(n) - offset());
+      }
+
+   private:
+      // offsetof() for a pointer to member; any aligned address would do,
+      // the null one is avoided for the sake of the optimizer
+      static ttl::ptrdiff_t offset()
+      {
+         const T *p = reinterpret_cast<const T *>(256);
+         return reinterpret_cast<const char *>(&(p->*Hook)) - reinterpret_cast<const char *>(p);
+      }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_MEMBER_HOOK_HPP_
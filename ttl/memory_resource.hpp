@@ -0,0 +1,255 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: memory resources for the containers
+//
+// A memory resource is a copyable class with the methods
+//
+//    void *allocate(ttl::size_t size);
+//    void deallocate(void *p, ttl::size_t size);
+//
+// where size is the same in both calls, and deallocate(0, size) does
+// nothing. The allocating containers take one as their last template
+// parameter, default to new_delete_resource and keep a copy of it as an
+// (empty, in the default case) base, so they cost nothing extra unless a
+// resource is used.
+//
+// The arena and the pool below hold state and are not copyable; a container
+// refers to one through a resource_ref:
+//
+//    ttl::monotonic_arena arena;
+//    ttl::vector<int, ttl::resource_ref<ttl::monotonic_arena> > v(arena);
+//
+// The memory is aligned for any fundamental type.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_MEMORY_RESOURCE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_MEMORY_RESOURCE_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+
+namespace ttl
+{
+   // the alignment of the global operator new (and of malloc)
+   static const ttl::size_t max_align = 2 * sizeof(void *);
+
+   struct new_delete_resource
+   {
+      void *allocate(ttl::size_t size) { return ::operator new(size); }
+      void deallocate(void *p, ttl::size_t) { ::operator delete(p); }
+   };
+
+   inline bool operator==(const new_delete_resource &, const new_delete_resource &) { return true; }
+   inline bool operator!=(const new_delete_resource &, const new_delete_resource &) { return false; }
+
+   template<class Resource>
+   class resource_ref
+   {
+      Resource *r_;
+   public:
+      resource_ref(Resource &r): r_(&r) {}
+
+      void *allocate(ttl::size_t size) { return r_->allocate(size); }
+      void deallocate(void *p, ttl::size_t size) { r_->deallocate(p, size); }
+
+      Resource &resource() const { return *r_; }
+      bool operator==(const resource_ref &other) const { return r_ == other.r_; }
+      bool operator!=(const resource_ref &other) const { return r_ != other.r_; }
+   };
+
+   //
+   // Hands out memory from big chunks by bumping a pointer and releases it
+   // all at once, on release() or on destruction: deallocate() only takes
+   // back the latest allocation. Good for containers that live as long as
+   // a request or a frame. The first chunk may be supplied by the caller
+   // (e.g. on the stack), the others are taken from the global operator new.
+   //
+   class monotonic_arena
+   {
+      struct chunk
+      {
+         chunk *next;
+         ttl::size_t size;
+      };
+
+      char *cur_, *end_;
+      chunk *chunks_;
+      char *initial_;
+      ttl::size_t initial_size_, chunk_size_, allocated_;
+
+      monotonic_arena(const monotonic_arena &);
+      monotonic_arena &operator=(const monotonic_arena &);
+
+      static ttl::size_t align(ttl::size_t n) { return (n + max_align - 1) & ~(max_align - 1); }
+      static char *align(char *p)
+      {
+         return p + (align((ttl::size_t)p) - (ttl::size_t)p);
+      }
+
+      void *grow(ttl::size_t size);
+
+   public:
+      explicit monotonic_arena(ttl::size_t chunk_size = 4096):
+         cur_(0), end_(0), chunks_(0), initial_(0), initial_size_(0),
+         chunk_size_(chunk_size), allocated_(0)
+      {}
+      monotonic_arena(void *buffer, ttl::size_t size, ttl::size_t chunk_size = 4096):
+         cur_(static_cast<char *>(buffer)), end_(cur_ + size), chunks_(0),
+         initial_(cur_), initial_size_(size), chunk_size_(chunk_size), allocated_(0)
+      {}
+      ~monotonic_arena() { release(); }
+
+      void *allocate(ttl::size_t size)
+      {
+         char *p = align(cur_);
+         if (p > end_ || (ttl::size_t)(end_ - p) < size)
+            return grow(size);
+         cur_ = p + size;
+         allocated_ += size;
+         return p;
+      }
+      void deallocate(void *p, ttl::size_t size)
+      {
+         if (p && static_cast<char *>(p) + size == cur_)
+         {
+            cur_ = static_cast<char *>(p);
+            allocated_ -= size;
+         }
+      }
+
+      // the bytes in use, not counting the alignment padding
+      ttl::size_t allocated() const { return allocated_; }
+
+      // frees everything at once, the memory of the containers using the
+      // arena must not be used afterwards
+      void release();
+   };
+
+   inline void *monotonic_arena::grow(ttl::size_t size)
+   {
+      const ttl::size_t header = align(sizeof(chunk));
+      ttl::size_t n = header + align(size);
+      if (n < chunk_size_)
+         n = chunk_size_;
+      chunk *c = static_cast<chunk *>(::operator new(n));
+      c->next = chunks_;
+      c->size = n;
+      chunks_ = c;
+      char *p = reinterpret_cast<char *>(c) + header;
+      cur_ = p + size;
+      end_ = reinterpret_cast<char *>(c) + n;
+      allocated_ += size;
+      return p;
+   }
+
+   inline void monotonic_arena::release()
+   {
+      while (chunks_)
+      {
+         chunk *c = chunks_;
+         chunks_ = c->next;
+         ::operator delete(c);
+      }
+      cur_ = initial_;
+      end_ = initial_ + initial_size_;
+      allocated_ = 0;
+   }
+
+   //
+   // A pool of blocks of one size, for the nodes of the lists and the trees:
+   // allocation and deallocation pop and push a free list. The blocks are
+   // carved out of chunks of blocks_per_chunk blocks, which are freed only
+   // with the pool. The block size is given to the constructor, or taken
+   // from the first allocation if 0; the bigger allocations are passed to
+   // the global operator new.
+   //
+   class fixed_pool
+   {
+      struct block
+      {
+         block *next;
+      };
+
+      block *free_;
+      block *chunks_;
+      ttl::size_t block_size_, blocks_per_chunk_;
+
+      fixed_pool(const fixed_pool &);
+      fixed_pool &operator=(const fixed_pool &);
+
+      void grow();
+
+   public:
+      explicit fixed_pool(ttl::size_t block_size = 0, ttl::size_t blocks_per_chunk = 64):
+         free_(0), chunks_(0), block_size_(0), blocks_per_chunk_(blocks_per_chunk)
+      {
+         if (block_size)
+            set_block_size(block_size);
+      }
+      ~fixed_pool();
+
+      ttl::size_t block_size() const { return block_size_; }
+
+      void *allocate(ttl::size_t size)
+      {
+         if (!block_size_)
+            set_block_size(size);
+         if (size > block_size_)
+            return ::operator new(size);
+         if (!free_)
+            grow();
+         block *b = free_;
+         free_ = b->next;
+         return b;
+      }
+      void deallocate(void *p, ttl::size_t size)
+      {
+         if (!p)
+            return;
+         if (size > block_size_)
+         {
+            ::operator delete(p);
+            return;
+         }
+         block *b = static_cast<block *>(p);
+         b->next = free_;
+         free_ = b;
+      }
+
+   private:
+      void set_block_size(ttl::size_t size)
+      {
+         if (size < sizeof(block))
+            size = sizeof(block);
+         block_size_ = (size + max_align - 1) & ~(max_align - 1);
+      }
+   };
+
+   inline void fixed_pool::grow()
+   {
+      // the first block of a chunk links the chunks
+      char *c = static_cast<char *>(::operator new(block_size_ * (blocks_per_chunk_ + 1)));
+      block *head = reinterpret_cast<block *>(c);
+      head->next = chunks_;
+      chunks_ = head;
+      for (ttl::size_t i = blocks_per_chunk_; i > 0; --i)
+      {
+         block *b = reinterpret_cast<block *>(c + i * block_size_);
+         b->next = free_;
+         free_ = b;
+      }
+   }
+
+   inline fixed_pool::~fixed_pool()
+   {
+      while (chunks_)
+      {
+         block *c = chunks_;
+         chunks_ = c->next;
+         ::operator delete(c);
+      }
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_MEMORY_RESOURCE_HPP_
@@ -0,0 +1,149 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a priority queue on a d-ary heap
+//
+// The heap is kept in a ttl::vector. The children of the element i are at
+// Arity*i + 1 ... Arity*i + Arity, so a 4-ary heap is half as deep as a
+// binary one and the children compared on each level of sift-down share a
+// cache line (for small elements).
+//
+// As in STL, top() is the greatest element according to Compare.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_PRIORITY_QUEUE_HPP_
+#define _TINY_TEMPLATE_LIBRARY_PRIORITY_QUEUE_HPP_ 1
+
+#include "types.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace ttl
+{
+   template<typename T, typename Compare = ttl::less<T>, const unsigned int Arity = 4>
+   class priority_queue
+   {
+   public:
+      typedef ttl::vector<T>   container_type;
+      typedef Compare          value_compare;
+      typedef T                value_type;
+      typedef T               &reference;
+      typedef const T         &const_reference;
+      typedef ttl::size_t      size_type;
+
+   private:
+      container_type c_;
+      Compare comp_;
+
+      void grow(size_type n)
+      {
+         size_type cap = c_.capacity();
+         if (n <= cap)
+            return;
+         cap = cap ? cap * 2: 16;
+         c_.reserve(cap < n ? n: cap);
+      }
+      void sift_up(size_type hole);
+      void sift_down(size_type hole);
+
+   public:
+      explicit priority_queue(const Compare &comp = Compare()): comp_(comp) {}
+      template<typename InputIterator>
+      priority_queue(InputIterator first, InputIterator last, const Compare &comp = Compare()):
+         comp_(comp)
+      {
+         push_range(first, last);
+      }
+
+      const_reference top() const { return c_.front(); }
+      bool empty() const { return c_.empty(); }
+      size_type size() const { return c_.size(); }
+      void reserve(size_type n) { grow(n); }
+
+      void push(const value_type &value)
+      {
+         grow(c_.size() + 1);
+         c_.push_back(value);
+         sift_up(c_.size() - 1);
+      }
+
+      // Appends the elements and restores the heap: one by one if the batch
+      // is small, otherwise by Floyd's O(N) bottom-up heap construction.
+      template<typename InputIterator>
+      void push_range(InputIterator first, InputIterator last);
+
+      void pop()
+      {
+         c_.front() = c_.back();
+         c_.pop_back();
+         if (!c_.empty())
+            sift_down(0);
+      }
+
+      void clear() { c_.clear(); }
+
+      void swap(priority_queue &other)
+      {
+         c_.swap(other.c_);
+         ttl::swap(comp_, other.comp_);
+      }
+   };
+
+   template<typename T, typename Compare, const unsigned int Arity>
+   void priority_queue<T,Compare,Arity>::sift_up(size_type hole)
+   {
+      const T value = c_[hole];
+      for (size_type parent; hole > 0 && comp_(c_[parent = (hole - 1) / Arity], value); hole = parent)
+         c_[hole] = c_[parent];
+      c_[hole] = value;
+   }
+
+   template<typename T, typename Compare, const unsigned int Arity>
+   void priority_queue<T,Compare,Arity>::sift_down(size_type hole)
+   {
+      const size_type n = c_.size();
+      const T value = c_[hole];
+      for (;;)
+      {
+         size_type child = Arity * hole + 1;
+         if (child >= n)
+            break;
+         const size_type last = n - child < Arity ? n: child + Arity;
+         size_type best = child;
+         for (++child; child < last; ++child)
+            if (comp_(c_[best], c_[child]))
+               best = child;
+         if (!comp_(value, c_[best]))
+            break;
+         c_[hole] = c_[best];
+         hole = best;
+      }
+      c_[hole] = value;
+   }
+
+   template<typename T, typename Compare, const unsigned int Arity>
+   template<typename InputIterator>
+   void priority_queue<T,Compare,Arity>::push_range(InputIterator first, InputIterator last)
+   {
+      const size_type old = c_.size();
+      for (; first != last; ++first)
+      {
+         grow(c_.size() + 1);
+         c_.push_back(*first);
+      }
+      const size_type n = c_.size();
+      if (n - old < old)
+      {
+         for (size_type i = old; i < n; ++i)
+            sift_up(i);
+      }
+      else if (n > 1)
+      {
+         for (size_type i = (n - 2) / Arity + 1; i-- > 0; )
+            sift_down(i);
+      }
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_PRIORITY_QUEUE_HPP_
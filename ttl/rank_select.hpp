@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a rank/select index over a bitset
+//
+// rank(pos) is the number of set bits before pos and select(k) the position
+// of the k-th set bit (from 0), both answered without counting from the
+// start of the set:
+//
+//    ttl::dynamic_bitset<> present(n);
+//    ...
+//    ttl::rank_select<ttl::dynamic_bitset<> > index(present);
+//    ttl::size_t slot = index.rank(id);     // the dense index of id
+//    ttl::size_t id = index.select(slot);   // and back
+//
+// The index keeps the count of the set bits before every 4096 bits (64
+// bits) and, relative to that, before every 512 bits (16 bits), about 4.7%
+// of the size of the set, so rank is O(1). select starts from the block of
+// every 8192-th set bit, so it is O(1) for the usual densities and
+// O(log N) for very sparse sets.
+//
+// Bits is bitset<N> or dynamic_bitset: the index refers to it and must be
+// rebuilt (build()) after it changes.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_RANK_SELECT_HPP_
+#define _TINY_TEMPLATE_LIBRARY_RANK_SELECT_HPP_ 1
+
+#include "types.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "bitset.hpp"
+
+namespace ttl
+{
+   template<class Bits>
+   class rank_select
+   {
+   public:
+      typedef ttl::size_t size_type;
+
+   private:
+      typedef bitset_slots::slot_type slot_type;
+      static const size_type slot_bits = bitset_slots::slot_bits;
+      static const size_type block_bits = 512;
+      static const size_type super_blocks = 8;          // blocks per superblock
+      static const size_type block_slots = block_bits / slot_bits;
+      static const size_type select_sample = 8192;      // set bits per hint
+
+      const Bits &bits_;
+      size_type count_;
+      vector<unsigned long long> super_; // set bits before each superblock
+      vector<unsigned short> block_;     // and before each block, in its superblock
+      vector<size_type> hints_;          // the block of every select_sample-th set bit
+
+      size_type slots() const { return (bits_.size() + slot_bits - 1) / slot_bits; }
+      // the slot with the bits past the end cleared
+      slot_type slot(size_type s) const
+      {
+         slot_type w = bits_.slot(s);
+         if (s == bits_.size() / slot_bits && bits_.size() % slot_bits)
+            w &= ((slot_type)1 << bits_.size() % slot_bits) - 1;
+         return w;
+      }
+      size_type block_rank(size_type b) const { return super_[b / super_blocks] + block_[b]; }
+
+      rank_select(const rank_select &);
+      rank_select &operator=(const rank_select &);
+
+   public:
+      explicit rank_select(const Bits &bits): bits_(bits), count_(0) { build(); }
+
+      void build();
+
+      size_type size() const { return bits_.size(); }
+      size_type count() const { return count_; }
+      // the memory of the index, not counting the set
+      size_type size_in_bytes() const
+      {
+         return super_.capacity() * sizeof(unsigned long long) +
+            block_.capacity() * sizeof(unsigned short) + hints_.capacity() * sizeof(size_type);
+      }
+
+      // the set bits before pos, pos <= size()
+      size_type rank(size_type pos) const;
+      // the clear bits before pos
+      size_type rank0(size_type pos) const { return pos - rank(pos); }
+      // the position of the k-th set bit, or size() if k >= count()
+      size_type select(size_type k) const;
+   };
+
+   template<class Bits>
+   void rank_select<Bits>::build()
+   {
+      const size_type n = slots();
+      const size_type blocks = (n + block_slots - 1) / block_slots;
+      super_.clear();
+      block_.clear();
+      hints_.clear();
+      super_.reserve(blocks / super_blocks + 2);
+      block_.reserve(blocks + 1);
+      size_type total = 0, rel = 0;
+      for (size_type b = 0; b <= blocks; ++b)
+      {
+         if (b % super_blocks == 0)
+         {
+            super_.push_back(total);
+            rel = 0;
+         }
+         // one more block, so that the end has a rank too
+         block_.push_back((unsigned short)rel);
+         if (b == blocks)
+            break;
+         size_type c = 0;
+         for (size_type s = b * block_slots; s < n && s < (b + 1) * block_slots; ++s)
+            c += bitset_slots::popcount(slot(s));
+         while (hints_.size() * select_sample < total + c)
+            hints_.push_back(b);
+         total += c;
+         rel += c;
+      }
+      count_ = total;
+   }
+
+   template<class Bits>
+   typename rank_select<Bits>::size_type rank_select<Bits>::rank(size_type pos) const
+   {
+      const size_type b = pos / block_bits;
+      size_type r = block_rank(b);
+      size_type s = b * block_slots;
+      for (; s < pos / slot_bits; ++s)
+         r += bitset_slots::popcount(slot(s));
+      if (pos % slot_bits)
+         r += bitset_slots::popcount(slot(s) & (((slot_type)1 << pos % slot_bits) - 1));
+      return r;
+   }
+
+   template<class Bits>
+   typename rank_select<Bits>::size_type rank_select<Bits>::select(size_type k) const
+   {
+      if (k >= count_)
+         return size();
+      // the last block with a rank not above k, between the hints
+      const size_type h = k / select_sample;
+      size_type lo = hints_[h];
+      size_type hi = h + 1 < hints_.size() ? hints_[h + 1] + 1: block_.size() - 1;
+      while (hi - lo > 1)
+      {
+         const size_type mid = lo + (hi - lo) / 2;
+         if (block_rank(mid) <= k)
+            lo = mid;
+         else
+            hi = mid;
+      }
+      k -= block_rank(lo);
+      size_type s = lo * block_slots;
+      slot_type w;
+      for (;; ++s)
+      {
+         w = slot(s);
+         const size_type c = bitset_slots::popcount(w);
+         if (k < c)
+            break;
+         k -= c;
+      }
+      for (; k; --k)
+         w &= w - 1;
+      return s * slot_bits + bitset_slots::lowest(w);
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_RANK_SELECT_HPP_
@@ -9,6 +9,9 @@
 #ifndef _TINY_TEMPLATE_LIBRARY_RBTREE_HPP_
 #define _TINY_TEMPLATE_LIBRARY_RBTREE_HPP_ 1
 
+#include <new>
+#include "memory_resource.hpp"
+
 namespace ttl
 {
    template<typename T1, typename T2> struct pair;
@@ -65,6 +68,157 @@ namespace ttl
       static rbnode *move_right(rbnode *pivot);
 
       rbnode *delete_min(rbnode **root);
+
+      void link_node(rbnode **edge, rbnode *parent, rbnode *n)
+      {
+         n->parent = parent;
+         *edge = n;
+         insert_rebalance(edge, parent);
+      }
+
+      //
+      // The searches by key, shared by the trees owning their nodes and the
+      // intrusive ones; keyof(const rbnode *) returns the key of a node.
+      // The key searched for may be of any type the Compare takes with the
+      // keys, the equal keys are those neither less nor greater.
+      //
+      template<class K, class KeyOfNode, class Compare>
+      const rbnode *find_node(const K &, const KeyOfNode &, const Compare &) const;
+      template<class K, class KeyOfNode, class Compare>
+      const rbnode *lower_bound_node(const K &, const KeyOfNode &, const Compare &) const;
+      template<class K, class KeyOfNode, class Compare>
+      const rbnode *upper_bound_node(const K &, const KeyOfNode &, const Compare &) const;
+
+      // The edge to link a node with the key to (and its parent), or, if
+      // unique, the edge to the node with the key when there is one
+      template<class K, class KeyOfNode, class Compare>
+      rbnode **insert_edge(const K &, rbnode **parent, bool unique,
+                           const KeyOfNode &, const Compare &);
+
+      // Unlinks and returns a node with the key, or 0
+      template<class K, class KeyOfNode, class Compare>
+      rbnode *remove_node(const K &key, const KeyOfNode &keyof, const Compare &is_less)
+      {
+         return remove_target(key_target<K, KeyOfNode, Compare>(key, keyof, is_less));
+      }
+      // Unlinks the node n, which is in the tree, of the equal keys too;
+      // O(log N) steps up to O(log N) long
+      rbnode *remove_node(const rbnode *n) { return remove_target(node_target(n)); }
+
+      // Unlinks and returns the node the Target leads to, or 0: before(n)
+      // is true when it is before n in order, and at(n), asked when it is
+      // not, when it is n
+      template<class Target>
+      rbnode *remove_target(const Target &);
+
+      //
+      // Joining and splitting of detached subtrees, after Blelloch, Ferizovic
+      // and Sun, "Just Join for Parallel Ordered Sets", 2016, kept
+      // left-leaning. A subtree is its root and its black height (the black
+      // nodes on a path down from the root, 0 for an empty one); the
+      // returned subtrees have a black root.
+      //
+      // Joining costs O(1 + the difference of the black heights), splitting
+      // and detaching the minimum O(log N); the nodes are relinked, not
+      // copied, so the pointers to them stay valid.
+      //
+      static int black_height(const rbnode *n);
+      // all of l < k < all of r
+      static rbnode *join(rbnode *l, int lh, rbnode *k, rbnode *r, int rh, int *h);
+      // all of l < all of r
+      static rbnode *join(rbnode *l, int lh, rbnode *r, int rh, int *h);
+      // unlinks the smallest node to *min, returns the rest
+      static rbnode *detach_min(rbnode *n, int nh, rbnode **min, int *h);
+      // the nodes for which before(n) is true (a prefix in order) to the
+      // returned subtree, the others to *r
+      template<class Before>
+      static rbnode *split(rbnode *n, int nh, const Before &before, rbnode **r, int *lh, int *rh);
+
+      // The whole tree as a subtree and back
+      rbnode *take_root(int *h)
+      {
+         rbnode *n = root_();
+         *h = black_height(n);
+         *root_edge() = 0;
+         return n;
+      }
+      void set_root(rbnode *n)
+      {
+         *root_edge() = n;
+         if (n)
+         {
+            n->parent = &header_;
+            n->color = rbnode::BLACK;
+         }
+      }
+
+      // Detaches and returns the nodes for which from(n) is false and to(n)
+      // is true, a range in order
+      template<class From, class To>
+      rbnode *cut(const From &from, const To &to);
+
+      // Moves the nodes of b to a, those with a key already in a to the
+      // list *dups linked by right; O(M log(N / M + 1)) for M nodes in b
+      template<class K, class KeyOfNode, class Compare>
+      static rbnode *unite(rbnode *a, int ah, rbnode *b, int bh, int *h, rbnode **dups,
+                           const KeyOfNode &, const Compare &);
+      // Moves the nodes of a with a key in b to the list *removed
+      template<class K, class KeyOfNode, class Compare>
+      static rbnode *subtract(rbnode *a, int ah, const rbnode *b, int *h, rbnode **removed,
+                              const KeyOfNode &, const Compare &);
+
+      // The predicates to split by a key
+      template<class K, class KeyOfNode, class Compare>
+      struct key_before
+      {
+         const K &key;
+         const KeyOfNode &keyof;
+         const Compare &is_less;
+         key_before(const K &k, const KeyOfNode &ko, const Compare &c): key(k), keyof(ko), is_less(c) {}
+         bool operator()(const rbnode *n) const { return is_less(keyof(n), key); }
+      };
+      template<class K, class KeyOfNode, class Compare>
+      struct key_not_after
+      {
+         const K &key;
+         const KeyOfNode &keyof;
+         const Compare &is_less;
+         key_not_after(const K &k, const KeyOfNode &ko, const Compare &c): key(k), keyof(ko), is_less(c) {}
+         bool operator()(const rbnode *n) const { return !is_less(key, keyof(n)); }
+      };
+      struct all_before
+      {
+         bool operator()(const rbnode *) const { return true; }
+      };
+
+      // The targets of remove_target
+      template<class K, class KeyOfNode, class Compare>
+      struct key_target
+      {
+         const K &key;
+         const KeyOfNode &keyof;
+         const Compare &is_less;
+         key_target(const K &k, const KeyOfNode &ko, const Compare &c): key(k), keyof(ko), is_less(c) {}
+         bool before(const rbnode *n) const { return is_less(key, keyof(n)); }
+         bool at(const rbnode *n) const { return !is_less(keyof(n), key); }
+      };
+      struct node_target
+      {
+         const rbnode *node;
+         node_target(const rbnode *n): node(n) {}
+         // n is on the way down to the node: whether it is in the left
+         // subtree of n is found on the way up from it
+         bool before(const rbnode *n) const
+         {
+            if (n == node)
+               return false;
+            const rbnode *c = node;
+            while (c->parent != n)
+               c = c->parent;
+            return c == n->left;
+         }
+         bool at(const rbnode *n) const { return n == node; }
+      };
    };
 
    inline void rbtree_base::flip_colors(rbnode *n)
@@ -226,249 +380,278 @@ namespace ttl
       }
       return deleted;
    }
-#endif //  RBTREE_MERGE(RBTREE_INLINEABLE) == 1
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   class rbtree: public rbtree_base
+   RBTREE_INLINEABLE int rbtree_base::black_height(const rbnode *n)
    {
-   public:
-      typedef KeyOfValue keyof_type;
-
-      struct node: rbnode
-      {
-         KV data;
-         node(const KV &d): data(d) {}
-      };
-
-      rbtree() {}
-      ~rbtree() { clear(); }
-
-      void assign(const rbtree &);
-
-      node *insert_equal(const KV &data);
-      pair<node *, bool> insert_unique(const KV &data);
-
-      node *remove(const K &key);
-
-      node *get_root() { return static_cast<node *>(root_()); }
-      const node *get_root() const { return static_cast<const node *>(root_()); }
-      const node *get_croot() const { return static_cast<const node *>(root_()); }
-
-      node *end() { return static_cast<node *>(&header_); }
-      const node *end() const { return static_cast<const node *>(&header_); }
+      int h = 0;
+      for (; n; n = n->left)
+         h += n->color == rbnode::BLACK;
+      return h;
+   }
 
-      const node *find(const K &) const;
-      node *find(const K &key)
+   RBTREE_INLINEABLE rbnode *rbtree_base::join(rbnode *l, int lh, rbnode *k, rbnode *r, int rh, int *h)
+   {
+      if (is_red(l))
+         l->color = rbnode::BLACK, ++lh;
+      if (is_red(r))
+         r->color = rbnode::BLACK, ++rh;
+      k->color = rbnode::RED;
+      if (lh == rh)
       {
-         return const_cast<node *>(static_cast<const rbtree *>(this)->find(key));
+         k->left = l;
+         k->right = r;
+         if (l)
+            l->parent = k;
+         if (r)
+            r->parent = k;
+         k->color = rbnode::BLACK;
+         *h = lh + 1;
+         return k;
       }
 
-      const node *lower_bound(const K &) const;
-      node *lower_bound(const K &key)
+      // k goes down the spine of the higher tree to the black node of the
+      // height of the other, and is fixed up as an inserted red node
+      rbnode *root = lh > rh ? l: r;
+      rbnode **path[128];
+      int depth = 0, ph = lh > rh ? lh: rh;
+      rbnode **e = &root, *parent = 0;
+      if (lh > rh)
       {
-         return const_cast<node *>(static_cast<const rbtree *>(this)->lower_bound(key));
+         // the right children are black
+         for (; ph > rh; --ph)
+         {
+            path[depth++] = e;
+            parent = *e;
+            e = &parent->right;
+         }
+         k->left = *e;
+         k->right = r;
       }
-
-      const node *upper_bound(const K &) const;
-      node *upper_bound(const K &key)
+      else
       {
-         return const_cast<node *>(static_cast<const rbtree *>(this)->upper_bound(key));
+         while (is_red(*e) || ph > lh)
+         {
+            path[depth++] = e;
+            parent = *e;
+            ph -= !is_red(parent);
+            e = &parent->left;
+         }
+         k->left = l;
+         k->right = *e;
       }
+      if (k->left)
+         k->left->parent = k;
+      if (k->right)
+         k->right->parent = k;
+      k->parent = parent;
+      *e = k;
+      while (depth--)
+         *path[depth] = fixup(*path[depth]);
+      *h = lh > rh ? lh: rh;
+      if (is_red(root))
+         root->color = rbnode::BLACK, ++*h;
+      return root;
+   }
 
-      pair<const node *, const node *> equal_range(const K &k) const
-      {
-         return pair<const node *, const node *>(lower_bound(k), upper_bound(k));
-      }
-      pair<node *, node *> equal_range(const K &k)
+   RBTREE_INLINEABLE rbnode *rbtree_base::join(rbnode *l, int lh, rbnode *r, int rh, int *h)
+   {
+      if (!r)
       {
-         return pair<node *, node *>(lower_bound(k), upper_bound(k));
+         if (is_red(l))
+            l->color = rbnode::BLACK, ++lh;
+         *h = lh;
+         return l;
       }
+      rbnode *k;
+      r = detach_min(r, rh, &k, &rh);
+      return join(l, lh, k, r, rh, h);
+   }
 
-      size_t count(const K &k) const;
-
-      void clear();
-
-   protected:
-      KeyOfValue keyof_;
-      Compare is_less_;
-
-      void postorder_destroy(node *n);
-      rbnode *preorder_copy(const node *n);
-   };
-
-   template <class K, class KV, class KeyOfValue, class Compare>
-   void rbtree<K,KV,KeyOfValue,Compare>::postorder_destroy(node *n)
+   RBTREE_INLINEABLE rbnode *rbtree_base::detach_min(rbnode *n, int nh, rbnode **min, int *h)
    {
-      if (!n)
-         return;
-
-      if (n->left)
-         postorder_destroy(static_cast<node *>(n->left));
-      if (n->right)
-         postorder_destroy(static_cast<node *>(n->right));
-      delete n;
+      const int ch = nh - !is_red(n);
+      if (!n->left)
+      {
+         *min = n;
+         rbnode *r = n->right;
+         *h = ch;
+         if (is_red(r))
+            r->color = rbnode::BLACK, ++*h;
+         return r;
+      }
+      int lh;
+      rbnode *right = n->right;
+      rbnode *l = detach_min(n->left, ch, min, &lh);
+      return join(l, lh, n, right, ch, h);
    }
+#endif //  RBTREE_MERGE(RBTREE_INLINEABLE) == 1
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   rbnode *rbtree<K,KV,KeyOfValue,Compare>::preorder_copy(const node *n)
+   template<class Before>
+   rbnode *rbtree_base::split(rbnode *n, int nh, const Before &before, rbnode **r, int *lh, int *rh)
    {
       if (!n)
+      {
+         *r = 0;
+         *lh = *rh = 0;
          return 0;
-      node *nc = new node(n->data);
-      nc->color = n->color;
-      if (n->left)
-         nc->left = preorder_copy(static_cast<const node *>(n->left)),
-         nc->left->parent = nc;
-      else
-         nc->left = 0;
-      if (n->right)
-         nc->right = preorder_copy(static_cast<const node *>(n->right)),
-         nc->right->parent = nc;
-      else
-         nc->right = 0;
-      return nc;
+      }
+      const int ch = nh - !is_red(n);
+      rbnode *left = n->left, *right = n->right;
+      if (before(n))
+      {
+         int mh;
+         rbnode *m = split(right, ch, before, r, &mh, rh);
+         return join(left, ch, n, m, mh, lh);
+      }
+      int mh;
+      rbnode *m;
+      rbnode *l = split(left, ch, before, &m, lh, &mh);
+      *r = join(m, mh, n, right, ch, rh);
+      return l;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   void rbtree<K,KV,KeyOfValue,Compare>::assign(const rbtree &other)
+   template<class From, class To>
+   rbnode *rbtree_base::cut(const From &from, const To &to)
    {
-      if (root_())
-         clear();
-      const node *otherroot = other.get_root();
-      if (otherroot)
-         (*root_edge() = preorder_copy(otherroot))->parent = &header_;
+      int h, lh, mh, rh;
+      rbnode *all = take_root(&h), *mid, *right;
+      rbnode *left = split(all, h, from, &mid, &lh, &mh);
+      mid = split(mid, mh, to, &right, &mh, &rh);
+      set_root(join(left, lh, right, rh, &h));
+      if (mid)
+         mid->parent = 0;
+      return mid;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   void rbtree<K,KV,KeyOfValue,Compare>::clear()
+   template<class K, class KeyOfNode, class Compare>
+   rbnode *rbtree_base::unite(rbnode *a, int ah, rbnode *b, int bh, int *h, rbnode **dups,
+                              const KeyOfNode &keyof, const Compare &is_less)
    {
-      node *root = static_cast<node *>(root_());
-      *root_edge() = 0;
-      postorder_destroy(root);
+      if (!b || !a)
+      {
+         rbnode *n = a ? a: b;
+         *h = a ? ah: bh;
+         if (is_red(n))
+            n->color = rbnode::BLACK, ++*h;
+         return n;
+      }
+      // the root of b splits a, and its subtrees are united with the parts
+      const int ch = bh - !is_red(b);
+      rbnode *k = b, *bl = b->left, *br = b->right, *ar;
+      int lh, rh;
+      rbnode *al = split(a, ah, key_before<K, KeyOfNode, Compare>(keyof(b), keyof, is_less),
+                         &ar, &lh, &rh);
+      if (ar && !is_less(keyof(b), keyof(min_node(ar))))
+      {
+         // a keeps its node
+         rbnode *dup = k;
+         ar = detach_min(ar, rh, &k, &rh);
+         dup->right = *dups;
+         *dups = dup;
+      }
+      rbnode *l = unite<K>(al, lh, bl, ch, &lh, dups, keyof, is_less);
+      rbnode *r = unite<K>(ar, rh, br, ch, &rh, dups, keyof, is_less);
+      return join(l, lh, k, r, rh, h);
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   size_t rbtree<K,KV,KeyOfValue,Compare>::count(const K &key) const
+   template<class K, class KeyOfNode, class Compare>
+   rbnode *rbtree_base::subtract(rbnode *a, int ah, const rbnode *b, int *h, rbnode **removed,
+                                 const KeyOfNode &keyof, const Compare &is_less)
    {
-      const rbnode *n = root_();
-      size_t c = 0;
-      while (n)
+      if (!a || !b)
       {
-         const K &nkey = keyof_(static_cast<const node *>(n)->data);
-         if (is_less_(nkey, key))
-            n = n->right;
-         else
-         {
-            if (nkey == key)
-               ++c;
-            n = n->left;
-         }
+         *h = ah;
+         if (is_red(a))
+            a->color = rbnode::BLACK, ++*h;
+         return a;
       }
-      return c;
+      rbnode *ar;
+      int lh, rh;
+      rbnode *al = split(a, ah, key_before<K, KeyOfNode, Compare>(keyof(b), keyof, is_less),
+                         &ar, &lh, &rh);
+      if (ar && !is_less(keyof(b), keyof(min_node(ar))))
+      {
+         rbnode *gone;
+         ar = detach_min(ar, rh, &gone, &rh);
+         gone->right = *removed;
+         *removed = gone;
+      }
+      rbnode *l = subtract<K>(al, lh, b->left, &lh, removed, keyof, is_less);
+      rbnode *r = subtract<K>(ar, rh, b->right, &rh, removed, keyof, is_less);
+      return join(l, lh, r, rh, h);
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   const typename rbtree<K,KV,KeyOfValue,Compare>::node *
-   rbtree<K,KV,KeyOfValue,Compare>::find(const K &key) const
+   template<class K, class KeyOfNode, class Compare>
+   const rbnode *rbtree_base::find_node(const K &key, const KeyOfNode &keyof, const Compare &is_less) const
    {
       const rbnode *n = root_();
       while (n)
       {
-         const K &nkey = keyof_(static_cast<const node *>(n)->data);
-         if (is_less_(key, nkey))
+         if (is_less(key, keyof(n)))
             n = n->left;
-         else if (key == nkey)
+         else if (!is_less(keyof(n), key))
             break;
          else
             n = n->right;
       }
-      return static_cast<const node *>(n ? n: &header_);
+      return n ? n: &header_;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   const typename rbtree<K,KV,KeyOfValue,Compare>::node *
-   rbtree<K,KV,KeyOfValue,Compare>::lower_bound(const K &key) const
+   template<class K, class KeyOfNode, class Compare>
+   const rbnode *rbtree_base::lower_bound_node(const K &key, const KeyOfNode &keyof, const Compare &is_less) const
    {
       const rbnode *n = root_(), *prev = &header_;
       while (n)
       {
-         if (is_less_(keyof_(static_cast<const node *>(n)->data), key))
+         if (is_less(keyof(n), key))
             n = n->right;
          else
             prev = n, n = n->left;
       }
-
-      return static_cast<const node *>(prev);
+      return prev;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   const typename rbtree<K,KV,KeyOfValue,Compare>::node *
-   rbtree<K,KV,KeyOfValue,Compare>::upper_bound(const K &key) const
+   template<class K, class KeyOfNode, class Compare>
+   const rbnode *rbtree_base::upper_bound_node(const K &key, const KeyOfNode &keyof, const Compare &is_less) const
    {
       const rbnode *n = root_(), *prev = &header_;
       while (n)
       {
-         if (is_less_(key, keyof_(static_cast<const node *>(n)->data)))
+         if (is_less(key, keyof(n)))
             prev = n, n = n->left;
          else
             n = n->right;
       }
-      return static_cast<const node *>(prev);
-   }
-
-   template <class K, class KV, class KeyOfValue, class Compare>
-   typename rbtree<K,KV,KeyOfValue,Compare>::node *
-   rbtree<K,KV,KeyOfValue,Compare>::insert_equal(const KV &data)
-   {
-      rbnode *parent = &header_;
-      rbnode **edge = root_edge();
-      for (const K &key = keyof_(data); *edge;)
-      {
-         parent = *edge;
-         if (is_less_(key, keyof_(static_cast<const node *>(*edge)->data)))
-            edge = &(*edge)->left;
-         else
-            edge = &(*edge)->right;
-      }
-      node *newnode = new node(data);
-      newnode->parent = parent;
-      *edge = newnode;
-      insert_rebalance(edge, parent);
-      return newnode;
+      return prev;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   ttl::pair<typename rbtree<K,KV,KeyOfValue,Compare>::node *, bool>
-   rbtree<K,KV,KeyOfValue,Compare>::insert_unique(const KV &data)
+   template<class K, class KeyOfNode, class Compare>
+   rbnode **rbtree_base::insert_edge(const K &key, rbnode **parent, bool unique,
+                                     const KeyOfNode &keyof, const Compare &is_less)
    {
-      rbnode *parent = &header_;
       rbnode **edge = root_edge();
-      for (const K &key = keyof_(data); *edge;)
+      *parent = &header_;
+      while (*edge)
       {
-         const K &ekey = keyof_(static_cast<const node *>(*edge)->data);
-         if (is_less_(key, ekey))
-            parent = *edge, edge = &(*edge)->left;
-         else if (key == ekey)
-            return pair<node *, bool>(static_cast<node *>(*edge), false);
+         const K &ekey = keyof(*edge);
+         if (is_less(key, ekey))
+            *parent = *edge, edge = &(*edge)->left;
+         else if (unique && !is_less(ekey, key))
+            break;
          else
-            parent = *edge, edge = &(*edge)->right;
+            *parent = *edge, edge = &(*edge)->right;
       }
-      node *newnode = new node(data);
-      newnode->parent = parent;
-      *edge = newnode;
-      insert_rebalance(edge, parent);
-      return pair<node *, bool>(static_cast<node *>(newnode), true);
+      return edge;
    }
 
-   template <class K, class KV, class KeyOfValue, class Compare>
-   typename rbtree<K,KV,KeyOfValue,Compare>::node *
-   rbtree<K,KV,KeyOfValue,Compare>::remove(const K &key)
+   template<class Target>
+   rbnode *rbtree_base::remove_target(const Target &target)
    {
       rbnode **root = root_edge(), *parent = &header_, *deleted = 0;
       while (*root)
       {
          parent = (*root)->parent;
-         bool isless = is_less_(key, keyof_(static_cast<const node *>(*root)->data));
+         bool isless = target.before(*root);
          if (isless)
          {
             if ((*root)->left && !is_red((*root)->left) && !is_red((*root)->left->left))
@@ -480,11 +663,9 @@ namespace ttl
             if (is_red((*root)->left))
             {
                *root = rotate_right(*root);
-               isless = is_less_(key, keyof_(static_cast<const node *>(*root)->data));
+               isless = target.before(*root);
             }
-            if (!isless &&
-                key == keyof_(static_cast<const node *>(*root)->data) &&
-                !(*root)->right)
+            if (!isless && target.at(*root) && !(*root)->right)
             {
                deleted = *root;
                *root = 0;
@@ -493,9 +674,9 @@ namespace ttl
             if ((*root)->right && !is_red((*root)->right) && !is_red((*root)->right->left))
             {
                *root = move_right(*root);
-               isless = is_less_(key, keyof_(static_cast<const node *>(*root)->data));
+               isless = target.before(*root);
             }
-            if (key == keyof_(static_cast<const node *>(*root)->data))
+            if (!isless && target.at(*root))
             {
                rbnode *orphan = delete_min(&(*root)->right);
                orphan->color = (*root)->color;
@@ -523,7 +704,300 @@ namespace ttl
       }
       if (root_())
          root_()->color = rbnode::BLACK;
-      return static_cast<node *>(deleted);
+      return deleted;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource = new_delete_resource>
+   class rbtree: public rbtree_base, private Resource
+   {
+   public:
+      typedef KeyOfValue keyof_type;
+
+      struct node: rbnode
+      {
+         KV data;
+         node(const KV &d): data(d) {}
+      };
+
+      rbtree() {}
+      explicit rbtree(const Resource &r): Resource(r) {}
+      ~rbtree() { clear(); }
+
+      node *create_node(const KV &data) { return ::new(Resource::allocate(sizeof(node))) node(data); }
+      void destroy_node(node *n)
+      {
+         n->~node();
+         Resource::deallocate(n, sizeof(node));
+      }
+
+      const Resource &get_resource() const { return *this; }
+
+      void assign(const rbtree &);
+
+      node *insert_equal(const KV &data);
+      pair<node *, bool> insert_unique(const KV &data);
+
+      template<class L> node *remove(const L &key);
+      node *remove(node *n) { return static_cast<node *>(remove_node(n)); }
+
+      node *get_root() { return static_cast<node *>(root_()); }
+      const node *get_root() const { return static_cast<const node *>(root_()); }
+      const node *get_croot() const { return static_cast<const node *>(root_()); }
+
+      node *end() { return static_cast<node *>(&header_); }
+      const node *end() const { return static_cast<const node *>(&header_); }
+
+      //
+      // The lookups take a K or any key type L the Compare takes with K
+      //
+      template<class L> const node *find(const L &) const;
+      template<class L> node *find(const L &key)
+      {
+         return const_cast<node *>(static_cast<const rbtree *>(this)->find(key));
+      }
+
+      template<class L> const node *lower_bound(const L &) const;
+      template<class L> node *lower_bound(const L &key)
+      {
+         return const_cast<node *>(static_cast<const rbtree *>(this)->lower_bound(key));
+      }
+
+      template<class L> const node *upper_bound(const L &) const;
+      template<class L> node *upper_bound(const L &key)
+      {
+         return const_cast<node *>(static_cast<const rbtree *>(this)->upper_bound(key));
+      }
+
+      template<class L> pair<const node *, const node *> equal_range(const L &k) const
+      {
+         return pair<const node *, const node *>(lower_bound(k), upper_bound(k));
+      }
+      template<class L> pair<node *, node *> equal_range(const L &k)
+      {
+         return pair<node *, node *>(lower_bound(k), upper_bound(k));
+      }
+
+      // O(log N + the count)
+      template<class L> size_t count(const L &k) const;
+
+      void clear();
+
+      // Destroy the nodes with keys in [lo, hi), or from lo on, and return
+      // their count; O(log N) plus the destruction
+      size_t erase_range(const K &lo, const K &hi)
+      {
+         return postorder_destroy(static_cast<node *>(
+            cut(key_before<K, node_key, Compare>(lo, node_key(keyof_), is_less_),
+                key_before<K, node_key, Compare>(hi, node_key(keyof_), is_less_))));
+      }
+      size_t erase_from(const K &lo)
+      {
+         return postorder_destroy(static_cast<node *>(
+            cut(key_before<K, node_key, Compare>(lo, node_key(keyof_), is_less_), all_before())));
+      }
+      // Destroy all the nodes with the key and return their count
+      template<class L> size_t erase_equal(const L &key)
+      {
+         return postorder_destroy(static_cast<node *>(
+            cut(key_before<L, node_key, Compare>(key, node_key(keyof_), is_less_),
+                key_not_after<L, node_key, Compare>(key, node_key(keyof_), is_less_))));
+      }
+
+      //
+      // These move the nodes between the trees, which must use the same
+      // memory resource
+      //
+
+      // Moves the nodes with keys not less than the key to other, after
+      // clearing it; O(log N)
+      void split(const K &key, rbtree &other);
+      // Moves all of other, with keys not less than those here, to this;
+      // O(log N)
+      void join(rbtree &other);
+      // Moves the nodes of other with keys not in this here, destroys the
+      // others; O(M log(N / M + 1)) for M nodes in other
+      void unite(rbtree &other);
+      // Destroys the nodes with keys in other; O(M log(N / M + 1))
+      void subtract(const rbtree &other);
+
+   protected:
+      KeyOfValue keyof_;
+      Compare is_less_;
+
+      struct node_key
+      {
+         const KeyOfValue &keyof;
+         node_key(const KeyOfValue &k): keyof(k) {}
+         const K &operator()(const rbnode *n) const { return keyof(static_cast<const node *>(n)->data); }
+      };
+
+      size_t postorder_destroy(node *n);
+      void destroy_list(rbnode *n)
+      {
+         while (n)
+         {
+            rbnode *next = n->right;
+            destroy_node(static_cast<node *>(n));
+            n = next;
+         }
+      }
+      rbnode *preorder_copy(const node *n);
+   };
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   size_t rbtree<K,KV,KeyOfValue,Compare,Resource>::postorder_destroy(node *n)
+   {
+      if (!n)
+         return 0;
+
+      size_t c = 1;
+      if (n->left)
+         c += postorder_destroy(static_cast<node *>(n->left));
+      if (n->right)
+         c += postorder_destroy(static_cast<node *>(n->right));
+      destroy_node(n);
+      return c;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   rbnode *rbtree<K,KV,KeyOfValue,Compare,Resource>::preorder_copy(const node *n)
+   {
+      if (!n)
+         return 0;
+      node *nc = create_node(n->data);
+      nc->color = n->color;
+      if (n->left)
+         nc->left = preorder_copy(static_cast<const node *>(n->left)),
+         nc->left->parent = nc;
+      else
+         nc->left = 0;
+      if (n->right)
+         nc->right = preorder_copy(static_cast<const node *>(n->right)),
+         nc->right->parent = nc;
+      else
+         nc->right = 0;
+      return nc;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::assign(const rbtree &other)
+   {
+      if (root_())
+         clear();
+      const node *otherroot = other.get_root();
+      if (otherroot)
+         (*root_edge() = preorder_copy(otherroot))->parent = &header_;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::clear()
+   {
+      node *root = static_cast<node *>(root_());
+      *root_edge() = 0;
+      postorder_destroy(root);
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   template <class L>
+   size_t rbtree<K,KV,KeyOfValue,Compare,Resource>::count(const L &key) const
+   {
+      size_t c = 0;
+      for (const node *n = lower_bound(key); n != end() && !is_less_(key, keyof_(n->data)); ++c)
+         n = static_cast<const node *>(next_node(n));
+      return c;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   template <class L>
+   const typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::find(const L &key) const
+   {
+      return static_cast<const node *>(find_node(key, node_key(keyof_), is_less_));
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   template <class L>
+   const typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::lower_bound(const L &key) const
+   {
+      return static_cast<const node *>(lower_bound_node(key, node_key(keyof_), is_less_));
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   template <class L>
+   const typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::upper_bound(const L &key) const
+   {
+      return static_cast<const node *>(upper_bound_node(key, node_key(keyof_), is_less_));
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::insert_equal(const KV &data)
+   {
+      rbnode *parent;
+      rbnode **edge = insert_edge(keyof_(data), &parent, false, node_key(keyof_), is_less_);
+      node *newnode = create_node(data);
+      link_node(edge, parent, newnode);
+      return newnode;
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   ttl::pair<typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *, bool>
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::insert_unique(const KV &data)
+   {
+      rbnode *parent;
+      rbnode **edge = insert_edge(keyof_(data), &parent, true, node_key(keyof_), is_less_);
+      if (*edge)
+         return pair<node *, bool>(static_cast<node *>(*edge), false);
+      node *newnode = create_node(data);
+      link_node(edge, parent, newnode);
+      return pair<node *, bool>(newnode, true);
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   template <class L>
+   typename rbtree<K,KV,KeyOfValue,Compare,Resource>::node *
+   rbtree<K,KV,KeyOfValue,Compare,Resource>::remove(const L &key)
+   {
+      return static_cast<node *>(remove_node(key, node_key(keyof_), is_less_));
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::split(const K &key, rbtree &other)
+   {
+      other.clear();
+      int h, lh, rh;
+      rbnode *r, *all = take_root(&h);
+      set_root(rbtree_base::split(all, h, key_before<K, node_key, Compare>(key, node_key(keyof_), is_less_),
+                                  &r, &lh, &rh));
+      other.set_root(r);
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::join(rbtree &other)
+   {
+      int h, lh, rh;
+      rbnode *l = take_root(&lh), *r = other.take_root(&rh);
+      set_root(rbtree_base::join(l, lh, r, rh, &h));
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::unite(rbtree &other)
+   {
+      int h, ah, bh;
+      rbnode *dups = 0, *a = take_root(&ah), *b = other.take_root(&bh);
+      set_root(rbtree_base::unite<K>(a, ah, b, bh, &h, &dups, node_key(keyof_), is_less_));
+      destroy_list(dups);
+   }
+
+   template <class K, class KV, class KeyOfValue, class Compare, class Resource>
+   void rbtree<K,KV,KeyOfValue,Compare,Resource>::subtract(const rbtree &other)
+   {
+      int h, ah;
+      rbnode *removed = 0, *a = take_root(&ah);
+      set_root(rbtree_base::subtract<K>(a, ah, other.root_(), &h, &removed, node_key(keyof_), is_less_));
+      destroy_list(removed);
    }
 }
 
@@ -0,0 +1,927 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a compressed bitmap of 32-bit ids
+//
+// The ids are split by their high 16 bits into chunks of 2^16 ids (the
+// "roaring" layout). A chunk keeps its low 16 bits
+//
+//    - as a sorted array, while it has at most 4096 ids (2 bytes per id),
+//    - as a bitset<65536> (8KB) when it has more,
+//    - as sorted runs of consecutive ids (4 bytes per run), after
+//      run_optimize() found that smaller.
+//
+// so a sparse set costs little more than its ids and a dense one about a
+// bit per id. Only the chunks with ids exist, their memory is taken from
+// a memory resource (see memory_resource.hpp):
+//
+//    ttl::roaring_bitmap<> online;
+//    online.add(id);
+//    online &= subscribed;
+//    for (ttl::roaring_bitmap<>::const_iterator i = online.begin(); i != online.end(); ++i)
+//       notify(*i);
+//
+// The operations work on the array and bitmap forms: a run chunk that is
+// modified is expanded first, run_optimize() may be called again later.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_ROARING_BITMAP_HPP_
+#define _TINY_TEMPLATE_LIBRARY_ROARING_BITMAP_HPP_ 1
+
+#include <new>
+#include "types.hpp"
+#include "memory_resource.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "bitset.hpp"
+
+namespace ttl
+{
+   template<typename T> void swap(T &, T &);
+
+   template<typename Resource = new_delete_resource>
+   class roaring_bitmap: private Resource
+   {
+   public:
+      typedef unsigned value_type; // 32 bits
+      typedef ttl::size_t size_type;
+
+   private:
+      typedef unsigned short low_type;
+      typedef bitset<0x10000> chunk_bits;
+      static const unsigned array_max = 4096;
+      static const unsigned bitmap_slots = 0x10000 / bitset_slots::slot_bits;
+
+      // a chunk keeps a copy of the resource of its bitmap, its arrays
+      // and the chunk itself are allocated from it
+      struct chunk: private Resource
+      {
+         enum { ARRAY, BITMAP, RUNS };
+
+         low_type key;     // the high 16 bits of the ids
+         unsigned char kind;
+         unsigned card;    // the number of ids, never 0
+         unsigned n, cap;  // ARRAY: n values; RUNS: n (start, length - 1) pairs
+         low_type *values;
+         chunk_bits *bits; // BITMAP
+
+         static chunk *create(low_type k, const Resource &r)
+         {
+            Resource a(r);
+            return ::new(a.allocate(sizeof(chunk))) chunk(k, r);
+         }
+         static void destroy(chunk *c)
+         {
+            Resource a(*c);
+            c->~chunk();
+            a.deallocate(c, sizeof(chunk));
+         }
+         // a copy from the resource r
+         chunk *clone(const Resource &r) const;
+
+         low_type *allocate_values(unsigned c)
+         {
+            return static_cast<low_type *>(Resource::allocate(c * sizeof(low_type)));
+         }
+         // frees values, of cap entries
+         void deallocate_values() { Resource::deallocate(values, cap * sizeof(low_type)); }
+         // a copy of from, or an empty one
+         chunk_bits *allocate_bits(const chunk_bits *from)
+         {
+            void *p = Resource::allocate(sizeof(chunk_bits));
+            return from ? ::new(p) chunk_bits(*from): ::new(p) chunk_bits;
+         }
+         void deallocate_bits() { Resource::deallocate(bits, sizeof(chunk_bits)); }
+
+         void reserve(unsigned entries);
+         // the index of the first value not less than x, in the first n
+         unsigned lower_bound(low_type x, unsigned stride) const;
+         bool contains(low_type x) const;
+         bool add(low_type x);
+         bool remove(low_type x);
+         // the first id not less than from, or 0x10000
+         unsigned next(unsigned from) const;
+         unsigned runs() const;
+
+         void to_array();  // from BITMAP
+         void to_bitmap();
+         void to_runs();
+         void expand();    // RUNS to ARRAY or BITMAP
+         void normalize(); // the form for the cardinality
+         void unite(const chunk &other);
+         void intersect(const chunk &other);
+         void subtract(const chunk &other);
+         bool operator==(const chunk &other) const;
+
+         template<typename Visitor> void for_each(Visitor &visit) const;
+
+      private:
+         chunk(low_type k, const Resource &r):
+            Resource(r), key(k), kind(ARRAY), card(0), n(0), cap(0), values(0), bits(0)
+         {}
+         ~chunk()
+         {
+            deallocate_values();
+            deallocate_bits();
+         }
+         chunk(const chunk &);
+         chunk &operator=(const chunk &);
+      };
+
+      vector<chunk *, Resource> chunks_;
+
+      // the index of the first chunk with a key not less than key
+      size_type find_chunk(low_type key) const;
+      void erase_chunk(size_type i)
+      {
+         chunk::destroy(chunks_[i]);
+         chunks_.erase(chunks_.begin() + i);
+      }
+
+      struct collect_runs;
+
+   public:
+      class const_iterator
+      {
+      public:
+         typedef roaring_bitmap::value_type value_type;
+         typedef const value_type *pointer;
+         typedef value_type reference;
+         typedef ttl::ptrdiff_t difference_type;
+
+         const_iterator() /* left uninitialized */ {}
+         value_type operator*() const
+         {
+            const chunk &ch = *b_->chunks_[c_];
+            return (value_type)ch.key << 16 | (ch.kind == chunk::ARRAY ? ch.values[i_]: i_);
+         }
+         const_iterator &operator++();
+         const_iterator operator++(int) { const_iterator tmp(*this); operator++(); return tmp; }
+
+         bool operator==(const const_iterator &other) const { return c_ == other.c_ && i_ == other.i_; }
+         bool operator!=(const const_iterator &other) const { return !operator==(other); }
+
+      private:
+         friend class roaring_bitmap;
+         const roaring_bitmap *b_;
+         size_type c_;  // the chunk
+         unsigned i_;   // ARRAY: the index; BITMAP, RUNS: the low bits
+         unsigned r_;   // RUNS: the run
+
+         const_iterator(const roaring_bitmap *b, size_type c): b_(b), c_(c), i_(0), r_(0) { settle(); }
+         void settle();
+      };
+      typedef const_iterator iterator;
+
+      roaring_bitmap() {}
+      explicit roaring_bitmap(const Resource &r): Resource(r), chunks_(r) {}
+      roaring_bitmap(const roaring_bitmap &other): Resource(other), chunks_(other.get_resource()) { operator=(other); }
+      ~roaring_bitmap() { clear(); }
+      roaring_bitmap &operator=(const roaring_bitmap &other);
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, chunks_.size()); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      bool empty() const { return chunks_.empty(); }
+      size_type cardinality() const;
+      size_type size() const { return cardinality(); }
+      // the memory used by the chunks
+      size_type size_in_bytes() const;
+
+      // true if the id was not there
+      bool add(value_type x);
+      // true if the id was there
+      bool remove(value_type x);
+      bool contains(value_type x) const;
+      void clear();
+      void swap(roaring_bitmap &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         chunks_.swap(other.chunks_);
+      }
+
+      // calls visit(id) for each id, in order, and returns visit
+      template<typename Visitor> Visitor for_each(Visitor visit) const
+      {
+         for (size_type i = 0; i < chunks_.size(); ++i)
+            chunks_[i]->for_each(visit);
+         return visit;
+      }
+
+      // converts the chunks to runs where that is smaller, true if any was
+      bool run_optimize();
+
+      roaring_bitmap &operator|=(const roaring_bitmap &other);
+      roaring_bitmap &operator&=(const roaring_bitmap &other);
+      roaring_bitmap &operator-=(const roaring_bitmap &other);
+
+      bool operator==(const roaring_bitmap &other) const;
+      bool operator!=(const roaring_bitmap &other) const { return !operator==(other); }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   template<typename Resource>
+   typename roaring_bitmap<Resource>::chunk *roaring_bitmap<Resource>::chunk::clone(const Resource &r) const
+   {
+      chunk *c = create(key, r);
+      c->kind = kind;
+      c->card = card;
+      if (bits)
+         c->bits = c->allocate_bits(bits);
+      const unsigned entries = kind == RUNS ? 2 * n: n;
+      c->reserve(entries);
+      for (unsigned i = 0; i < entries; ++i)
+         c->values[i] = values[i];
+      c->n = n;
+      return c;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::reserve(unsigned entries)
+   {
+      if (entries <= cap)
+         return;
+      unsigned c = cap ? cap * 2: 4;
+      if (c < entries)
+         c = entries;
+      low_type *v = allocate_values(c);
+      for (unsigned i = 0; i < (kind == RUNS ? 2 * n: n); ++i)
+         v[i] = values[i];
+      deallocate_values();
+      values = v;
+      cap = c;
+   }
+
+   template<typename Resource>
+   unsigned roaring_bitmap<Resource>::chunk::lower_bound(low_type x, unsigned stride) const
+   {
+      unsigned lo = 0, hi = n;
+      while (lo < hi)
+      {
+         const unsigned mid = lo + (hi - lo) / 2;
+         if (values[mid * stride] < x)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      return lo;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::chunk::contains(low_type x) const
+   {
+      if (kind == BITMAP)
+         return bits->test(x);
+      if (kind == ARRAY)
+      {
+         const unsigned i = lower_bound(x, 1);
+         return i < n && values[i] == x;
+      }
+      // the run before the first one starting after x
+      unsigned i = lower_bound(x, 2);
+      if (i < n && values[2 * i] == x)
+         return true;
+      return i > 0 && x - values[2 * (i - 1)] <= values[2 * (i - 1) + 1];
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::chunk::add(low_type x)
+   {
+      if (kind == RUNS)
+      {
+         if (contains(x))
+            return false;
+         expand();
+      }
+      if (kind == BITMAP)
+      {
+         if (bits->test(x))
+            return false;
+         bits->set(x);
+         ++card;
+         return true;
+      }
+      const unsigned i = lower_bound(x, 1);
+      if (i < n && values[i] == x)
+         return false;
+      if (n == array_max)
+      {
+         to_bitmap();
+         return add(x);
+      }
+      reserve(n + 1);
+      for (unsigned j = n; j > i; --j)
+         values[j] = values[j - 1];
+      values[i] = x;
+      ++n;
+      ++card;
+      return true;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::chunk::remove(low_type x)
+   {
+      if (kind == RUNS)
+      {
+         if (!contains(x))
+            return false;
+         expand();
+      }
+      if (kind == BITMAP)
+      {
+         if (!bits->test(x))
+            return false;
+         bits->reset(x);
+         --card;
+         normalize();
+         return true;
+      }
+      const unsigned i = lower_bound(x, 1);
+      if (i == n || values[i] != x)
+         return false;
+      for (unsigned j = i + 1; j < n; ++j)
+         values[j - 1] = values[j];
+      --n;
+      --card;
+      return true;
+   }
+
+   template<typename Resource>
+   unsigned roaring_bitmap<Resource>::chunk::next(unsigned from) const
+   {
+      if (from > 0xffff)
+         return 0x10000;
+      if (kind == BITMAP)
+         return from ? bits->find_next(from - 1): bits->find_first();
+      if (kind == ARRAY)
+      {
+         const unsigned i = lower_bound((low_type)from, 1);
+         return i < n ? values[i]: 0x10000;
+      }
+      unsigned i = lower_bound((low_type)from, 2);
+      if (i > 0 && from - values[2 * (i - 1)] <= values[2 * (i - 1) + 1])
+         return from;
+      return i < n ? values[2 * i]: 0x10000;
+   }
+
+   // the number of runs of consecutive ids
+   template<typename Resource>
+   unsigned roaring_bitmap<Resource>::chunk::runs() const
+   {
+      unsigned r = 0;
+      if (kind == RUNS)
+         return n;
+      if (kind == ARRAY)
+      {
+         for (unsigned i = 0; i < n; ++i)
+            r += !i || values[i] != values[i - 1] + 1;
+         return r;
+      }
+      // the run starts are the set bits whose lower neighbour is clear
+      bitset_slots::slot_type carry = 0;
+      for (unsigned s = 0; s < bitmap_slots; ++s)
+      {
+         const bitset_slots::slot_type w = bits->slot(s);
+         r += bitset_slots::popcount(w & ~(w << 1 | carry));
+         carry = w >> (bitset_slots::slot_bits - 1);
+      }
+      return r;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::to_array()
+   {
+      low_type *v = allocate_values(card);
+      unsigned k = 0;
+      for (ttl::size_t i = bits->find_first(); i < bits->size(); i = bits->find_next(i))
+         v[k++] = (low_type)i;
+      deallocate_values();
+      deallocate_bits();
+      bits = 0;
+      values = v;
+      n = cap = card;
+      kind = ARRAY;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::to_bitmap()
+   {
+      chunk_bits *b = allocate_bits(0);
+      if (kind == ARRAY)
+         for (unsigned i = 0; i < n; ++i)
+            b->set(values[i]);
+      else
+         for (unsigned r = 0; r < n; ++r)
+            for (unsigned x = values[2 * r]; x <= (unsigned)values[2 * r] + values[2 * r + 1]; ++x)
+               b->set(x);
+      deallocate_values();
+      values = 0;
+      n = cap = 0;
+      bits = b;
+      kind = BITMAP;
+   }
+
+   template<typename Resource>
+   struct roaring_bitmap<Resource>::collect_runs
+   {
+      low_type *v;
+      unsigned n;
+      collect_runs(low_type *p): v(p), n(0) {}
+      void operator()(unsigned x)
+      {
+         const low_type low = (low_type)x;
+         if (n && low == v[2 * n - 2] + v[2 * n - 1] + 1)
+            ++v[2 * n - 1];
+         else
+         {
+            v[2 * n] = low;
+            v[2 * n + 1] = 0;
+            ++n;
+         }
+      }
+   };
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::to_runs()
+   {
+      const unsigned r = runs();
+      low_type *v = allocate_values(2 * r);
+      collect_runs c(v);
+      for_each(c);
+      deallocate_values();
+      deallocate_bits();
+      bits = 0;
+      values = v;
+      n = r;
+      cap = 2 * r;
+      kind = RUNS;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::expand()
+   {
+      if (kind != RUNS)
+         return;
+      if (card > array_max)
+      {
+         to_bitmap();
+         return;
+      }
+      low_type *v = allocate_values(card);
+      unsigned k = 0;
+      for (unsigned r = 0; r < n; ++r)
+         for (unsigned x = values[2 * r]; x <= (unsigned)values[2 * r] + values[2 * r + 1]; ++x)
+            v[k++] = (low_type)x;
+      deallocate_values();
+      values = v;
+      n = cap = card;
+      kind = ARRAY;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::normalize()
+   {
+      if (kind == BITMAP && card <= array_max)
+         to_array();
+      else if (kind == ARRAY && card > array_max)
+         to_bitmap();
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::unite(const chunk &other)
+   {
+      if (other.kind == RUNS)
+      {
+         chunk *o = other.clone(*this);
+         o->expand();
+         unite(*o);
+         destroy(o);
+         return;
+      }
+      expand();
+      if (kind == ARRAY && other.kind == ARRAY && n + other.n <= array_max)
+      {
+         // merge into a new array
+         low_type *v = allocate_values(n + other.n);
+         unsigned i = 0, j = 0, k = 0;
+         while (i < n && j < other.n)
+            if (values[i] < other.values[j])
+               v[k++] = values[i++];
+            else if (other.values[j] < values[i])
+               v[k++] = other.values[j++];
+            else
+               v[k++] = values[i++], ++j;
+         while (i < n)
+            v[k++] = values[i++];
+         while (j < other.n)
+            v[k++] = other.values[j++];
+         deallocate_values();
+         values = v;
+         n = card = k;
+         cap = i + j;
+         return;
+      }
+      if (kind == ARRAY)
+      {
+         if (other.kind == BITMAP)
+         {
+            chunk_bits *b = allocate_bits(other.bits);
+            for (unsigned i = 0; i < n; ++i)
+               b->set(values[i]);
+            deallocate_values();
+            values = 0;
+            n = cap = 0;
+            bits = b;
+            kind = BITMAP;
+            card = bits->count();
+            return;
+         }
+         to_bitmap();
+      }
+      if (other.kind == BITMAP)
+         *bits |= *other.bits;
+      else
+         for (unsigned i = 0; i < other.n; ++i)
+            bits->set(other.values[i]);
+      card = bits->count();
+      normalize();
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::intersect(const chunk &other)
+   {
+      if (other.kind == RUNS)
+      {
+         chunk *o = other.clone(*this);
+         o->expand();
+         intersect(*o);
+         destroy(o);
+         return;
+      }
+      expand();
+      unsigned k = 0;
+      if (kind == BITMAP)
+      {
+         if (other.kind == BITMAP)
+         {
+            *bits &= *other.bits;
+            card = bits->count();
+            normalize();
+            return;
+         }
+         // the result is the part of the other array in the bitmap
+         low_type *v = allocate_values(other.n);
+         for (unsigned j = 0; j < other.n; ++j)
+            if (bits->test(other.values[j]))
+               v[k++] = other.values[j];
+         deallocate_bits();
+         bits = 0;
+         values = v;
+         n = card = k;
+         cap = other.n;
+         kind = ARRAY;
+         return;
+      }
+      if (other.kind == BITMAP)
+      {
+         for (unsigned i = 0; i < n; ++i)
+            if (other.bits->test(values[i]))
+               values[k++] = values[i];
+      }
+      else
+      {
+         unsigned i = 0, j = 0;
+         while (i < n && j < other.n)
+            if (values[i] < other.values[j])
+               ++i;
+            else if (other.values[j] < values[i])
+               ++j;
+            else
+               values[k++] = values[i++], ++j;
+      }
+      n = card = k;
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::chunk::subtract(const chunk &other)
+   {
+      if (other.kind == RUNS)
+      {
+         chunk *o = other.clone(*this);
+         o->expand();
+         subtract(*o);
+         destroy(o);
+         return;
+      }
+      expand();
+      if (kind == BITMAP)
+      {
+         if (other.kind == BITMAP)
+            *bits &= ~*other.bits;
+         else
+            for (unsigned j = 0; j < other.n; ++j)
+               bits->reset(other.values[j]);
+         card = bits->count();
+         normalize();
+         return;
+      }
+      unsigned k = 0;
+      if (other.kind == BITMAP)
+      {
+         for (unsigned i = 0; i < n; ++i)
+            if (!other.bits->test(values[i]))
+               values[k++] = values[i];
+      }
+      else
+      {
+         unsigned i = 0, j = 0;
+         while (i < n)
+            if (j == other.n || values[i] < other.values[j])
+               values[k++] = values[i++];
+            else if (other.values[j] < values[i])
+               ++j;
+            else
+               ++i, ++j;
+      }
+      n = card = k;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::chunk::operator==(const chunk &other) const
+   {
+      if (key != other.key || card != other.card)
+         return false;
+      for (unsigned x = next(0); x < 0x10000; x = next(x + 1))
+         if (!other.contains((low_type)x))
+            return false;
+      return true;
+   }
+
+   template<typename Resource>
+   template<typename Visitor>
+   void roaring_bitmap<Resource>::chunk::for_each(Visitor &visit) const
+   {
+      const value_type high = (value_type)key << 16;
+      if (kind == ARRAY)
+         for (unsigned i = 0; i < n; ++i)
+            visit(high | values[i]);
+      else if (kind == RUNS)
+         for (unsigned r = 0; r < n; ++r)
+            for (unsigned x = values[2 * r]; x <= (unsigned)values[2 * r] + values[2 * r + 1]; ++x)
+               visit(high | x);
+      else
+         for (unsigned s = 0; s < bitmap_slots; ++s)
+            for (bitset_slots::slot_type w = bits->slot(s); w; w &= w - 1)
+               visit(high | (s * bitset_slots::slot_bits + bitset_slots::lowest(w)));
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::const_iterator::settle()
+   {
+      if (c_ >= b_->chunks_.size())
+      {
+         i_ = 0;
+         return;
+      }
+      const chunk &ch = *b_->chunks_[c_];
+      r_ = 0;
+      i_ = ch.kind == chunk::ARRAY ? 0: ch.kind == chunk::RUNS ? ch.values[0]: ch.bits->find_first();
+   }
+
+   template<typename Resource>
+   typename roaring_bitmap<Resource>::const_iterator &roaring_bitmap<Resource>::const_iterator::operator++()
+   {
+      const chunk &ch = *b_->chunks_[c_];
+      if (ch.kind == chunk::ARRAY)
+      {
+         if (++i_ < ch.n)
+            return *this;
+      }
+      else if (ch.kind == chunk::BITMAP)
+      {
+         i_ = ch.bits->find_next(i_);
+         if (i_ < 0x10000)
+            return *this;
+      }
+      else
+      {
+         if (i_ < (unsigned)ch.values[2 * r_] + ch.values[2 * r_ + 1])
+         {
+            ++i_;
+            return *this;
+         }
+         if (++r_ < ch.n)
+         {
+            i_ = ch.values[2 * r_];
+            return *this;
+         }
+      }
+      ++c_;
+      settle();
+      return *this;
+   }
+
+   template<typename Resource>
+   roaring_bitmap<Resource> &roaring_bitmap<Resource>::operator=(const roaring_bitmap &other)
+   {
+      if (this == &other)
+         return *this;
+      clear();
+      chunks_.reserve(other.chunks_.size());
+      for (size_type i = 0; i < other.chunks_.size(); ++i)
+         chunks_.push_back(other.chunks_[i]->clone(*this));
+      return *this;
+   }
+
+   template<typename Resource>
+   typename roaring_bitmap<Resource>::size_type roaring_bitmap<Resource>::find_chunk(low_type key) const
+   {
+      size_type lo = 0, hi = chunks_.size();
+      while (lo < hi)
+      {
+         const size_type mid = lo + (hi - lo) / 2;
+         if (chunks_[mid]->key < key)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      return lo;
+   }
+
+   template<typename Resource>
+   typename roaring_bitmap<Resource>::size_type roaring_bitmap<Resource>::cardinality() const
+   {
+      size_type c = 0;
+      for (size_type i = 0; i < chunks_.size(); ++i)
+         c += chunks_[i]->card;
+      return c;
+   }
+
+   template<typename Resource>
+   typename roaring_bitmap<Resource>::size_type roaring_bitmap<Resource>::size_in_bytes() const
+   {
+      size_type s = sizeof(*this) + chunks_.capacity() * sizeof(chunk *);
+      for (size_type i = 0; i < chunks_.size(); ++i)
+         s += sizeof(chunk) + chunks_[i]->cap * sizeof(low_type) +
+            (chunks_[i]->bits ? sizeof(chunk_bits): 0);
+      return s;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::add(value_type x)
+   {
+      const low_type key = (low_type)(x >> 16);
+      const size_type i = find_chunk(key);
+      if (i == chunks_.size() || chunks_[i]->key != key)
+         chunks_.insert(chunks_.begin() + i, chunk::create(key, *this));
+      return chunks_[i]->add((low_type)x);
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::remove(value_type x)
+   {
+      const low_type key = (low_type)(x >> 16);
+      const size_type i = find_chunk(key);
+      if (i == chunks_.size() || chunks_[i]->key != key || !chunks_[i]->remove((low_type)x))
+         return false;
+      if (!chunks_[i]->card)
+         erase_chunk(i);
+      return true;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::contains(value_type x) const
+   {
+      const low_type key = (low_type)(x >> 16);
+      const size_type i = find_chunk(key);
+      return i < chunks_.size() && chunks_[i]->key == key && chunks_[i]->contains((low_type)x);
+   }
+
+   template<typename Resource>
+   void roaring_bitmap<Resource>::clear()
+   {
+      for (size_type i = 0; i < chunks_.size(); ++i)
+         chunk::destroy(chunks_[i]);
+      chunks_.clear();
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::run_optimize()
+   {
+      bool changed = false;
+      for (size_type i = 0; i < chunks_.size(); ++i)
+      {
+         chunk &ch = *chunks_[i];
+         if (ch.kind == chunk::RUNS)
+            continue;
+         const size_type size = ch.kind == chunk::ARRAY ? 2 * ch.card: sizeof(chunk_bits);
+         if (4 * ch.runs() < size)
+         {
+            ch.to_runs();
+            changed = true;
+         }
+      }
+      return changed;
+   }
+
+   template<typename Resource>
+   roaring_bitmap<Resource> &roaring_bitmap<Resource>::operator|=(const roaring_bitmap &other)
+   {
+      if (this == &other)
+         return *this;
+      vector<chunk *, Resource> result(get_resource());
+      result.reserve(chunks_.size() + other.chunks_.size());
+      size_type i = 0, j = 0;
+      while (i < chunks_.size() || j < other.chunks_.size())
+         if (j == other.chunks_.size() || (i < chunks_.size() && chunks_[i]->key < other.chunks_[j]->key))
+            result.push_back(chunks_[i++]);
+         else if (i == chunks_.size() || other.chunks_[j]->key < chunks_[i]->key)
+            result.push_back(other.chunks_[j++]->clone(*this));
+         else
+         {
+            chunks_[i]->unite(*other.chunks_[j++]);
+            result.push_back(chunks_[i++]);
+         }
+      chunks_.swap(result);
+      return *this;
+   }
+
+   template<typename Resource>
+   roaring_bitmap<Resource> &roaring_bitmap<Resource>::operator&=(const roaring_bitmap &other)
+   {
+      if (this == &other)
+         return *this;
+      size_type i = 0, j = 0, k = 0;
+      for (; i < chunks_.size(); ++i)
+      {
+         while (j < other.chunks_.size() && other.chunks_[j]->key < chunks_[i]->key)
+            ++j;
+         if (j < other.chunks_.size() && other.chunks_[j]->key == chunks_[i]->key)
+            chunks_[i]->intersect(*other.chunks_[j]);
+         else
+            chunks_[i]->card = 0;
+         if (chunks_[i]->card)
+            chunks_[k++] = chunks_[i];
+         else
+            chunk::destroy(chunks_[i]);
+      }
+      chunks_.erase(chunks_.begin() + k, chunks_.end());
+      return *this;
+   }
+
+   template<typename Resource>
+   roaring_bitmap<Resource> &roaring_bitmap<Resource>::operator-=(const roaring_bitmap &other)
+   {
+      if (this == &other)
+      {
+         clear();
+         return *this;
+      }
+      size_type i = 0, j = 0, k = 0;
+      for (; i < chunks_.size(); ++i)
+      {
+         while (j < other.chunks_.size() && other.chunks_[j]->key < chunks_[i]->key)
+            ++j;
+         if (j < other.chunks_.size() && other.chunks_[j]->key == chunks_[i]->key)
+            chunks_[i]->subtract(*other.chunks_[j]);
+         if (chunks_[i]->card)
+            chunks_[k++] = chunks_[i];
+         else
+            chunk::destroy(chunks_[i]);
+      }
+      chunks_.erase(chunks_.begin() + k, chunks_.end());
+      return *this;
+   }
+
+   template<typename Resource>
+   bool roaring_bitmap<Resource>::operator==(const roaring_bitmap &other) const
+   {
+      if (chunks_.size() != other.chunks_.size())
+         return false;
+      for (size_type i = 0; i < chunks_.size(); ++i)
+         if (!(*chunks_[i] == *other.chunks_[i]))
+            return false;
+      return true;
+   }
+
+   template<typename Resource>
+   roaring_bitmap<Resource> operator|(const roaring_bitmap<Resource> &a, const roaring_bitmap<Resource> &b)
+   {
+      return roaring_bitmap<Resource>(a) |= b;
+   }
+   template<typename Resource>
+   roaring_bitmap<Resource> operator&(const roaring_bitmap<Resource> &a, const roaring_bitmap<Resource> &b)
+   {
+      return roaring_bitmap<Resource>(a) &= b;
+   }
+   template<typename Resource>
+   roaring_bitmap<Resource> operator-(const roaring_bitmap<Resource> &a, const roaring_bitmap<Resource> &b)
+   {
+      return roaring_bitmap<Resource>(a) -= b;
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_ROARING_BITMAP_HPP_
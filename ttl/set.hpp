@@ -4,8 +4,8 @@
 //
 // This code is Public Domain
 //
-#ifndef _TINY_TEMPLATE_LIBRARY_MAP_HPP_
-#define _TINY_TEMPLATE_LIBRARY_MAP_HPP_ 1
+#ifndef _TINY_TEMPLATE_LIBRARY_SET_HPP_
+#define _TINY_TEMPLATE_LIBRARY_SET_HPP_ 1
 
 #include "types.hpp"
 #include "functional.hpp"
@@ -14,7 +14,9 @@
 
 namespace ttl
 {
-   template<typename KT, typename Compare = less<KT> >
+   template<typename KT, typename Compare, typename Resource> class multiset;
+
+   template<typename KT, typename Compare = less<KT>, typename Resource = new_delete_resource>
    class set // unique keys to values
    {
    public:
@@ -30,7 +32,7 @@ namespace ttl
       typedef const value_type *const_pointer;
 
    private:
-      typedef rbtree<KT,KT,select_same<KT>,Compare> tree_type;
+      typedef rbtree<KT,KT,select_same<KT>,Compare,Resource> tree_type;
       typedef typename tree_type::node node_type;
 
       tree_type rbtree_;
@@ -40,9 +42,9 @@ namespace ttl
 
       struct iterator
       {
-         typedef typename set<KT,Compare>::node_type node_type;
+         typedef typename set<KT,Compare,Resource>::node_type node_type;
       public:
-         typedef set<KT,Compare>::value_type value_type;
+         typedef set<KT,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
@@ -74,16 +76,17 @@ namespace ttl
          bool operator!=(const const_iterator &other) const { return other != *this; }
       private:
          node_type *ptr_;
-         friend class set<KT,Compare>;
-         friend class set<KT,Compare>::const_iterator;
+         friend class set<KT,Compare,Resource>;
+         friend class set<KT,Compare,Resource>::const_iterator;
+         friend class multiset<KT,Compare,Resource>;
          iterator(node_type *ptr): ptr_(ptr) {}
          static node_type *prev(const node_type *);
       };
       struct const_iterator
       {
-         typedef typename set<KT,Compare>::iterator::node_type node_type;
+         typedef typename set<KT,Compare,Resource>::iterator::node_type node_type;
       public:
-         typedef set<KT,Compare>::value_type value_type;
+         typedef set<KT,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
@@ -121,7 +124,8 @@ namespace ttl
          const_iterator(const iterator &other): ptr_(other.ptr_) {}
       private:
          const node_type *ptr_;
-         friend class set<KT,Compare>;
+         friend class set<KT,Compare,Resource>;
+         friend class multiset<KT,Compare,Resource>;
          const_iterator(const node_type *ptr): ptr_(ptr) {}
       };
 
@@ -155,14 +159,17 @@ namespace ttl
       }
 
       explicit set() {}
+      explicit set(const Resource &r): rbtree_(r) {}
       ~set() {}
 
-      set(const set &other)
+      set(const set &other):
+         rbtree_(other.rbtree_.get_resource())
       {
          rbtree_.assign(other.rbtree_);
       }
 
-      template<class InputIt> set(InputIt first, InputIt last)
+      template<class InputIt> set(InputIt first, InputIt last, const Resource &r = Resource()):
+         rbtree_(r)
       {
          insert(first, last);
       }
@@ -192,18 +199,59 @@ namespace ttl
       bool empty() const { return !rbtree_.get_root(); }
       size_type max_size() const { return (size_type)-1 / sizeof(node_type); }
 
-      iterator erase(const_iterator pos);
-      iterator erase(const_iterator first, const_iterator last);
+      iterator erase(const_iterator pos)
+      {
+         iterator next(static_cast<node_type *>(rbtree_base::next_node(pos.ptr_)));
+         rbtree_.destroy_node(rbtree_.remove(*pos));
+         return next;
+      }
+      // O(log N) plus the destruction of the erased nodes
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         if (first != last)
+         {
+            if (last == cend())
+               rbtree_.erase_from(*first);
+            else
+               rbtree_.erase_range(*first, *last);
+         }
+         return iterator(const_cast<node_type *>(last.ptr_));
+      }
+      // the keys in [lo, hi), returns their count
+      size_type erase_range(const KT &lo, const KT &hi)
+      {
+         return Compare()(lo, hi) ? rbtree_.erase_range(lo, hi): 0;
+      }
 
       size_type erase(const KT &key)
       {
          node_type *n = rbtree_.remove(key);
-         delete n;
-         return !!n;
+         if (!n)
+            return 0;
+         rbtree_.destroy_node(n);
+         return 1;
+      }
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key)
+      {
+         node_type *n = rbtree_.remove(key);
+         if (!n)
+            return 0;
+         rbtree_.destroy_node(n);
+         return 1;
       }
 
       void swap(set &other);
 
+      // Moves the values of other with keys not here to this, and destroys
+      // the rest of other, which must use the same memory resource;
+      // O(M log(N / M + 1)) for M values in other
+      void unite(set &other) { rbtree_.unite(other.rbtree_); }
+      // Erases the keys of other; O(M log(N / M + 1))
+      void subtract(const set &other) { rbtree_.subtract(other.rbtree_); }
+
+      const Resource &get_resource() const { return rbtree_.get_resource(); }
+
       //
       // The set template has unique keys (so all ranges are either empty or
       // 1 element long), so the amount of generated template code can be
@@ -218,24 +266,100 @@ namespace ttl
       iterator lower_bound(const KT &key) { return iterator(rbtree_.lower_bound(key)); }
       const_iterator lower_bound(const KT &key) const { return const_iterator(rbtree_.lower_bound(key)); }
 
-      iterator upper_bound(const KT &key);
-      const_iterator upper_bound(const KT &key) const;
+      iterator upper_bound(const KT &key) { return iterator(after(rbtree_.lower_bound(key), key)); }
+      const_iterator upper_bound(const KT &key) const { return const_iterator(after(rbtree_.lower_bound(key), key)); }
+
+      pair<iterator, iterator> equal_range(const KT &key)
+      {
+         node_type *lo = rbtree_.lower_bound(key);
+         return pair<iterator, iterator>(iterator(lo), iterator(after(lo, key)));
+      }
+      pair<const_iterator, const_iterator> equal_range(const KT &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(after(lo, key)));
+      }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key)
+      {
+         return iterator(rbtree_.find(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const
+      {
+         return const_iterator(rbtree_.find(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const
+      {
+         return rbtree_.find(key) != rbtree_.end();
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key)
+      {
+         return iterator(rbtree_.lower_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.lower_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key)
+      {
+         return iterator(after(rbtree_.lower_bound(key), key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return const_iterator(after(rbtree_.lower_bound(key), key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, pair<iterator, iterator> >::type equal_range(const K &key)
+      {
+         node_type *lo = rbtree_.lower_bound(key);
+         return pair<iterator, iterator>(iterator(lo), iterator(after(lo, key)));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+      equal_range(const K &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(after(lo, key)));
+      }
 
-      pair<iterator, iterator> equal_range(const KT &key);
-      pair<const_iterator, const_iterator> equal_range(const KT &key) const;
+   private:
+      // the node after lo = lower_bound(key) when it has the key
+      template<class K>
+      node_type *after(const node_type *lo, const K &key) const
+      {
+         if (lo != rbtree_.end() && !Compare()(key, lo->data))
+            lo = static_cast<const node_type *>(rbtree_base::next_node(lo));
+         return const_cast<node_type *>(lo);
+      }
    };
 
-   template<typename KT, typename Compare>
+   template<typename KT, typename Compare, typename Resource>
    template<class InputIt>
-   void set<KT,Compare>::insert(InputIt first, InputIt last)
+   void set<KT,Compare,Resource>::insert(InputIt first, InputIt last)
    {
       for (; first != last; ++first)
          rbtree_.insert_unique(*first);
    }
 
-   template<typename KT, typename Compare>
-   typename set<KT,Compare>::iterator::node_type *
-   set<KT,Compare>::iterator::prev(const node_type *n)
+   template<typename KT, typename Compare, typename Resource>
+   typename set<KT,Compare,Resource>::iterator::node_type *
+   set<KT,Compare,Resource>::iterator::prev(const node_type *n)
    {
       // check if it is the sentinel/header
       if (!n->parent)
@@ -247,56 +371,248 @@ namespace ttl
       return const_cast<node_type *>(n);
    }
 
-   template<typename KT, typename Compare>
-   typename set<KT,Compare>::iterator set<KT,Compare>::upper_bound(const KT &key)
+   //
+   // The multiset: equal keys are kept in the order of their insertion.
+   // The ranges of a key are found in O(log N + K) for K equal keys, and
+   // they are erased at once in the same.
+   //
+   template<typename KT, typename Compare = less<KT>, typename Resource = new_delete_resource>
+   class multiset // keys
    {
-      node_type *lo = rbtree_.lower_bound(key);
-      if (lo == rbtree_.end())
-         return end();
-      return iterator(static_cast<node_type *>(rbtree_base::next_node(lo)));
-   }
-   template<typename KT, typename Compare>
-   typename set<KT,Compare>::const_iterator set<KT,Compare>::upper_bound(const KT &key) const
-   {
-      const node_type *lo = rbtree_.lower_bound(key);
-      if (lo == rbtree_.end())
-         return end();
-      return const_iterator(static_cast<const node_type *>(rbtree_base::next_node(lo)));
-   }
+   public:
+      typedef KT key_type;
+      typedef KT value_type;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+      typedef Compare key_compare;
+      typedef Compare value_compare;
+      typedef value_type &reference;
+      typedef const value_type &const_reference;
+      typedef value_type *pointer;
+      typedef const value_type *const_pointer;
+
+      // the iterators are those of the set
+      typedef typename set<KT,Compare,Resource>::iterator iterator;
+      typedef typename set<KT,Compare,Resource>::const_iterator const_iterator;
 
-   template<typename KT, typename Compare>
-   pair<typename set<KT,Compare>::iterator, typename set<KT,Compare>::iterator>
-   set<KT,Compare>::equal_range(const KT &key)
+   private:
+      typedef rbtree<KT,KT,select_same<KT>,Compare,Resource> tree_type;
+      typedef typename tree_type::node node_type;
+
+      tree_type rbtree_;
+
+   public:
+      iterator end() { return iterator(rbtree_.end()); }
+      const_iterator end() const { return const_iterator(rbtree_.end()); }
+      const_iterator cend() const { return end(); }
+
+      iterator begin()
+      {
+         rbnode *root = rbtree_.get_root();
+         return root ? iterator(static_cast<node_type *>(rbtree_base::min_node(root))): end();
+      }
+      const_iterator begin() const
+      {
+         const rbnode *root = rbtree_.get_root();
+         return root ? const_iterator(static_cast<const node_type *>(rbtree_base::min_node(root))): end();
+      }
+      const_iterator cbegin() const { return begin(); }
+
+      explicit multiset() {}
+      explicit multiset(const Resource &r): rbtree_(r) {}
+      ~multiset() {}
+
+      multiset(const multiset &other):
+         rbtree_(other.rbtree_.get_resource())
+      {
+         rbtree_.assign(other.rbtree_);
+      }
+
+      template<class InputIt> multiset(InputIt first, InputIt last, const Resource &r = Resource()):
+         rbtree_(r)
+      {
+         insert(first, last);
+      }
+
+      multiset &operator=(const multiset &other)
+      {
+         clear();
+         rbtree_.assign(other.rbtree_);
+         return *this;
+      }
+
+      // After the equal keys
+      iterator insert(const value_type &value) { return iterator(rbtree_.insert_equal(value)); }
+
+      template<class InputIt> void insert(InputIt first, InputIt last)
+      {
+         for (; first != last; ++first)
+            rbtree_.insert_equal(*first);
+      }
+
+      void clear()
+      {
+         rbtree_.clear();
+      }
+
+      bool empty() const { return !rbtree_.get_root(); }
+      size_type max_size() const { return (size_type)-1 / sizeof(node_type); }
+
+      // O(log N), this key and not an equal one
+      iterator erase(const_iterator pos)
+      {
+         iterator next(static_cast<node_type *>(rbtree_base::next_node(pos.ptr_)));
+         rbtree_.destroy_node(rbtree_.remove(const_cast<node_type *>(pos.ptr_)));
+         return next;
+      }
+      // O(log N) plus the destruction of the erased nodes when the range
+      // does not split the equal keys, else one by one
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         if (first == last)
+            ;
+         else if (!starts_key(first))
+            while (first != last)
+               first = erase(first);
+         else if (last == cend())
+            rbtree_.erase_from(*first);
+         else if (starts_key(last))
+            rbtree_.erase_range(*first, *last);
+         else
+            while (first != last)
+               first = erase(first);
+         return iterator(const_cast<node_type *>(last.ptr_));
+      }
+      // the keys in [lo, hi), returns their count
+      size_type erase_range(const KT &lo, const KT &hi)
+      {
+         return Compare()(lo, hi) ? rbtree_.erase_range(lo, hi): 0;
+      }
+
+      // All the equal keys, returns their count; O(log N + K)
+      size_type erase(const KT &key) { return rbtree_.erase_equal(key); }
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key)
+      {
+         return rbtree_.erase_equal(key);
+      }
+
+      const Resource &get_resource() const { return rbtree_.get_resource(); }
+
+      // the first of the equal keys
+      iterator find(const KT &key) { return iterator(first_of(key)); }
+      const_iterator find(const KT &key) const { return const_iterator(first_of(key)); }
+
+      size_type count(const KT &key) const { return rbtree_.count(key); }
+
+      iterator lower_bound(const KT &key) { return iterator(rbtree_.lower_bound(key)); }
+      const_iterator lower_bound(const KT &key) const { return const_iterator(rbtree_.lower_bound(key)); }
+
+      iterator upper_bound(const KT &key) { return iterator(rbtree_.upper_bound(key)); }
+      const_iterator upper_bound(const KT &key) const { return const_iterator(rbtree_.upper_bound(key)); }
+
+      // O(log N), the equal keys are the K steps between
+      pair<iterator, iterator> equal_range(const KT &key)
+      {
+         return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+      }
+      pair<const_iterator, const_iterator> equal_range(const KT &key) const
+      {
+         return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+      }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key) { return iterator(first_of(key)); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const
+      {
+         return const_iterator(first_of(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const { return rbtree_.count(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key)
+      {
+         return iterator(rbtree_.lower_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.lower_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key)
+      {
+         return iterator(rbtree_.upper_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return const_iterator(rbtree_.upper_bound(key));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, pair<iterator, iterator> >::type equal_range(const K &key)
+      {
+         return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+      }
+      template<class K>
+      typename if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+      equal_range(const K &key) const
+      {
+         return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+      }
+
+   private:
+      template<class K>
+      node_type *first_of(const K &key) const
+      {
+         const node_type *lo = rbtree_.lower_bound(key);
+         if (lo != rbtree_.end() && Compare()(key, lo->data))
+            lo = rbtree_.end();
+         return const_cast<node_type *>(lo);
+      }
+      // whether i is the first of its equal keys
+      bool starts_key(const_iterator i) const
+      {
+         if (i == begin())
+            return true;
+         const_iterator prev(i);
+         return Compare()(*--prev, *i);
+      }
+   };
+
+   template<class InputIt1, class InputIt2>
+   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
+
+   template <typename KT, typename Compare, typename Resource>
+   bool operator==(const set<KT,Compare,Resource> &a, const set<KT,Compare,Resource> &b)
    {
-      node_type *lo = rbtree_.lower_bound(key);
-      node_type *up = lo;
-      if (lo != rbtree_.end())
-         up = static_cast<node_type *>(rbtree_base::next_node(lo));
-      return pair<iterator, iterator>(iterator(lo), iterator(up));
+      return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template<typename KT, typename Compare>
-   pair<typename set<KT,Compare>::const_iterator, typename set<KT,Compare>::const_iterator>
-   set<KT,Compare>::equal_range(const KT &key) const
+   template <typename KT, typename Compare, typename Resource>
+   bool operator!=(const set<KT,Compare,Resource> &a, const set<KT,Compare,Resource> &b)
    {
-      const node_type *lo = rbtree_.lower_bound(key);
-      const node_type *up = lo;
-      if (lo != rbtree_.end())
-         up = static_cast<const node_type *>(rbtree_base::next_node(lo));
-      return pair<const_iterator, const_iterator>(const_iterator(lo), const_iterator(up));
+      return !(a == b);
    }
 
-   template<class InputIt1, class InputIt2>
-   bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
-
-   template <typename T>
-   bool operator==(const set<T> &a, const set<T> &b)
+   template <typename KT, typename Compare, typename Resource>
+   bool operator==(const multiset<KT,Compare,Resource> &a, const multiset<KT,Compare,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template <typename T>
-   bool operator!=(const set<T> &a, const set<T> &b)
+   template <typename KT, typename Compare, typename Resource>
+   bool operator!=(const multiset<KT,Compare,Resource> &a, const multiset<KT,Compare,Resource> &b)
    {
       return !(a == b);
    }
 }
-#endif // _TINY_TEMPLATE_LIBRARY_MAP_HPP_
+#endif // _TINY_TEMPLATE_LIBRARY_SET_HPP_
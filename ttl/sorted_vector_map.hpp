@@ -5,19 +5,32 @@
 // Can be used as a small map: the underlying data structure is a sorted array.
 // It has much less element overhead than a red-black tree implementation.
 //
+// For the insert-heavy maps, set_buffer_limit(B) puts the new keys of
+// operator[] and insert_buffered into a small sorted side buffer first,
+// merged into the array in one pass when it holds B elements: an insert
+// then moves O(B + N / B) pointers instead of O(N), B about sqrt(N) is
+// the balance. The lookups search both and the iterators walk the two
+// in order, nothing merges the buffer early but flush(), the batch
+// inserts and the set operations. A buffered insert invalidates the
+// iterators, as any insert.
+//
 // This code is Public Domain
 //
 #ifndef _TINY_TEMPLATE_LIBRARY_SORTED_VECTOR_MAP_HPP_
 #define _TINY_TEMPLATE_LIBRARY_SORTED_VECTOR_MAP_HPP_ 1
 
+#include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 #include "utility.hpp"
 #include "functional.hpp"
+#include "algorithm.hpp"
+#include "vector.hpp"
 
 namespace ttl
 {
-   template<typename KT, typename T, typename Compare = ttl::less<KT> >
-   class sorted_vector_map // unique keys to values
+   template<typename KT, typename T, typename Compare = ttl::less<KT>, typename Resource = new_delete_resource>
+   class sorted_vector_map: private Resource // unique keys to values
    {
    public:
       typedef KT key_type;
@@ -35,164 +48,305 @@ namespace ttl
 
       struct const_iterator;
 
+      // the merges of the side buffer into the array
+      struct buffer_stats
+      {
+         size_type merges;  // of a full buffer
+         size_type flushes; // by flush(), the batches and the set operations
+         size_type merged;  // the elements they moved into the array
+      };
+
       struct iterator
       {
       public:
-         typedef sorted_vector_map<KT,T,Compare>::value_type value_type;
+         typedef sorted_vector_map<KT,T,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
 
-         value_type &operator*() const { return **ptr_; }
-         value_type *operator->() const { return *ptr_; }
-         iterator &operator++() { ++ptr_; return *this; }
-         iterator operator++(int) { iterator tmp(*this); ++ptr_; return tmp; }
-         iterator &operator--() { --ptr_; return *this; }
-         iterator operator--(int) { iterator tmp(*this); --ptr_; return tmp; }
+         value_type &operator*() const { return buffered_ ? **b_: **a_; }
+         value_type *operator->() const { return buffered_ ? *b_: *a_; }
+         iterator &operator++()
+         {
+            if (buffered_)
+               ++b_;
+            else
+               ++a_;
+            buffered_ = map_->from_buffer(a_, b_);
+            return *this;
+         }
+         iterator operator++(int) { iterator tmp(*this); ++*this; return tmp; }
+         iterator &operator--()
+         {
+            buffered_ = map_->from_buffer_before(a_, b_);
+            if (buffered_)
+               --b_;
+            else
+               --a_;
+            return *this;
+         }
+         iterator operator--(int) { iterator tmp(*this); --*this; return tmp; }
 
-         bool operator==(const iterator &other) const { return ptr_ == other.ptr_; }
-         bool operator!=(const iterator &other) const { return ptr_ != other.ptr_; }
+         bool operator==(const iterator &other) const { return a_ == other.a_ && b_ == other.b_; }
+         bool operator!=(const iterator &other) const { return !(*this == other); }
          bool operator==(const const_iterator &other) const { return other == *this; }
          bool operator!=(const const_iterator &other) const { return other != *this; }
       private:
-         value_type **ptr_;
-         friend class sorted_vector_map<KT,T,Compare>;
-         friend class sorted_vector_map<KT,T,Compare>::const_iterator;
-         iterator(value_type **ptr): ptr_(ptr) {}
+         // the next positions in the array and in the buffer, the element
+         // is the lesser of the two
+         value_type **a_, **b_;
+         const sorted_vector_map<KT,T,Compare,Resource> *map_;
+         bool buffered_;
+         friend class sorted_vector_map<KT,T,Compare,Resource>;
+         friend class sorted_vector_map<KT,T,Compare,Resource>::const_iterator;
+         iterator(value_type **a, value_type **b, const sorted_vector_map<KT,T,Compare,Resource> *map):
+            a_(a), b_(b), map_(map), buffered_(map->from_buffer(a, b))
+         {}
       };
       struct const_iterator
       {
       public:
-         typedef sorted_vector_map<KT,T,Compare>::value_type value_type;
+         typedef sorted_vector_map<KT,T,Compare,Resource>::value_type value_type;
          typedef ttl::ptrdiff_t difference_type;
          typedef value_type *pointer;
          typedef value_type *reference;
 
-         const value_type &operator*() const { return **ptr_; }
-         const value_type *operator->() const { return *ptr_; }
-         const_iterator &operator++() { ++ptr_; return *this; }
-         const_iterator operator++(int) { const_iterator tmp(*this); ++ptr_; return tmp; }
-         const_iterator &operator--() { --ptr_; return *this; }
-         const_iterator operator--(int) { const_iterator tmp(*this); --ptr_; return tmp; }
+         const value_type &operator*() const { return buffered_ ? **b_: **a_; }
+         const value_type *operator->() const { return buffered_ ? *b_: *a_; }
+         const_iterator &operator++()
+         {
+            if (buffered_)
+               ++b_;
+            else
+               ++a_;
+            buffered_ = map_->from_buffer(a_, b_);
+            return *this;
+         }
+         const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+         const_iterator &operator--()
+         {
+            buffered_ = map_->from_buffer_before(a_, b_);
+            if (buffered_)
+               --b_;
+            else
+               --a_;
+            return *this;
+         }
+         const_iterator operator--(int) { const_iterator tmp(*this); --*this; return tmp; }
 
-         bool operator==(const const_iterator &other) const { return ptr_ == other.ptr_; }
-         bool operator==(const iterator &other) const { return ptr_ == other.ptr_; }
-         bool operator!=(const const_iterator &other) const { return ptr_ != other.ptr_; }
-         bool operator!=(const iterator &other) const { return ptr_ != other.ptr_; }
+         bool operator==(const const_iterator &other) const { return a_ == other.a_ && b_ == other.b_; }
+         bool operator==(const iterator &other) const { return a_ == other.a_ && b_ == other.b_; }
+         bool operator!=(const const_iterator &other) const { return !(*this == other); }
+         bool operator!=(const iterator &other) const { return !(*this == other); }
 
-         const_iterator(const iterator &other): ptr_(other.ptr_) {}
+         const_iterator(const iterator &other):
+            a_(other.a_), b_(other.b_), map_(other.map_), buffered_(other.buffered_)
+         {}
       private:
-         const value_type * const *ptr_;
-         friend class sorted_vector_map<KT,T,Compare>;
-         const_iterator(const value_type * const *ptr): ptr_(ptr) {}
+         const value_type * const *a_, * const *b_;
+         const sorted_vector_map<KT,T,Compare,Resource> *map_;
+         bool buffered_;
+         friend class sorted_vector_map<KT,T,Compare,Resource>;
+         const_iterator(const value_type * const *a, const value_type * const *b,
+                        const sorted_vector_map<KT,T,Compare,Resource> *map):
+            a_(a), b_(b), map_(map), buffered_(map->from_buffer(a, b))
+         {}
       };
 
    public:
       explicit sorted_vector_map():
          elements_(0), last_(0), end_of_elements_(0)
       {}
+      explicit sorted_vector_map(const Resource &r):
+         Resource(r), elements_(0), last_(0), end_of_elements_(0)
+      {}
       sorted_vector_map(const sorted_vector_map& other);
-      explicit sorted_vector_map(size_type prealloc)
+      explicit sorted_vector_map(size_type prealloc, const Resource &r = Resource()):
+         Resource(r)
       {
-         elements_ = last_ = new value_type*[prealloc];
+         elements_ = last_ = allocate_elements(prealloc);
          end_of_elements_ = elements_ + prealloc;
       }
       template<class InputIt>
-      sorted_vector_map(InputIt first, InputIt last);
+      sorted_vector_map(InputIt first, InputIt last, const Resource &r = Resource());
 
       ~sorted_vector_map()
       {
-         for (value_type **i = elements_; i != last_; ++i)
-            delete *i;
-         delete [] elements_;
+         clear();
+         deallocate_elements();
+         deallocate_buffer();
       }
 
       sorted_vector_map &operator=(const sorted_vector_map &other);
 
       T &operator[](const KT &key)
       {
-         iterator i = find_insert_pos(key);
-         if (i != end() && i->first == key)
-            return i->second;
-         return insert_before(i, ttl::make_pair(key, T()))->second;
+         pair<unsigned, bool> re = bsearch(key);
+         if (re.second)
+            return elements_[re.first]->second;
+         if (buffer_.limit)
+            return buffer_insert(ttl::make_pair(key, T())).first->second;
+         return (*insert_before(elements_ + re.first, ttl::make_pair(key, T())))->second;
       }
 
-      T &at(const KT &key) { return find(key)->second; }
-      const T &at(const KT &key) const { return find(key)->second; }
+      T &at(const KT &key) { return lookup(key)->second; }
+      const T &at(const KT &key) const { return lookup(key)->second; }
 
-      iterator       begin() { return iterator(elements_); }
-      const_iterator begin() const { return const_iterator(elements_); }
-      iterator       end() { return iterator(last_); }
-      const_iterator end() const { return const_iterator(last_); }
-      const_iterator cbegin() const { return const_iterator(elements_); }
-      const_iterator cend() const { return const_iterator(last_); }
+      iterator       begin() { return iterator(elements_, buffer_.first, this); }
+      const_iterator begin() const { return const_iterator(elements_, buffer_.first, this); }
+      iterator       end() { return iterator(last_, buffer_.last, this); }
+      const_iterator end() const { return const_iterator(last_, buffer_.last, this); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
 
-      size_type size() const { return last_ - elements_; }
-      bool empty() const { return last_ == elements_; }
+      size_type size() const { return (last_ - elements_) + (buffer_.last - buffer_.first); }
+      bool empty() const { return last_ == elements_ && buffer_.last == buffer_.first; }
       size_type max_size() const { return (size_type)-1 / sizeof(value_type); }
 
       void clear()
       {
          while (last_ > elements_)
-            delete *--last_;
+            destroy_value(*--last_);
+         while (buffer_.last > buffer_.first)
+            destroy_value(*--buffer_.last);
       }
 
       ttl::pair<iterator,bool> insert(const value_type &value)
       {
          iterator i = find_insert_pos(value.first);
-         if (i != end() && i->first == value.first)
+         if (i != end() && !Compare()(value.first, i->first))
             return ttl::pair<iterator, bool>(i, false);
-         return ttl::pair<iterator, bool>(insert_before(i, value), true);
+         return ttl::pair<iterator, bool>(iterator(insert_before(i.a_, value), i.b_, this), true);
       }
       iterator insert(iterator, const value_type &);
 
+      // Inserts without returning a position: into the side buffer when
+      // there is one. Returns whether the key was not there.
+      bool insert_buffered(const value_type &value)
+      {
+         pair<unsigned, bool> re = bsearch(value.first);
+         if (re.second)
+            return false;
+         if (buffer_.limit)
+            return buffer_insert(value).second;
+         insert_before(elements_ + re.first, value);
+         return true;
+      }
+
+      // Buffers up to limit new elements before merging them into the
+      // array, 0 merges each one at once (the default)
+      void set_buffer_limit(size_type limit);
+      size_type buffer_limit() const { return buffer_.limit; }
+      // Merges the buffered elements into the array
+      void flush() { merge_buffer(); ++buffer_.stats.flushes; }
+      size_type buffered() const { return buffer_.last - buffer_.first; }
+      const buffer_stats &stats() const { return buffer_.stats; }
+
+      // Inserts a batch: the new elements are sorted, then merged from the
+      // back into the grown array, in O(N + K log K) instead of K inserts
+      // moving O(N) each. Of the equal keys in the batch, the first one is
+      // inserted, as K inserts would.
+      template<class InputIt>
+      void insert(InputIt first, InputIt last) { settle(); insert_batch(first, last, true); }
+      // The same for a batch sorted by key, in O(N + K)
       template<class InputIt>
-      void insert(InputIt first, InputIt last);
+      void insert_sorted(InputIt first, InputIt last) { settle(); insert_batch(first, last, false); }
 
-      iterator erase(const_iterator pos);
+      iterator erase(const_iterator pos)
+      {
+         const_iterator next(pos);
+         return erase(pos, ++next);
+      }
       iterator erase(const_iterator first, const_iterator last);
-      size_type erase(const key_type &key);
+      size_type erase(const key_type &key) { return erase_key(key); }
 
       void swap(sorted_vector_map &other);
 
-      iterator find(const KT &key);
-      const_iterator find(const KT &key) const;
+      // Grows the array of the elements to at least n
+      void reserve(size_type n);
+
+      //
+      // The set operations on the keys, in place: the elements are moved
+      // in the array of this, the other is searched by galloping (see
+      // set_intersection) and only the array of this may be reallocated
+      //
 
-      size_type count(const KT &key) const { return find(key) == cend(); }
+      // Inserts copies of the elements of other with keys not here
+      void unite(const sorted_vector_map &other);
+      // Erases the keys not in other
+      void intersect(const sorted_vector_map &other) { settle(); retain(other, true); }
+      // Erases the keys in other
+      void subtract(const sorted_vector_map &other) { settle(); retain(other, false); }
+
+      iterator find(const KT &key) { return find_key(key); }
+      const_iterator find(const KT &key) const { return find_key(key); }
+
+      size_type count(const KT &key) const { return lookup(key) != 0; }
 
       ttl::pair<iterator,iterator> equal_range(const KT &key)
       {
-         iterator i1 = find(key);
-         iterator i2 = i1;
-         if (i2 != end())
-            ++i2;
-         return ttl::make_pair(i1, i2);
+         iterator i = find_insert_pos(key);
+         return ttl::make_pair(i, after(i, key));
       }
       ttl::pair<const_iterator,const_iterator> equal_range(const KT &key) const
       {
-         const_iterator i1 = find(key);
-         const_iterator i2 = i1;
-         if (i2 != cend())
-            ++i2;
-         return ttl::make_pair(i1, i2);
+         iterator i = find_insert_pos(key);
+         return ttl::make_pair(const_iterator(i), const_iterator(after(i, key)));
       }
 
       iterator lower_bound(const KT &key) { return find_insert_pos(key); }
       const_iterator lower_bound(const KT &key) const { return find_insert_pos(key); }
 
-      iterator upper_bound(const KT &key)
+      iterator upper_bound(const KT &key) { return after(find_insert_pos(key), key); }
+      const_iterator upper_bound(const KT &key) const { return after(find_insert_pos(key), key); }
+
+      //
+      // With a transparent Compare, such as less<void>, the lookups also
+      // take any type K the Compare takes with the keys
+      //
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type erase(const K &key) { return erase_key(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type find(const K &key) { return find_key(key); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type find(const K &key) const { return find_key(key); }
+
+      template<class K>
+      typename if_transparent<Compare, K, size_type>::type count(const K &key) const { return lookup(key) != 0; }
+
+      template<class K>
+      typename if_transparent<Compare, K, ttl::pair<iterator,iterator> >::type equal_range(const K &key)
       {
          iterator i = find_insert_pos(key);
-         while (i != end() && i->first == key)
-            ++i;
-         return i;
+         return ttl::make_pair(i, after(i, key));
       }
-      const_iterator upper_bound(const KT &key) const
+      template<class K>
+      typename if_transparent<Compare, K, ttl::pair<const_iterator,const_iterator> >::type
+      equal_range(const K &key) const
       {
-         const_iterator i = find_insert_pos(key);
-         while (i != cend() && i->first == key)
-            ++i;
-         return i;
+         iterator i = find_insert_pos(key);
+         return ttl::make_pair(const_iterator(i), const_iterator(after(i, key)));
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type lower_bound(const K &key) { return find_insert_pos(key); }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type lower_bound(const K &key) const
+      {
+         return find_insert_pos(key);
+      }
+
+      template<class K>
+      typename if_transparent<Compare, K, iterator>::type upper_bound(const K &key)
+      {
+         return after(find_insert_pos(key), key);
+      }
+      template<class K>
+      typename if_transparent<Compare, K, const_iterator>::type upper_bound(const K &key) const
+      {
+         return after(find_insert_pos(key), key);
       }
 
       key_compare key_comp() const { return Compare(); }
@@ -200,7 +354,7 @@ namespace ttl
       struct value_compare
       {
       protected:
-         friend class sorted_vector_map<KT, T, Compare>;
+         friend class sorted_vector_map<KT,T,Compare,Resource>;
          value_compare() {}
       public:
          typedef value_type first_argument_type;
@@ -214,82 +368,448 @@ namespace ttl
       };
       value_compare value_comp() const { return value_compare(); }
 
+      const Resource &get_resource() const { return *this; }
+
    private:
       value_type **elements_, **last_, **end_of_elements_;
-      iterator insert_before(iterator, const value_type &);
-      iterator find_insert_pos(const KT &key) const;
-      pair<unsigned, bool> bsearch(const KT &key) const;
+
+      // the sorted side buffer of the new elements
+      struct buffer
+      {
+         value_type **first, **last;
+         size_type limit;
+         buffer_stats stats;
+
+         buffer(): first(0), last(0), limit(0)
+         {
+            stats.merges = stats.flushes = stats.merged = 0;
+         }
+      } buffer_;
+
+      value_type **allocate_elements(size_type n)
+      {
+         return static_cast<value_type **>(Resource::allocate(n * sizeof(value_type *)));
+      }
+      void deallocate_elements()
+      {
+         Resource::deallocate(elements_, (end_of_elements_ - elements_) * sizeof(value_type *));
+      }
+      value_type *create_value(const value_type &value)
+      {
+         return ::new(Resource::allocate(sizeof(value_type))) value_type(value);
+      }
+      void destroy_value(value_type *p)
+      {
+         p->~value_type();
+         Resource::deallocate(p, sizeof(value_type));
+      }
+      void deallocate_buffer()
+      {
+         Resource::deallocate(buffer_.first, buffer_.limit * sizeof(value_type *));
+      }
+
+      // the batches and the set operations merge into the array only
+      void settle()
+      {
+         if (buffer_.last != buffer_.first)
+            flush();
+      }
+      void merge_buffer()
+      {
+         buffer_.stats.merged += buffer_.last - buffer_.first;
+         merge_batch(buffer_.first, buffer_.last);
+         buffer_.last = buffer_.first;
+      }
+      pair<value_type *, bool> buffer_insert(const value_type &value);
+
+      value_type **insert_before(value_type **, const value_type &);
+      void copy_elements(const sorted_vector_map &other);
+      void erase_slots(value_type **first, value_type **last, value_type **&end);
+      void retain(const sorted_vector_map &other, bool in_other);
+
+      // whether the element at the positions a and b of an iterator, or
+      // the one before, is the one in the buffer
+      template<class P> bool from_buffer(P a, P b) const
+      {
+         return b != buffer_.last && (a == last_ || Compare()((*b)->first, (*a)->first));
+      }
+      template<class P> bool from_buffer_before(P a, P b) const
+      {
+         return b != buffer_.first && (a == elements_ || Compare()((*(a - 1))->first, (*(b - 1))->first));
+      }
+
+      // compares an element with a key, for the searches in the array
+      struct element_less
+      {
+         template<class K>
+         bool operator()(const value_type *a, const K &key) const { return Compare()(a->first, key); }
+      };
+      // orders the elements by key
+      struct element_order
+      {
+         bool operator()(const value_type *a, const value_type *b) const { return Compare()(a->first, b->first); }
+      };
+
+      template<class InputIt> void insert_batch(InputIt first, InputIt last, bool sort);
+      static void sort_batch(value_type **first, value_type **last, value_type **tmp);
+      void merge_batch(value_type **first, value_type **last);
+      template<class K> iterator find_insert_pos(const K &key) const
+      {
+         value_type **b = buffer_.first;
+         if (b != buffer_.last)
+            b += bsearch(b, buffer_.last - b, key).first;
+         return iterator(elements_ + bsearch(key).first, b, this);
+      }
+      template<class K> iterator find_key(const K &key) const
+      {
+         iterator i = find_insert_pos(key);
+         return i != end_pos() && !Compare()(key, i->first) ? i: end_pos();
+      }
+      iterator end_pos() const { return iterator(last_, buffer_.last, this); }
+      // the element with the key in the array or the buffer, or 0
+      template<class K> value_type *lookup(const K &key) const
+      {
+         pair<unsigned, bool> re = bsearch(key);
+         if (re.second)
+            return elements_[re.first];
+         re = bsearch(buffer_.first, buffer_.last - buffer_.first, key);
+         return re.second ? buffer_.first[re.first]: 0;
+      }
+      template<class K> size_type erase_key(const K &key);
+      // the element after the lower bound i of the key when it has the key
+      template<class K> iterator after(iterator i, const K &key) const
+      {
+         if (i != end_pos() && !Compare()(key, i->first))
+            ++i;
+         return i;
+      }
+      // the lower bound of the key in the array and whether it is there
+      template<class K> pair<unsigned, bool> bsearch(const K &key) const
+      {
+         return bsearch(elements_, last_ - elements_, key);
+      }
+      template<class K>
+      static pair<unsigned, bool> bsearch(const value_type * const *a, unsigned n, const K &key);
    };
 
-   template<typename KT, typename T, typename Compare>
-   sorted_vector_map<KT,T,Compare>::sorted_vector_map(const sorted_vector_map& other)
+   template<typename KT, typename T, typename Compare, typename Resource>
+   sorted_vector_map<KT,T,Compare,Resource>::sorted_vector_map(const sorted_vector_map& other):
+      Resource(other)
    {
       size_type prealloc = other.end_of_elements_ - other.elements_;
-      elements_ = last_ = new value_type*[prealloc];
+      elements_ = last_ = allocate_elements(prealloc);
       end_of_elements_ = elements_ + prealloc;
+      copy_elements(other);
+   }
+
+   // copies the array and the buffer of other into this, empty
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::copy_elements(const sorted_vector_map &other)
+   {
+      reserve(other.last_ - other.elements_);
       for (const value_type * const *i = other.elements_; i != other.last_; ++i)
-         *last_++ = new value_type(**i);
+         *last_++ = create_value(**i);
+      set_buffer_limit(other.buffer_.limit);
+      for (const value_type * const *i = other.buffer_.first; i != other.buffer_.last; ++i)
+         *buffer_.last++ = create_value(**i);
    }
 
-   template<typename KT, typename T, typename Compare>
+   template<typename KT, typename T, typename Compare, typename Resource>
+   template<class K>
    pair<unsigned, bool>
-   sorted_vector_map<KT,T,Compare>::bsearch(const KT &key) const
+   sorted_vector_map<KT,T,Compare,Resource>::bsearch(const value_type * const *a, unsigned n, const K &key)
    {
       Compare comp;
-      unsigned L = 0, H = size();
+      unsigned L = 0, H = n;
       while (L < H) {
          unsigned m = L + (H - L) / 2;
-         if (elements_[m]->first == key)
-            return pair<unsigned, bool>(m, true);
-         if (comp(elements_[m]->first, key))
+         if (comp(a[m]->first, key))
             L = m + 1;
          else
             H = m;
       }
-      return pair<unsigned, bool>(L, false);
+      return pair<unsigned, bool>(L, L < n && !comp(key, a[L]->first));
    }
 
-   template<typename KT, typename T, typename Compare>
-   typename sorted_vector_map<KT,T,Compare>::iterator
-   sorted_vector_map<KT,T,Compare>::find(const KT &key)
+   template<typename KT, typename T, typename Compare, typename Resource>
+   template<class K>
+   typename sorted_vector_map<KT,T,Compare,Resource>::size_type
+   sorted_vector_map<KT,T,Compare,Resource>::erase_key(const K &key)
    {
       pair<unsigned, bool> re = bsearch(key);
-      return re.second ? iterator(elements_ + re.first): end();
+      if (re.second)
+      {
+         erase_slots(elements_ + re.first, elements_ + re.first + 1, last_);
+         return 1;
+      }
+      re = bsearch(buffer_.first, buffer_.last - buffer_.first, key);
+      if (!re.second)
+         return 0;
+      erase_slots(buffer_.first + re.first, buffer_.first + re.first + 1, buffer_.last);
+      return 1;
    }
-   template<typename KT, typename T, typename Compare>
-   typename sorted_vector_map<KT,T,Compare>::const_iterator
-   sorted_vector_map<KT,T,Compare>::find(const KT &key) const
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   pair<typename sorted_vector_map<KT,T,Compare,Resource>::value_type *, bool>
+   sorted_vector_map<KT,T,Compare,Resource>::buffer_insert(const value_type &value)
    {
-      pair<unsigned, bool> re = bsearch(key);
-      return re.second ? const_iterator(elements_ + re.first): end();
+      pair<unsigned, bool> re = bsearch(buffer_.first, buffer_.last - buffer_.first, value.first);
+      if (re.second)
+         return pair<value_type *, bool>(buffer_.first[re.first], false);
+      value_type **pos = buffer_.first + re.first;
+      for (value_type **i = buffer_.last++; i != pos; --i)
+         *i = *(i - 1);
+      value_type *p = *pos = create_value(value);
+      // the elements stay where they are, only their pointers move
+      if (buffer_.last - buffer_.first == (ttl::ptrdiff_t)buffer_.limit)
+      {
+         merge_buffer();
+         ++buffer_.stats.merges;
+      }
+      return pair<value_type *, bool>(p, true);
    }
-   template<typename KT, typename T, typename Compare>
-   typename sorted_vector_map<KT,T,Compare>::iterator
-   sorted_vector_map<KT,T,Compare>::find_insert_pos(const KT &key) const
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::set_buffer_limit(size_type limit)
    {
-      pair<unsigned, bool> re = bsearch(key);
-      return elements_ + re.first;
+      if (limit == buffer_.limit)
+         return;
+      if (buffer_.last != buffer_.first)
+         flush();
+      deallocate_buffer();
+      buffer_.first = buffer_.last = limit ? static_cast<value_type **>(Resource::allocate(limit * sizeof(value_type *))): 0;
+      buffer_.limit = limit;
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   typename sorted_vector_map<KT,T,Compare,Resource>::iterator
+   sorted_vector_map<KT,T,Compare,Resource>::erase(const_iterator first, const_iterator last)
+   {
+      // the range is a range of the array and one of the buffer
+      value_type **a = const_cast<value_type **>(first.a_);
+      value_type **b = const_cast<value_type **>(first.b_);
+      erase_slots(a, const_cast<value_type **>(last.a_), last_);
+      erase_slots(b, const_cast<value_type **>(last.b_), buffer_.last);
+      return iterator(a, b, this);
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::erase_slots(value_type **first, value_type **last, value_type **&end)
+   {
+      for (value_type **d = first; d != last; ++d)
+         destroy_value(*d);
+      while (last != end)
+         *first++ = *last++;
+      end = first;
+   }
+   template<typename KT, typename T, typename Compare, typename Resource>
+   template<class InputIt>
+   sorted_vector_map<KT,T,Compare,Resource>::sorted_vector_map(InputIt first, InputIt last, const Resource &r):
+      Resource(r), elements_(0), last_(0), end_of_elements_(0)
+   {
+      insert(first, last);
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   template<class InputIt>
+   void sorted_vector_map<KT,T,Compare,Resource>::insert_batch(InputIt first, InputIt last, bool sort)
+   {
+      vector<value_type *, Resource> batch(static_cast<const Resource &>(*this));
+      for (; first != last; ++first)
+      {
+         if (batch.size() == batch.capacity())
+            batch.reserve(batch.capacity() * 2 + 16);
+         batch.push_back(create_value(*first));
+      }
+      if (sort)
+      {
+         vector<value_type *, Resource> tmp(static_cast<const Resource &>(*this));
+         tmp.resize(batch.size());
+         sort_batch(batch.begin(), batch.end(), tmp.begin());
+      }
+      merge_batch(batch.begin(), batch.end());
+   }
+
+   // a stable sort, the merge of the batch keeps the first of the equal
+   // keys: runs of insertion sort, merged in passes between the batch and
+   // tmp, of the same size
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::sort_batch(value_type **first, value_type **last, value_type **tmp)
+   {
+      const size_type n = last - first, run = 16;
+      element_order less;
+      for (size_type lo = 0; lo < n; lo += run)
+      {
+         value_type **r = first + lo, **e = first + ttl::min(lo + run, n);
+         for (value_type **i = r + 1; i < e; ++i)
+         {
+            value_type *v = *i, **j = i;
+            for (; j != r && less(v, *(j - 1)); --j)
+               *j = *(j - 1);
+            *j = v;
+         }
+      }
+      value_type **from = first, **to = tmp;
+      for (size_type w = run; w < n; w *= 2)
+      {
+         for (size_type lo = 0; lo < n; lo += 2 * w)
+         {
+            value_type **i = from + lo, **mid = from + ttl::min(lo + w, n);
+            value_type **j = mid, **hi = from + ttl::min(lo + 2 * w, n), **o = to + lo;
+            while (i != mid && j != hi)
+               *o++ = less(*j, *i) ? *j++: *i++;
+            o = ttl::copy(i, mid, o);
+            ttl::copy(j, hi, o);
+         }
+         ttl::swap(from, to);
+      }
+      if (from != first)
+         ttl::copy(from, from + n, first);
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::merge_batch(value_type **first, value_type **last)
+   {
+      // the repeated keys and those here are dropped
+      value_type **kept = first;
+      value_type * const *j = elements_, * const *end = last_;
+      for (value_type **i = first; i != last; ++i)
+      {
+         const KT &key = (*i)->first;
+         j = _gallop_lower(j, end, key, element_less());
+         if ((kept != first && !Compare()(kept[-1]->first, key)) ||
+             (j != end && !Compare()(key, (*j)->first)))
+            destroy_value(*i);
+         else
+            *kept++ = *i;
+      }
+      const size_type added = kept - first;
+      if (!added)
+         return;
+      const size_type n = last_ - elements_;
+      if (n + added > (size_type)(end_of_elements_ - elements_))
+         reserve(n + ttl::max(added, n / 2));
+
+      value_type **i = last_, **o = last_ + added;
+      for (j = kept; j != first;)
+         if (i != elements_ && Compare()((*(j - 1))->first, (*(i - 1))->first))
+            *--o = *--i;
+         else
+            *--o = *--j;
+      last_ += added;
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   sorted_vector_map<KT,T,Compare,Resource> &
+   sorted_vector_map<KT,T,Compare,Resource>::operator=(const sorted_vector_map &other)
+   {
+      if (&other == this)
+         return *this;
+      clear();
+      copy_elements(other);
+      return *this;
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::reserve(size_type n)
+   {
+      if (n <= (size_type)(end_of_elements_ - elements_))
+         return;
+      value_type **newelements = allocate_elements(n);
+      value_type **o = ttl::copy(elements_, last_, newelements);
+      deallocate_elements();
+      elements_ = newelements;
+      last_ = o;
+      end_of_elements_ = elements_ + n;
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::unite(const sorted_vector_map &other)
+   {
+      settle();
+      // other is walked in order, its buffer too
+      const const_iterator first = other.begin(), last = other.end();
+      size_type added = 0;
+      value_type * const *j = elements_, * const *end = last_;
+      for (const_iterator i = first; i != last; ++i)
+      {
+         j = _gallop_lower(j, end, i->first, element_less());
+         if (j == end || Compare()(i->first, (*j)->first))
+            ++added;
+      }
+      if (!added)
+         return;
+      const size_type n = last_ - elements_;
+      if (n + added > (size_type)(end_of_elements_ - elements_))
+         reserve(n + ttl::max(added, n / 2));
+
+      // merged from the back
+      value_type **i = last_, **o = last_ + added;
+      for (const_iterator j = last; j != first;)
+      {
+         const_iterator prev = j;
+         --prev;
+         if (i != elements_ && !Compare()((*(i - 1))->first, prev->first))
+         {
+            if (!Compare()(prev->first, (*(i - 1))->first))
+               j = prev;
+            *--o = *--i;
+         }
+         else
+         {
+            *--o = create_value(*prev);
+            j = prev;
+         }
+      }
+      last_ += added;
+   }
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   void sorted_vector_map<KT,T,Compare,Resource>::retain(const sorted_vector_map &other, bool in_other)
+   {
+      if (&other == this)
+      {
+         if (!in_other)
+            clear();
+         return;
+      }
+      // the keys of other are in its array or its buffer
+      value_type **o = elements_;
+      value_type * const *j = other.elements_, * const *end = other.last_;
+      value_type * const *k = other.buffer_.first, * const *kend = other.buffer_.last;
+      for (value_type **i = elements_; i != last_; ++i)
+      {
+         const KT &key = (*i)->first;
+         j = _gallop_lower(j, end, key, element_less());
+         k = _gallop_lower(k, kend, key, element_less());
+         const bool there = (j != end && !Compare()(key, (*j)->first)) ||
+                            (k != kend && !Compare()(key, (*k)->first));
+         if (there == in_other)
+            *o++ = *i;
+         else
+            destroy_value(*i);
+      }
+      last_ = o;
    }
-   template<typename KT, typename T, typename Compare>
-   typename sorted_vector_map<KT,T,Compare>::iterator
-   sorted_vector_map<KT,T,Compare>::insert_before(iterator pos, const value_type& value)
+
+   template<typename KT, typename T, typename Compare, typename Resource>
+   typename sorted_vector_map<KT,T,Compare,Resource>::value_type **
+   sorted_vector_map<KT,T,Compare,Resource>::insert_before(value_type **pos, const value_type& value)
    {
       if (end_of_elements_ - last_ < 1)
       {
          value_type **o;
          value_type **i;
          size_type newcapacity = end_of_elements_ - elements_;
-         newcapacity += newcapacity/2; // temporarily funny...
-         if (!newcapacity)
-            newcapacity = 2;
-         value_type **newelements = o = new value_type *[newcapacity];
-         for (i = elements_; i != pos.ptr_;)
+         newcapacity += newcapacity/2 + 1;
+         value_type **newelements = o = allocate_elements(newcapacity);
+         for (i = elements_; i != pos;)
             *o++ = *i++;
-         *o = new value_type(value);
-         pos = iterator(o++);
+         *o = create_value(value);
+         pos = o++;
          for (; i != last_;)
             *o++ = *i++;
-         delete [] elements_;
+         deallocate_elements();
          elements_ = newelements;
          end_of_elements_ = elements_ + newcapacity;
          last_ = o;
@@ -299,10 +819,10 @@ namespace ttl
       }
       value_type **i = last_++;
       value_type **o = last_;
-      while (i != pos.ptr_)
+      while (i != pos)
          *--o = *--i;
-      *i = new value_type(value);
-      return iterator(i);
+      *i = create_value(value);
+      return i;
    }
 }
 #endif // _TINY_TEMPLATE_LIBRARY_SORTED_VECTOR_MAP_HPP_
@@ -0,0 +1,404 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a string of char with the short strings inline
+//
+// A string is 24 bytes. Up to inline_capacity (23) characters are kept
+// in them with no allocation, as in a fixed_vector: the last byte holds
+// 23 - size, which is 0, the terminator, for 23 characters. A longer
+// string allocates a power of two bytes from the Resource, keeps the
+// pointer and the size inline and the log2 of the allocation, tagged by
+// its high bit, in the last byte.
+//
+// It converts to a string_view, which does the searches and the
+// comparisons, so both are keys for map, sorted_vector_map (with
+// less<string>, or less<> to look up a string_view or a char *) and the
+// hashed containers (with hash<string>).
+//
+// A position out of the string is clamped to its size, there are no
+// exceptions.
+//
+//    ttl::string s("key");
+//    s += ':';
+//    s.append(v.substr(0, 16));
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_STRING_HPP_
+#define _TINY_TEMPLATE_LIBRARY_STRING_HPP_ 1
+
+#include <string.h>
+#include "types.hpp"
+#include "memory_resource.hpp"
+#include "string_view.hpp"
+
+namespace ttl
+{
+   template<typename Resource = new_delete_resource>
+   class sso_string: private Resource
+   {
+   public:
+      typedef char value_type;
+      typedef char *pointer;
+      typedef const char *const_pointer;
+      typedef char &reference;
+      typedef const char &const_reference;
+      typedef char *iterator;
+      typedef const char *const_iterator;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+      static const size_type npos = string_view::npos;
+      static const size_type inline_capacity = 23;
+
+   private:
+      struct heap
+      {
+         char *data;
+         size_type size;
+      };
+      union
+      {
+         char chars[inline_capacity + 1];
+         heap h;
+      } rep_;
+
+      enum { allocated = 0x80 };
+      unsigned char tag() const { return (unsigned char)rep_.chars[inline_capacity]; }
+      void set_tag(unsigned char t) { rep_.chars[inline_capacity] = (char)t; }
+      bool is_inline() const { return !(tag() & allocated); }
+      size_type allocation() const { return (size_type)1 << (tag() & ~allocated); }
+
+      void set_size(size_type n)
+      {
+         if (is_inline())
+         {
+            rep_.chars[n] = 0;
+            set_tag((unsigned char)(inline_capacity - n));
+         }
+         else
+         {
+            rep_.h.data[n] = 0;
+            rep_.h.size = n;
+         }
+      }
+      void init()
+      {
+         rep_.chars[0] = 0;
+         set_tag(inline_capacity);
+      }
+      void grow(size_type n);
+      // whether s points into the characters, which a reallocation frees
+      bool aliases(const char *s) const { return s >= data() && s < data() + size(); }
+      sso_string copy_of(const char *s, size_type n) const
+      {
+         sso_string copy(get_resource());
+         copy.append(s, n);
+         return copy;
+      }
+
+   public:
+      sso_string() { init(); }
+      explicit sso_string(const Resource &r): Resource(r) { init(); }
+      sso_string(const char *s) { init(); append(s, strlen(s)); }
+      sso_string(const char *s, size_type n) { init(); append(s, n); }
+      explicit sso_string(string_view s) { init(); append(s.data(), s.size()); }
+      sso_string(size_type n, char c) { init(); append(n, c); }
+      sso_string(const sso_string &other): Resource(other)
+      {
+         init();
+         append(other.data(), other.size());
+      }
+      ~sso_string()
+      {
+         if (!is_inline())
+            Resource::deallocate(rep_.h.data, allocation());
+      }
+
+      sso_string &operator=(const sso_string &other)
+      {
+         if (this != &other)
+            assign(other.data(), other.size());
+         return *this;
+      }
+      sso_string &operator=(string_view s) { return assign(s.data(), s.size()); }
+      sso_string &operator=(const char *s) { return assign(s, strlen(s)); }
+      sso_string &operator=(char c) { return assign(&c, 1); }
+
+      sso_string &assign(const char *s, size_type n)
+      {
+         if (aliases(s))
+            return *this = copy_of(s, n);
+         set_size(0);
+         return append(s, n);
+      }
+      sso_string &assign(string_view s) { return assign(s.data(), s.size()); }
+      sso_string &assign(size_type n, char c)
+      {
+         set_size(0);
+         return append(n, c);
+      }
+
+      iterator begin() { return data(); }
+      iterator end() { return data() + size(); }
+      const_iterator begin() const { return data(); }
+      const_iterator end() const { return data() + size(); }
+      const_iterator cbegin() const { return data(); }
+      const_iterator cend() const { return data() + size(); }
+
+      size_type size() const { return is_inline() ? inline_capacity - tag(): rep_.h.size; }
+      size_type length() const { return size(); }
+      size_type capacity() const { return is_inline() ? inline_capacity: allocation() - 1; }
+      size_type max_size() const { return npos / 2; }
+      bool empty() const { return !size(); }
+
+      char *data() { return is_inline() ? rep_.chars: rep_.h.data; }
+      const char *data() const { return is_inline() ? rep_.chars: rep_.h.data; }
+      const char *c_str() const { return data(); }
+      operator string_view() const { return string_view(data(), size()); }
+
+      reference operator[](size_type n) { return data()[n]; }
+      const_reference operator[](size_type n) const { return data()[n]; }
+      reference at(size_type n) { return data()[n]; }
+      const_reference at(size_type n) const { return data()[n]; }
+      reference front() { return data()[0]; }
+      const_reference front() const { return data()[0]; }
+      reference back() { return data()[size() - 1]; }
+      const_reference back() const { return data()[size() - 1]; }
+
+      void reserve(size_type n)
+      {
+         if (n > capacity())
+            grow(n);
+      }
+      // moves the characters back inline where they fit
+      void shrink_to_fit();
+      void resize(size_type n, char c = 0)
+      {
+         const size_type size = this->size();
+         if (n > size)
+            append(n - size, c);
+         else
+            set_size(n);
+      }
+      void clear() { set_size(0); }
+
+      void push_back(char c)
+      {
+         const size_type size = this->size();
+         if (size == capacity())
+            grow(size + 1);
+         data()[size] = c;
+         set_size(size + 1);
+      }
+      void pop_back() { set_size(size() - 1); }
+
+      sso_string &append(const char *s, size_type n)
+      {
+         const size_type size = this->size();
+         if (n > capacity() - size)
+         {
+            if (aliases(s))
+               return append(copy_of(s, n));
+            grow(size + n);
+         }
+         if (n)
+            memcpy(data() + size, s, n);
+         set_size(size + n);
+         return *this;
+      }
+      sso_string &append(string_view s) { return append(s.data(), s.size()); }
+      sso_string &append(const char *s) { return append(s, strlen(s)); }
+      sso_string &append(size_type n, char c)
+      {
+         const size_type size = this->size();
+         reserve(size + n);
+         memset(data() + size, c, n);
+         set_size(size + n);
+         return *this;
+      }
+      sso_string &operator+=(string_view s) { return append(s.data(), s.size()); }
+      sso_string &operator+=(const char *s) { return append(s, strlen(s)); }
+      sso_string &operator+=(char c) { push_back(c); return *this; }
+
+      sso_string &insert(size_type pos, string_view s);
+      sso_string &erase(size_type pos = 0, size_type n = npos);
+      iterator erase(const_iterator first, const_iterator last)
+      {
+         const size_type pos = first - data();
+         erase(pos, last - first);
+         return data() + pos;
+      }
+
+      sso_string substr(size_type pos = 0, size_type n = npos) const
+      {
+         const string_view s = string_view(*this).substr(pos, n);
+         return copy_of(s.data(), s.size());
+      }
+      size_type copy(char *s, size_type n, size_type pos = 0) const { return string_view(*this).copy(s, n, pos); }
+
+      int compare(string_view s) const { return string_view(*this).compare(s); }
+      bool starts_with(string_view s) const { return string_view(*this).starts_with(s); }
+      bool ends_with(string_view s) const { return string_view(*this).ends_with(s); }
+      size_type find(string_view s, size_type pos = 0) const { return string_view(*this).find(s, pos); }
+      size_type find(char c, size_type pos = 0) const { return string_view(*this).find(c, pos); }
+      size_type rfind(string_view s, size_type pos = npos) const { return string_view(*this).rfind(s, pos); }
+      size_type rfind(char c, size_type pos = npos) const { return string_view(*this).rfind(c, pos); }
+      size_type find_first_of(string_view s, size_type pos = 0) const
+      {
+         return string_view(*this).find_first_of(s, pos);
+      }
+      size_type find_last_of(string_view s, size_type pos = npos) const
+      {
+         return string_view(*this).find_last_of(s, pos);
+      }
+      size_type find_first_not_of(string_view s, size_type pos = 0) const
+      {
+         return string_view(*this).find_first_not_of(s, pos);
+      }
+      size_type find_last_not_of(string_view s, size_type pos = npos) const
+      {
+         return string_view(*this).find_last_not_of(s, pos);
+      }
+
+      // the representations hold no pointers into themselves
+      void swap(sso_string &other)
+      {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(other));
+         char tmp[sizeof(rep_)];
+         memcpy(tmp, &rep_, sizeof(rep_));
+         memcpy(&rep_, &other.rep_, sizeof(rep_));
+         memcpy(&other.rep_, tmp, sizeof(rep_));
+      }
+
+      const Resource &get_resource() const { return *this; }
+   };
+
+   typedef sso_string<> string;
+
+   template<typename Resource>
+   void sso_string<Resource>::grow(size_type n)
+   {
+      unsigned char log2 = 5;
+      while (((size_type)1 << log2) <= n)
+         ++log2;
+      char *data = static_cast<char *>(Resource::allocate((size_type)1 << log2));
+      const size_type size = this->size();
+      memcpy(data, this->data(), size + 1);
+      if (!is_inline())
+         Resource::deallocate(rep_.h.data, allocation());
+      rep_.h.data = data;
+      rep_.h.size = size;
+      set_tag(allocated | log2);
+   }
+
+   template<typename Resource>
+   void sso_string<Resource>::shrink_to_fit()
+   {
+      const size_type size = this->size();
+      if (is_inline() || size > inline_capacity)
+         return;
+      char *data = rep_.h.data;
+      const size_type n = allocation();
+      memcpy(rep_.chars, data, size);
+      set_tag(0);
+      set_size(size);
+      Resource::deallocate(data, n);
+   }
+
+   template<typename Resource>
+   sso_string<Resource> &sso_string<Resource>::insert(size_type pos, string_view s)
+   {
+      if (aliases(s.data()))
+         return insert(pos, copy_of(s.data(), s.size()));
+      const size_type size = this->size();
+      if (pos > size)
+         pos = size;
+      reserve(size + s.size());
+      char *p = data() + pos;
+      memmove(p + s.size(), p, size - pos);
+      if (s.size())
+         memcpy(p, s.data(), s.size());
+      set_size(size + s.size());
+      return *this;
+   }
+
+   template<typename Resource>
+   sso_string<Resource> &sso_string<Resource>::erase(size_type pos, size_type n)
+   {
+      const size_type size = this->size();
+      if (pos > size)
+         pos = size;
+      if (n > size - pos)
+         n = size - pos;
+      char *p = data() + pos;
+      memmove(p, p + n, size - pos - n);
+      set_size(size - n);
+      return *this;
+   }
+
+   //
+   // The strings compare as their string_views, a string with a string_view
+   // or a char * converts to the string_view; between two strings, these
+   // are a better match than the comparisons of the Resource base.
+   //
+   template<typename Resource>
+   inline bool operator==(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) == string_view(b);
+   }
+   template<typename Resource>
+   inline bool operator!=(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) != string_view(b);
+   }
+   template<typename Resource>
+   inline bool operator<(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) < string_view(b);
+   }
+   template<typename Resource>
+   inline bool operator>(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) > string_view(b);
+   }
+   template<typename Resource>
+   inline bool operator<=(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) <= string_view(b);
+   }
+   template<typename Resource>
+   inline bool operator>=(const sso_string<Resource> &a, const sso_string<Resource> &b)
+   {
+      return string_view(a) >= string_view(b);
+   }
+
+   template<typename Resource>
+   sso_string<Resource> operator+(const sso_string<Resource> &a, string_view b)
+   {
+      sso_string<Resource> s(a.get_resource());
+      s.reserve(a.size() + b.size());
+      s.append(a.data(), a.size());
+      s.append(b.data(), b.size());
+      return s;
+   }
+   template<typename Resource>
+   sso_string<Resource> operator+(const sso_string<Resource> &a, const char *b)
+   {
+      return a + string_view(b);
+   }
+   template<typename Resource>
+   sso_string<Resource> operator+(const sso_string<Resource> &a, char b)
+   {
+      return a + string_view(&b, 1);
+   }
+
+   template<typename Resource>
+   struct hash<sso_string<Resource> >
+   {
+      typedef sso_string<Resource> argument_type;
+      typedef ttl::size_t result_type;
+      ttl::size_t operator()(const sso_string<Resource> &s) const { return hash_bytes(s.data(), s.size()); }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_STRING_HPP_
@@ -0,0 +1,315 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: an implementation of STL string_view of char
+//
+// The searches and the comparison scan 16 bytes at once with SSE2 where
+// it is available: find of a character and compare test them for
+// equality, find_first_of of a set of up to 16 characters tests each of
+// them, and find of a string filters the positions by its first and last
+// characters (see _search_bytes in algorithm.hpp). Elsewhere they use
+// memchr, memcmp, a bitmap of the set and the two-way search.
+//
+// A position out of the view is clamped to its size, there are no
+// exceptions.
+//
+// hash<string_view> and hash_bytes hash the characters a word at a time.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_STRING_VIEW_HPP_
+#define _TINY_TEMPLATE_LIBRARY_STRING_VIEW_HPP_ 1
+
+#include <string.h>
+#include <limits.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+#include "types.hpp"
+#include "functional.hpp"
+#include "utility.hpp"
+#include "algorithm.hpp"
+
+namespace ttl
+{
+   // the index of the first c in s[0, n), or n
+   inline ttl::size_t _find_byte(const char *s, ttl::size_t n, char c)
+   {
+#if defined(__SSE2__) && defined(__GNUC__)
+      const __m128i v = _mm_set1_epi8(c);
+      ttl::size_t i = 0;
+      for (; i + 16 <= n; i += 16)
+      {
+         const unsigned mask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)), v));
+         if (mask)
+            return i + __builtin_ctz(mask);
+      }
+      for (; i < n; ++i)
+         if (s[i] == c)
+            return i;
+      return n;
+#else
+      const void *p = n ? memchr(s, c, n): 0;
+      return p ? static_cast<const char *>(p) - s: n;
+#endif
+   }
+
+   // a set of characters as a bitmap
+   struct _byte_set
+   {
+      unsigned long bits[(1 << CHAR_BIT) / (CHAR_BIT * sizeof(unsigned long))];
+      _byte_set(const char *set, ttl::size_t m)
+      {
+         memset(bits, 0, sizeof(bits));
+         for (ttl::size_t j = 0; j < m; ++j)
+         {
+            const unsigned char c = (unsigned char)set[j];
+            bits[c / (CHAR_BIT * sizeof(unsigned long))] |= 1ul << c % (CHAR_BIT * sizeof(unsigned long));
+         }
+      }
+      bool test(char c) const
+      {
+         const unsigned char u = (unsigned char)c;
+         return bits[u / (CHAR_BIT * sizeof(unsigned long))] >> u % (CHAR_BIT * sizeof(unsigned long)) & 1;
+      }
+   };
+
+   // the index of the first character of s[0, n) in set[0, m), or n
+   inline ttl::size_t _find_first_of_bytes(const char *s, ttl::size_t n, const char *set, ttl::size_t m)
+   {
+      ttl::size_t i = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+      if (m <= 16)
+      {
+         __m128i v[16];
+         for (ttl::size_t j = 0; j < m; ++j)
+            v[j] = _mm_set1_epi8(set[j]);
+         for (; i + 16 <= n; i += 16)
+         {
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i eq = _mm_setzero_si128();
+            for (ttl::size_t j = 0; j < m; ++j)
+               eq = _mm_or_si128(eq, _mm_cmpeq_epi8(b, v[j]));
+            const unsigned mask = _mm_movemask_epi8(eq);
+            if (mask)
+               return i + __builtin_ctz(mask);
+         }
+      }
+#endif
+      const _byte_set bytes(set, m);
+      for (; i < n; ++i)
+         if (bytes.test(s[i]))
+            return i;
+      return n;
+   }
+
+   // memcmp of a[0, n) and b[0, n)
+   inline int _compare_bytes(const char *a, const char *b, ttl::size_t n)
+   {
+#if defined(__SSE2__) && defined(__GNUC__)
+      ttl::size_t i = 0;
+      for (; i + 16 <= n; i += 16)
+      {
+         const unsigned mask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i))));
+         if (mask != 0xffff)
+         {
+            i += __builtin_ctz(~mask);
+            return (unsigned char)a[i] - (unsigned char)b[i];
+         }
+      }
+      for (; i < n; ++i)
+         if (a[i] != b[i])
+            return (unsigned char)a[i] - (unsigned char)b[i];
+      return 0;
+#else
+      return n ? memcmp(a, b, n): 0;
+#endif
+   }
+
+   inline ttl::size_t hash_bytes(const char *s, ttl::size_t n)
+   {
+      unsigned long long h = n * 0x9e3779b97f4a7c15ull, w;
+      for (; n >= sizeof(w); s += sizeof(w), n -= sizeof(w))
+      {
+         memcpy(&w, s, sizeof(w));
+         h ^= w * 0x87c37b91114253d5ull;
+         h = (h << 31 | h >> 33) * 0x4cf5ad432745937full;
+      }
+      w = 0;
+      if (n)
+         memcpy(&w, s, n);
+      return hash_mix(h ^ w);
+   }
+
+   class string_view
+   {
+   public:
+      typedef char value_type;
+      typedef const char *pointer;
+      typedef const char *const_pointer;
+      typedef const char &reference;
+      typedef const char &const_reference;
+      typedef const char *iterator;
+      typedef const char *const_iterator;
+      typedef ttl::size_t size_type;
+      typedef ttl::ptrdiff_t difference_type;
+
+      static const size_type npos = (size_type)-1;
+
+   private:
+      const char *data_;
+      size_type size_;
+
+   public:
+      string_view(): data_(0), size_(0) {}
+      string_view(const char *s): data_(s), size_(strlen(s)) {}
+      string_view(const char *s, size_type n): data_(s), size_(n) {}
+
+      const_iterator begin() const { return data_; }
+      const_iterator end() const { return data_ + size_; }
+      const_iterator cbegin() const { return data_; }
+      const_iterator cend() const { return data_ + size_; }
+
+      size_type size() const { return size_; }
+      size_type length() const { return size_; }
+      size_type max_size() const { return npos / 2; }
+      bool empty() const { return !size_; }
+
+      const_reference operator[](size_type n) const { return data_[n]; }
+      const_reference at(size_type n) const { return data_[n]; }
+      const_reference front() const { return data_[0]; }
+      const_reference back() const { return data_[size_ - 1]; }
+      const_pointer data() const { return data_; }
+
+      void remove_prefix(size_type n) { data_ += n; size_ -= n; }
+      void remove_suffix(size_type n) { size_ -= n; }
+      void swap(string_view &other)
+      {
+         ttl::swap(data_, other.data_);
+         ttl::swap(size_, other.size_);
+      }
+
+      size_type copy(char *s, size_type n, size_type pos = 0) const
+      {
+         const string_view v = substr(pos, n);
+         if (v.size_)
+            memcpy(s, v.data_, v.size_);
+         return v.size_;
+      }
+      string_view substr(size_type pos = 0, size_type n = npos) const
+      {
+         if (pos > size_)
+            pos = size_;
+         return string_view(data_ + pos, n < size_ - pos ? n: size_ - pos);
+      }
+
+      int compare(string_view other) const
+      {
+         const int r = _compare_bytes(data_, other.data_, size_ < other.size_ ? size_: other.size_);
+         return r ? r: size_ < other.size_ ? -1: size_ != other.size_;
+      }
+      bool starts_with(string_view s) const
+      {
+         return size_ >= s.size_ && !_compare_bytes(data_, s.data_, s.size_);
+      }
+      bool ends_with(string_view s) const
+      {
+         return size_ >= s.size_ && !_compare_bytes(data_ + size_ - s.size_, s.data_, s.size_);
+      }
+
+      size_type find(char c, size_type pos = 0) const
+      {
+         if (pos >= size_)
+            return npos;
+         const size_type i = pos + _find_byte(data_ + pos, size_ - pos, c);
+         return i < size_ ? i: npos;
+      }
+      size_type find(string_view s, size_type pos = 0) const;
+      size_type rfind(char c, size_type pos = npos) const
+      {
+         for (size_type i = pos < size_ ? pos + 1: size_; i--; )
+            if (data_[i] == c)
+               return i;
+         return npos;
+      }
+      size_type rfind(string_view s, size_type pos = npos) const
+      {
+         if (s.size_ > size_)
+            return npos;
+         for (size_type i = pos < size_ - s.size_ ? pos + 1: size_ - s.size_ + 1; i--; )
+            if (!_compare_bytes(data_ + i, s.data_, s.size_))
+               return i;
+         return npos;
+      }
+      size_type find_first_of(string_view s, size_type pos = 0) const
+      {
+         if (pos >= size_)
+            return npos;
+         const size_type i = pos + _find_first_of_bytes(data_ + pos, size_ - pos, s.data_, s.size_);
+         return i < size_ ? i: npos;
+      }
+      size_type find_first_of(char c, size_type pos = 0) const { return find(c, pos); }
+      size_type find_last_of(string_view s, size_type pos = npos) const
+      {
+         const _byte_set bytes(s.data_, s.size_);
+         for (size_type i = pos < size_ ? pos + 1: size_; i--; )
+            if (bytes.test(data_[i]))
+               return i;
+         return npos;
+      }
+      size_type find_last_of(char c, size_type pos = npos) const { return rfind(c, pos); }
+      size_type find_first_not_of(string_view s, size_type pos = 0) const
+      {
+         const _byte_set bytes(s.data_, s.size_);
+         for (size_type i = pos; i < size_; ++i)
+            if (!bytes.test(data_[i]))
+               return i;
+         return npos;
+      }
+      size_type find_last_not_of(string_view s, size_type pos = npos) const
+      {
+         const _byte_set bytes(s.data_, s.size_);
+         for (size_type i = pos < size_ ? pos + 1: size_; i--; )
+            if (!bytes.test(data_[i]))
+               return i;
+         return npos;
+      }
+   };
+
+   inline string_view::size_type string_view::find(string_view s, size_type pos) const
+   {
+      if (pos > size_ || s.size_ > size_ - pos)
+         return npos;
+      if (s.size_ < 2)
+         return s.size_ ? find(s.data_[0], pos): pos;
+      const char *first = data_ + pos, *last = data_ + size_;
+#if defined(__SSE2__) && defined(__GNUC__)
+      const char *r = _search_bytes(first, last - first, s.data_, s.size_);
+#else
+      const char *r = two_way_searcher<const char *>(s.data_, s.data_ + s.size_)(first, last).first;
+#endif
+      return r != last ? r - data_: npos;
+   }
+
+   inline bool operator==(string_view a, string_view b)
+   {
+      return a.size() == b.size() && !_compare_bytes(a.data(), b.data(), a.size());
+   }
+   inline bool operator!=(string_view a, string_view b) { return !(a == b); }
+   inline bool operator<(string_view a, string_view b) { return a.compare(b) < 0; }
+   inline bool operator>(string_view a, string_view b) { return a.compare(b) > 0; }
+   inline bool operator<=(string_view a, string_view b) { return a.compare(b) <= 0; }
+   inline bool operator>=(string_view a, string_view b) { return a.compare(b) >= 0; }
+
+   template<>
+   struct hash<string_view>
+   {
+      typedef string_view argument_type;
+      typedef ttl::size_t result_type;
+      ttl::size_t operator()(string_view s) const { return hash_bytes(s.data(), s.size()); }
+   };
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_STRING_VIEW_HPP_
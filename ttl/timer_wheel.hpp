@@ -0,0 +1,263 @@
+/////////////////////////////////////////////////// vim: sw=3 ts=8 et
+//
+// Tiny Template Library: a hierarchical timer wheel
+//
+// The timers are intrusive: a timer_node is a base (or a member) of the
+// user's object and is linked into the wheel slots through its list_node,
+// so schedule, reschedule and cancel are O(1) and never allocate.
+//
+// The level L of the wheel has 64 slots of 64^L ticks each. A timer is put
+// in the lowest level whose span covers its distance from the current time
+// and is moved down (cascaded) as the time approaches its expiry. Timers
+// beyond the span of the top level wait there and are re-examined each time
+// the top level comes around. Slots with no timers are skipped, so advancing
+// over an idle period costs O(Levels), not O(ticks).
+//
+// George Varghese, Tony Lauck, "Hashed and Hierarchical Timing Wheels:
+// Data Structures for the Efficient Implementation of a Timer Facility",
+// SOSP 1987.
+//
+// This code is Public Domain
+//
+#ifndef _TINY_TEMPLATE_LIBRARY_TIMER_WHEEL_HPP_
+#define _TINY_TEMPLATE_LIBRARY_TIMER_WHEEL_HPP_ 1
+
+#include "types.hpp"
+#include "list.hpp"
+
+namespace ttl
+{
+   struct timer_node: list_node
+   {
+      unsigned long long expires;
+
+      timer_node(): expires(0) { init(); }
+      // a copy is not scheduled
+      timer_node(const timer_node &other): list_node(), expires(other.expires) { init(); }
+      timer_node &operator=(const timer_node &) { return *this; }
+
+      bool scheduled() const { return next != this; }
+   };
+
+   //
+   // Levels * 6 bits of ticks are covered without re-examination, up to 10
+   // levels; the default covers 2^36 ticks (2 years of milliseconds).
+   //
+   // The wheel does not own the timers: a timer must be cancelled before it
+   // is destroyed, and the timers still scheduled when the wheel is
+   // destroyed are left unscheduled.
+   //
+   template<const unsigned int Levels = 6>
+   class timer_wheel
+   {
+   public:
+      typedef unsigned long long tick_type;
+      typedef ttl::size_t size_type;
+
+      static const unsigned int slot_bits = 6;
+      static const unsigned int slots = 1u << slot_bits;
+
+   private:
+      static const unsigned int slot_mask = slots - 1;
+
+      list_node wheel_[Levels][slots];
+      unsigned long long occupied_[Levels]; // may have bits of empty slots
+      tick_type now_;
+      size_type size_;
+
+      timer_wheel(const timer_wheel &);
+      timer_wheel &operator=(const timer_wheel &);
+
+      static unsigned int first_bit(unsigned long long bits)
+      {
+#ifdef __GNUC__
+         return __builtin_ctzll(bits);
+#else
+         unsigned int n = 0;
+         for (; !(bits & 1); bits >>= 1)
+            ++n;
+         return n;
+#endif
+      }
+
+      void place(timer_node &t, tick_type when);
+      tick_type next_event();
+      void cascade(unsigned int level, unsigned int slot);
+      template<typename Callback>
+      size_type expire(unsigned int slot, Callback &cb);
+
+   public:
+      explicit timer_wheel(tick_type now = 0);
+      ~timer_wheel();
+
+      tick_type now() const { return now_; }
+      size_type size() const { return size_; }
+      bool empty() const { return !size_; }
+
+      // (re)schedules the timer to expire at the given tick, the timers due
+      // at or before now() expire at now() + 1
+      void schedule(timer_node &t, tick_type expires)
+      {
+         if (t.scheduled())
+            t.unlink();
+         else
+            ++size_;
+         t.expires = expires;
+         place(t, expires > now_ ? expires: now_ + 1);
+      }
+
+      void cancel(timer_node &t)
+      {
+         if (t.scheduled())
+         {
+            t.unlink();
+            t.init();
+            --size_;
+         }
+      }
+
+      // Moves the time forward and calls cb(timer_node &) for each timer
+      // that expires at or before now, tick by tick (the timers of one tick
+      // in no particular order). A timer is unscheduled before its callback
+      // is called, so the callback may schedule it again or destroy it.
+      // Returns the number of expired timers.
+      template<typename Callback>
+      size_type advance(tick_type now, Callback cb);
+   };
+
+   template<const unsigned int Levels>
+   timer_wheel<Levels>::timer_wheel(tick_type now):
+      now_(now), size_(0)
+   {
+      for (unsigned int level = 0; level < Levels; ++level)
+      {
+         occupied_[level] = 0;
+         for (unsigned int s = 0; s < slots; ++s)
+            wheel_[level][s].init();
+      }
+   }
+
+   template<const unsigned int Levels>
+   timer_wheel<Levels>::~timer_wheel()
+   {
+      for (unsigned int level = 0; level < Levels; ++level)
+         for (unsigned int s = 0; s < slots; ++s)
+            for (list_node &head = wheel_[level][s]; head.next != &head;)
+            {
+               list_node *n = head.next;
+               n->unlink();
+               n->init();
+            }
+   }
+
+   template<const unsigned int Levels>
+   void timer_wheel<Levels>::place(timer_node &t, tick_type when)
+   {
+      const tick_type delta = when - now_;
+      unsigned int level = 0;
+      while (level + 1 < Levels && delta >> (slot_bits * (level + 1)))
+         ++level;
+      if (delta >> (slot_bits * Levels))
+         when = now_ + ((tick_type)1 << (slot_bits * Levels)) - 1;
+      const unsigned int s = (when >> (slot_bits * level)) & slot_mask;
+      wheel_[level][s].insert_before(&t);
+      occupied_[level] |= 1ull << s;
+   }
+
+   // The earliest tick at which a slot has to be expired or cascaded
+   template<const unsigned int Levels>
+   typename timer_wheel<Levels>::tick_type timer_wheel<Levels>::next_event()
+   {
+      tick_type next = (tick_type)-1;
+      for (unsigned int level = 0; level < Levels; ++level)
+      {
+         const unsigned int shift = slot_bits * level;
+         const unsigned int idx = (now_ >> shift) & slot_mask;
+         const tick_type rotation = (tick_type)slots << shift;
+         const tick_type base = now_ & ~(rotation - 1);
+         while (occupied_[level])
+         {
+            // the slots after the current one are in this rotation of the
+            // level, the rest have wrapped around into the next one
+            const unsigned long long later = idx == slot_mask ? 0: occupied_[level] & (~0ull << (idx + 1));
+            const unsigned int s = first_bit(later ? later: occupied_[level]);
+            if (wheel_[level][s].next == &wheel_[level][s])
+            {
+               occupied_[level] &= ~(1ull << s);
+               continue;
+            }
+            const tick_type t = base + (later ? 0: rotation) + ((tick_type)s << shift);
+            if (t < next)
+               next = t;
+            break;
+         }
+      }
+      return next;
+   }
+
+   template<const unsigned int Levels>
+   void timer_wheel<Levels>::cascade(unsigned int level, unsigned int slot)
+   {
+      list_node &head = wheel_[level][slot];
+      occupied_[level] &= ~(1ull << slot);
+      if (head.next == &head)
+         return;
+      list_node pending;
+      pending.init();
+      pending.splice(head.next, &head);
+      while (pending.next != &pending)
+      {
+         timer_node *t = static_cast<timer_node *>(pending.next);
+         t->unlink();
+         place(*t, t->expires);
+      }
+   }
+
+   template<const unsigned int Levels>
+   template<typename Callback>
+   typename timer_wheel<Levels>::size_type timer_wheel<Levels>::expire(unsigned int slot, Callback &cb)
+   {
+      list_node &head = wheel_[0][slot];
+      occupied_[0] &= ~(1ull << slot);
+      if (head.next == &head)
+         return 0;
+      list_node due;
+      due.init();
+      due.splice(head.next, &head);
+      size_type n = 0;
+      while (due.next != &due)
+      {
+         timer_node *t = static_cast<timer_node *>(due.next);
+         t->unlink();
+         t->init();
+         --size_;
+         ++n;
+         cb(*t);
+      }
+      return n;
+   }
+
+   template<const unsigned int Levels>
+   template<typename Callback>
+   typename timer_wheel<Levels>::size_type timer_wheel<Levels>::advance(tick_type now, Callback cb)
+   {
+      size_type n = 0;
+      while (size_)
+      {
+         const tick_type t = next_event();
+         if (t > now)
+            break;
+         now_ = t;
+         for (unsigned int level = 1;
+              level < Levels && !(t & (((tick_type)1 << (slot_bits * level)) - 1));
+              ++level)
+            cascade(level, (t >> (slot_bits * level)) & slot_mask);
+         n += expire(t & slot_mask, cb);
+      }
+      if (now_ < now)
+         now_ = now;
+      return n;
+   }
+}
+
+#endif // _TINY_TEMPLATE_LIBRARY_TIMER_WHEEL_HPP_
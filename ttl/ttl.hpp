@@ -17,8 +17,9 @@
 //
 // Some templates are implementations of STL interfaces, some are not.
 //
-// There is no allocator support and the O(log N) and similar complexity
-// guarantees might be not implemented.
+// There are no STL allocators, the allocating containers take a simpler
+// memory resource (see memory_resource.hpp). The O(log N) and similar
+// complexity guarantees might be not implemented.
 //
 // The reverse iterators are not implemented.
 //
@@ -36,34 +37,40 @@
 #include "type_traits.hpp"
 #include "functional.hpp"
 #include "utility.hpp"
+#include "memory_resource.hpp"
 #include "algorithm.hpp"
 #include "array.hpp"
 #include "vector.hpp"
 #include "fixed_vector.hpp"
+#include "string_view.hpp"
+#include "string.hpp"
 #include "forward_list.hpp"
 #include "backward_list.hpp"
 #include "lazy_queue.hpp"
+#include "circular_buffer.hpp"
+#include "deque.hpp"
+#include "priority_queue.hpp"
+#include "timer_wheel.hpp"
 #include "list.hpp"
+#include "fixed_list.hpp"
+#include "fixed_forward_list.hpp"
+#include "fixed_backward_list.hpp"
+#include "intrusive_list.hpp"
+#include "intrusive_slist.hpp"
 #include "map.hpp"
 #include "set.hpp"
+#include "intrusive_rbtree.hpp"
 #include "vector_map.hpp"
 #include "sorted_vector_map.hpp"
+#include "fixed_unordered_map.hpp"
+#include "lru_cache.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+#include "flat_map_file.hpp"
 #include "bitset.hpp"
-
-namespace ttl
-{
-   //
-   // TODO: items below
-   //
-
-   // Lists with a fixed predefined storage
-   template<typename T, const ttl::size_t N> class fixed_list {};
-   template<typename T, const ttl::size_t N> class fixed_forward_list {};
-   template<typename T, const ttl::size_t N> class fixed_backward_list {};
-
-   // Red-black tree derivations
-   template<typename Key, typename Compare> class multiset {};
-   template<typename T> class multimap {};
-}
+#include "dynamic_bitset.hpp"
+#include "roaring_bitmap.hpp"
+#include "rank_select.hpp"
+#include "atomic_bitset.hpp"
 
 #endif // _TINY_TEMPLATE_LIBRARY_HPP_
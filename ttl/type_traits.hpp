@@ -155,5 +155,9 @@ namespace ttl
    template<class T> struct is_array<T[]>: true_type {};
    template<class T, ttl::size_t N> struct is_array<T[N]>: true_type {};
 
+   // enable_if<B, T>::type is T if B, else a substitution failure
+   template<bool B, class T = void> struct enable_if {};
+   template<class T> struct enable_if<true, T> { typedef T type; };
+
 }
 #endif // _TINY_TEMPLATE_LIBRARY_TYPE_TRAITS_HPP_
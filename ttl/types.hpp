@@ -13,5 +13,9 @@ namespace ttl
 {
    using ::size_t;
    using ::ptrdiff_t;
+
+   // to keep the data written by one thread apart from the data read by
+   // the others
+   static const ttl::size_t cache_line_size = 64;
 }
 #endif // _TINY_TEMPLATE_LIBRARY_TYPES_HPP_
@@ -9,14 +9,15 @@
 
 #include <new>
 #include "types.hpp"
+#include "memory_resource.hpp"
 
 namespace ttl
 {
    template<typename T> void swap(T &, T &);
    template<class InputIt1, class InputIt2> bool equal(InputIt1, InputIt1, InputIt2, InputIt2);
 
-   template<typename T>
-   class vector
+   template<typename T, typename Resource = new_delete_resource>
+   class vector: private Resource
    {
    public:
       typedef T              value_type;
@@ -57,20 +58,24 @@ namespace ttl
          ::new(p) T(*i);
          ++i;
       }
-      iterator insert_values(const_iterator pos, difference_type n, void (ttl::vector<T>::*)(T *, vc_args &) const, vc_args &);
+      iterator insert_values(const_iterator pos, difference_type n, void (ttl::vector<T,Resource>::*)(T *, vc_args &) const, vc_args &);
+
+      T *allocate(size_type n) { return static_cast<T *>(Resource::allocate(n * sizeof(T))); }
+      void deallocate() { Resource::deallocate(elements_, capacity() * sizeof(T)); }
 
    public:
       vector(): elements_(0), last_(0), end_of_elements_(0) {}
-      explicit vector(size_type n);
-      explicit vector(size_type n, const value_type &);
+      explicit vector(const Resource &r): Resource(r), elements_(0), last_(0), end_of_elements_(0) {}
+      explicit vector(size_type n, const Resource &r = Resource());
+      explicit vector(size_type n, const value_type &, const Resource &r = Resource());
       vector(const vector &other);
       template<typename RandomAccessIterator>
-      vector(RandomAccessIterator first, RandomAccessIterator last);
+      vector(RandomAccessIterator first, RandomAccessIterator last, const Resource &r = Resource());
 
       ~vector()
       {
          clear();
-         ::operator delete(elements_);
+         deallocate();
       }
 
       vector& operator=(const vector &other);
@@ -122,20 +127,20 @@ namespace ttl
       iterator insert(const_iterator pos, size_type n, const value_type &x)
       {
          vc_counter_args args(x);
-         return insert_values(pos, n, &ttl::vector<T>::vc_counter, args);
+         return insert_values(pos, n, &vector::vc_counter, args);
       }
 
       iterator insert(const_iterator pos, const value_type &x)
       {
          vc_counter_args args(x);
-         return insert_values(pos, 1, &ttl::vector<T>::vc_counter, args);
+         return insert_values(pos, 1, &vector::vc_counter, args);
       }
 
       template<typename InputIterator>
       iterator insert(const_iterator pos, InputIterator first, InputIterator last)
       {
          vc_iterator_args<InputIterator> args(first);
-         return insert_values(pos, last - first, &ttl::vector<T>::vc_iterator<InputIterator>, args);
+         return insert_values(pos, last - first, &vector::vc_iterator<InputIterator>, args);
       }
 
       void push_back(const value_type &x)
@@ -160,6 +165,7 @@ namespace ttl
 
       void swap(vector& x)
       {
+         ttl::swap(static_cast<Resource &>(*this), static_cast<Resource &>(x));
          ttl::swap(this->elements_, x.elements_);
          ttl::swap(this->last_, x.last_);
          ttl::swap(this->end_of_elements_, x.end_of_elements_);
@@ -170,43 +176,48 @@ namespace ttl
          while (last_ > elements_)
             (--last_)->~T();
       }
+
+      const Resource &get_resource() const { return *this; }
    };
 
-   template<typename T>
-   vector<T>::vector(size_type n)
+   template<typename T, typename Resource>
+   vector<T,Resource>::vector(size_type n, const Resource &r):
+      Resource(r)
    {
-      last_ = elements_ = static_cast<T *>(::operator new(n * sizeof(T)));
+      last_ = elements_ = allocate(n);
       end_of_elements_ = elements_ + n;
       while (n--)
          ::new(last_++) T();
    }
-   template<typename T>
-   vector<T>::vector(size_type n, const value_type &value)
+   template<typename T, typename Resource>
+   vector<T,Resource>::vector(size_type n, const value_type &value, const Resource &r):
+      Resource(r)
    {
-      last_ = elements_ = static_cast<T *>(::operator new(n * sizeof(T)));
+      last_ = elements_ = allocate(n);
       end_of_elements_ = elements_ + n;
       while (n--)
          ::new(last_++) T(value);
    }
-   template<typename T>
-   vector<T>::vector(const vector &other)
+   template<typename T, typename Resource>
+   vector<T,Resource>::vector(const vector &other):
+      Resource(other)
    {
-      last_ = elements_ = static_cast<T *>(::operator new(other.size() * sizeof(T)));
+      last_ = elements_ = allocate(other.size());
       end_of_elements_ = elements_ + other.size();
       for (const_iterator i = other.cbegin(); i != other.cend(); ++i)
          ::new(last_++) T(*i);
    }
-   template<typename T>
+   template<typename T, typename Resource>
    template<typename RandomAccessIterator>
-   vector<T>::vector(RandomAccessIterator first, RandomAccessIterator last):
-      elements_(0), last_(0), end_of_elements_(0)
+   vector<T,Resource>::vector(RandomAccessIterator first, RandomAccessIterator last, const Resource &r):
+      Resource(r), elements_(0), last_(0), end_of_elements_(0)
    {
       reserve(last - first);
       for (; first != last; ++first)
          push_back(*first);
    }
-   template<typename T>
-   vector<T> &vector<T>::operator=(const vector &other)
+   template<typename T, typename Resource>
+   vector<T,Resource> &vector<T,Resource>::operator=(const vector &other)
    {
       clear();
       reserve(other.capacity());
@@ -214,16 +225,16 @@ namespace ttl
          ::new(last_++) T(*i);
       return *this;
    }
-   template<typename T>
-   void vector<T>::assign(size_type n, const value_type &value)
+   template<typename T, typename Resource>
+   void vector<T,Resource>::assign(size_type n, const value_type &value)
    {
       clear();
       reserve(n);
       while (n--)
          ::new(last_++) T(value);
    }
-   template<typename T>
-   void vector<T>::resize(size_type new_size)
+   template<typename T, typename Resource>
+   void vector<T,Resource>::resize(size_type new_size)
    {
       if (new_size < size())
          for (T *pos = elements_ + new_size; last_ > pos;)
@@ -231,27 +242,27 @@ namespace ttl
       else
          insert(end(), new_size - size(), value_type());
    }
-   template<typename T>
-   void vector<T>::reserve(size_type n)
+   template<typename T, typename Resource>
+   void vector<T,Resource>::reserve(size_type n)
    {
       if (elements_ + n < end_of_elements_)
          return;
-      T *newelements = static_cast<T *>(::operator new(n * sizeof(T)));
+      T *newelements = allocate(n);
       T *o = newelements, *i = elements_;
       for (; i != last_; ++i)
          ::new(o++) T(*i);
       for (; i > elements_; )
          (--i)->~T();
-      ::operator delete(elements_);
+      deallocate();
       elements_ = newelements;
       end_of_elements_ = elements_ + n;
       last_ = o;
    }
 
-   template<typename T>
-   typename vector<T>::iterator vector<T>::insert_values(const_iterator pos,
+   template<typename T, typename Resource>
+   typename vector<T,Resource>::iterator vector<T,Resource>::insert_values(const_iterator pos,
                                                          difference_type n,
-                                                         void (ttl::vector<T>::* vc)(T *, vc_args &) const,
+                                                         void (ttl::vector<T,Resource>::* vc)(T *, vc_args &) const,
                                                          vc_args &args)
    {
       difference_type dist = pos - cbegin();
@@ -262,7 +273,7 @@ namespace ttl
          if (end_of_elements_ - last_ < n)
          {
             size_type newcapacity = size() + n;
-            T *newelements = o = static_cast<T *>(::operator new(newcapacity * sizeof(T)));
+            T *newelements = o = allocate(newcapacity);
             for (i = elements_; i != pos; ++i)
                ::new(o++) T(*i);
             while (n-- > 0)
@@ -271,7 +282,7 @@ namespace ttl
                ::new(o++) T(*i);
             for (; i > elements_; )
                (--i)->~T();
-            ::operator delete(elements_);
+            deallocate();
             elements_ = newelements;
             end_of_elements_ = elements_ + newcapacity;
             last_ = o;
@@ -300,8 +311,8 @@ namespace ttl
       return begin() + dist;
    }
 
-   template<typename T>
-   typename vector<T>::iterator vector<T>::erase(const_iterator first, const_iterator last)
+   template<typename T, typename Resource>
+   typename vector<T,Resource>::iterator vector<T,Resource>::erase(const_iterator first, const_iterator last)
    {
       difference_type off = first - begin();
       difference_type lastoff = last - begin();
@@ -316,13 +327,13 @@ namespace ttl
       last_ = o;
       return begin() + off;
    }
-   template<typename T>
-   inline bool operator==(const vector<T> &a, const vector<T> &b)
+   template<typename T, typename Resource>
+   inline bool operator==(const vector<T,Resource> &a, const vector<T,Resource> &b)
    {
       return ttl::equal(a.begin(), a.end(), b.begin(), b.end());
    }
-   template<typename T>
-   inline bool operator!=(const vector<T> &a, const vector<T> &b)
+   template<typename T, typename Resource>
+   inline bool operator!=(const vector<T,Resource> &a, const vector<T,Resource> &b)
    {
       return !(a == b);
    }
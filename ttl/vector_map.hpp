@@ -14,6 +14,9 @@
 // stable_sort<> and searched with binary_search, lower_bound, uppper_bound and
 // equal_range operations.
 //
+// The keys are compared with KeyEqual, with a transparent one, such as
+// equal_to<void>, find and count take any type comparable with the keys.
+//
 // This code is Public Domain
 //
 #ifndef _TINY_TEMPLATE_LIBRARY_VECTOR_MAP_HPP_
@@ -26,7 +29,7 @@
 
 namespace ttl
 {
-   template<typename KT, typename T>
+   template<typename KT, typename T, typename KeyEqual = equal_to<KT> >
    class vector_map: public vector< pair<KT, T> >
    {
    public:
@@ -41,6 +44,7 @@ namespace ttl
       typedef const value_type *const_pointer;
       typedef typename vector<value_type>::iterator iterator;
       typedef typename vector<value_type>::const_iterator const_iterator;
+      typedef KeyEqual key_equal;
 
       explicit vector_map() {}
       vector_map(const vector_map &other): vector<value_type>(other) {}
@@ -66,12 +70,23 @@ namespace ttl
       iterator find(const KT &key) { return iterator(find_key(begin(), key)); }
       const_iterator find(const KT &key) const { return const_iterator(find_key(begin(), key)); }
 
-      size_type count(const KT &key) const
+      size_type count(const KT &key) const { return count_key(key); }
+
+      template<class K>
+      typename if_transparent<KeyEqual, K, iterator>::type find(const K &key)
       {
-         size_type n = 0;
-         for (const_iterator i = begin(); (i = find_key(i, key)) != end();)
-            ++n;
-         return n;
+         return iterator(find_key(begin(), key));
+      }
+      template<class K>
+      typename if_transparent<KeyEqual, K, const_iterator>::type find(const K &key) const
+      {
+         return const_iterator(find_key(begin(), key));
+      }
+
+      template<class K>
+      typename if_transparent<KeyEqual, K, size_type>::type count(const K &key) const
+      {
+         return count_key(key);
       }
 
       pair<iterator,bool> insert(const value_type &value)
@@ -83,13 +98,23 @@ namespace ttl
       }
 
    protected:
-      iterator find_key(const_iterator i, const KT &key) const
+      template<class K>
+      iterator find_key(const_iterator i, const K &key) const
       {
+         KeyEqual eq;
          for (; i != end(); ++i)
-            if (key == i->first)
+            if (eq(key, i->first))
                break;
          return const_cast<iterator>(i);
       }
+      template<class K>
+      size_type count_key(const K &key) const
+      {
+         size_type n = 0;
+         for (const_iterator i = begin(); (i = find_key(i, key)) != end(); ++i)
+            ++n;
+         return n;
+      }
    };
 }
 #endif // _TINY_TEMPLATE_LIBRARY_SORTED_VECTOR_MAP_HPP_